@@ -22,9 +22,152 @@ namespace csharp
             }
         }
 
+        static bool near(float a, float b)
+        {
+            return Math.Abs(a - b) <= 1e-5f * Math.Max(1.0f, Math.Abs(a));
+        }
+
+        static bool near(vec3 a, vec3 b)
+        {
+            return near(a.x, b.x) && near(a.y, b.y) && near(a.z, b.z);
+        }
+
+        static bool near(vec4 a, vec4 b)
+        {
+            return near(a.x, b.x) && near(a.y, b.y) && near(a.z, b.z) && near(a.w, b.w);
+        }
+
+        static bool near(mat4 a, mat4 b)
+        {
+            return near(a[0], b[0]) && near(a[1], b[1]) && near(a[2], b[2]) && near(a[3], b[3]);
+        }
+
+        static void simd_test()
+        {
+            Random random = new Random(1);
+            Func<float> rand = () => (float)random.NextDouble() * 20.0f - 10.0f;
+
+            bool passed = true;
+            vec3[] points  = new vec3[37];
+            vec3[] normals = new vec3[37];
+            vec4[] vectors = new vec4[37];
+            mat4[] models  = new mat4[37];
+            for (int i = 0; i < points.Length; i++)
+            {
+                points[i]  = vec3(rand(), rand(), rand());
+                vectors[i] = vec4(rand(), rand(), rand(), rand());
+                models[i]  = mat4(
+                    rand(), rand(), rand(), rand(),
+                    rand(), rand(), rand(), rand(),
+                    rand(), rand(), rand(), rand(),
+                    rand(), rand(), rand(), rand());
+            }
+            points[5] = vec3(0.0f);
+
+            mat4 m = models[0];
+            for (int i = 0; i < points.Length; i++)
+            {
+                vec3 a = points[i];
+                vec3 b = points[(i + 1) % points.Length];
+                vec4 v = vectors[i];
+                passed &= near(dot(a, b), scalar.dot(a, b));
+                passed &= near(dot(v, v), scalar.dot(v, v));
+                passed &= near(cross(a, b), scalar.cross(a, b));
+                passed &= near(normalize(a), scalar.normalize(a));
+                passed &= near(normalize(v), scalar.normalize(v));
+                passed &= near(mul(m, v), scalar.mul(m, v));
+                passed &= near(mul(m, models[i]), scalar.mul(m, models[i]));
+            }
+
+            /* Batches, in place */
+            vec3[] transformed = (vec3[])points.Clone();
+            transform(m, transformed, transformed);
+            vec4[] transformed4 = (vec4[])vectors.Clone();
+            transform(m, transformed4, transformed4);
+            mat4[] products = new mat4[models.Length];
+            mul(models, models, products);
+            Array.Copy(points, normals, points.Length);
+            normalize(normals, normals);
+            for (int i = 0; i < points.Length; i++)
+            {
+                vec4 p = scalar.mul(m, vec4(points[i].x, points[i].y, points[i].z, 1.0f));
+                passed &= near(transformed[i], vec3(p.x, p.y, p.z));
+                passed &= near(transformed4[i], scalar.mul(m, vectors[i]));
+                passed &= near(products[i], scalar.mul(models[i], models[i]));
+                passed &= near(normals[i], scalar.normalize(points[i]));
+            }
+
+            /* Translation is carried by the w column */
+            passed &= near(mul(translate(1, 2, 3), vec4(1, 1, 1, 1)), vec4(2, 3, 4, 1));
+
+            if (passed)
+            {
+                Console.WriteLine(string.Format("simd: {0}", System.Numerics.Vector.IsHardwareAccelerated ? "accelerated" : "scalar"));
+            }
+            else
+            {
+                Console.WriteLine("Test failed");
+            }
+        }
+
+        static void native_test()
+        {
+            if (!vmath_native.IsAvailable)
+            {
+                Console.WriteLine("native: skipped, build libvmath with: make -C test libvmath");
+                return;
+            }
+
+            bool passed = true;
+            mat4 m = mul(translate(1, 2, 3), scale(2, 2, 2));
+            vec3[] points = { vec3(1, 0, 0), vec3(0, 1, 0), vec3(0, 0, 1), vec3(1, 2, 3), vec3(-1, -2, -3) };
+            vec3[] expect = new vec3[points.Length];
+            transform(m, points, expect);
+            vmath_native.transform(m, points, points);
+            for (int i = 0; i < points.Length; i++)
+            {
+                passed &= near(points[i], expect[i]);
+            }
+
+            vec4[] vectors = { vec4(1, 2, 3, 4), vec4(0, 0, 0, 1) };
+            vec4[] result4 = new vec4[vectors.Length];
+            vmath_native.transform(m, vectors, result4);
+            passed &= near(result4[0], mul(m, vectors[0])) && near(result4[1], vec4(1, 2, 3, 1));
+
+            /* Rotation of 90 degrees around y, then translate */
+            quat q = quat(0, (float)Math.Sqrt(0.5), 0, (float)Math.Sqrt(0.5));
+            mat4[] trs = new mat4[1];
+            vmath_native.composetrs(new[] { vec3(1, 2, 3) }, new[] { q }, new[] { vec3(2, 2, 2) }, trs);
+            passed &= near(mul(trs[0], vec4(1, 0, 0, 1)), vec4(1, 2, 1, 1));
+
+            /* A bone with identity rotation and translation (0, 0.5, 0): dual = 0.5 * (t, 0) * real */
+            dquat[] palette = { new dquat(quat(0, 0, 0, 1), quat(0, 0.25f, 0, 0)) };
+            vec3[] skinned = new vec3[1];
+            vmath_native.skin(new[] { vec3(1, 0, 0) }, default, new[] { 0, 0, 0, 0 }, new[] { 1.0f, 0, 0, 0 }, palette, skinned, default);
+            passed &= near(skinned[0], vec3(1, 0.5f, 0));
+
+            vec4[] planes = new vec4[6];
+            vmath_native.frustumplanes(perspective((float)Math.PI * 0.5f, 1.0f, 1.0f, 100.0f), planes);
+            vec4[] spheres = { vec4(0, 0, -10, 1), vec4(0, 0, 10, 1), vec4(11, 0, -10, 2), vec4(100, 0, -10, 1), vec4(0, 0, -200, 1), vec4(0, 3, -50, 1) };
+            int[] visible = new int[spheres.Length];
+            int count = vmath_native.cullspheres(planes, spheres, visible);
+            passed &= count == 3 && visible[0] == 0 && visible[1] == 2 && visible[2] == 5;
+
+            if (passed)
+            {
+                Console.WriteLine("native: passed");
+            }
+            else
+            {
+                Console.WriteLine("Test failed");
+            }
+        }
+
         static void Main(string[] args)
         {
             vec2_test();
+            simd_test();
+            native_test();
         }
     }
 }
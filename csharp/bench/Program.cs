@@ -0,0 +1,194 @@
+using System;
+using System.Diagnostics;
+using static vmath;
+
+namespace bench
+{
+    /// <summary>
+    /// BenchmarkDotNet-style comparison of the SIMD paths against vmath.scalar.
+    /// Each case runs warmup rounds, then timed iterations over COUNT elements,
+    /// and reports mean/stddev per element and the SIMD/scalar ratio.
+    /// Run with: dotnet run -c Release
+    /// </summary>
+    class Program
+    {
+        const int COUNT      = 4096;
+        const int WARMUP     = 8;
+        const int ITERATIONS = 16;
+        const double ITERATION_SECONDS = 0.05;
+
+        static vec3[] points   = new vec3[COUNT];
+        static vec4[] vectors  = new vec4[COUNT];
+        static mat4[] models   = new mat4[COUNT];
+        static vec3[] points2  = new vec3[COUNT];
+        static vec4[] vectors2 = new vec4[COUNT];
+        static mat4[] models2  = new mat4[COUNT];
+        static float  sink;
+
+        static void setup()
+        {
+            Random random = new Random(1);
+            Func<float> rand = () => (float)random.NextDouble() * 2.0f - 1.0f;
+            for (int i = 0; i < COUNT; i++)
+            {
+                points[i]  = vec3(rand(), rand(), rand());
+                vectors[i] = vec4(rand(), rand(), rand(), rand());
+                models[i]  = mat4(
+                    rand(), rand(), rand(), rand(),
+                    rand(), rand(), rand(), rand(),
+                    rand(), rand(), rand(), rand(),
+                    rand(), rand(), rand(), 1.0f);
+            }
+        }
+
+        /// Returns mean and standard deviation in nanoseconds per element
+        static (double mean, double stddev) measure(Action body, int elements = COUNT)
+        {
+            for (int i = 0; i < WARMUP; i++)
+            {
+                body();
+            }
+
+            /* Pick a round count so one iteration takes about ITERATION_SECONDS */
+            Stopwatch watch = Stopwatch.StartNew();
+            body();
+            double once   = Math.Max(watch.Elapsed.TotalSeconds, 1e-7);
+            int    rounds = Math.Max(1, (int)(ITERATION_SECONDS / once));
+
+            double[] samples = new double[ITERATIONS];
+            for (int i = 0; i < ITERATIONS; i++)
+            {
+                watch.Restart();
+                for (int r = 0; r < rounds; r++)
+                {
+                    body();
+                }
+                samples[i] = watch.Elapsed.TotalSeconds * 1e9 / ((double)rounds * elements);
+            }
+
+            double mean = 0.0;
+            foreach (double s in samples) mean += s;
+            mean /= ITERATIONS;
+
+            double variance = 0.0;
+            foreach (double s in samples) variance += (s - mean) * (s - mean);
+            return (mean, Math.Sqrt(variance / (ITERATIONS - 1)));
+        }
+
+        static void run(string method, Action baseline, Action simd)
+        {
+            (double mean, double stddev) a = measure(baseline);
+            (double mean, double stddev) b = measure(simd);
+            Console.WriteLine("| {0,-28} | {1,8:F3} ns | {2,8:F3} ns | {3,8:F3} ns | {4,8:F3} ns | {5,5:F2} |",
+                method, a.mean, a.stddev, b.mean, b.stddev, b.mean / a.mean);
+        }
+
+        /// Same COUNT points cut in batches of size n, so every call pays the P/Invoke transition.
+        /// Native wins once a batch is long enough to hide that fixed cost.
+        static void native()
+        {
+            Console.WriteLine();
+            if (!vmath_native.IsAvailable)
+            {
+                Console.WriteLine("libvmath not found, build it with: make -C test libvmath");
+                return;
+            }
+
+            Console.WriteLine("transform(mat4, Span<vec3>) per point, managed SIMD vs libvmath through P/Invoke");
+            Console.WriteLine();
+            Console.WriteLine("| {0,6} | {1,11} | {2,11} | {3,11} | {4,5} |", "Batch", "Managed", "Native", "Per call", "Ratio");
+            Console.WriteLine("|--------|-------------|-------------|-------------|-------|");
+
+            int amortized = 0;
+            for (int n = 1; n <= COUNT; n *= 4)
+            {
+                int batch = n;
+                mat4 m = models[0];
+                (double mean, double stddev) a = measure(() =>
+                {
+                    for (int i = 0; i < COUNT; i += batch)
+                    {
+                        transform(m, points.AsSpan(i, batch), points2.AsSpan(i, batch));
+                    }
+                });
+                (double mean, double stddev) b = measure(() =>
+                {
+                    for (int i = 0; i < COUNT; i += batch)
+                    {
+                        vmath_native.transform(m, points.AsSpan(i, batch), points2.AsSpan(i, batch));
+                    }
+                });
+
+                if (amortized == 0 && b.mean <= a.mean)
+                {
+                    amortized = batch;
+                }
+                Console.WriteLine("| {0,6} | {1,8:F3} ns | {2,8:F3} ns | {3,8:F3} ns | {4,5:F2} |",
+                    batch, a.mean, b.mean, b.mean * batch, b.mean / a.mean);
+            }
+
+            Console.WriteLine();
+            Console.WriteLine(amortized > 0
+                ? string.Format("P/Invoke overhead amortized from batches of {0} points", amortized)
+                : "P/Invoke overhead not amortized up to " + COUNT + " points");
+        }
+
+        static void Main(string[] args)
+        {
+            setup();
+
+            Console.WriteLine("vmath.cs SIMD vs scalar, {0} elements per round, Vector128 accelerated: {1}",
+                COUNT, System.Runtime.Intrinsics.Vector128.IsHardwareAccelerated);
+            Console.WriteLine();
+            Console.WriteLine("| {0,-28} | {1,11} | {2,11} | {3,11} | {4,11} | {5,5} |",
+                "Method", "Scalar", "StdDev", "SIMD", "StdDev", "Ratio");
+            Console.WriteLine("|{0}|-------------|-------------|-------------|-------------|-------|", new string('-', 30));
+
+            run("dot(vec3, vec3)",
+                () => { float s = 0; for (int i = 0; i < COUNT; i++) s += scalar.dot(points[i], points[COUNT - 1 - i]); sink = s; },
+                () => { float s = 0; for (int i = 0; i < COUNT; i++) s += dot(points[i], points[COUNT - 1 - i]); sink = s; });
+            run("dot(vec4, vec4)",
+                () => { float s = 0; for (int i = 0; i < COUNT; i++) s += scalar.dot(vectors[i], vectors[COUNT - 1 - i]); sink = s; },
+                () => { float s = 0; for (int i = 0; i < COUNT; i++) s += dot(vectors[i], vectors[COUNT - 1 - i]); sink = s; });
+            run("cross(vec3, vec3)",
+                () => { for (int i = 0; i < COUNT; i++) points2[i] = scalar.cross(points[i], points[COUNT - 1 - i]); },
+                () => { for (int i = 0; i < COUNT; i++) points2[i] = cross(points[i], points[COUNT - 1 - i]); });
+            run("normalize(vec3)",
+                () => { for (int i = 0; i < COUNT; i++) points2[i] = scalar.normalize(points[i]); },
+                () => { for (int i = 0; i < COUNT; i++) points2[i] = normalize(points[i]); });
+            run("normalize(vec4)",
+                () => { for (int i = 0; i < COUNT; i++) vectors2[i] = scalar.normalize(vectors[i]); },
+                () => { for (int i = 0; i < COUNT; i++) vectors2[i] = normalize(vectors[i]); });
+            run("mul(mat4, vec4)",
+                () => { mat4 m = models[0]; for (int i = 0; i < COUNT; i++) vectors2[i] = scalar.mul(m, vectors[i]); },
+                () => { mat4 m = models[0]; for (int i = 0; i < COUNT; i++) vectors2[i] = mul(m, vectors[i]); });
+            run("mul(mat4, mat4)",
+                () => { for (int i = 0; i < COUNT; i++) models2[i] = scalar.mul(models[i], models[COUNT - 1 - i]); },
+                () => { for (int i = 0; i < COUNT; i++) models2[i] = mul(models[i], models[COUNT - 1 - i]); });
+            run("transform(mat4, Span<vec3>)",
+                () =>
+                {
+                    mat4 m = models[0];
+                    for (int i = 0; i < COUNT; i++)
+                    {
+                        vec4 p = scalar.mul(m, vec4(points[i].x, points[i].y, points[i].z, 1.0f));
+                        points2[i] = vec3(p.x, p.y, p.z);
+                    }
+                },
+                () => transform(models[0], points, points2));
+            run("transform(mat4, Span<vec4>)",
+                () => { mat4 m = models[0]; for (int i = 0; i < COUNT; i++) vectors2[i] = scalar.mul(m, vectors[i]); },
+                () => transform(models[0], vectors, vectors2));
+            run("mul(Span<mat4>, Span<mat4>)",
+                () => { for (int i = 0; i < COUNT; i++) models2[i] = scalar.mul(models[i], models[i]); },
+                () => mul(models, models, models2));
+            run("normalize(Span<vec3>)",
+                () => { for (int i = 0; i < COUNT; i++) points2[i] = scalar.normalize(points[i]); },
+                () => normalize(points, points2));
+
+            native();
+
+            GC.KeepAlive(sink);
+        }
+    }
+}
@@ -6,9 +6,25 @@
 #define VMATH_UNITY
 #endif
 
+#if NETCOREAPP2_1_OR_GREATER || NETSTANDARD2_1_OR_GREATER || UNITY_2021_2_OR_NEWER
+#define VMATH_SPAN
+#endif
+
+#if NETCOREAPP3_0_OR_GREATER && !VMATH_UNITY && !VMATH_NO_INTRINSICS
+#define VMATH_INTRINSICS
+#endif
+
 using System;
 using System.Diagnostics;
 using System.Runtime.CompilerServices;
+#if VMATH_SPAN
+using System.Runtime.InteropServices;
+#endif
+#if VMATH_INTRINSICS
+using System.Runtime.Intrinsics;
+using System.Runtime.Intrinsics.X86;
+using System.Runtime.Intrinsics.Arm;
+#endif
 
 [System.Serializable]
 [DebuggerTypeProxy(typeof(DebuggerProxy))]
@@ -1392,7 +1408,8 @@ public static class vmath
     [MethodImpl(MethodInlineOptions)]
     public static float dot(vec3 a, vec3 b)
     {
-        return a.x * b.x + a.y * b.y + a.z * b.z;
+        /* Widening vec3 to Vector128 costs more than it saves, see bench */
+        return scalar.dot(a, b);
     }
 
     [MethodImpl(MethodInlineOptions)]
@@ -1404,7 +1421,7 @@ public static class vmath
     [MethodImpl(MethodInlineOptions)]
     public static float length(vec3 v)
     {
-        return (float)Math.Sqrt(length(v));
+        return (float)Math.Sqrt(lengthsquared(v));
     }
 
     [MethodImpl(MethodInlineOptions)]
@@ -1422,11 +1439,8 @@ public static class vmath
     [MethodImpl(MethodInlineOptions)]
     public static vec3 cross(vec3 a, vec3 b)
     {
-        return vec3(
-            a.y * b.z - a.z * b.y,
-            a.z * b.x - a.x * b.z,
-            a.x * b.y - a.y * b.x
-        );
+        /* Widening vec3 to Vector128 costs more than the shuffles save, see bench */
+        return scalar.cross(a, b);
     }
 
     [MethodImpl(MethodInlineOptions)]
@@ -1438,16 +1452,13 @@ public static class vmath
     [MethodImpl(MethodInlineOptions)]
     public static vec3 normalize(vec3 v)
     {
-        float lsqr = lengthsquared(v);
-        if (lsqr != 1.0f && lsqr > 0.0f)
+#if VMATH_INTRINSICS
+        if (simd.IsSupported)
         {
-            float l = 1.0f / (float)Math.Sqrt(lsqr);
-            return vec3(v.x * l, v.y * l, v.z * l);
-        }
-        else
-        {
-            return v;
+            return simd.tovec3(simd.normalize(simd.load(v)));
         }
+#endif
+        return scalar.normalize(v);
     }
     #endregion vec3...
     /* * */
@@ -1535,7 +1546,13 @@ public static class vmath
     [MethodImpl(MethodInlineOptions)]
     public static float dot(vec4 a, vec4 b)
     {
-        return a.x * b.x + a.y * b.y + a.z * b.z;
+#if VMATH_INTRINSICS
+        if (simd.IsSupported)
+        {
+            return simd.dot(simd.load(a), simd.load(b)).ToScalar();
+        }
+#endif
+        return scalar.dot(a, b);
     }
 
     [MethodImpl(MethodInlineOptions)]
@@ -1571,16 +1588,13 @@ public static class vmath
     [MethodImpl(MethodInlineOptions)]
     public static vec4 normalize(vec4 v)
     {
-        float lsqr = lengthsquared(v);
-        if (lsqr != 1.0f && lsqr > 0.0f)
+#if VMATH_INTRINSICS
+        if (simd.IsSupported)
         {
-            float l = 1.0f / (float)Math.Sqrt(lsqr);
-            return vec4(v.x * l, v.y * l, v.z * l, v.w * l);
-        }
-        else
-        {
-            return v;
+            return simd.tovec4(simd.normalize(simd.load(v)));
         }
+#endif
+        return scalar.normalize(v);
     }
     #endregion vec4...
     /* * */
@@ -1626,31 +1640,13 @@ public static class vmath
     [MethodImpl(MethodInlineOptions)]
     public static mat4 mul(mat4 a, mat4 b)
     {
-        return mat4(
-            /* Row 1 */
-            a.m00 * b.m00 + a.m10 * b.m01 + a.m20 * b.m02 + a.m30 * b.m03, 
-            a.m01 * b.m00 + a.m11 * b.m01 + a.m21 * b.m02 + a.m31 * b.m03,
-            a.m02 * b.m00 + a.m12 * b.m01 + a.m22 * b.m02 + a.m32 * b.m03,
-            a.m03 * b.m00 + a.m13 * b.m01 + a.m23 * b.m02 + a.m33 * b.m03,
-
-            /* Row 2*/
-            a.m00 * b.m10 + a.m10 * b.m11 + a.m20 * b.m12 + a.m30 * b.m13, 
-            a.m21 * b.m10 + a.m11 * b.m11 + a.m21 * b.m12 + a.m31 * b.m13,
-            a.m02 * b.m10 + a.m12 * b.m11 + a.m22 * b.m12 + a.m32 * b.m13,
-            a.m03 * b.m10 + a.m13 * b.m11 + a.m23 * b.m12 + a.m33 * b.m13,
-
-            /* Row 3 */
-            a.m00 * b.m20 + a.m10 * b.m21 + a.m20 * b.m22 + a.m30 * b.m23, 
-            a.m01 * b.m20 + a.m11 * b.m21 + a.m21 * b.m22 + a.m31 * b.m23,
-            a.m02 * b.m20 + a.m12 * b.m21 + a.m22 * b.m22 + a.m32 * b.m23,
-            a.m03 * b.m20 + a.m13 * b.m21 + a.m23 * b.m22 + a.m33 * b.m23,
-
-            /* Row 4 */
-            a.m00 * b.m30 + a.m10 * b.m31 + a.m20 * b.m32 + a.m30 * b.m33, 
-            a.m01 * b.m30 + a.m11 * b.m31 + a.m21 * b.m32 + a.m31 * b.m33,
-            a.m02 * b.m30 + a.m12 * b.m31 + a.m22 * b.m32 + a.m32 * b.m33,
-            a.m03 * b.m30 + a.m13 * b.m31 + a.m23 * b.m32 + a.m33 * b.m33
-        );
+#if VMATH_INTRINSICS
+        if (simd.IsSupported)
+        {
+            return simd.mul(in a, in b);
+        }
+#endif
+        return scalar.mul(a, b);
     }
 
     [MethodImpl(MethodInlineOptions)]
@@ -1716,17 +1712,13 @@ public static class vmath
     [MethodImpl(MethodInlineOptions)]
     public static vec4 mul(mat4 m, vec4 v)
     {
-        vec4 c0 = vec4(m.m00, m.m10, m.m20, m.m30);
-        vec4 c1 = vec4(m.m01, m.m11, m.m21, m.m31);
-        vec4 c2 = vec4(m.m02, m.m12, m.m22, m.m32);
-        vec4 c3 = vec4(m.m03, m.m13, m.m23, m.m33);
-
-        float x = dot(c0, v);
-        float y = dot(c1, v);
-        float z = dot(c2, v);
-        float w = dot(c3, v);
-
-        return vec4(x, y, z, w);
+#if VMATH_INTRINSICS
+        if (simd.IsSupported)
+        {
+            return simd.tovec4(simd.mul(in m, simd.load(v)));
+        }
+#endif
+        return scalar.mul(m, v);
     }
 
     [MethodImpl(MethodInlineOptions)]
@@ -1916,4 +1908,466 @@ public static class vmath
     }
     #endregion mat4...
     /* * */
+
+    #region Scalar functions
+    /// <summary>
+    /// Plain float implementations of the functions that have SIMD paths.
+    /// Used when no SIMD instruction set is available, and as the reference for tests and benchmarks.
+    /// </summary>
+    public static class scalar
+    {
+        [MethodImpl(MethodInlineOptions)]
+        public static float dot(vec3 a, vec3 b)
+        {
+            return a.x * b.x + a.y * b.y + a.z * b.z;
+        }
+
+        [MethodImpl(MethodInlineOptions)]
+        public static float dot(vec4 a, vec4 b)
+        {
+            return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+        }
+
+        [MethodImpl(MethodInlineOptions)]
+        public static vec3 cross(vec3 a, vec3 b)
+        {
+            return vec3(
+                a.y * b.z - a.z * b.y,
+                a.z * b.x - a.x * b.z,
+                a.x * b.y - a.y * b.x
+            );
+        }
+
+        [MethodImpl(MethodInlineOptions)]
+        public static vec3 normalize(vec3 v)
+        {
+            float lsqr = dot(v, v);
+            if (lsqr != 1.0f && lsqr > 0.0f)
+            {
+                float l = 1.0f / (float)Math.Sqrt(lsqr);
+                return vec3(v.x * l, v.y * l, v.z * l);
+            }
+            else
+            {
+                return v;
+            }
+        }
+
+        [MethodImpl(MethodInlineOptions)]
+        public static vec4 normalize(vec4 v)
+        {
+            float lsqr = dot(v, v);
+            if (lsqr != 1.0f && lsqr > 0.0f)
+            {
+                float l = 1.0f / (float)Math.Sqrt(lsqr);
+                return vec4(v.x * l, v.y * l, v.z * l, v.w * l);
+            }
+            else
+            {
+                return v;
+            }
+        }
+
+        [MethodImpl(MethodInlineOptions)]
+        public static mat4 mul(mat4 a, mat4 b)
+        {
+            return mat4(
+                /* Row 1 */
+                a.m00 * b.m00 + a.m10 * b.m01 + a.m20 * b.m02 + a.m30 * b.m03, 
+                a.m01 * b.m00 + a.m11 * b.m01 + a.m21 * b.m02 + a.m31 * b.m03,
+                a.m02 * b.m00 + a.m12 * b.m01 + a.m22 * b.m02 + a.m32 * b.m03,
+                a.m03 * b.m00 + a.m13 * b.m01 + a.m23 * b.m02 + a.m33 * b.m03,
+
+                /* Row 2*/
+                a.m00 * b.m10 + a.m10 * b.m11 + a.m20 * b.m12 + a.m30 * b.m13, 
+                a.m01 * b.m10 + a.m11 * b.m11 + a.m21 * b.m12 + a.m31 * b.m13,
+                a.m02 * b.m10 + a.m12 * b.m11 + a.m22 * b.m12 + a.m32 * b.m13,
+                a.m03 * b.m10 + a.m13 * b.m11 + a.m23 * b.m12 + a.m33 * b.m13,
+
+                /* Row 3 */
+                a.m00 * b.m20 + a.m10 * b.m21 + a.m20 * b.m22 + a.m30 * b.m23, 
+                a.m01 * b.m20 + a.m11 * b.m21 + a.m21 * b.m22 + a.m31 * b.m23,
+                a.m02 * b.m20 + a.m12 * b.m21 + a.m22 * b.m22 + a.m32 * b.m23,
+                a.m03 * b.m20 + a.m13 * b.m21 + a.m23 * b.m22 + a.m33 * b.m23,
+
+                /* Row 4 */
+                a.m00 * b.m30 + a.m10 * b.m31 + a.m20 * b.m32 + a.m30 * b.m33, 
+                a.m01 * b.m30 + a.m11 * b.m31 + a.m21 * b.m32 + a.m31 * b.m33,
+                a.m02 * b.m30 + a.m12 * b.m31 + a.m22 * b.m32 + a.m32 * b.m33,
+                a.m03 * b.m30 + a.m13 * b.m31 + a.m23 * b.m32 + a.m33 * b.m33
+            );
+        }
+
+        [MethodImpl(MethodInlineOptions)]
+        public static vec4 mul(mat4 m, vec4 v)
+        {
+            vec4 c0 = vec4(m.m00, m.m10, m.m20, m.m30);
+            vec4 c1 = vec4(m.m01, m.m11, m.m21, m.m31);
+            vec4 c2 = vec4(m.m02, m.m12, m.m22, m.m32);
+            vec4 c3 = vec4(m.m03, m.m13, m.m23, m.m33);
+
+            float x = dot(c0, v);
+            float y = dot(c1, v);
+            float z = dot(c2, v);
+            float w = dot(c3, v);
+
+            return vec4(x, y, z, w);
+        }
+    }
+    #endregion Scalar...
+    /* * */
+
+#if VMATH_SPAN
+    #region Batch functions
+    /// <summary>
+    /// result[i] = a[i] * b[i]. result may be the same span as a or b.
+    /// </summary>
+    public static void mul(ReadOnlySpan<mat4> a, ReadOnlySpan<mat4> b, Span<mat4> result)
+    {
+        if (a.Length != b.Length || result.Length < a.Length)
+        {
+            throw new ArgumentException("Span lengths do not match", nameof(result));
+        }
+
+#if VMATH_INTRINSICS
+        if (simd.IsSupported)
+        {
+            for (int i = 0; i < a.Length; i++)
+            {
+                result[i] = simd.mul(in a[i], in b[i]);
+            }
+            return;
+        }
+#endif
+        for (int i = 0; i < a.Length; i++)
+        {
+            result[i] = scalar.mul(a[i], b[i]);
+        }
+    }
+
+    /// <summary>
+    /// result[i] = m * vec4(points[i], 1), without perspective divide. result may be the same span as points.
+    /// </summary>
+    public static void transform(mat4 m, ReadOnlySpan<vec3> points, Span<vec3> result)
+    {
+        if (result.Length < points.Length)
+        {
+            throw new ArgumentException("Span lengths do not match", nameof(result));
+        }
+
+#if VMATH_INTRINSICS
+        if (simd.IsSupported)
+        {
+            Vector128<float> c0 = simd.load(in m.m00);
+            Vector128<float> c1 = simd.load(in m.m10);
+            Vector128<float> c2 = simd.load(in m.m20);
+            Vector128<float> c3 = simd.load(in m.m30);
+            for (int i = 0; i < points.Length; i++)
+            {
+                vec3 p = points[i];
+                Vector128<float> r = simd.madd(c0, Vector128.Create(p.x), c3);
+                r = simd.madd(c1, Vector128.Create(p.y), r);
+                r = simd.madd(c2, Vector128.Create(p.z), r);
+                result[i] = simd.tovec3(r);
+            }
+            return;
+        }
+#endif
+        for (int i = 0; i < points.Length; i++)
+        {
+            vec3 p = points[i];
+            result[i] = vec3(
+                m.m00 * p.x + m.m10 * p.y + m.m20 * p.z + m.m30,
+                m.m01 * p.x + m.m11 * p.y + m.m21 * p.z + m.m31,
+                m.m02 * p.x + m.m12 * p.y + m.m22 * p.z + m.m32
+            );
+        }
+    }
+
+    /// <summary>
+    /// result[i] = m * vectors[i]. result may be the same span as vectors.
+    /// </summary>
+    public static void transform(mat4 m, ReadOnlySpan<vec4> vectors, Span<vec4> result)
+    {
+        if (result.Length < vectors.Length)
+        {
+            throw new ArgumentException("Span lengths do not match", nameof(result));
+        }
+
+#if VMATH_INTRINSICS
+        if (simd.IsSupported)
+        {
+            Vector128<float> c0 = simd.load(in m.m00);
+            Vector128<float> c1 = simd.load(in m.m10);
+            Vector128<float> c2 = simd.load(in m.m20);
+            Vector128<float> c3 = simd.load(in m.m30);
+            for (int i = 0; i < vectors.Length; i++)
+            {
+                Vector128<float> v = simd.load(in vectors[i].x);
+                result[i] = simd.tovec4(simd.mul(c0, c1, c2, c3, v));
+            }
+            return;
+        }
+#endif
+        for (int i = 0; i < vectors.Length; i++)
+        {
+            result[i] = scalar.mul(m, vectors[i]);
+        }
+    }
+
+    /// <summary>
+    /// result[i] = normalize(vectors[i]). result may be the same span as vectors.
+    /// </summary>
+    public static void normalize(ReadOnlySpan<vec3> vectors, Span<vec3> result)
+    {
+        if (result.Length < vectors.Length)
+        {
+            throw new ArgumentException("Span lengths do not match", nameof(result));
+        }
+
+        int i = 0;
+#if VMATH_INTRINSICS
+        if (Sse.IsSupported)
+        {
+            /* Four vec3 are exactly three Vector128 */
+            ref float src = ref MemoryMarshal.GetReference(MemoryMarshal.Cast<vec3, float>(vectors));
+            ref float dst = ref MemoryMarshal.GetReference(MemoryMarshal.Cast<vec3, float>(result));
+            for (; i + 4 <= vectors.Length; i += 4)
+            {
+                int k = i * 3;
+                simd.normalize4(
+                    ref Unsafe.Add(ref src, k), 
+                    ref Unsafe.Add(ref dst, k));
+            }
+        }
+#endif
+        for (; i < vectors.Length; i++)
+        {
+            result[i] = normalize(vectors[i]);
+        }
+    }
+    #endregion Batch...
+    /* * */
+#endif
+
+#if VMATH_INTRINSICS
+    #region SIMD functions
+    /// <summary>
+    /// Vector128 kernels. vec4, quat and every mat4 column have the layout of Vector128&lt;float&gt;,
+    /// so they are reinterpreted in place; vec3 is widened with w = 0.
+    /// Callers must check IsSupported (or Sse.IsSupported) first.
+    /// </summary>
+    internal static class simd
+    {
+        public static bool IsSupported
+        {
+            [MethodImpl(MethodInlineOptions)]
+            get { return Sse.IsSupported || AdvSimd.Arm64.IsSupported; }
+        }
+
+        [MethodImpl(MethodInlineOptions)]
+        public static Vector128<float> load(vec3 v)
+        {
+            return Vector128.Create(v.x, v.y, v.z, 0.0f);
+        }
+
+        [MethodImpl(MethodInlineOptions)]
+        public static Vector128<float> load(vec4 v)
+        {
+            return Unsafe.As<vec4, Vector128<float>>(ref v);
+        }
+
+        /// Load 4 consecutive floats, e.g. a mat4 column: load(in m.m10)
+        [MethodImpl(MethodInlineOptions)]
+        public static Vector128<float> load(in float first)
+        {
+            return Unsafe.As<float, Vector128<float>>(ref Unsafe.AsRef(in first));
+        }
+
+        [MethodImpl(MethodInlineOptions)]
+        public static void store(ref float first, Vector128<float> v)
+        {
+            Unsafe.As<float, Vector128<float>>(ref first) = v;
+        }
+
+        [MethodImpl(MethodInlineOptions)]
+        public static vec3 tovec3(Vector128<float> v)
+        {
+            return Unsafe.As<Vector128<float>, vec3>(ref v);
+        }
+
+        [MethodImpl(MethodInlineOptions)]
+        public static vec4 tovec4(Vector128<float> v)
+        {
+            return Unsafe.As<Vector128<float>, vec4>(ref v);
+        }
+
+        [MethodImpl(MethodInlineOptions)]
+        public static Vector128<float> mul(Vector128<float> a, Vector128<float> b)
+        {
+            if (Sse.IsSupported)
+            {
+                return Sse.Multiply(a, b);
+            }
+            return AdvSimd.Multiply(a, b);
+        }
+
+        /// a * b + c
+        [MethodImpl(MethodInlineOptions)]
+        public static Vector128<float> madd(Vector128<float> a, Vector128<float> b, Vector128<float> c)
+        {
+            if (Fma.IsSupported)
+            {
+                return Fma.MultiplyAdd(a, b, c);
+            }
+            if (Sse.IsSupported)
+            {
+                return Sse.Add(Sse.Multiply(a, b), c);
+            }
+            return AdvSimd.FusedMultiplyAdd(c, a, b);
+        }
+
+        [MethodImpl(MethodInlineOptions)]
+        public static Vector128<float> splatx(Vector128<float> v)
+        {
+            if (Sse.IsSupported)
+            {
+                return Sse.Shuffle(v, v, 0x00);
+            }
+            return AdvSimd.DuplicateSelectedScalarToVector128(v, 0);
+        }
+
+        [MethodImpl(MethodInlineOptions)]
+        public static Vector128<float> splaty(Vector128<float> v)
+        {
+            if (Sse.IsSupported)
+            {
+                return Sse.Shuffle(v, v, 0x55);
+            }
+            return AdvSimd.DuplicateSelectedScalarToVector128(v, 1);
+        }
+
+        [MethodImpl(MethodInlineOptions)]
+        public static Vector128<float> splatz(Vector128<float> v)
+        {
+            if (Sse.IsSupported)
+            {
+                return Sse.Shuffle(v, v, 0xAA);
+            }
+            return AdvSimd.DuplicateSelectedScalarToVector128(v, 2);
+        }
+
+        [MethodImpl(MethodInlineOptions)]
+        public static Vector128<float> splatw(Vector128<float> v)
+        {
+            if (Sse.IsSupported)
+            {
+                return Sse.Shuffle(v, v, 0xFF);
+            }
+            return AdvSimd.DuplicateSelectedScalarToVector128(v, 3);
+        }
+
+        /// Sum of a * b in every lane
+        [MethodImpl(MethodInlineOptions)]
+        public static Vector128<float> dot(Vector128<float> a, Vector128<float> b)
+        {
+            if (Sse41.IsSupported)
+            {
+                return Sse41.DotProduct(a, b, 0xFF);
+            }
+            if (Sse.IsSupported)
+            {
+                Vector128<float> m = Sse.Multiply(a, b);
+                m = Sse.Add(m, Sse.Shuffle(m, m, 0xB1));
+                return Sse.Add(m, Sse.Shuffle(m, m, 0x4E));
+            }
+            Vector128<float> p = AdvSimd.Multiply(a, b);
+            p = AdvSimd.Arm64.AddPairwise(p, p);
+            return AdvSimd.Arm64.AddPairwise(p, p);
+        }
+
+        /// Same rules as scalar.normalize: zero, NaN and unit vectors are returned unchanged
+        [MethodImpl(MethodInlineOptions)]
+        public static Vector128<float> normalize(Vector128<float> v)
+        {
+            Vector128<float> lsqr = dot(v, v);
+            float l = lsqr.ToScalar();
+            if (l != 1.0f && l > 0.0f)
+            {
+                if (Sse.IsSupported)
+                {
+                    return Sse.Divide(v, Sse.Sqrt(lsqr));
+                }
+                return AdvSimd.Arm64.Divide(v, AdvSimd.Arm64.Sqrt(lsqr));
+            }
+            return v;
+        }
+
+        /// m * v, columns passed in registers
+        [MethodImpl(MethodInlineOptions)]
+        public static Vector128<float> mul(Vector128<float> c0, Vector128<float> c1, Vector128<float> c2, Vector128<float> c3, Vector128<float> v)
+        {
+            Vector128<float> r = mul(c0, splatx(v));
+            r = madd(c1, splaty(v), r);
+            r = madd(c2, splatz(v), r);
+            return madd(c3, splatw(v), r);
+        }
+
+        [MethodImpl(MethodInlineOptions)]
+        public static Vector128<float> mul(in mat4 m, Vector128<float> v)
+        {
+            return mul(load(in m.m00), load(in m.m10), load(in m.m20), load(in m.m30), v);
+        }
+
+        [MethodImpl(MethodInlineOptions)]
+        public static mat4 mul(in mat4 a, in mat4 b)
+        {
+            Vector128<float> a0 = load(in a.m00);
+            Vector128<float> a1 = load(in a.m10);
+            Vector128<float> a2 = load(in a.m20);
+            Vector128<float> a3 = load(in a.m30);
+
+            mat4 result;
+            Unsafe.SkipInit(out result);
+            store(ref result.m00, mul(a0, a1, a2, a3, load(in b.m00)));
+            store(ref result.m10, mul(a0, a1, a2, a3, load(in b.m10)));
+            store(ref result.m20, mul(a0, a1, a2, a3, load(in b.m20)));
+            store(ref result.m30, mul(a0, a1, a2, a3, load(in b.m30)));
+            return result;
+        }
+
+        /// Normalize 4 packed vec3 (12 floats), Sse only.
+        /// Transposes to x/y/z lanes for the lengths, then scales the packed rows.
+        [MethodImpl(MethodInlineOptions)]
+        public static void normalize4(ref float src, ref float dst)
+        {
+            Vector128<float> v0 = Unsafe.As<float, Vector128<float>>(ref src);                   /* x0 y0 z0 x1 */
+            Vector128<float> v1 = Unsafe.As<float, Vector128<float>>(ref Unsafe.Add(ref src, 4)); /* y1 z1 x2 y2 */
+            Vector128<float> v2 = Unsafe.As<float, Vector128<float>>(ref Unsafe.Add(ref src, 8)); /* z2 x3 y3 z3 */
+
+            Vector128<float> s0 = Sse.Multiply(v0, v0);
+            Vector128<float> s1 = Sse.Multiply(v1, v1);
+            Vector128<float> s2 = Sse.Multiply(v2, v2);
+
+            Vector128<float> t0 = Sse.Shuffle(s1, s2, 0x92); /* y1 x1 y2 z2 */
+            Vector128<float> t1 = Sse.Shuffle(s0, s1, 0x49); /* y0 z0 y1 z1 */
+            Vector128<float> t2 = Sse.Shuffle(s1, s2, 0xEC); /* y1 y2 x3 y3 */
+            Vector128<float> x  = Sse.Shuffle(s0, t0, 0x8C); /* x0 x1 x2 x3 */
+            Vector128<float> y  = Sse.Shuffle(t1, t2, 0x98); /* y0 y1 y2 y3 */
+            Vector128<float> z  = Sse.Shuffle(t1, s2, 0xCD); /* z0 z1 z2 z3 */
+            Vector128<float> lsqr = Sse.Add(Sse.Add(x, y), z);
+
+            Vector128<float> one  = Vector128.Create(1.0f);
+            Vector128<float> mask = Sse.CompareGreaterThan(lsqr, Vector128<float>.Zero);
+            Vector128<float> inv  = Sse.Divide(one, Sse.Sqrt(lsqr));
+            inv = Sse.Or(Sse.And(mask, inv), Sse.AndNot(mask, one));
+
+            Unsafe.As<float, Vector128<float>>(ref dst)                   = Sse.Multiply(v0, Sse.Shuffle(inv, inv, 0x40));
+            Unsafe.As<float, Vector128<float>>(ref Unsafe.Add(ref dst, 4)) = Sse.Multiply(v1, Sse.Shuffle(inv, inv, 0xA5));
+            Unsafe.As<float, Vector128<float>>(ref Unsafe.Add(ref dst, 8)) = Sse.Multiply(v2, Sse.Shuffle(inv, inv, 0xFE));
+        }
+    }
+    #endregion SIMD...
+    /* * */
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,179 @@
+using System;
+using System.Runtime.CompilerServices;
+using System.Runtime.InteropServices;
+
+/// <summary>
+/// Dual quaternion, layout of dquat_t: real x y z w then dual x y z w
+/// </summary>
+[System.Serializable]
+[StructLayout(LayoutKind.Sequential)]
+public struct dquat
+{
+    public quat real;
+    public quat dual;
+
+    public dquat(quat real, quat dual)
+    {
+        this.real = real;
+        this.dual = dual;
+    }
+}
+
+/// <summary>
+/// Batch kernels of libvmath (vmath_native.h), build it with: make -C test libvmath
+/// vec3, vec4, quat, mat4 and dquat are blittable and match the packed layout of the C ABI,
+/// spans are pinned and passed by reference, nothing is copied or marshalled.
+/// Every call has a fixed cost of a few nanoseconds, use it for batches, not single elements.
+/// </summary>
+public static class vmath_native
+{
+    public const string Library = "vmath";
+    public const int AbiVersion = 1;
+
+    #region Imports
+    static class imports
+    {
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        public static extern int vmath_native_abi_version();
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        public static extern void vmath_native_transform_points(in mat4 m, in vec3 points, ref vec3 result, int count);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        public static extern void vmath_native_transform_vectors(in mat4 m, in vec4 vectors, ref vec4 result, int count);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        public static extern void vmath_native_compose_trs(ref mat4 result, in vec3 t, in quat r, in vec3 s, int count);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        public static extern void vmath_native_skin(ref vec3 outPositions, ref vec3 outNormals,
+                                                    in vec3 positions, in vec3 normals,
+                                                    in int bones, in float weights, int count,
+                                                    in dquat palette, int boneCount);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        public static extern void vmath_native_frustum_planes(in mat4 viewproj, ref vec4 planes, int depthZeroToOne);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)]
+        public static extern int vmath_native_cull_spheres(in vec4 planes, int planeCount, in vec4 spheres, int count, ref int visible);
+    }
+    #endregion
+
+    static int available = -1;
+
+    /// <summary>
+    /// True when libvmath can be loaded and has the same ABI version
+    /// </summary>
+    public static bool IsAvailable
+    {
+        get
+        {
+            if (available < 0)
+            {
+                try
+                {
+                    available = imports.vmath_native_abi_version() == AbiVersion ? 1 : 0;
+                }
+                catch (DllNotFoundException)
+                {
+                    available = 0;
+                }
+                catch (EntryPointNotFoundException)
+                {
+                    available = 0;
+                }
+            }
+            return available == 1;
+        }
+    }
+
+    [MethodImpl(vmath.MethodInlineOptions)]
+    static void check(int length, int resultLength)
+    {
+        if (resultLength < length)
+        {
+            throw new ArgumentException("Span lengths do not match");
+        }
+    }
+
+    /// <summary>
+    /// result[i] = (m * vec4(points[i], 1)).xyz, no perspective divide. result may be the same span as points.
+    /// </summary>
+    public static void transform(mat4 m, ReadOnlySpan<vec3> points, Span<vec3> result)
+    {
+        check(points.Length, result.Length);
+        imports.vmath_native_transform_points(in m, in MemoryMarshal.GetReference(points), ref MemoryMarshal.GetReference(result), points.Length);
+    }
+
+    /// <summary>
+    /// result[i] = m * vectors[i]. result may be the same span as vectors.
+    /// </summary>
+    public static void transform(mat4 m, ReadOnlySpan<vec4> vectors, Span<vec4> result)
+    {
+        check(vectors.Length, result.Length);
+        imports.vmath_native_transform_vectors(in m, in MemoryMarshal.GetReference(vectors), ref MemoryMarshal.GetReference(result), vectors.Length);
+    }
+
+    /// <summary>
+    /// result[i] = translate(t[i]) * rotate(r[i]) * scale(s[i])
+    /// </summary>
+    public static void composetrs(ReadOnlySpan<vec3> t, ReadOnlySpan<quat> r, ReadOnlySpan<vec3> s, Span<mat4> result)
+    {
+        if (r.Length != t.Length || s.Length != t.Length)
+        {
+            throw new ArgumentException("Span lengths do not match");
+        }
+        check(t.Length, result.Length);
+
+        imports.vmath_native_compose_trs(ref MemoryMarshal.GetReference(result),
+            in MemoryMarshal.GetReference(t), in MemoryMarshal.GetReference(r), in MemoryMarshal.GetReference(s), t.Length);
+    }
+
+    /// <summary>
+    /// Dual quaternion skinning with 4 bones per vertex.
+    /// normals and outNormals can be empty to skip normals.
+    /// </summary>
+    public static void skin(ReadOnlySpan<vec3> positions, ReadOnlySpan<vec3> normals,
+                            ReadOnlySpan<int> bones, ReadOnlySpan<float> weights, ReadOnlySpan<dquat> palette,
+                            Span<vec3> outPositions, Span<vec3> outNormals)
+    {
+        int count = positions.Length;
+        check(count, outPositions.Length);
+        check(4 * count, bones.Length);
+        check(4 * count, weights.Length);
+
+        bool hasNormals = !normals.IsEmpty && !outNormals.IsEmpty;
+        if (hasNormals)
+        {
+            check(count, normals.Length);
+            check(count, outNormals.Length);
+        }
+
+        /* An empty span is a null reference, which is passed as NULL */
+        imports.vmath_native_skin(
+            ref MemoryMarshal.GetReference(outPositions), ref (hasNormals ? ref MemoryMarshal.GetReference(outNormals) : ref Unsafe.NullRef<vec3>()),
+            in MemoryMarshal.GetReference(positions), in (hasNormals ? ref MemoryMarshal.GetReference(normals) : ref Unsafe.NullRef<vec3>()),
+            in MemoryMarshal.GetReference(bones), in MemoryMarshal.GetReference(weights), count,
+            in MemoryMarshal.GetReference(palette), palette.Length);
+    }
+
+    /// <summary>
+    /// Normalized planes of a view-projection matrix: left, right, bottom, top, near, far.
+    /// depthZeroToOne for vmath.perspective style matrices, false for -w..w clip depth.
+    /// </summary>
+    public static void frustumplanes(mat4 viewproj, Span<vec4> planes, bool depthZeroToOne = true)
+    {
+        check(6, planes.Length);
+        imports.vmath_native_frustum_planes(in viewproj, ref MemoryMarshal.GetReference(planes), depthZeroToOne ? 1 : 0);
+    }
+
+    /// <summary>
+    /// Write indices of spheres (xyz center, w radius) inside or intersecting all planes, return their count
+    /// </summary>
+    public static int cullspheres(ReadOnlySpan<vec4> planes, ReadOnlySpan<vec4> spheres, Span<int> visible)
+    {
+        check(spheres.Length, visible.Length);
+        return imports.vmath_native_cull_spheres(in MemoryMarshal.GetReference(planes), planes.Length,
+            in MemoryMarshal.GetReference(spheres), spheres.Length, ref MemoryMarshal.GetReference(visible));
+    }
+}
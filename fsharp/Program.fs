@@ -1,17 +1,57 @@
 ﻿// Learn more about F# at http://fsharp.org
 
 open System
+open System.Diagnostics
+open System.Numerics
+open System.Runtime.InteropServices
+
+/// Scalar references, defined before vmath operators shadow the float32 ones
+module reference =
+    let points (count : int) =
+        Array.init (3 * count) (fun i -> float32 (i % 1999) * 0.01f - 10.0f)
+
+    let transform (m : vmath.mat4) (p : float32[]) =
+        Array.init p.Length (fun k ->
+            let i = k - k % 3
+            let x, y, z = p.[i], p.[i + 1], p.[i + 2]
+            match k % 3 with
+            | 0 -> m.m00 * x + m.m10 * y + m.m20 * z + m.m30
+            | 1 -> m.m01 * x + m.m11 * y + m.m21 * z + m.m31
+            | _ -> m.m02 * x + m.m12 * y + m.m22 * z + m.m32)
+
+    /// Hamilton product as vmath.h quat_mul
+    let quatmul (a : vmath.quat) (b : vmath.quat) =
+        vmath.quat(a.x * b.w + b.x * a.w + (a.y * b.z - a.z * b.y),
+                   a.y * b.w + b.y * a.w + (a.z * b.x - a.x * b.z),
+                   a.z * b.w + b.z * a.w + (a.x * b.y - a.y * b.x),
+                   a.w * b.w - (a.x * b.x + a.y * b.y + a.z * b.z))
+
+    let near (a : float32[]) (b : float32[]) =
+        a.Length = b.Length && Array.forall2 (fun x y -> abs (x - y) <= 1e-4f * max 1.0f (abs x)) a b
+
+    /// The 16 floats of m in mat4_t data order
+    let floats (m : vmath.mat4) =
+        MemoryMarshal.Cast<vmath.mat4, float32>(Span<vmath.mat4>([| m |])).ToArray()
+
+    let time (f : unit -> 'a) =
+        let watch = Stopwatch.StartNew()
+        f () |> ignore
+        watch.Elapsed.TotalMilliseconds
+
 open vmath
 
 let print a = 
     printfn "%s" (a.ToString())
 
+let check name passed =
+    printfn "%s: %s" name (if passed then "passed" else "Test failed")
+
 module test =
     let vec2 =
         let a = vec2(1.0f, 2.0f)
         let v = a + 1.0f
 
-        let f = a |> add
+        let f = add a a
 
 
         print v
@@ -19,19 +59,97 @@ module test =
         ()
 
     let vec3 = 
-        ()
+        let a = vec3(1.0f, 0.0f, 0.0f)
+        let b = vec3(0.0f, 1.0f, 0.0f)
+        let c = cross (a, b)
+        let n = normalize (vec3(3.0f, 0.0f, 4.0f))
+        check "vec3" (c.z = 1.0f && n.x = 0.6f && dot a b = 0.0f && length (a + b * 2.0f) = sqrt 5.0f)
     
     let vec4 =
-        ()
+        let a = vmath.vec4(1.0f, 2.0f, 3.0f, 4.0f)
+        let b = a + 1.0f
+        check "vec4" (b.z = 4.0f && dot a a = 30.0f && lengthsquared (normalize a) < 1.000001f)
 
     let quat =
-        ()
+        let a = vmath.quat(0.0f, 0.6f, 0.0f, 0.8f)
+        let b = vmath.quat(0.5f, 0.5f, 0.5f, 0.5f)
+        let c = mul a b
+        let r = reference.quatmul a b
+        check "quat" (c.x = r.x && c.y = r.y && c.z = r.z && c.w = r.w)
+
+    let mat4 =
+        let m = mul (vmath.mat4.translate(vmath.vec3(1.0f, 2.0f, 3.0f))) (vmath.mat4.scale(vmath.vec3(2.0f, 2.0f, 2.0f)))
+        let v = mul m (vmath.vec4(1.0f, 1.0f, 1.0f, 1.0f))
+        let i = mul (vmath.mat4.inverse m) v
+        check "mat4" (v.x = 3.0f && v.y = 4.0f && v.z = 5.0f && i.x > 0.99999f && i.x < 1.00001f && i.w = 1.0f)
+
+    /// A function rather than a value: Parallel.For workers would block on the module initializer
+    let arrays () =
+        let m = mul (vmath.mat4.translate(vmath.vec3(1.0f, 2.0f, 3.0f))) (vmath.mat4.rotate(vmath.quat(0.0f, 0.6f, 0.0f, 0.8f)))
+        let points = reference.points 3000000
+        let mutable simd = [||]
+        let mutable scalar = [||]
+        let scalarTime = reference.time (fun () -> scalar <- reference.transform m points)
+        let simdTime = reference.time (fun () -> simd <- Array.transformPoints m points)
+        let mapped = Array.mapVec3 (fun p -> vmath.mat4.transform(m, p)) points
+        check "arrays" (reference.near scalar simd && reference.near scalar mapped)
+        printfn "transformPoints of 3M points: %.1f ms, scalar Array.init: %.1f ms" simdTime scalarTime
+
+    /// Layouts of the libvmath bindings, against the managed results
+    let native () =
+        if not (vmath_native.isAvailable.Force()) then
+            printfn "native: skipped, build libvmath with: make -C test libvmath"
+        else
+            let near (a : vmath.vec3) (b : vmath.vec3) = reference.near [| a.x; a.y; a.z |] [| b.x; b.y; b.z |]
+            let near4 (a : vmath.vec4) (b : vmath.vec4) = reference.near [| a.x; a.y; a.z; a.w |] [| b.x; b.y; b.z; b.w |]
+
+            let m = mul (vmath.mat4.translate(vmath.vec3(1.0f, 2.0f, 3.0f))) (vmath.mat4.scale(vmath.vec3(2.0f, 2.0f, 2.0f)))
+            let points = [| vmath.vec3(1.0f, 0.0f, 0.0f); vmath.vec3(0.0f, 1.0f, 0.0f); vmath.vec3(1.0f, 2.0f, 3.0f); vmath.vec3(-1.0f, -2.0f, -3.0f) |]
+            let expect = points |> Array.map (fun p -> vmath.mat4.transform(m, p))
+            vmath_native.native.transform(ReadOnlySpan(reference.floats m), ReadOnlySpan(points), Span(points))
+            let mutable passed = Array.forall2 near points expect
+
+            let vectors = [| vmath.vec4(1.0f, 2.0f, 3.0f, 4.0f); vmath.vec4(0.0f, 0.0f, 0.0f, 1.0f) |]
+            let result4 = Array.zeroCreate<vmath.vec4> vectors.Length
+            vmath_native.native.transform(ReadOnlySpan(reference.floats m), ReadOnlySpan(vectors), Span(result4))
+            passed <- passed && near4 result4.[0] (mul m vectors.[0]) && near4 result4.[1] (vmath.vec4(1.0f, 2.0f, 3.0f, 1.0f))
+
+            // Rotation of 90 degrees around y, then translate
+            let q = vmath.quat(0.0f, sqrt 0.5f, 0.0f, sqrt 0.5f)
+            let trs = Array.zeroCreate<float32> 16
+            vmath_native.native.composetrs(ReadOnlySpan([| vmath.vec3(1.0f, 2.0f, 3.0f) |]), ReadOnlySpan([| q |]),
+                                           ReadOnlySpan([| vmath.vec3(2.0f, 2.0f, 2.0f) |]), Span(trs))
+            let trs = MemoryMarshal.Cast<float32, vmath.mat4>(Span(trs)).[0]
+            passed <- passed && near4 (mul trs (vmath.vec4(1.0f, 0.0f, 0.0f, 1.0f))) (vmath.vec4(1.0f, 2.0f, 1.0f, 1.0f))
+
+            // A bone with identity rotation and translation (0, 0.5, 0): dual = 0.5 * (t, 0) * real
+            let palette = [| 0.0f; 0.0f; 0.0f; 1.0f; 0.0f; 0.25f; 0.0f; 0.0f |]
+            let skinned = Array.zeroCreate<vmath.vec3> 1
+            vmath_native.native.skin(ReadOnlySpan([| vmath.vec3(1.0f, 0.0f, 0.0f) |]), ReadOnlySpan(),
+                                     ReadOnlySpan([| 0; 0; 0; 0 |]), ReadOnlySpan([| 1.0f; 0.0f; 0.0f; 0.0f |]), ReadOnlySpan(palette),
+                                     Span(skinned), Span())
+            passed <- passed && near skinned.[0] (vmath.vec3(1.0f, 0.5f, 0.0f))
+
+            // Right handed, depth in 0..1 as vmath.perspective
+            let projection = vmath.mat4.ofMatrix(Matrix4x4.CreatePerspectiveFieldOfView(1.5707964f, 1.0f, 1.0f, 100.0f))
+            let planes = Array.zeroCreate<vmath.vec4> 6
+            vmath_native.native.frustumplanes(ReadOnlySpan(reference.floats projection), Span(planes), true)
+            let spheres = [| vmath.vec4(0.0f, 0.0f, -10.0f, 1.0f); vmath.vec4(0.0f, 0.0f, 10.0f, 1.0f); vmath.vec4(11.0f, 0.0f, -10.0f, 2.0f)
+                             vmath.vec4(100.0f, 0.0f, -10.0f, 1.0f); vmath.vec4(0.0f, 0.0f, -200.0f, 1.0f); vmath.vec4(0.0f, 3.0f, -50.0f, 1.0f) |]
+            let visible = Array.zeroCreate<int> spheres.Length
+            let count = vmath_native.native.cullspheres(ReadOnlySpan(planes), ReadOnlySpan(spheres), Span(visible))
+            passed <- passed && count = 3 && visible.[0] = 0 && visible.[1] = 2 && visible.[2] = 5
+
+            check "native" passed
 
     let all =
         vec2
         vec3
         vec4
         quat
+        mat4
+        arrays ()
+        native ()
 
 [<EntryPoint>]
 let main argv =
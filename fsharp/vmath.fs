@@ -9,6 +9,11 @@
 module vmath
 
 open Microsoft.FSharp.Core;
+open System
+open System.Numerics
+open System.Runtime.CompilerServices
+open System.Runtime.InteropServices
+open System.Threading.Tasks
 
 type vec2 =
     struct
@@ -103,59 +108,65 @@ type vec3 =
         new (xy : vec2, ?z : float32) = { x = xy.x; y = xy.y; z = defaultArg z 0.0f };
     end
 
+    static member inline toVector (v : vec3) : Vector3 =
+        Unsafe.BitCast<vec3, Vector3>(v)
+
+    static member inline ofVector (v : Vector3) : vec3 =
+        Unsafe.BitCast<Vector3, vec3>(v)
+
     static member inline neg (v : vec3) : vec3 =
-        vec3(-v.x, -v.y, -v.z)
+        vec3.ofVector(Vector3.Negate(vec3.toVector(v)))
         
     static member inline add (a : vec3, b : vec3) : vec3 =
-        vec3(a.x + b.x, a.y + b.y, a.z + b.z)
+        vec3.ofVector(Vector3.Add(vec3.toVector(a), vec3.toVector(b)))
 
-    static member inline add (a : vec3, b) : vec3 =
-        vec3(a.x + b, a.y + b, a.z + b)
+    static member inline add (a : vec3, b : float32) : vec3 =
+        vec3.ofVector(Vector3.Add(vec3.toVector(a), Vector3(b)))
 
-    static member inline add (a, b : vec3) : vec3 =
-        vec3(a + b.x, a + b.y, a + b.z)
+    static member inline add (a : float32, b : vec3) : vec3 =
+        vec3.ofVector(Vector3.Add(Vector3(a), vec3.toVector(b)))
 
     static member inline sub (a : vec3, b : vec3) : vec3 = 
-        vec3(a.x - b.x, a.y - b.y, a.z - b.z)
+        vec3.ofVector(Vector3.Subtract(vec3.toVector(a), vec3.toVector(b)))
 
-    static member inline sub (a : vec3, b) : vec3 = 
-        vec3(a.x - b, a.y - b, a.z - b)
+    static member inline sub (a : vec3, b : float32) : vec3 = 
+        vec3.ofVector(Vector3.Subtract(vec3.toVector(a), Vector3(b)))
 
-    static member inline sub (a, b : vec3) : vec3 = 
-        vec3(a - b.x, a - b.y, a - b.z)
+    static member inline sub (a : float32, b : vec3) : vec3 = 
+        vec3.ofVector(Vector3.Subtract(Vector3(a), vec3.toVector(b)))
 
     static member inline mul (a : vec3, b : vec3) : vec3 =
-        vec3(a.x * b.x, a.y * b.y, a.z * b.z)
+        vec3.ofVector(Vector3.Multiply(vec3.toVector(a), vec3.toVector(b)))
 
-    static member inline mul (a : vec3, b) : vec3 =
-        vec3(a.x * b, a.y * b, a.z * b)
+    static member inline mul (a : vec3, b : float32) : vec3 =
+        vec3.ofVector(Vector3.Multiply(vec3.toVector(a), b))
         
-    static member inline mul (a, b : vec3) : vec3 =
-        vec3(a * b.x, a * b.y, a * b.z)
+    static member inline mul (a : float32, b : vec3) : vec3 =
+        vec3.ofVector(Vector3.Multiply(a, vec3.toVector(b)))
 
     static member inline div (a : vec3, b : vec3) : vec3 = 
-        vec3(a.x / b.x, a.y / b.y, a.z / b.z)
+        vec3.ofVector(Vector3.Divide(vec3.toVector(a), vec3.toVector(b)))
 
-    static member inline div (a : vec3, b) : vec3 = 
-        vec3(a.x / b, a.y / b, a.z / b)
+    static member inline div (a : vec3, b : float32) : vec3 = 
+        vec3.ofVector(Vector3.Divide(vec3.toVector(a), b))
 
-    static member inline div (a, b : vec3) : vec3 = 
-        vec3(a / b.x, a / b.y, a / b.z)
+    static member inline div (a : float32, b : vec3) : vec3 = 
+        vec3.ofVector(Vector3.Divide(Vector3(a), vec3.toVector(b)))
 
     static member inline dot (a : vec3, b : vec3) =
-        a.x * b.x + a.y * b.y + a.z * b.z
+        Vector3.Dot(vec3.toVector(a), vec3.toVector(b))
 
     static member inline lengthsquared (v : vec3) =
-        vec3.dot(v, v)
+        vec3.toVector(v).LengthSquared()
 
     static member inline length (v : vec3) =
-        sqrt(vec3.lengthsquared(v))
+        vec3.toVector(v).Length()
 
     static member inline distance (a : vec3, b : vec3) =
-        vec3.length(vec3.sub(a, b))
+        Vector3.Distance(vec3.toVector(a), vec3.toVector(b))
 
     static member inline distancesquared (a : vec3, b : vec3) =
-        vec3.lengthsquared(vec3.sub(a, b))
+        Vector3.DistanceSquared(vec3.toVector(a), vec3.toVector(b))
 
     static member inline reflect (v : vec3, n : vec3) : vec3 =
         vec3.sub(v, vec3.mul(n, 2.0f * vec3.dot(v, n)))
@@ -164,12 +175,10 @@ type vec3 =
         let lsqr = vec3.lengthsquared(v)
         match lsqr with
         | 0.0f | 1.0f -> v
-        | _           ->
-            let l = 1.0f / sqrt(lsqr)
-            vec3(v.x * l, v.y * l, v.z * l)
+        | _           -> vec3.ofVector(Vector3.Multiply(vec3.toVector(v), 1.0f / sqrt(lsqr)))
 
     static member inline cross (a : vec3, b : vec3) : vec3 =
-        vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x) 
+        vec3.ofVector(Vector3.Cross(vec3.toVector(a), vec3.toVector(b)))
 
     override this.ToString() : string = 
         "vec3(" + this.x.ToString() + ", " + this.y.ToString() + ", " + this.z.ToString() + ")"
@@ -197,59 +206,65 @@ type vec4 =
             vec4 (xyz.x, xyz.y, xyz.z, defaultArg w 0.0f)
     end
 
-    static member inline neg (v : vec4) : vec4 = 
-        vec4(-v.x, -v.y, -v.z, -v.w)
+    static member inline toVector (v : vec4) : Vector4 =
+        Unsafe.BitCast<vec4, Vector4>(v)
+
+    static member inline ofVector (v : Vector4) : vec4 =
+        Unsafe.BitCast<Vector4, vec4>(v)
+
+    static member inline neg (v : vec4) : vec4 =
+        vec4.ofVector(Vector4.Negate(vec4.toVector(v)))
         
     static member inline add (a : vec4, b : vec4) : vec4 =
-        vec4(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w)
+        vec4.ofVector(Vector4.Add(vec4.toVector(a), vec4.toVector(b)))
 
-    static member inline add (a : vec4, b) : vec4 =
-        vec4(a.x + b, a.y + b, a.y + b, a.w + b)
+    static member inline add (a : vec4, b : float32) : vec4 =
+        vec4.ofVector(Vector4.Add(vec4.toVector(a), Vector4(b)))
 
-    static member inline add (a, b : vec4) : vec4 =
-        vec4(a + b.x, a + b.y, a + b.z, a + b.w)
+    static member inline add (a : float32, b : vec4) : vec4 =
+        vec4.ofVector(Vector4.Add(Vector4(a), vec4.toVector(b)))
 
     static member inline sub (a : vec4, b : vec4) : vec4 = 
-        vec4(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w)
+        vec4.ofVector(Vector4.Subtract(vec4.toVector(a), vec4.toVector(b)))
 
-    static member inline sub (a : vec4, b) : vec4 = 
-        vec4(a.x - b, a.y - b, a.z - b, a.w - b)
+    static member inline sub (a : vec4, b : float32) : vec4 = 
+        vec4.ofVector(Vector4.Subtract(vec4.toVector(a), Vector4(b)))
 
-    static member inline sub (a, b : vec4) : vec4 = 
-        vec4(a - b.x, a - b.y, a - b.z, a - b.w)
+    static member inline sub (a : float32, b : vec4) : vec4 = 
+        vec4.ofVector(Vector4.Subtract(Vector4(a), vec4.toVector(b)))
 
     static member inline mul (a : vec4, b : vec4) : vec4 =
-        vec4(a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w)
+        vec4.ofVector(Vector4.Multiply(vec4.toVector(a), vec4.toVector(b)))
 
-    static member inline mul (a : vec4, b) : vec4 =
-        vec4(a.x * b, a.y * b, a.z * b, a.w * b)
+    static member inline mul (a : vec4, b : float32) : vec4 =
+        vec4.ofVector(Vector4.Multiply(vec4.toVector(a), b))
         
-    static member inline mul (a, b : vec4) : vec4 =
-        vec4(a * b.x, a * b.y, a * b.z, a * b.w)
+    static member inline mul (a : float32, b : vec4) : vec4 =
+        vec4.ofVector(Vector4.Multiply(a, vec4.toVector(b)))
 
     static member inline div (a : vec4, b : vec4) : vec4 = 
-        vec4(a.x / b.x, a.y / b.y, a.z / b.z, a.w / b.w)
+        vec4.ofVector(Vector4.Divide(vec4.toVector(a), vec4.toVector(b)))
 
-    static member inline div (a : vec4, b) : vec4 = 
-        vec4(a.x / b, a.y / b, a.z / b, a.w / b)
+    static member inline div (a : vec4, b : float32) : vec4 = 
+        vec4.ofVector(Vector4.Divide(vec4.toVector(a), b))
 
-    static member inline div (a, b : vec4) : vec4 = 
-        vec4(a / b.x, a / b.y, a / b.z, a / b.w)
+    static member inline div (a : float32, b : vec4) : vec4 = 
+        vec4.ofVector(Vector4.Divide(Vector4(a), vec4.toVector(b)))
 
     static member inline dot (a : vec4, b : vec4) =
-        a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w
+        Vector4.Dot(vec4.toVector(a), vec4.toVector(b))
 
     static member inline lengthsquared (v : vec4) =
-        vec4.dot(v, v)
+        vec4.toVector(v).LengthSquared()
 
     static member inline length (v : vec4) =
-        sqrt(vec4.lengthsquared(v))
+        vec4.toVector(v).Length()
 
     static member inline distance (a : vec4, b : vec4) =
-        vec4.length(vec4.sub(a, b))
+        Vector4.Distance(vec4.toVector(a), vec4.toVector(b))
 
     static member inline distancesquared (a : vec4, b : vec4) =
-        vec4.lengthsquared(vec4.sub(a, b))
+        Vector4.DistanceSquared(vec4.toVector(a), vec4.toVector(b))
 
     static member inline reflect (v : vec4, n : vec4) : vec4 =
         vec4.sub(v, vec4.mul(n, 2.0f * vec4.dot(v, n)))
@@ -258,9 +273,8 @@ type vec4 =
         let lsqr = vec4.lengthsquared(v)
         match lsqr with
         | 0.0f | 1.0f -> v
-        | _           ->
-            let l = 1.0f / sqrt(lsqr)
-            vec4(v.x * l, v.y * l, v.z * l, v.w * l)
+        | _           -> vec4.ofVector(Vector4.Multiply(vec4.toVector(v), 1.0f / sqrt(lsqr)))
+
 
     override this.ToString() : string = 
         "vec4(" + this.x.ToString() + ", " + this.y.ToString() + ", " + this.z.ToString() + ", " + this.w.ToString() + ")"
@@ -282,53 +296,216 @@ type quat =
             { x = x; y = y; z = z; w = w; }
     end
 
+    static member inline toQuaternion (q : quat) : Quaternion =
+        Unsafe.BitCast<quat, Quaternion>(q)
+
+    static member inline ofQuaternion (q : Quaternion) : quat =
+        Unsafe.BitCast<Quaternion, quat>(q)
+
+    static member inline toVector (q : quat) : Vector4 =
+        Unsafe.BitCast<quat, Vector4>(q)
+
+    static member inline ofVector (v : Vector4) : quat =
+        Unsafe.BitCast<Vector4, quat>(v)
+
     static member inline neg (v : quat) : quat = 
-        quat(-v.x, -v.y, -v.z, -v.w)
+        quat.ofVector(Vector4.Negate(quat.toVector(v)))
         
     static member inline add (a : quat, b : quat) : quat =
-        quat(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w)
+        quat.ofVector(Vector4.Add(quat.toVector(a), quat.toVector(b)))
 
-    static member inline add (a : quat, b) : quat =
-        quat(a.x + b, a.y + b, a.y + b, a.w + b)
+    static member inline add (a : quat, b : float32) : quat =
+        quat.ofVector(Vector4.Add(quat.toVector(a), Vector4(b)))
 
-    static member inline add (a, b : quat) : quat =
-        quat(a + b.x, a + b.y, a + b.z, a + b.w)
+    static member inline add (a : float32, b : quat) : quat =
+        quat.ofVector(Vector4.Add(Vector4(a), quat.toVector(b)))
 
     static member inline sub (a : quat, b : quat) : quat = 
-        quat(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w)
+        quat.ofVector(Vector4.Subtract(quat.toVector(a), quat.toVector(b)))
 
-    static member inline sub (a : quat, b) : quat = 
-        quat(a.x - b, a.y - b, a.z - b, a.w - b)
+    static member inline sub (a : quat, b : float32) : quat = 
+        quat.ofVector(Vector4.Subtract(quat.toVector(a), Vector4(b)))
 
-    static member inline sub (a, b : quat) : quat = 
-        quat(a - b.x, a - b.y, a - b.z, a - b.w)
+    static member inline sub (a : float32, b : quat) : quat = 
+        quat.ofVector(Vector4.Subtract(Vector4(a), quat.toVector(b)))
 
-    static member inline mul (a : quat, b) : quat =
-        quat(a.x * b, a.y * b, a.z * b, a.w * b)
+    static member inline mul (a : quat, b : float32) : quat =
+        quat.ofVector(Vector4.Multiply(quat.toVector(a), b))
         
-    static member inline mul (a, b : quat) : quat =
-        quat(a * b.x, a * b.y, a * b.z, a * b.w)
+    static member inline mul (a : float32, b : quat) : quat =
+        quat.ofVector(Vector4.Multiply(a, quat.toVector(b)))
 
-    static member inline div (a : quat, b) : quat = 
-        quat(a.x / b, a.y / b, a.z / b, a.w / b)
+    static member inline div (a : quat, b : float32) : quat = 
+        quat.ofVector(Vector4.Divide(quat.toVector(a), b))
 
-    static member inline div (a, b : quat) : quat = 
-        quat(a / b.x, a / b.y, a / b.z, a / b.w)
+    static member inline div (a : float32, b : quat) : quat = 
+        quat.ofVector(Vector4.Divide(Vector4(a), quat.toVector(b)))
 
+    /// Hamilton product, rotate by b then by a
     static member inline mul (a : quat, b : quat) : quat =
-        quat(a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w)
+        quat.ofQuaternion(Quaternion.Multiply(quat.toQuaternion(a), quat.toQuaternion(b)))
 
     static member inline normalize (v : quat) : quat =
-        let lsqr = v.x * v.x + v.y * v.y + v.z * v.z + v.w * v.w
+        let lsqr = quat.toVector(v).LengthSquared()
         match lsqr with
         | 0.0f | 1.0f -> v
-        | _           ->
-            let l = 1.0f / sqrt(lsqr)
-            quat(v.x * l, v.y * l, v.z * l, v.w * l)
+        | _           -> quat.ofVector(Vector4.Multiply(quat.toVector(v), 1.0f / sqrt(lsqr)))
 
     override this.ToString() : string = 
         "quat(" + this.x.ToString() + ", " + this.y.ToString() + ", " + this.z.ToString() + ", " + this.w.ToString() + ")"
 
+/// Matrix 4x4 with the memory layout of vmath.h mat4_t and System.Numerics.Matrix4x4:
+/// m00 m01 m02 m03 is the first column of a column-vector matrix (the first row of Matrix4x4),
+/// so Matrix4x4 kernels work on it directly with multiplications in the reverse order.
+type mat4 =
+    struct
+        val m00 : float32
+        val m01 : float32
+        val m02 : float32
+        val m03 : float32
+        val m10 : float32
+        val m11 : float32
+        val m12 : float32
+        val m13 : float32
+        val m20 : float32
+        val m21 : float32
+        val m22 : float32
+        val m23 : float32
+        val m30 : float32
+        val m31 : float32
+        val m32 : float32
+        val m33 : float32
+
+        new (s : float32) =
+            mat4(s, 0.0f, 0.0f, 0.0f,
+                 0.0f, s, 0.0f, 0.0f,
+                 0.0f, 0.0f, s, 0.0f,
+                 0.0f, 0.0f, 0.0f, s)
+
+        new (m00 : float32, m01 : float32, m02 : float32, m03 : float32,
+             m10 : float32, m11 : float32, m12 : float32, m13 : float32,
+             m20 : float32, m21 : float32, m22 : float32, m23 : float32,
+             m30 : float32, m31 : float32, m32 : float32, m33 : float32) =
+            { m00 = m00; m01 = m01; m02 = m02; m03 = m03;
+              m10 = m10; m11 = m11; m12 = m12; m13 = m13;
+              m20 = m20; m21 = m21; m22 = m22; m23 = m23;
+              m30 = m30; m31 = m31; m32 = m32; m33 = m33; }
+    end
+
+    static member inline toMatrix (m : mat4) : Matrix4x4 =
+        Unsafe.BitCast<mat4, Matrix4x4>(m)
+
+    static member inline ofMatrix (m : Matrix4x4) : mat4 =
+        Unsafe.BitCast<Matrix4x4, mat4>(m)
+
+    static member identity : mat4 =
+        mat4(1.0f)
+
+    static member inline translate (v : vec3) : mat4 =
+        mat4.ofMatrix(Matrix4x4.CreateTranslation(vec3.toVector(v)))
+
+    static member inline scale (v : vec3) : mat4 =
+        mat4.ofMatrix(Matrix4x4.CreateScale(vec3.toVector(v)))
+
+    static member inline rotate (q : quat) : mat4 =
+        mat4.ofMatrix(Matrix4x4.CreateFromQuaternion(quat.toQuaternion(q)))
+
+    static member inline neg (m : mat4) : mat4 =
+        mat4.ofMatrix(Matrix4x4.Negate(mat4.toMatrix(m)))
+
+    static member inline add (a : mat4, b : mat4) : mat4 =
+        mat4.ofMatrix(Matrix4x4.Add(mat4.toMatrix(a), mat4.toMatrix(b)))
+
+    static member inline sub (a : mat4, b : mat4) : mat4 =
+        mat4.ofMatrix(Matrix4x4.Subtract(mat4.toMatrix(a), mat4.toMatrix(b)))
+
+    /// a * b, apply b then a
+    static member inline mul (a : mat4, b : mat4) : mat4 =
+        mat4.ofMatrix(Matrix4x4.Multiply(mat4.toMatrix(b), mat4.toMatrix(a)))
+
+    static member inline mul (m : mat4, v : vec4) : vec4 =
+        vec4.ofVector(Vector4.Transform(vec4.toVector(v), mat4.toMatrix(m)))
+
+    static member inline mul (m : mat4, s : float32) : mat4 =
+        mat4.ofMatrix(Matrix4x4.Multiply(mat4.toMatrix(m), s))
+
+    /// (m * vec4(p, 1)).xyz, no perspective divide
+    static member inline transform (m : mat4, p : vec3) : vec3 =
+        vec3.ofVector(Vector3.Transform(vec3.toVector(p), mat4.toMatrix(m)))
+
+    static member inline transpose (m : mat4) : mat4 =
+        mat4.ofMatrix(Matrix4x4.Transpose(mat4.toMatrix(m)))
+
+    /// Inverse, or a matrix of NaN when m is singular
+    static member inline inverse (m : mat4) : mat4 =
+        let mutable r = Matrix4x4()
+        Matrix4x4.Invert(mat4.toMatrix(m), &r) |> ignore
+        mat4.ofMatrix(r)
+
+    override this.ToString() : string = 
+        "mat4(" + this.m00.ToString() + ", " + this.m01.ToString() + ", " + this.m02.ToString() + ", " + this.m03.ToString() + ", "
+                + this.m10.ToString() + ", " + this.m11.ToString() + ", " + this.m12.ToString() + ", " + this.m13.ToString() + ", "
+                + this.m20.ToString() + ", " + this.m21.ToString() + ", " + this.m22.ToString() + ", " + this.m23.ToString() + ", "
+                + this.m30.ToString() + ", " + this.m31.ToString() + ", " + this.m32.ToString() + ", " + this.m33.ToString() + ")"
+
+/// Batches over packed float32[] buffers (x y z per point, no padding).
+/// Work is cut in chunks of Array.ChunkPoints points which run on the thread pool,
+/// smaller buffers stay on the calling thread.
+module Array =
+    [<Literal>]
+    let ChunkPoints = 65536
+
+    /// Run body start count over [0, count) in chunks, in parallel when there is more than one
+    let inline forChunks (count : int) ([<InlineIfLambda>] body : int -> int -> unit) =
+        if count <= ChunkPoints then
+            body 0 count
+        else
+            let chunks = (count + ChunkPoints - 1) / ChunkPoints
+            Parallel.For(0, chunks, fun c ->
+                let start = c * ChunkPoints
+                body start (min ChunkPoints (count - start))) |> ignore
+
+    /// Number of points in a packed buffer
+    let inline pointCount (buffer : float32[]) =
+        if buffer.Length % 3 <> 0 then
+            raise (ArgumentException("Length of a point buffer must be a multiple of 3"))
+        buffer.Length / 3
+
+    /// result.[3i..3i+2] = f (points.[3i..3i+2]), result may be points
+    let inline mapVec3Into ([<InlineIfLambda>] f : vec3 -> vec3) (points : float32[]) (result : float32[]) =
+        let count = pointCount points
+        if result.Length < points.Length then
+            raise (ArgumentException("Result buffer is shorter than points"))
+        forChunks count (fun start n ->
+            let src = MemoryMarshal.Cast<float32, vec3>(ReadOnlySpan<float32>(points, 3 * start, 3 * n))
+            let dst = MemoryMarshal.Cast<float32, vec3>(Span<float32>(result, 3 * start, 3 * n))
+            for i in 0 .. n - 1 do
+                dst.[i] <- f src.[i])
+
+    /// Apply f to every point of a packed buffer
+    let inline mapVec3 ([<InlineIfLambda>] f : vec3 -> vec3) (points : float32[]) : float32[] =
+        let result = Array.zeroCreate<float32> points.Length
+        mapVec3Into f points result
+        result
+
+    /// result = (m * vec4(p, 1)).xyz for every point, no perspective divide, result may be points
+    let transformPointsInto (m : mat4) (points : float32[]) (result : float32[]) =
+        let matrix = mat4.toMatrix(m)
+        let count  = pointCount points
+        if result.Length < points.Length then
+            raise (ArgumentException("Result buffer is shorter than points"))
+        forChunks count (fun start n ->
+            let src = MemoryMarshal.Cast<float32, Vector3>(ReadOnlySpan<float32>(points, 3 * start, 3 * n))
+            let dst = MemoryMarshal.Cast<float32, Vector3>(Span<float32>(result, 3 * start, 3 * n))
+            for i in 0 .. n - 1 do
+                dst.[i] <- Vector3.Transform(src.[i], matrix))
+
+    /// Transform every point of a packed buffer, no perspective divide
+    let transformPoints (m : mat4) (points : float32[]) : float32[] =
+        let result = Array.zeroCreate<float32> points.Length
+        transformPointsInto m points result
+        result
+
 let inline neg x            = (^T : (static member neg : ^T -> ^T) (x))
 let inline add a b          = (^T : (static member add : ^T -> ^U -> ^V) (a, b))
 let inline sub a b          = (^T : (static member sub : ^T -> ^U -> ^V) (a, b))
@@ -0,0 +1,117 @@
+module vmath_native
+
+open System
+open System.Runtime.InteropServices
+
+// Batch kernels of libvmath (vmath_native.h), build it with: make -C test libvmath
+// vmath.vec3, vec4 and quat are blittable and match the packed layout of the C ABI,
+// spans are pinned and passed by reference, nothing is copied or marshalled.
+// Matrices are 16 floats in mat4_t data order, dual quaternions are 8 floats.
+
+[<Literal>]
+let Library = "vmath"
+
+[<Literal>]
+let AbiVersion = 1
+
+module private imports =
+    [<DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)>]
+    extern int vmath_native_abi_version()
+
+    [<DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)>]
+    extern void vmath_native_transform_points(float32& m, vmath.vec3& points, vmath.vec3& result, int count)
+
+    [<DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)>]
+    extern void vmath_native_transform_vectors(float32& m, vmath.vec4& vectors, vmath.vec4& result, int count)
+
+    [<DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)>]
+    extern void vmath_native_compose_trs(float32& result, vmath.vec3& t, vmath.quat& r, vmath.vec3& s, int count)
+
+    [<DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)>]
+    extern void vmath_native_skin(vmath.vec3& outPositions, vmath.vec3& outNormals, vmath.vec3& positions, vmath.vec3& normals,
+                                  int& bones, float32& weights, int count, float32& palette, int boneCount)
+
+    [<DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)>]
+    extern void vmath_native_frustum_planes(float32& viewproj, vmath.vec4& planes, int depthZeroToOne)
+
+    [<DllImport(Library, CallingConvention = CallingConvention.Cdecl, ExactSpelling = true)>]
+    extern int vmath_native_cull_spheres(vmath.vec4& planes, int planeCount, vmath.vec4& spheres, int count, int& visible)
+
+let private check (length : int) (resultLength : int) =
+    if resultLength < length then
+        raise (ArgumentException("Span lengths do not match"))
+
+/// True when libvmath can be loaded and has the same ABI version
+let isAvailable =
+    lazy (
+        try
+            imports.vmath_native_abi_version() = AbiVersion
+        with
+        | :? DllNotFoundException         -> false
+        | :? EntryPointNotFoundException  -> false
+    )
+
+[<AbstractClass; Sealed>]
+type native =
+    /// result[i] = (m * vec4(points[i], 1)).xyz, no perspective divide. result may be the same span as points.
+    static member transform (m : ReadOnlySpan<float32>, points : ReadOnlySpan<vmath.vec3>, result : Span<vmath.vec3>) =
+        check 16 m.Length
+        check points.Length result.Length
+        imports.vmath_native_transform_points(
+            &MemoryMarshal.GetReference(m), &MemoryMarshal.GetReference(points), &MemoryMarshal.GetReference(result), points.Length)
+
+    /// result[i] = m * vectors[i]. result may be the same span as vectors.
+    static member transform (m : ReadOnlySpan<float32>, vectors : ReadOnlySpan<vmath.vec4>, result : Span<vmath.vec4>) =
+        check 16 m.Length
+        check vectors.Length result.Length
+        imports.vmath_native_transform_vectors(
+            &MemoryMarshal.GetReference(m), &MemoryMarshal.GetReference(vectors), &MemoryMarshal.GetReference(result), vectors.Length)
+
+    /// result[16 * i ..] = translate(t[i]) * rotate(r[i]) * scale(s[i])
+    static member composetrs (t : ReadOnlySpan<vmath.vec3>, r : ReadOnlySpan<vmath.quat>, s : ReadOnlySpan<vmath.vec3>, result : Span<float32>) =
+        if r.Length <> t.Length || s.Length <> t.Length then
+            raise (ArgumentException("Span lengths do not match"))
+        check (16 * t.Length) result.Length
+        imports.vmath_native_compose_trs(
+            &MemoryMarshal.GetReference(result),
+            &MemoryMarshal.GetReference(t), &MemoryMarshal.GetReference(r), &MemoryMarshal.GetReference(s), t.Length)
+
+    /// Dual quaternion skinning with 4 bones per vertex, palette is 8 floats per bone.
+    /// normals and outNormals can be empty to skip normals.
+    static member skin (positions : ReadOnlySpan<vmath.vec3>, normals : ReadOnlySpan<vmath.vec3>,
+                        bones : ReadOnlySpan<int>, weights : ReadOnlySpan<float32>, palette : ReadOnlySpan<float32>,
+                        outPositions : Span<vmath.vec3>, outNormals : Span<vmath.vec3>) =
+        let count = positions.Length
+        check count outPositions.Length
+        check (4 * count) bones.Length
+        check (4 * count) weights.Length
+        if palette.Length % 8 <> 0 then
+            raise (ArgumentException("Length of a dual quaternion palette must be a multiple of 8"))
+
+        let hasNormals = not normals.IsEmpty && not outNormals.IsEmpty
+        if hasNormals then
+            check count normals.Length
+            check count outNormals.Length
+
+        // A default span is a null reference, which is passed as NULL
+        let normals    = if hasNormals then normals else ReadOnlySpan<vmath.vec3>()
+        let outNormals = if hasNormals then outNormals else Span<vmath.vec3>()
+        imports.vmath_native_skin(
+            &MemoryMarshal.GetReference(outPositions), &MemoryMarshal.GetReference(outNormals),
+            &MemoryMarshal.GetReference(positions), &MemoryMarshal.GetReference(normals),
+            &MemoryMarshal.GetReference(bones), &MemoryMarshal.GetReference(weights), count,
+            &MemoryMarshal.GetReference(palette), palette.Length / 8)
+
+    /// Normalized planes of a view-projection matrix: left, right, bottom, top, near, far
+    static member frustumplanes (viewproj : ReadOnlySpan<float32>, planes : Span<vmath.vec4>, depthZeroToOne : bool) =
+        check 16 viewproj.Length
+        check 6 planes.Length
+        imports.vmath_native_frustum_planes(
+            &MemoryMarshal.GetReference(viewproj), &MemoryMarshal.GetReference(planes), (if depthZeroToOne then 1 else 0))
+
+    /// Write indices of spheres (xyz center, w radius) inside or intersecting all planes, return their count
+    static member cullspheres (planes : ReadOnlySpan<vmath.vec4>, spheres : ReadOnlySpan<vmath.vec4>, visible : Span<int>) : int =
+        check spheres.Length visible.Length
+        imports.vmath_native_cull_spheres(
+            &MemoryMarshal.GetReference(planes), planes.Length,
+            &MemoryMarshal.GetReference(spheres), spheres.Length, &MemoryMarshal.GetReference(visible))
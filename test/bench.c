@@ -0,0 +1,1731 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../vmath.h"
+#include "../vmath_noise.h"
+#include "../vmath_random.h"
+#include "../vmath_spline.h"
+#include "../vmath_anim.h"
+#include "../vmath_color.h"
+#include "../vmath_reduce.h"
+
+#define VMATH_IMPL
+#include "../vmath_jobs.h"
+#include "../vmath_memory.h"
+#include "../vmath_file.h"
+#include "../vmath_text.h"
+#include "../vmath_solve.h"
+#include "../vmath_svd.h"
+#include "../vmath_rotation.h"
+#include "../vmath_geometry.h"
+#include "../vmath_gjk.h"
+#include "../vmath_expr.h"
+#include "../vmath_transform.h"
+#include "../vmath_gpu.h"
+#include "../vmath_spatial.h"
+
+#define countof(x) (sizeof(x) / sizeof((x)[0]))
+
+#define BENCH_COUNT (1 << 16)
+
+static float bench_x[BENCH_COUNT];
+static float bench_y[BENCH_COUNT];
+static float bench_z[BENCH_COUNT];
+static float bench_w[BENCH_COUNT];
+static float bench_out[BENCH_COUNT];
+
+static double bench_seconds(void)
+{
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+/* Wall time, clock() sum the time of all threads */
+static double bench_wallseconds(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (double)counter.QuadPart / frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+static void bench_report(const char* name, double items, double seconds)
+{
+    printf("%-32s %10.2f M/s\n", name, items / seconds * 1e-6);
+}
+
+static void bench_report_bytes(const char* name, double bytes, double seconds)
+{
+    printf("%-32s %10.2f GB/s\n", name, bytes / seconds * 1e-9);
+}
+
+static void bench_noise(void)
+{
+    static const struct
+    {
+        const char* name;
+        int         basis;
+        int         dims;
+    } cases[] = {
+        { "noise perlin 2d",  NOISE_PERLIN,  2 },
+        { "noise perlin 3d",  NOISE_PERLIN,  3 },
+        { "noise perlin 4d",  NOISE_PERLIN,  4 },
+        { "noise simplex 2d", NOISE_SIMPLEX, 2 },
+        { "noise simplex 3d", NOISE_SIMPLEX, 3 },
+        { "noise simplex 4d", NOISE_SIMPLEX, 4 },
+        { "noise value 3d",   NOISE_VALUE,   3 },
+    };
+
+    int i, k, rounds = 0;
+    for (i = 0; i < countof(cases); i++)
+    {
+        const noise_desc_t desc = noise_desc(cases[i].basis, NOISE_FRACTAL_NONE, 1);
+        const double start = bench_seconds();
+        double now;
+
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            switch (cases[i].dims)
+            {
+            case 2:  noise_batch2(&desc, bench_out, bench_x, bench_y, BENCH_COUNT, NULL, NULL); break;
+            case 3:  noise_batch3(&desc, bench_out, bench_x, bench_y, bench_z, BENCH_COUNT, NULL, NULL, NULL); break;
+            default: noise_batch4(&desc, bench_out, bench_x, bench_y, bench_z, bench_w, BENCH_COUNT, NULL, NULL, NULL, NULL); break;
+            }
+        }
+
+        bench_report(cases[i].name, (double)rounds * BENCH_COUNT, now - start);
+    }
+
+    for (k = 0; k < 2; k++)
+    {
+        const noise_desc_t desc = noise_desc(NOISE_SIMPLEX, k ? NOISE_FRACTAL_RIDGED : NOISE_FRACTAL_FBM, 5);
+        const double start = bench_seconds();
+        double now;
+
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            noise_batch3(&desc, bench_out, bench_x, bench_y, bench_z, BENCH_COUNT, NULL, NULL, NULL);
+        }
+
+        bench_report(k ? "noise simplex 3d ridged x5" : "noise simplex 3d fbm x5", (double)rounds * BENCH_COUNT, now - start);
+    }
+}
+
+static void bench_random(void)
+{
+    static vec3_t dirs[BENCH_COUNT];
+    static const char* names[] = { "random sphere", "random ball", "random cone", "random hemisphere" };
+
+    random_t rng = random_seed(1);
+    int kind, rounds;
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            random_fill_float(&rng, bench_out, BENCH_COUNT, 0.0f, 1.0f);
+        }
+        bench_report("random float", (double)rounds * BENCH_COUNT, now - start);
+    }
+
+    for (kind = RANDOM_SPHERE; kind <= RANDOM_HEMISPHERE; kind++)
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            random_fill3_soa(&rng, bench_x, bench_y, bench_z, BENCH_COUNT, kind, vec3(0, 1, 0), 0.5f);
+        }
+        bench_report(names[kind], (double)rounds * BENCH_COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            random_fill_sphere(&rng, dirs, BENCH_COUNT);
+        }
+        bench_report("random sphere (AoS)", (double)rounds * BENCH_COUNT, now - start);
+    }
+}
+
+static void bench_spline(void)
+{
+    /* Every curve use the shuffled inputs as control points */
+    const float* cx[4] = { bench_x, bench_y, bench_z, bench_w };
+    const float* cy[4] = { bench_y, bench_z, bench_w, bench_x };
+    const float* cz[4] = { bench_z, bench_w, bench_x, bench_y };
+    static float t[BENCH_COUNT], ox[BENCH_COUNT], oy[BENCH_COUNT];
+
+    const double start = bench_seconds();
+    double now;
+    int i, rounds;
+
+    for (i = 0; i < BENCH_COUNT; i++)
+    {
+        t[i] = (float)i / BENCH_COUNT;
+    }
+
+    for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+    {
+        spline_batch3(SPLINE_CATMULLROM, 0, cx, cy, cz, t, ox, oy, bench_out, BENCH_COUNT);
+    }
+    bench_report("spline catmull-rom 3d", (double)rounds * BENCH_COUNT, now - start);
+}
+
+static void bench_anim(void)
+{
+    enum { KEYS = 64, TRACKS = 24, INSTANCES = 10000 };
+
+    static float        times[KEYS];
+    static short        keys[TRACKS * KEYS * 4];
+    static anim_track_t tracks[TRACKS];
+    static int          cursors[INSTANCES * TRACKS];
+    static vec4_t       out[INSTANCES * TRACKS];
+    static float        playtime[INSTANCES];
+
+    const anim_clip_t clip = { (float)(KEYS - 1), TRACKS, tracks };
+    int i, frames;
+
+    for (i = 0; i < KEYS; i++)
+    {
+        times[i] = (float)i;
+    }
+    for (i = 0; i < TRACKS; i++)
+    {
+        tracks[i].type   = i < TRACKS / 2 ? ANIM_TRACK_VEC3 : ANIM_TRACK_QUAT;
+        tracks[i].format = ANIM_KEY_FLOAT;
+        tracks[i].count  = KEYS;
+        tracks[i].times  = times;
+        tracks[i].values = bench_x + i * KEYS;
+    }
+    for (i = 0; i < INSTANCES; i++)
+    {
+        playtime[i] = (float)(i % KEYS);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (frames = 0; (now = bench_seconds()) - start < 0.5; frames++)
+        {
+            /* Forward playback at 60Hz, wrap at the end of clip */
+            for (i = 0; i < INSTANCES; i++)
+            {
+                playtime[i] += 1.0f / 60.0f;
+                playtime[i]  = playtime[i] >= clip.duration ? 0.0f : playtime[i];
+            }
+            anim_sample_instances(&clip, playtime, INSTANCES, cursors, out);
+        }
+        bench_report("anim tracks (10k characters)", (double)frames * INSTANCES * TRACKS, now - start);
+    }
+
+    for (i = 0; i < TRACKS; i++)
+    {
+        anim_quantize(bench_x + i * KEYS, KEYS, keys + i * KEYS * 4, &tracks[i].offset, &tracks[i].scale);
+        tracks[i].format = ANIM_KEY_INT16;
+        tracks[i].values = keys + i * KEYS * 4;
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (frames = 0; (now = bench_seconds()) - start < 0.5; frames++)
+        {
+            anim_sample_instances(&clip, playtime, INSTANCES, cursors, out);
+        }
+        bench_report("anim tracks int16 keys", (double)frames * INSTANCES * TRACKS, now - start);
+    }
+}
+
+static void bench_color(void)
+{
+    static const struct
+    {
+        const char* name;
+        int         op;
+    } cases[] = {
+        { "color srgb to linear",      COLOR_SRGB_TO_LINEAR      },
+        { "color srgb to linear fast", COLOR_SRGB_TO_LINEAR_FAST },
+        { "color rgb to hsv",          COLOR_RGB_TO_HSV          },
+        { "color tonemap aces",        COLOR_TONEMAP_ACES        },
+    };
+
+    static vec4_t        pixels[BENCH_COUNT / 4], result[BENCH_COUNT / 4];
+    static unsigned char bytes[BENCH_COUNT * 4], target[BENCH_COUNT * 4];
+
+    const int count = BENCH_COUNT / 4;
+    int i, rounds;
+
+    for (i = 0; i < count; i++)
+    {
+        pixels[i] = vec4(bench_x[i] / 256.0f + 0.5f, bench_y[i] / 256.0f + 0.5f, bench_z[i] / 256.0f + 0.5f, 1.0f);
+    }
+    for (i = 0; i < BENCH_COUNT * 4; i++)
+    {
+        bytes[i] = (unsigned char)rand();
+    }
+
+    for (i = 0; i < countof(cases); i++)
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            color_convert(result, pixels, count, cases[i].op);
+        }
+        bench_report_bytes(cases[i].name, (double)rounds * count * sizeof(vec4_t), now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            color_blend8(target, bytes, BENCH_COUNT, COLOR_BLEND_SRC_OVER);
+        }
+        bench_report_bytes("color blend rgba8 src over", (double)rounds * BENCH_COUNT * 4, now - start);
+    }
+}
+
+static void bench_jobs(void)
+{
+    enum { COUNT = 1 << 20 };
+
+    static vec3_t points[COUNT], result[COUNT];
+    static quat_t rotations[COUNT / 4];
+    static mat4_t matrices[COUNT / 4];
+
+    const mat4_t m = mat4_mul(mat4_rotatex(0.5f), mat4_translate3f(1.0f, 2.0f, 3.0f));
+    int i, threads, max_threads, rounds;
+
+    for (i = 0; i < COUNT; i++)
+    {
+        points[i] = vec3(bench_x[i % BENCH_COUNT], bench_y[i % BENCH_COUNT], bench_z[(i * 7) % BENCH_COUNT]);
+    }
+    for (i = 0; i < COUNT / 4; i++)
+    {
+        rotations[i] = quat_normalize(quat(bench_x[i % BENCH_COUNT], bench_y[i % BENCH_COUNT], bench_z[i % BENCH_COUNT], bench_w[i % BENCH_COUNT]));
+    }
+
+    /* Scale by thread count: 1, 2, 4, ... all cores */
+    vmath_jobs_init(0);
+    max_threads = vmath_jobs_threads();
+    vmath_jobs_shutdown();
+
+    for (threads = 1;; threads = threads * 2 < max_threads ? threads * 2 : max_threads)
+    {
+        char name[64];
+        vmath_jobs_init(threads);
+
+        {
+            const double start = bench_wallseconds();
+            double now;
+            for (rounds = 0; (now = bench_wallseconds()) - start < 0.25; rounds++)
+            {
+                mat4_transformpoints_mt(&m, result, points, COUNT);
+            }
+            sprintf(name, "jobs transform points x%d", threads);
+            bench_report(name, (double)rounds * COUNT, now - start);
+        }
+
+        {
+            const double start = bench_wallseconds();
+            double now;
+            for (rounds = 0; (now = bench_wallseconds()) - start < 0.25; rounds++)
+            {
+                vec3_normalizearray_mt(result, points, COUNT);
+            }
+            sprintf(name, "jobs normalize x%d", threads);
+            bench_report(name, (double)rounds * COUNT, now - start);
+        }
+
+        {
+            const double start = bench_wallseconds();
+            double now;
+            for (rounds = 0; (now = bench_wallseconds()) - start < 0.25; rounds++)
+            {
+                mat4_composetrs_mt(matrices, points, rotations, points + COUNT / 4, COUNT / 4);
+            }
+            sprintf(name, "jobs compose trs x%d", threads);
+            bench_report(name, (double)rounds * (COUNT / 4), now - start);
+        }
+
+        {
+            const double start = bench_wallseconds();
+            double now;
+            vec3_t lo, hi;
+            for (rounds = 0; (now = bench_wallseconds()) - start < 0.25; rounds++)
+            {
+                vec3_bounds_mt(points, COUNT, &lo, &hi);
+            }
+            sprintf(name, "jobs bounds x%d", threads);
+            bench_report(name, (double)rounds * COUNT, now - start);
+        }
+
+        {
+            const double start = bench_wallseconds();
+            double now;
+            vmath_reduce_t result;
+            for (rounds = 0; (now = bench_wallseconds()) - start < 0.25; rounds++)
+            {
+                vmath_reduce_mt(points, COUNT, VMATH_REDUCE_ALL, &result);
+            }
+            sprintf(name, "jobs reduce all x%d", threads);
+            bench_report(name, (double)rounds * COUNT, now - start);
+        }
+
+        {
+            static uint32_t keys[COUNT], sorted[COUNT];
+            static int      order[COUNT];
+            const vmath_grid_t grid = vmath_grid(vec3(-128.0f, -128.0f, -128.0f), vec3(128.0f, 128.0f, 128.0f));
+            const double start = bench_wallseconds();
+            double now;
+            vmath_morton30_array(keys, points, COUNT, &grid);
+            for (rounds = 0; (now = bench_wallseconds()) - start < 0.25; rounds++)
+            {
+                memcpy(sorted, keys, sizeof(keys));
+                vmath_radix_sort32(sorted, order, COUNT);
+            }
+            sprintf(name, "jobs radix sort x%d", threads);
+            bench_report(name, (double)rounds * COUNT, now - start);
+        }
+
+        vmath_jobs_shutdown();
+        if (threads == max_threads)
+        {
+            break;
+        }
+    }
+}
+
+static void bench_memory(void)
+{
+    enum { BUFFERS = 64, NODES = 1024 };
+
+    static void*  buffers[BUFFERS];
+    static size_t sizes[BUFFERS];
+
+    vmath_arena_t        arena;
+    vmath_pool_t         pool;
+    vmath_memory_stats_t before, after;
+    int i, rounds;
+
+    /* A frame of temporary batch buffers, 16 to 1024 points */
+    for (i = 0; i < BUFFERS; i++)
+    {
+        sizes[i] = (16 + rand() % 1009) * sizeof(vec3_t);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            for (i = 0; i < BUFFERS; i++)
+            {
+                buffers[i] = malloc(sizes[i]);
+                ((char*)buffers[i])[0] = (char)i;
+            }
+            for (i = 0; i < BUFFERS; i++)
+            {
+                free(buffers[i]);
+            }
+        }
+        bench_report("memory malloc/free", (double)rounds * BUFFERS, now - start);
+    }
+
+    vmath_arena_init(&arena, BUFFERS * 1024 * sizeof(vec3_t));
+    before = vmath_memory_stats();
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            vmath_arena_reset(&arena);
+            for (i = 0; i < BUFFERS; i++)
+            {
+                buffers[i] = vmath_arena_alloc(&arena, sizes[i], VMATH_MEMORY_ALIGN);
+                ((char*)buffers[i])[0] = (char)i;
+            }
+        }
+        bench_report("memory frame arena", (double)rounds * BUFFERS, now - start);
+    }
+    vmath_arena_free(&arena);
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            const size_t mark = vmath_scratch_begin();
+            for (i = 0; i < BUFFERS / 4; i++)
+            {
+                buffers[i] = vmath_scratch_alloc(sizes[i]);
+                ((char*)buffers[i])[0] = (char)i;
+            }
+            vmath_scratch_end(mark);
+        }
+        bench_report("memory scratch", (double)rounds * (BUFFERS / 4), now - start);
+    }
+    vmath_scratch_release();
+
+    vmath_pool_init(&pool, sizeof(mat4_t) * 2, NODES);
+    {
+        static void* nodes[NODES];
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            for (i = 0; i < NODES; i++)
+            {
+                nodes[i] = vmath_pool_alloc(&pool);
+            }
+            for (i = NODES - 1; i >= 0; i -= 2)
+            {
+                vmath_pool_release(&pool, nodes[i]);
+            }
+            for (i = NODES - 2; i >= 0; i -= 2)
+            {
+                vmath_pool_release(&pool, nodes[i]);
+            }
+        }
+        bench_report("memory pool nodes", (double)rounds * NODES, now - start);
+    }
+    vmath_pool_free(&pool);
+
+    /* Heap calls made by the arena, scratch and pool runs */
+    after = vmath_memory_stats();
+    printf("%-32s %10ld allocs\n", "memory heap allocs", after.allocs - before.allocs);
+}
+
+/* Size of the file of bench_file, set to some GB to go past the page cache */
+#ifndef BENCH_FILE_BYTES
+#define BENCH_FILE_BYTES (256ull << 20)
+#endif
+
+static void bench_file(void)
+{
+    enum { BLOCK = 1 << 16 };
+
+    const char*    path  = "bench_file.bin";
+    const uint64_t count = BENCH_FILE_BYTES / sizeof(vec4_t);
+    vec4_t*        block = (vec4_t*)vmath_aligned_alloc(BLOCK * sizeof(vec4_t), VMATH_MEMORY_ALIGN);
+    uint64_t       i, n;
+    volatile float sum = 0.0f;
+
+    {
+        vmath_file_writer_t writer;
+        const double start = bench_wallseconds();
+        for (i = 0; i < BLOCK; i++)
+        {
+            block[i] = vec4(bench_x[i % BENCH_COUNT], bench_y[i % BENCH_COUNT], bench_z[i % BENCH_COUNT], 1.0f);
+        }
+
+        if (!vmath_file_writer_open(&writer, path))
+        {
+            printf("%-32s cannot write %s\n", "file", path);
+            vmath_aligned_free(block);
+            return;
+        }
+        vmath_file_writer_begin(&writer, VMATH_CHUNK_VEC4, VMATH_FOURCC('P', 'O', 'S', '0'));
+        for (i = 0; i < count; i += n)
+        {
+            n = count - i < BLOCK ? count - i : BLOCK;
+            vmath_file_writer_write(&writer, block, n);
+        }
+        vmath_file_writer_end(&writer);
+        vmath_file_writer_close(&writer);
+        bench_report_bytes("file streaming write", (double)count * sizeof(vec4_t), bench_wallseconds() - start);
+    }
+
+    /* Baseline: fread the whole array to a heap copy */
+    {
+        const double start = bench_wallseconds();
+        FILE*        file  = fopen(path, "rb");
+        vec4_t*      copy  = (vec4_t*)vmath_aligned_alloc(count * sizeof(vec4_t), VMATH_MEMORY_ALIGN);
+        n = 0;
+        if (file)
+        {
+            fseek(file, 2 * VMATH_FILE_ALIGN, SEEK_SET);
+            n = fread(copy, sizeof(vec4_t), (size_t)count, file);
+            fclose(file);
+        }
+        for (i = 0; i < n; i += 4096 / sizeof(vec4_t))
+        {
+            sum += copy[i].x;
+        }
+        vmath_aligned_free(copy);
+        bench_report_bytes("file fread load", (double)n * sizeof(vec4_t), bench_wallseconds() - start);
+    }
+
+    /* Map and use in place, the checksum touch every page */
+    {
+        const double start = bench_wallseconds();
+        vmath_file_t  file;
+        vmath_chunk_t chunk;
+        memset(&chunk, 0, sizeof(chunk));
+        if (vmath_file_open(&file, path))
+        {
+            if (vmath_file_chunk(&file, 0, &chunk))
+            {
+                sum += vmath_file_verify(&chunk) ? ((const vec4_t*)chunk.data)[0].x : 0.0f;
+            }
+            vmath_file_close(&file);
+        }
+        bench_report_bytes("file mmap view + verify", (double)chunk.count * sizeof(vec4_t), bench_wallseconds() - start);
+    }
+
+    {
+        const double start = bench_wallseconds();
+        vmath_file_t  file;
+        const vec4_t* points;
+        n = 0;
+        if (vmath_file_open(&file, path))
+        {
+            points = vmath_file_vec4s(&file, VMATH_FOURCC('P', 'O', 'S', '0'), &n);
+            for (i = 0; points && i < n; i += 4096 / sizeof(vec4_t))
+            {
+                sum += points[i].x;
+            }
+            vmath_file_close(&file);
+        }
+        bench_report_bytes("file mmap view", (double)n * sizeof(vec4_t), bench_wallseconds() - start);
+    }
+
+    {
+        const double start = bench_wallseconds();
+        vmath_file_reader_t reader;
+        vmath_chunk_t       chunk;
+        uint64_t            total = 0;
+        if (vmath_file_reader_open(&reader, path))
+        {
+            if (vmath_file_reader_next(&reader, &chunk))
+            {
+                while ((n = vmath_file_reader_read(&reader, block, BLOCK)) > 0)
+                {
+                    sum   += block[0].x;
+                    total += n;
+                }
+                sum += vmath_file_reader_verify(&reader) ? 0.0f : 1.0f;
+            }
+            vmath_file_reader_close(&reader);
+        }
+        bench_report_bytes("file chunked read + verify", (double)total * sizeof(vec4_t), bench_wallseconds() - start);
+    }
+
+    remove(path);
+    vmath_aligned_free(block);
+}
+
+static void bench_text(void)
+{
+    enum { COUNT = BENCH_COUNT, CHUNK = 64 * 1024 };
+
+    static vec3_t points[COUNT];
+    static float  xs[COUNT], ys[COUNT], zs[COUNT];
+    static char   text[COUNT * 40];
+
+    vmath_text_parser_t parser;
+    size_t length = 0, offset;
+    int    i, rounds;
+
+    for (i = 0; i < COUNT; i++)
+    {
+        length += sprintf(text + length, "v %.9g %.9g %.9g\n", bench_x[i], bench_y[i], bench_z[i]);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            vmath_text_init(&parser, "v", 3, COUNT);
+            vmath_text_vec3(&parser, 0, points);
+            for (offset = 0; offset < length; offset += CHUNK)
+            {
+                vmath_text_feed(&parser, text + offset, length - offset < CHUNK ? length - offset : CHUNK);
+            }
+            vmath_text_finish(&parser);
+        }
+        bench_report_bytes("text parse obj to aos", (double)rounds * length, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            vmath_text_init(&parser, "v", 3, COUNT);
+            vmath_text_soa(&parser, 0, xs);
+            vmath_text_soa(&parser, 1, ys);
+            vmath_text_soa(&parser, 2, zs);
+            for (offset = 0; offset < length; offset += CHUNK)
+            {
+                vmath_text_feed(&parser, text + offset, length - offset < CHUNK ? length - offset : CHUNK);
+            }
+            vmath_text_finish(&parser);
+        }
+        bench_report_bytes("text parse obj to soa", (double)rounds * length, now - start);
+    }
+
+    /* Baseline: strtof per number */
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            char* p = text;
+            for (i = 0; i < COUNT; i++)
+            {
+                points[i].x = strtof(p + 1, &p);
+                points[i].y = strtof(p, &p);
+                points[i].z = strtof(p, &p);
+                p++;
+            }
+        }
+        bench_report_bytes("text parse obj strtof", (double)rounds * length, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        char   line[64];
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            for (i = 0; i < COUNT; i += 16)
+            {
+                vmath_format_vec3(line, sizeof(line), points[i]);
+            }
+        }
+        bench_report("text format vec3", (double)rounds * (COUNT / 16), now - start);
+    }
+}
+
+static void bench_solve(void)
+{
+    enum { COUNT = 4096 };
+
+    static mat3_t a3[COUNT];
+    static mat4_t a4[COUNT];
+    static vec3_t b3[COUNT], x3[COUNT];
+    static vec4_t b4[COUNT], x4[COUNT];
+    static float  rcond[COUNT];
+
+    int i, j, rounds;
+
+    /* Diagonally dominant, so every method applies */
+    for (i = 0; i < COUNT; i++)
+    {
+        for (j = 0; j < 16; j++)
+        {
+            a4[i].data[j] = bench_x[(i * 16 + j) % BENCH_COUNT] / 128.0f;
+        }
+        for (j = 0; j < 4; j++)
+        {
+            a4[i].m[j][j] = 8.0f;
+        }
+        a4[i] = mat4_mul(a4[i], mat4_transpose(a4[i]));
+        for (j = 0; j < 9; j++)
+        {
+            a3[i].m[j / 3][j % 3] = a4[i].m[j / 3][j % 3];
+        }
+        b3[i] = vec3(bench_y[i], bench_z[i], bench_w[i]);
+        b4[i] = vec4(bench_y[i], bench_z[i], bench_w[i], bench_x[i]);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            for (i = 0; i < COUNT; i++)
+            {
+                x4[i] = mat4_mulv4(mat4_inverse(a4[i]), b4[i]);
+            }
+        }
+        bench_report("solve mat4 inverse", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            for (i = 0; i < COUNT; i++)
+            {
+                mat4_solve(a4[i], b4[i], &x4[i], VMATH_SOLVE_LU, 0);
+            }
+        }
+        bench_report("solve mat4 lu", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            for (i = 0; i < COUNT; i++)
+            {
+                mat4_solve(a4[i], b4[i], &x4[i], VMATH_SOLVE_QR, 0);
+            }
+        }
+        bench_report("solve mat4 qr", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            mat4_solve_batch(a4, b4, x4, rcond, COUNT, VMATH_SOLVE_LU);
+        }
+        bench_report("solve mat4 lu batch", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            mat4_solve_batch(a4, b4, x4, rcond, COUNT, VMATH_SOLVE_CHOLESKY);
+        }
+        bench_report("solve mat4 cholesky batch", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            mat3_solve_batch(a3, b3, x3, rcond, COUNT, VMATH_SOLVE_LU);
+        }
+        bench_report("solve mat3 lu batch", (double)rounds * COUNT, now - start);
+    }
+}
+
+static void bench_svd(void)
+{
+    enum { COUNT = 4096 };
+
+    static mat3_t a[COUNT], u[COUNT], v[COUNT];
+    static quat_t qu[COUNT], qv[COUNT];
+    static vec3_t s[COUNT];
+
+    int i, j, rounds;
+
+    for (i = 0; i < COUNT; i++)
+    {
+        for (j = 0; j < 9; j++)
+        {
+            a[i].data[j] = bench_x[(i * 9 + j) % BENCH_COUNT] / 128.0f;
+        }
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            for (i = 0; i < COUNT; i++)
+            {
+                mat3_svd(a[i], &u[i], &s[i], &v[i]);
+            }
+        }
+        bench_report("svd mat3", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            mat3_svd_batch(a, qu, s, qv, COUNT);
+        }
+        bench_report("svd mat3 batch", (double)rounds * COUNT, now - start);
+    }
+
+    for (i = 0; i < COUNT; i++)
+    {
+        a[i] = mat3_mul(a[i], mat3_transpose(a[i]));
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            for (i = 0; i < COUNT; i++)
+            {
+                mat3_eigensym(a[i], &s[i], &u[i]);
+            }
+        }
+        bench_report("eigensym mat3", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            mat3_eigensym_batch(a, s, qu, COUNT);
+        }
+        bench_report("eigensym mat3 batch", (double)rounds * COUNT, now - start);
+    }
+}
+
+static void bench_rotation(void)
+{
+    enum { COUNT = 4096 };
+
+    static vec3_t e[COUNT];
+    static quat_t q[COUNT];
+    static mat3_t m3[COUNT];
+    static mat4_t m4[COUNT];
+
+    int i, rounds;
+
+    for (i = 0; i < COUNT; i++)
+    {
+        e[i] = vec3(bench_x[i] / 40.0f, bench_y[i] / 40.0f, bench_z[i] / 40.0f);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            for (i = 0; i < COUNT; i++)
+            {
+                q[i] = quat_eulerv3(e[i]);
+            }
+        }
+        bench_report("rotation quat_eulerv3", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            quat_fromeuler_batch(e, q, COUNT, VMATH_EULER_ZYX);
+        }
+        bench_report("rotation fromeuler batch", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            for (i = 0; i < COUNT; i++)
+            {
+                e[i] = quat_toeuler(q[i]);
+            }
+        }
+        bench_report("rotation quat_toeuler", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            quat_toeuler_batch(q, e, COUNT, VMATH_EULER_ZYX);
+        }
+        bench_report("rotation toeuler batch", (double)rounds * COUNT, now - start);
+    }
+
+    quat_tomat3_batch(q, m3, COUNT);
+    quat_tomat4_batch(q, m4, COUNT);
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            quat_frommat3_batch(m3, q, COUNT);
+        }
+        bench_report("rotation frommat3 batch", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            quat_frommat4_batch(m4, q, COUNT);
+        }
+        bench_report("rotation frommat4 batch", (double)rounds * COUNT, now - start);
+    }
+}
+
+static void bench_geometry(void)
+{
+    enum { COUNT = 4096 };
+
+    static vec3_t            v[COUNT * 3];
+    static vmath_triangle8_t blocks[COUNT / 8];
+    static float             d[COUNT];
+
+    const vec3_t p = vec3(0.5f, -0.25f, 1.0f);
+    int          i, rounds;
+    float        sum = 0.0f;
+
+    for (i = 0; i < COUNT * 3; i++)
+    {
+        v[i] = vec3(bench_x[i % BENCH_COUNT], bench_y[(i * 7) % BENCH_COUNT], bench_z[(i * 13) % BENCH_COUNT]);
+    }
+    vmath_triangle8_pack(v, NULL, COUNT, blocks);
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            for (i = 0; i < COUNT; i++)
+            {
+                d[i] = vmath_distance2_triangle(p, v[i * 3 + 0], v[i * 3 + 1], v[i * 3 + 2]);
+            }
+        }
+        bench_report("geometry distance2_triangle", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            vmath_triangle8_distances(blocks, COUNT, p, d);
+        }
+        bench_report("geometry triangle8_distances", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            float dist2;
+            vmath_triangle8_closest(blocks, COUNT, p, NULL, &dist2);
+            sum += dist2;
+        }
+        bench_report("geometry triangle8_closest", (double)rounds * COUNT, now - start);
+    }
+
+    if (sum < 0.0f) printf("%f\n", sum);
+}
+
+static void bench_gjk(void)
+{
+    enum { COUNT = 1024, HULL = 64 };
+
+    static vec3_t         vertices[HULL];
+    static float          blocks[HULL * 3];
+    static vmath_convex_t shapes[COUNT];
+    static float          d[COUNT];
+
+    vmath_gjk_cache_t cache[COUNT];
+    vmath_hull_t      hull;
+    vmath_convex_t    box;
+    int               i, rounds;
+
+    /* Points on a sphere, all on the hull */
+    for (i = 0; i < HULL; i++)
+    {
+        const vec3_t v = vec3(bench_x[i], bench_y[i], bench_z[i]);
+        vertices[i] = vec3_mulf(v, 1.0f / sqrtf(vec3_lengthsquared(v) + 1e-6f));
+    }
+    hull.blocks = blocks;
+    hull.count  = HULL;
+    vmath_hull_pack(vertices, HULL, blocks);
+
+    box = vmath_convex_box(vec3(1.0f, 0.5f, 2.0f), vec3(0.0f, 0.0f, 0.0f), quat(0.0f, 0.0f, 0.0f, 1.0f));
+    for (i = 0; i < COUNT; i++)
+    {
+        const vec3_t p = vec3(bench_x[i] * 3.0f, bench_y[i] * 3.0f, bench_z[i] * 3.0f);
+        shapes[i] = vmath_convex_hull(&hull, p, quat_normalize(quat(bench_y[i], bench_z[i], bench_w[i], 1.0f)));
+        cache[i].count = 0;
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            for (i = 0; i < COUNT; i++)
+            {
+                d[i] = (float)vmath_hull_search(&hull, vec3(bench_x[i], bench_y[i], bench_z[i]));
+            }
+        }
+        bench_report("gjk hull_search 64", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            for (i = 0; i < COUNT; i++)
+            {
+                d[i] = vmath_gjk_distance(&box, &shapes[i], NULL, NULL, NULL);
+            }
+        }
+        bench_report("gjk distance cold", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            for (i = 0; i < COUNT; i++)
+            {
+                d[i] = vmath_gjk_distance(&box, &shapes[i], &cache[i], NULL, NULL);
+            }
+        }
+        bench_report("gjk distance warm", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            for (i = 0; i < COUNT; i++)
+            {
+                d[i] = (float)vmath_gjk_intersect(&box, &shapes[i], &cache[i]);
+            }
+        }
+        bench_report("gjk intersect warm", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            for (i = 0; i < COUNT; i++)
+            {
+                vmath_epa_penetration(&box, &shapes[i], &cache[i], NULL, &d[i], NULL, NULL);
+            }
+        }
+        bench_report("gjk epa_penetration", (double)rounds * COUNT, now - start);
+    }
+}
+
+static void bench_expr(void)
+{
+    enum { COUNT = 4096 };
+
+    static vmath_expr_t e;
+    static float        out[4][COUNT];
+    static vec3_t       p[COUNT], t[COUNT];
+
+    const float* inputs[]  = { bench_x, bench_y, bench_z, bench_y, bench_z, bench_w, bench_w };
+    float*       outputs[] = { out[0], out[1], out[2], out[3] };
+    int          i, rounds;
+
+    vmath_expr_init(&e);
+    vmath_expr_input(&e, "p", VMATH_EXPR_VEC3);
+    vmath_expr_input(&e, "t", VMATH_EXPR_VEC3);
+    vmath_expr_input(&e, "speed", VMATH_EXPR_FLOAT);
+    vmath_expr_output(&e, "r", VMATH_EXPR_VEC3);
+    vmath_expr_output(&e, "d", VMATH_EXPR_FLOAT);
+    vmath_expr_compile(&e, "dir = normalize(t - p); r = p + dir * clamp(speed, 0.0, 2.0) * 0.016; d = distance(t, p)");
+
+    for (i = 0; i < COUNT; i++)
+    {
+        p[i] = vec3(bench_x[i], bench_y[i], bench_z[i]);
+        t[i] = vec3(bench_y[i], bench_z[i], bench_w[i]);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            for (i = 0; i < COUNT; i++)
+            {
+                const vec3_t to    = vec3_sub(t[i], p[i]);
+                const float  l     = sqrtf(vec3_dot(to, to));
+                const float  speed = fminf(fmaxf(bench_w[i], 0.0f), 2.0f);
+                const vec3_t r     = vec3_add(p[i], vec3_mulf(to, speed * 0.016f / l));
+                out[0][i] = r.x;
+                out[1][i] = r.y;
+                out[2][i] = r.z;
+                out[3][i] = l;
+            }
+        }
+        bench_report("expr native", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            for (i = 0; i < COUNT; i++)
+            {
+                const float* one_inputs[]  = { bench_x + i, bench_y + i, bench_z + i, bench_y + i, bench_z + i, bench_w + i, bench_w + i };
+                float*       one_outputs[] = { out[0] + i, out[1] + i, out[2] + i, out[3] + i };
+                vmath_expr_run(&e, one_inputs, one_outputs, 1);
+            }
+        }
+        bench_report("expr bytecode per entity", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            vmath_expr_run(&e, inputs, outputs, COUNT);
+        }
+        bench_report("expr bytecode batched", (double)rounds * COUNT, now - start);
+    }
+}
+
+static void bench_transform(void)
+{
+    enum { COUNT = 200000, MOVED = COUNT / 20 };
+
+    static transform_id_t ids[COUNT];
+    static int            moved[MOVED];
+
+    transform_store_t store;
+    int i, rounds;
+
+    /* Small trees: every 8th node is a root, the others hang under a node of their tree */
+    transform_store_init(&store, COUNT);
+    for (i = 0; i < COUNT; i++)
+    {
+        ids[i] = transform_store_create(&store, i % 8 ? ids[i - 1 - rand() % (i % 8)] : transform_none());
+        transform_store_setposition(&store, ids[i], vec3(bench_x[i % BENCH_COUNT], bench_y[i % BENCH_COUNT], bench_z[i % BENCH_COUNT]));
+    }
+    for (i = 0; i < MOVED; i++)
+    {
+        moved[i] = rand() % COUNT;
+    }
+    transform_store_update(&store);
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            mat4_composetrs(store.local, store.position, store.rotation, store.scale, store.count);
+            for (i = 0; i < store.count; i++)
+            {
+                const int p = store.parent[i];
+                store.world[i] = p >= 0 ? mat4_mul(store.world[p], store.local[i]) : store.local[i];
+            }
+        }
+        bench_report("transform full update", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            for (i = 0; i < MOVED; i++)
+            {
+                transform_store_setposition(&store, ids[moved[i]], vec3(bench_x[i], bench_y[i], (float)rounds));
+            }
+            transform_store_update(&store);
+        }
+        bench_report("transform dirty update (5%)", (double)rounds * COUNT, now - start);
+        printf("%-32s %10d\n", "transform changed per update", store.changed_count);
+    }
+
+    transform_store_free(&store);
+}
+
+/* The loops of the vmath_gpu writers with normal stores, the baselines of the streaming writers */
+static void bench_gpu_store_mat4(void* dst, const mat4_t* src, int count)
+{
+    float* out = (float*)dst;
+    int i;
+    for (i = 0; i < count; i++, out += 16)
+    {
+        vmath_gpu_store(out,      src[i].rows[0], 0);
+        vmath_gpu_store(out + 4,  src[i].rows[1], 0);
+        vmath_gpu_store(out + 8,  src[i].rows[2], 0);
+        vmath_gpu_store(out + 12, src[i].rows[3], 0);
+    }
+}
+
+static void bench_gpu_store_mat3x4(void* dst, const mat4_t* src, int count)
+{
+    float* out = (float*)dst;
+    int i;
+    for (i = 0; i < count; i++, out += 12)
+    {
+#if VMATH_SSE_ENABLE
+        __m128 r0 = src[i].rows[0].data;
+        __m128 r1 = src[i].rows[1].data;
+        __m128 r2 = src[i].rows[2].data;
+        __m128 r3 = src[i].rows[3].data;
+        vec4_t t0, t1, t2;
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        t0.data = r0;
+        t1.data = r1;
+        t2.data = r2;
+#else
+        const mat4_t m = src[i];
+        const vec4_t t0 = vec4(m.m00, m.m10, m.m20, m.m30);
+        const vec4_t t1 = vec4(m.m01, m.m11, m.m21, m.m31);
+        const vec4_t t2 = vec4(m.m02, m.m12, m.m22, m.m32);
+#endif
+        vmath_gpu_store(out,     t0, 0);
+        vmath_gpu_store(out + 4, t1, 0);
+        vmath_gpu_store(out + 8, t2, 0);
+    }
+}
+
+static void bench_gpu_store_normal(void* dst, const mat4_t* src, int count)
+{
+    float* out = (float*)dst;
+    int i;
+    for (i = 0; i < count; i++, out += 12)
+    {
+        const vec3_t a   = src[i].rows[0].xyz;
+        const vec3_t b   = src[i].rows[1].xyz;
+        const vec3_t c   = src[i].rows[2].xyz;
+        const vec3_t bc  = vec3_cross(b, c);
+        const float  det = vec3_dot(a, bc);
+        const float  inv = det != 0.0f ? 1.0f / det : 1.0f;
+
+        vmath_gpu_store(out,     vmath_gpu_vec4(vec3_mulf(bc, inv), 0.0f), 0);
+        vmath_gpu_store(out + 4, vmath_gpu_vec4(vec3_mulf(vec3_cross(c, a), inv), 0.0f), 0);
+        vmath_gpu_store(out + 8, vmath_gpu_vec4(vec3_mulf(vec3_cross(a, b), inv), 0.0f), 0);
+    }
+}
+
+static void bench_gpu_store_vertices(void* dst, const vec3_t* positions, const vec3_t* normals, int count)
+{
+    float* out = (float*)dst;
+    int i;
+    for (i = 0; i < count; i++, out += 4)
+    {
+        const uint32_t normal = normals ? vmath_gpu_snorm10(normals[i]) : 0;
+#if VMATH_SSE_ENABLE
+        vec4_t v;
+        const __m128 zn = _mm_shuffle_ps(positions[i].data, _mm_castsi128_ps(_mm_set1_epi32((int)normal)), _MM_SHUFFLE(0, 0, 2, 2));
+        v.data = _mm_shuffle_ps(positions[i].data, zn, _MM_SHUFFLE(2, 0, 1, 0));
+        vmath_gpu_store(out, v, 0);
+#else
+        vmath_gpu_vertex_t v;
+        v.x      = positions[i].x;
+        v.y      = positions[i].y;
+        v.z      = positions[i].z;
+        v.normal = normal;
+        memcpy(out, &v, sizeof(v));
+#endif
+    }
+}
+
+static void bench_gpu(void)
+{
+    /* Bigger than the last level cache, like the instance data of a frame */
+    enum { COUNT = 1 << 18 };
+
+    mat4_t*  matrices = (mat4_t*)vmath_aligned_alloc(COUNT * sizeof(mat4_t), 64);
+    vec3_t*  points   = (vec3_t*)vmath_aligned_alloc(COUNT * sizeof(vec3_t), 64);
+    float*   upload   = (float*)vmath_aligned_alloc(COUNT * sizeof(mat4_t), 64);
+    int i, rounds;
+
+    for (i = 0; i < COUNT; i++)
+    {
+        const int j = i % BENCH_COUNT;
+        matrices[i] = mat4_mul(mat4_translate3f(bench_x[j], bench_y[j], bench_z[j]), mat4_scale3f(1.0f, 2.0f, 0.5f + (float)i / COUNT));
+        points[i]   = vec3(bench_x[j], bench_y[j], bench_z[j]);
+    }
+
+    /* Each writer against the same loop with normal stores, the only difference is the store instruction */
+#define BENCH_GPU(name, call, bytes)                                            \
+    {                                                                           \
+        const double start = bench_seconds();                                  \
+        double now;                                                             \
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)      \
+        {                                                                       \
+            call;                                                               \
+        }                                                                       \
+        bench_report_bytes(name, (double)rounds * COUNT * (bytes), now - start);\
+    }
+
+    BENCH_GPU("gpu mat4 store",       bench_gpu_store_mat4(upload, matrices, COUNT), sizeof(mat4_t));
+    BENCH_GPU("gpu mat4 stream",      vmath_gpu_write_mat4(upload, matrices, COUNT), sizeof(mat4_t));
+    BENCH_GPU("gpu mat3x4 store",     bench_gpu_store_mat3x4(upload, matrices, COUNT), 12 * sizeof(float));
+    BENCH_GPU("gpu mat3x4 stream",    vmath_gpu_write_mat3x4(upload, matrices, COUNT), 12 * sizeof(float));
+    BENCH_GPU("gpu normal store",     bench_gpu_store_normal(upload, matrices, COUNT), 12 * sizeof(float));
+    BENCH_GPU("gpu normal stream",    vmath_gpu_write_normal(upload, matrices, COUNT), 12 * sizeof(float));
+    BENCH_GPU("gpu vertices store",   bench_gpu_store_vertices(upload, points, points, COUNT), sizeof(vmath_gpu_vertex_t));
+    BENCH_GPU("gpu vertices stream",  vmath_gpu_write_vertices(upload, points, points, COUNT), sizeof(vmath_gpu_vertex_t));
+#undef BENCH_GPU
+
+    vmath_aligned_free(matrices);
+    vmath_aligned_free(points);
+    vmath_aligned_free(upload);
+}
+
+static void bench_reduce(void)
+{
+    enum { COUNT = 1 << 20 };
+
+    static vec3_t points[COUNT];
+
+    vmath_reduce_t result;
+    volatile float sum = 0.0f;
+    int i, rounds;
+
+    memset(&result, 0, sizeof(result));
+
+    for (i = 0; i < COUNT; i++)
+    {
+        points[i] = vec3(bench_x[i % BENCH_COUNT], bench_y[i % BENCH_COUNT], bench_z[(i * 7) % BENCH_COUNT]);
+    }
+
+    /* One loop per result: bounds, centroid, covariance, then Ritter's 3 reads */
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            vec3_t total = vec3(0.0f, 0.0f, 0.0f), lo[3], hi[3];
+            mat3_t cov;
+            int    axis, k;
+
+            vec3_bounds(points, COUNT, &result.min, &result.max);
+
+            for (i = 0; i < COUNT; i++)
+            {
+                total = vec3_add(total, points[i]);
+            }
+            result.centroid = vec3_mulf(total, 1.0f / COUNT);
+
+            memset(&cov, 0, sizeof(cov));
+            for (i = 0; i < COUNT; i++)
+            {
+                const vec3_t d = vec3_sub(points[i], result.centroid);
+                cov.m00 += d.x * d.x; cov.m01 += d.x * d.y; cov.m02 += d.x * d.z;
+                cov.m11 += d.y * d.y; cov.m12 += d.y * d.z; cov.m22 += d.z * d.z;
+            }
+            result.covariance = cov;
+
+            for (k = 0; k < 3; k++)
+            {
+                lo[k] = points[0];
+                hi[k] = points[0];
+            }
+            for (i = 0; i < COUNT; i++)
+            {
+                for (k = 0; k < 3; k++)
+                {
+                    if (points[i].m[k] < lo[k].m[k]) lo[k] = points[i];
+                    if (points[i].m[k] > hi[k].m[k]) hi[k] = points[i];
+                }
+            }
+            axis = 0;
+            for (k = 1; k < 3; k++)
+            {
+                if (vec3_distancesquared(lo[k], hi[k]) > vec3_distancesquared(lo[axis], hi[axis])) axis = k;
+            }
+            result.center = vec3_mulf(vec3_add(lo[axis], hi[axis]), 0.5f);
+            result.radius = 0.5f * vec3_distance(lo[axis], hi[axis]);
+            vmath_reduce_sphere(points, COUNT, &result.center, &result.radius);
+            sum += result.min.x + result.centroid.y + result.covariance.m01 + result.radius;
+        }
+        bench_report("reduce all, separate loops", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            vmath_reduce(points, COUNT, VMATH_REDUCE_ALL, &result);
+            sum += result.min.x + result.centroid.y + result.covariance.m01 + result.radius;
+        }
+        bench_report("reduce all", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            vmath_reduce(points, COUNT, VMATH_REDUCE_BOUNDS | VMATH_REDUCE_CENTROID | VMATH_REDUCE_COVARIANCE, &result);
+            sum += result.min.x + result.centroid.y + result.covariance.m01;
+        }
+        bench_report("reduce bounds + covariance", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            vec3_bounds(points, COUNT, &result.min, &result.max);
+            sum += result.min.x + result.max.y;
+        }
+        bench_report("reduce bounds, vec3_bounds", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            vmath_reduce(points, COUNT, VMATH_REDUCE_BOUNDS, &result);
+            sum += result.min.x + result.max.y;
+        }
+        bench_report("reduce bounds", (double)rounds * COUNT, now - start);
+    }
+}
+
+/* Sum the positions of the neighbours of every point */
+static float bench_spatial_neighbours(const vec3_t* points, const int (*nbrs)[8], vec3_t* out, int count)
+{
+    int i, k;
+    for (i = 0; i < count; i++)
+    {
+        vec3_t sum = points[i];
+        for (k = 0; k < 8; k++)
+        {
+            sum = vec3_add(sum, points[nbrs[i][k]]);
+        }
+        out[i] = sum;
+    }
+    return out[count - 1].x;
+}
+
+/* Reorder points and neighbour lists by keys, the neighbour indices follow their points */
+static void bench_spatial_sort(uint32_t* keys, vec3_t* points, int (*nbrs)[8], int* order, int* inverse, int count)
+{
+    void*     arrays[2] = { points, nbrs };
+    const int sizes[2]  = { sizeof(vec3_t), sizeof(nbrs[0]) };
+    int i, k;
+
+    vmath_radix_sort32(keys, order, count);
+    vmath_reorder(order, count, arrays, sizes, 2);
+    for (i = 0; i < count; i++)
+    {
+        inverse[order[i]] = i;
+    }
+    for (i = 0; i < count; i++)
+    {
+        for (k = 0; k < 8; k++)
+        {
+            nbrs[i][k] = inverse[nbrs[i][k]];
+        }
+    }
+}
+
+static void bench_spatial(void)
+{
+    enum { COUNT = 1 << 20 };
+
+    static vec3_t   points[COUNT], sorted[COUNT], out[COUNT];
+    static uint32_t keys[COUNT], keys_sorted[COUNT];
+    static uint64_t keys64[COUNT], keys64_sorted[COUNT];
+    static int      order[COUNT], inverse[COUNT], nbrs[COUNT][8], nbrs_sorted[COUNT][8];
+
+    const vmath_grid_t grid = vmath_grid(vec3(-128.0f, -128.0f, -128.0f), vec3(128.0f, 128.0f, 128.0f));
+    volatile float sum = 0.0f;
+    int i, k, rounds, layout;
+
+    /* Random points, a grid of 32^3 cells hold about 32 points per cell */
+    for (i = 0; i < COUNT; i++)
+    {
+        points[i] = vec3((float)rand() / RAND_MAX * 256.0f - 128.0f,
+                         (float)rand() / RAND_MAX * 256.0f - 128.0f,
+                         (float)rand() / RAND_MAX * 256.0f - 128.0f);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            vmath_morton30_array(keys, points, COUNT, &grid);
+            sum += (float)keys[rounds & (COUNT - 1)];
+        }
+        bench_report("spatial morton30 keys", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            vmath_hilbert30_array(keys, points, COUNT, &grid);
+            sum += (float)keys[rounds & (COUNT - 1)];
+        }
+        bench_report("spatial hilbert30 keys", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            vmath_morton63_array(keys64, points, COUNT, &grid);
+            sum += (float)keys64[rounds & (COUNT - 1)];
+        }
+        bench_report("spatial morton63 keys", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            vmath_hilbert63_array(keys64, points, COUNT, &grid);
+            sum += (float)keys64[rounds & (COUNT - 1)];
+        }
+        bench_report("spatial hilbert63 keys", (double)rounds * COUNT, now - start);
+    }
+
+    /* The sorts include the copy of the keys */
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            memcpy(keys_sorted, keys, sizeof(keys));
+            vmath_radix_sort32(keys_sorted, order, COUNT);
+        }
+        bench_report("spatial radix sort 32", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            memcpy(keys64_sorted, keys64, sizeof(keys64));
+            vmath_radix_sort64(keys64_sorted, order, COUNT);
+        }
+        bench_report("spatial radix sort 64", (double)rounds * COUNT, now - start);
+    }
+
+    {
+        void*     arrays[1] = { sorted };
+        const int sizes[1]  = { sizeof(vec3_t) };
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            vmath_reorder(order, COUNT, arrays, sizes, 1);
+        }
+        bench_report("spatial reorder vec3", (double)rounds * COUNT, now - start);
+    }
+
+    /* Neighbour lists: the next 8 points of the same 32^3 cell, found with a coarse sort */
+    for (i = 0; i < COUNT; i++)
+    {
+        keys[i] = vmath_morton30(vmath_grid_cell(&grid, points[i], 5));
+    }
+    vmath_radix_sort32(keys, order, COUNT);
+    for (i = 0; i < COUNT;)
+    {
+        int first = i, n;
+        while (i < COUNT && keys[i] == keys[first])
+        {
+            i++;
+        }
+        n = i - first;
+        for (k = first; k < i; k++)
+        {
+            int j;
+            for (j = 0; j < 8; j++)
+            {
+                nbrs[order[k]][j] = order[first + (k - first + 1 + j) % n];
+            }
+        }
+    }
+
+    /* Same pass on the random layout, then on the layouts sorted by Morton and Hilbert keys */
+    for (layout = 0; layout < 3; layout++)
+    {
+        static const char* names[3] = { "spatial neighbours, unsorted", "spatial neighbours, morton sorted", "spatial neighbours, hilbert sorted" };
+        double start, now;
+
+        memcpy(sorted, points, sizeof(points));
+        memcpy(nbrs_sorted, nbrs, sizeof(nbrs));
+        if (layout == 1)
+        {
+            vmath_morton30_array(keys, sorted, COUNT, &grid);
+            bench_spatial_sort(keys, sorted, nbrs_sorted, order, inverse, COUNT);
+        }
+        else if (layout == 2)
+        {
+            vmath_hilbert30_array(keys, sorted, COUNT, &grid);
+            bench_spatial_sort(keys, sorted, nbrs_sorted, order, inverse, COUNT);
+        }
+
+        start = bench_seconds();
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            sum += bench_spatial_neighbours(sorted, (const int (*)[8])nbrs_sorted, out, COUNT);
+        }
+        bench_report(names[layout], (double)rounds * COUNT, now - start);
+    }
+
+    /* Key, sort and reorder cost, to weigh against the pass speedup */
+    {
+        const double start = bench_seconds();
+        double now;
+        for (rounds = 0; (now = bench_seconds()) - start < 0.25; rounds++)
+        {
+            memcpy(sorted, points, sizeof(points));
+            memcpy(nbrs_sorted, nbrs, sizeof(nbrs));
+            vmath_hilbert30_array(keys, sorted, COUNT, &grid);
+            bench_spatial_sort(keys, sorted, nbrs_sorted, order, inverse, COUNT);
+        }
+        bench_report("spatial hilbert sort points + lists", (double)rounds * COUNT, now - start);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int i;
+    for (i = 0; i < BENCH_COUNT; i++)
+    {
+        bench_x[i] = (float)rand() / RAND_MAX * 256.0f - 128.0f;
+        bench_y[i] = (float)rand() / RAND_MAX * 256.0f - 128.0f;
+        bench_z[i] = (float)rand() / RAND_MAX * 256.0f - 128.0f;
+        bench_w[i] = (float)rand() / RAND_MAX * 256.0f - 128.0f;
+    }
+
+    bench_noise();
+    bench_random();
+    bench_spline();
+    bench_anim();
+    bench_color();
+    bench_jobs();
+    bench_memory();
+    bench_file();
+    bench_text();
+    bench_solve();
+    bench_svd();
+    bench_rotation();
+    bench_geometry();
+    bench_gjk();
+    bench_expr();
+    bench_transform();
+    bench_gpu();
+    bench_reduce();
+    bench_spatial();
+    return 0;
+}
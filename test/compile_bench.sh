@@ -0,0 +1,100 @@
+#!/bin/sh
+#
+# Compile cost of vmath per translation unit: textual include (C and C++),
+# include with a VMATH_BUILD_* type subset or without the C++ wrappers,
+# precompiled header and C++20 module import. The include cost is the time
+# over an empty TU.
+#
+# usage: ./compile_bench.sh [runs]
+#        CC, CXX and CXXFLAGS can be overridden from the environment
+#
+
+set -e
+
+RUNS=${1:-20}
+CC=${CC:-gcc}
+CXX=${CXX:-g++}
+CFLAGS=${CFLAGS:-"-std=c99 -O2 -w"}
+CXXFLAGS=${CXXFLAGS:-"-std=c++20 -O2 -fpermissive -w"}
+SUBSET="-DVMATH_BUILD_VEC2=0 -DVMATH_BUILD_MAT2=0 -DVMATH_BUILD_MAT3=0 -DVMATH_BUILD_DQUAT=0"
+CAPI="-DVMATH_GLSL_LIKE=0 -DVMATH_FUNCTION_OVERLOADING=0 -DVMATH_OPERATOR_OVERLOADING=0"
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+cd "$WORK"
+
+# A typical user of the library: a few vector and matrix calls
+BODY='
+float bench_tu(float x)
+{
+    vec3_t p = vec3_normalize(vec3_add(vec3(x, 1.0f, 2.0f), vec3(1.0f, x, 0.0f)));
+    mat4_t m = mat4_mul(mat4_translatev3(p), mat4_rotateq(quat_euler(x, 0.0f, 0.0f)));
+    return mat4_mulv4(m, vec4(p.x, p.y, p.z, 1.0f)).x;
+}'
+
+printf 'float bench_tu(float x) { return x; }\n'   > empty.cpp
+printf '#include "vmath.h"\n%s\n' "$BODY"          > include.c
+printf '#include "vmath.h"\n%s\n' "$BODY"          > include.cpp
+printf 'import vmath;\n%s\n' "$BODY"               > import.cpp
+
+mkdir pch
+cp "$ROOT/vmath.h" pch/vmath.h
+
+# now in nanoseconds
+now()
+{
+    date +%s%N
+}
+
+# ms per compile of $@ over RUNS runs
+measure()
+{
+    "$@" # warm up, and fail early
+    start=$(now)
+    i=0
+    while [ $i -lt "$RUNS" ]; do
+        "$@"
+        i=$((i + 1))
+    done
+    end=$(now)
+    echo "$start $end $RUNS" | awk '{ printf "%.1f", ($2 - $1) / $3 / 1000000 }'
+}
+
+# ms of a single command
+once()
+{
+    start=$(now)
+    "$@"
+    end=$(now)
+    echo "$start $end" | awk '{ printf "%.1f", ($2 - $1) / 1000000 }'
+}
+
+report()
+{
+    echo "$2 $EMPTY" | awk -v name="$1" '{ printf "%-28s %8.1f ms %8.1f ms\n", name, $1, $1 - $2 }'
+}
+
+EMPTY=$(measure $CXX $CXXFLAGS -c empty.cpp -o empty.o)
+
+echo "vmath compile cost per TU, $RUNS runs, $CXX $CXXFLAGS"
+echo
+printf '%-28s %11s %11s\n' "mode" "TU" "include"
+report "empty TU"              "$EMPTY"
+report "include (C)"           "$(measure $CC $CFLAGS -I"$ROOT" -c include.c -o include.o)"
+report "include (C++)"         "$(measure $CXX $CXXFLAGS -I"$ROOT" -c include.cpp -o include.o)"
+report "include, type subset"  "$(measure $CXX $CXXFLAGS $SUBSET -I"$ROOT" -c include.cpp -o include.o)"
+report "include, C API only"   "$(measure $CXX $CXXFLAGS $CAPI -I"$ROOT" -c include.cpp -o include.o)"
+
+PCH=$(once $CXX $CXXFLAGS -x c++-header pch/vmath.h -o pch/vmath.h.gch)
+report "precompiled header"    "$(measure $CXX $CXXFLAGS -Ipch -c include.cpp -o include.o)"
+
+if BMI=$(once $CXX $CXXFLAGS -fmodules-ts -c -x c++ "$ROOT/vmath.cppm" -o vmath.o 2>/dev/null); then
+    report "import vmath"      "$(measure $CXX $CXXFLAGS -fmodules-ts -c import.cpp -o import.o)"
+else
+    BMI="n/a"
+    printf '%-28s %11s\n' "import vmath" "n/a"
+fi
+
+echo
+echo "one-off: precompiled header $PCH ms, module interface $BMI ms"
@@ -0,0 +1,21 @@
+/**
+ * Smoke test of the C++20 module: constants and functions read through
+ * import vmath, the same values as with #include "vmath.h".
+ * Build and run with `make module_test`.
+ */
+
+import vmath;
+
+#include <stdio.h>
+
+int main(void)
+{
+    const vec3_t p = vec3_add(VEC3_UNITX, vec3(0.0f, 2.0f, 0.0f));
+    const vec4_t q = mat4_mulv4(MAT4_IDENTITY, vec4(p.x, p.y, p.z, 1.0f));
+
+    const bool ok = VEC3_UNITX.x == 1.0f && VEC3_UP.y == 1.0f && QUAT_IDENTITY.w == 1.0f && MAT4_IDENTITY.m33 == 1.0f
+                 && q.x == 1.0f && q.y == 2.0f && q.w == 1.0f;
+
+    printf("import vmath: %s\n", ok ? "pass" : "fail");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+/**
+ * Heavy functions inline (default) against VMATH_OUTLINE 1 and 2:
+ * many systems call the same heavy functions from their own call sites,
+ * like the update code of a game. Build both ways with `make outline_bench`.
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "../vmath.h"
+
+#define OBJECT_COUNT 1024
+#define FRAME_COUNT  5000
+
+typedef struct
+{
+    vec3_t  position;
+    mat4_t  world;
+    dquat_t pose;
+} object_t;
+
+static object_t objects[OBJECT_COUNT];
+
+/* Every system has its own copies of the heavy functions when they are inline:
+ * the cold ones set up the camera once per frame, the hot ones run per object */
+#define SYSTEM(n)                                                                               \
+static float system_##n(float t)                                                                \
+{                                                                                               \
+    const mat4_t  proj = mat4_perspective(0.8f + 0.01f * n, 1.7f, 0.1f, 100.0f + n);            \
+    const mat4_t  view = mat4_lookat(vec3(t, 2.0f, (float)n), VEC3_ZERO, VEC3_UP);              \
+    const mat4_t  spin = mat4_rotate3f(0.0f, 1.0f, 0.0f, t * n);                                \
+    const vec3_t  tilt = quat_toeuler(quat_euler(t, 0.1f * n, 0.0f));                           \
+    const dquat_t base = dquat_frommat4(view);                                                  \
+    const mat4_t  camera = mat4_mul(mat4_mul(view, spin), proj);                                \
+    float sum = tilt.x;                                                                         \
+    int   i;                                                                                    \
+    for (i = n; i < OBJECT_COUNT; i += 16)                                                      \
+    {                                                                                           \
+        object_t* o = &objects[i];                                                              \
+        const dquat_t dqs[2] = { o->pose, base };                                               \
+        const float   w[2]   = { 0.25f * n, 1.0f };                                             \
+        o->world = mat4_mul(mat4_translatev3(o->position), camera);                             \
+        o->world = mat4_inverse(o->world);                                                      \
+        o->pose  = dquat_blend(dqs, w, 2);                                                      \
+        o->position = vec3_add(o->position, vec3(o->world.m30, o->world.m31, 0.0f));            \
+        sum += mat4_det(o->world) + o->pose.real.w;                                             \
+    }                                                                                           \
+    return sum;                                                                                 \
+}
+
+SYSTEM(0)  SYSTEM(1)  SYSTEM(2)  SYSTEM(3)
+SYSTEM(4)  SYSTEM(5)  SYSTEM(6)  SYSTEM(7)
+SYSTEM(8)  SYSTEM(9)  SYSTEM(10) SYSTEM(11)
+SYSTEM(12) SYSTEM(13) SYSTEM(14) SYSTEM(15)
+
+static float (*const systems[])(float) = {
+    system_0,  system_1,  system_2,  system_3,
+    system_4,  system_5,  system_6,  system_7,
+    system_8,  system_9,  system_10, system_11,
+    system_12, system_13, system_14, system_15,
+};
+
+int main(void)
+{
+    int   i, frame;
+    float sum = 0.0f;
+
+    for (i = 0; i < OBJECT_COUNT; i++)
+    {
+        objects[i].position = vec3((float)(i % 32), (float)(i / 32), 1.0f);
+        objects[i].pose     = DQUAT_IDENTITY;
+    }
+
+    const clock_t start = clock();
+    for (frame = 0; frame < FRAME_COUNT; frame++)
+    {
+        for (i = 0; i < (int)(sizeof(systems) / sizeof(systems[0])); i++)
+        {
+            sum += systems[i](0.016f * frame);
+        }
+    }
+    const double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("VMATH_OUTLINE %d: %.3f ms/frame (checksum %g)\n", VMATH_OUTLINE,
+           seconds * 1000.0 / FRAME_COUNT, sum);
+    return 0;
+}
@@ -2,6 +2,28 @@
 #include <stdlib.h>
 
 #include "../../vmath.h"
+#include "../../vmath_noise.h"
+#include "../../vmath_random.h"
+#include "../../vmath_spline.h"
+#include "../../vmath_anim.h"
+#include "../../vmath_color.h"
+#include "../../vmath_text.h"
+#include "../../vmath_solve.h"
+#include "../../vmath_svd.h"
+#include "../../vmath_rotation.h"
+#include "../../vmath_geometry.h"
+#include "../../vmath_gjk.h"
+#include "../../vmath_expr.h"
+#include "../../vmath_reduce.h"
+
+#define VMATH_IMPL
+#include "../../vmath_jobs.h"
+#include "../../vmath_memory.h"
+#include "../../vmath_file.h"
+#include "../../vmath_native.h"
+#include "../../vmath_transform.h"
+#include "../../vmath_gpu.h"
+#include "../../vmath_spatial.h"
 #include "../csfx/csfx.h"
 
 #define NONE
@@ -31,9 +53,867 @@ void vmath_test_vec2(void)
     test_assert(vec2_lengthsquared(vec2(0, 0)) == 0, VOIDVAL);
 }
 
+void vmath_test_dquat(void)
+{
+    const quat_t  q  = quat(0.0f, 0.70710678f, 0.0f, 0.70710678f);
+    const dquat_t dq = dquat_fromquat(q, vec3(1, 2, 3));
+    const vec3_t  p  = dquat_transform(dq, vec3(1, 0, 0));
+    test_assert(fabsf(p.x - 1) < 1e-5f && fabsf(p.y - 2) < 1e-5f && fabsf(p.z - 2) < 1e-5f, VOIDVAL);
+}
+
+void vmath_test_noise(void)
+{
+    const noise_desc_t desc = noise_desc(NOISE_PERLIN, NOISE_FRACTAL_NONE, 1);
+    const float x[5] = { 0.0f, 0.25f, 1.5f, -3.75f, 7.125f };
+    const float y[5] = { 0.0f, 0.50f, 2.5f,  1.25f, -0.5f  };
+    float out[5], out4[5], dx[5], dy[5], dz[5], dw[5], dy2[5];
+    vec2_t grad;
+    vec4_t grad4;
+    bool   same4 = true;
+    int    i;
+
+    /* 4D values and gradients of the batch, over a group and a tail, match the single point ones */
+    noise_batch2(&desc, out, x, y, 5, NULL, NULL);
+    noise_batch4(&desc, out4, x, y, y, x, 5, dx, dy, dz, dw);
+    for (i = 0; i < 5; i++)
+    {
+        same4 = same4 && out4[i] == noise4(&desc, vec4(x[i], y[i], y[i], x[i]), &grad4)
+                      && dx[i] == grad4.x && dy[i] == grad4.y && dz[i] == grad4.z && dw[i] == grad4.w;
+    }
+
+    /* A single non-NULL derivative output is written on its own */
+    noise_batch2(&desc, out4, x, y, 5, NULL, dy2);
+    for (i = 0; i < 5; i++)
+    {
+        same4 = same4 && out4[i] == noise2(&desc, vec2(x[i], y[i]), &grad) && dy2[i] == grad.y;
+    }
+    test_assert(out[0] == 0.0f && out[4] == noise2(&desc, vec2(x[4], y[4]), &grad) && fabsf(out[3]) <= 1.0f && same4, VOIDVAL);
+}
+
+void vmath_test_random(void)
+{
+    random_t a = random_seed(7);
+    random_t b = random_seed(7);
+    vec3_t   dirs[11];
+    float    fa[11], fb[11];
+
+    random_fill_float(&a, fa, 11, 0.0f, 1.0f);
+    random_fill_float(&b, fb, 11, 0.0f, 1.0f);
+    random_fill_cone(&a, dirs, 11, vec3(0, 0, 1), 0.1f);
+    test_assert(memcmp(fa, fb, sizeof(fa)) == 0 && fa[0] >= 0.0f && fa[0] < 1.0f && dirs[10].z >= 0.99f, VOIDVAL);
+}
+
+void vmath_test_spline(void)
+{
+    const vec3_t path[6] = { vec3(0, 0, 0), vec3(1, 2, 0), vec3(3, 1, 1), vec3(4, -2, 2), vec3(6, 0, 0), vec3(7, 1, 0) };
+    const float  t[5]    = { 0.0f, 1.0f, 0.25f, 0.5f, 1.0f };
+    float        x[4][5], y[4][5], z[4][5], ox[5], oy[5], oz[5];
+    bool         through = true, batched = true;
+    int          i, k, first = -1;
+
+    /* Catmull-Rom pass through p1..p4 at the segment ends */
+    for (i = 0; i <= 3; i++)
+    {
+        through = through && vec3_distance(spline_path3(SPLINE_CATMULLROM, path, 6, (float)i, 0), path[i + 1]) < 1e-5f;
+    }
+
+    /* 5 Bezier curves, a full group and a tail, against the scalar evaluation */
+    for (i = 0; i < 5; i++)
+    {
+        for (k = 0; k < 4; k++)
+        {
+            x[k][i] = path[i + (k & 1)].x * (float)(k + 1);
+            y[k][i] = path[i + (k >> 1)].y - (float)k;
+            z[k][i] = path[i + 1].z + (float)(k * i);
+        }
+    }
+    {
+        const float* const cx[4] = { x[0], x[1], x[2], x[3] };
+        const float* const cy[4] = { y[0], y[1], y[2], y[3] };
+        const float* const cz[4] = { z[0], z[1], z[2], z[3] };
+        spline_batch3(SPLINE_BEZIER, 0, cx, cy, cz, t, ox, oy, oz, 5);
+    }
+    for (i = 0; i < 5; i++)
+    {
+        vec3_t p[4], r;
+        for (k = 0; k < 4; k++) p[k] = vec3(x[k][i], y[k][i], z[k][i]);
+        r = spline_eval3(SPLINE_BEZIER, p, t[i], 0);
+        batched = batched && fabsf(r.x - ox[i]) < 1e-4f && fabsf(r.y - oy[i]) < 1e-4f && fabsf(r.z - oz[i]) < 1e-4f;
+    }
+
+    /* A path shorter than one segment locate the first segment, not p[-stride] */
+    spline_locate(SPLINE_BEZIER, 2, 1.5f, &first);
+
+    test_assert(through && batched && ox[0] == x[0][0] && ox[1] == x[3][1] && first == 0, VOIDVAL);
+}
+
+void vmath_test_anim(void)
+{
+    const float  times[4]     = { 0.0f, 1.0f, 2.0f, 4.0f };
+    const float  values[4][4] = { { 0, 0, 0, 0 }, { 2, 0, -2, 0 }, { 2, 4, -2, 0 }, { 6, 4, 2, 0 } };
+    const float  at[4]        = { 0.5f, 1.5f, 3.0f, 0.25f };
+    const int    keys[4]      = { 0, 1, 2, 0 };
+    short        quantized[4][4];
+    anim_track_t tracks[2];
+    anim_clip_t  clip;
+    vec4_t       out[2];
+    int          cursors[2] = { 0, 0 }, i;
+    bool         moved = true, sampled = true;
+
+    tracks[0].type   = ANIM_TRACK_VEC3;
+    tracks[0].format = ANIM_KEY_FLOAT;
+    tracks[0].count  = 4;
+    tracks[0].times  = times;
+    tracks[0].values = values;
+    tracks[1]        = tracks[0];
+    tracks[1].format = ANIM_KEY_INT16;
+    tracks[1].values = quantized;
+    anim_quantize(values[0], 4, quantized[0], &tracks[1].offset, &tracks[1].scale);
+
+    clip.duration    = 4.0f;
+    clip.track_count = 2;
+    clip.tracks      = tracks;
+
+    /* Forward across the keys, then back to the first segment */
+    for (i = 0; i < 4; i++)
+    {
+        const int   k = keys[i];
+        const float f = (at[i] - times[k]) / (times[k + 1] - times[k]);
+        anim_sample(&clip, at[i], cursors, out);
+        moved   = moved && cursors[0] == k && cursors[1] == k;
+        sampled = sampled && fabsf(out[0].x - (values[k][0] + f * (values[k + 1][0] - values[k][0]))) < 1e-5f
+                          && fabsf(out[0].z - (values[k][2] + f * (values[k + 1][2] - values[k][2]))) < 1e-5f
+                          && vec3_distance(vec3(out[0].x, out[0].y, out[0].z), vec3(out[1].x, out[1].y, out[1].z)) < 1e-3f;
+    }
+
+    test_assert(moved && sampled && out[0].x == 0.5f, VOIDVAL);
+}
+
+void vmath_test_color(void)
+{
+    unsigned char bytes[256 * 4], back[256 * 4];
+    vec4_t        linear[256], srgb[256], again[256];
+    bool          exact = true, close = true;
+    int           i;
+
+    /* Every 8 bits value decode and encode to itself, alpha stay linear */
+    for (i = 0; i < 256 * 4; i++)
+    {
+        bytes[i] = (unsigned char)((i >> 2) ^ (i & 3) * 85);
+    }
+    color_decode8(linear, bytes, 256, true);
+    color_encode8(back, linear, 256, true);
+    exact = memcmp(bytes, back, sizeof(bytes)) == 0;
+
+    /* Float round trip and a known value of the curve */
+    for (i = 0; i < 256; i++)
+    {
+        linear[i] = vec4((float)i / 255.0f, (float)(i * i) / 65025.0f, 0.5f, 1.0f);
+    }
+    color_convert(srgb, linear, 256, COLOR_LINEAR_TO_SRGB);
+    color_convert(again, srgb, 255, COLOR_SRGB_TO_LINEAR);
+    for (i = 0; i < 255; i++)
+    {
+        close = close && fabsf(again[i].x - linear[i].x) < 1e-4f && fabsf(again[i].y - linear[i].y) < 1e-4f && again[i].w == 1.0f;
+    }
+
+    test_assert(exact && close && fabsf(srgb[0].z - 0.735357f) < 1e-4f, VOIDVAL);
+}
+
+void vmath_test_jobs(void)
+{
+    /* More points than 4 * VMATH_JOBS_MAX_THREADS chunks of the default grain, and not a multiple of it */
+    enum { COUNT = 600001, PIXELS = 10001 };
+
+    static vec3_t points[COUNT];
+    static vec4_t pixels[PIXELS], colors[PIXELS], colors_mt[PIXELS];
+    const int     counts[3] = { 1, 3000, COUNT };
+    vec3_t        min, max, min_mt, max_mt;
+    bool          same = true;
+    int           i;
+
+    for (i = 0; i < COUNT; i++)
+    {
+        points[i] = vec3((float)(i % 1000), (float)(i % 777) - 300.0f, (float)(i % 13));
+    }
+    points[COUNT - 1] = vec3(-5000.0f, 9000.0f, 0.5f);
+    for (i = 0; i < PIXELS; i++)
+    {
+        pixels[i] = vec4((float)(i % 256) / 255.0f, (float)(i % 97) / 96.0f, (float)(i % 13) / 12.0f, (float)(i % 7) / 6.0f);
+    }
+
+    vmath_jobs_init(4);
+    for (i = 0; i < 3; i++)
+    {
+        vec3_bounds(points + COUNT - counts[i], counts[i], &min, &max);
+        vec3_bounds_mt(points + COUNT - counts[i], counts[i], &min_mt, &max_mt);
+        same = same && vec3_equal(min, min_mt) && vec3_equal(max, max_mt);
+    }
+
+    /* Ranges of the pool give the same pixels as one serial pass */
+    color_convert(colors, pixels, PIXELS, COLOR_LINEAR_TO_SRGB);
+    color_convert_mt(colors_mt, pixels, PIXELS, COLOR_LINEAR_TO_SRGB);
+    color_blend(colors, pixels, PIXELS, COLOR_BLEND_SRC_OVER);
+    color_blend_mt(colors_mt, pixels, PIXELS, COLOR_BLEND_SRC_OVER);
+    same = same && memcmp(colors, colors_mt, sizeof(colors)) == 0;
+    vmath_jobs_shutdown();
+
+    test_assert(same && min_mt.x == -5000.0f && max_mt.y == 9000.0f, VOIDVAL);
+}
+
+void vmath_test_memory(void)
+{
+    vec3_array_t  points = vec3_array();
+    vmath_arena_t arena;
+    void*         a;
+    void*         b;
+    bool          ok;
+    int           i;
+
+    for (i = 0; i < 100; i++)
+    {
+        vec3_array_push(&points, vec3((float)i, 0, 0));
+    }
+    vmath_arena_init(&arena, 256);
+    a = vmath_arena_alloc(&arena, 3, 1);
+    b = vmath_arena_alloc(&arena, sizeof(mat4_t), 16);
+    ok = ((size_t)points.data & 15) == 0 && points.data[99].x == 99.0f && ((size_t)b & 15) == 0 && (char*)b - (char*)a == 16
+      && vmath_arena_alloc(&arena, 256, 16) == 0;
+
+    vmath_arena_free(&arena);
+    vec3_array_free(&points);
+    test_assert(ok, VOIDVAL);
+}
+
+void vmath_test_file(void)
+{
+    const char*         path  = "vmath_test_file.bin";
+    const uint32_t      tag   = VMATH_FOURCC('P', 'O', 'S', '0');
+    const char          text[11] = { 'h', 'e', 'l', 'l', 'o', ' ', 'w', 'o', 'r', 'l', 'd' };
+    vec3_t              points[5], read[5];
+    char                bytes[11];
+    vmath_file_writer_t writer;
+    vmath_file_reader_t reader;
+    vmath_file_t        file;
+    vmath_chunk_t       chunk;
+    const vec3_t*       view;
+    uint64_t            count, n, huge = 1ull << 60;
+    FILE*               patch;
+    bool                mapped, streamed, crafted;
+    int                 i;
+
+    memset(&file, 0, sizeof(file));
+    memset(&chunk, 0, sizeof(chunk));
+    for (i = 0; i < 5; i++)
+    {
+        points[i] = vec3((float)i, 2.0f * i, -1.0f);
+    }
+    vmath_file_writer_open(&writer, path);
+    vmath_file_writer_chunk(&writer, VMATH_CHUNK_VEC3, tag, points, 5);
+    vmath_file_writer_begin(&writer, VMATH_CHUNK_BYTES, 0);
+    vmath_file_writer_write(&writer, text, 3);
+    vmath_file_writer_write(&writer, text + 3, 8);
+    vmath_file_writer_end(&writer);
+    mapped = vmath_file_writer_close(&writer) != 0;
+
+    /* Zero-copy views */
+    mapped = mapped && vmath_file_open(&file, path);
+    if (mapped)
+    {
+        view   = vmath_file_vec3s(&file, tag, &count);
+        mapped = view && count == 5 && memcmp(view, points, sizeof(points)) == 0
+              && vmath_file_chunk(&file, 1, &chunk) && vmath_file_verify(&chunk) && chunk.count == 11;
+        vmath_file_close(&file);
+    }
+
+    /* Streaming reads which stop inside checksum words */
+    streamed = vmath_file_reader_open(&reader, path) && vmath_file_reader_next(&reader, &chunk);
+    for (count = 0; streamed && (n = vmath_file_reader_read(&reader, read + count, 2)) > 0; count += n);
+    streamed = streamed && count == 5 && vmath_file_reader_verify(&reader) && memcmp(read, points, sizeof(points)) == 0;
+    streamed = streamed && vmath_file_reader_next(&reader, &chunk);
+    for (count = 0; streamed && (n = vmath_file_reader_read(&reader, bytes + count, 3)) > 0; count += n);
+    streamed = streamed && count == 11 && vmath_file_reader_verify(&reader) && memcmp(bytes, text, sizeof(text)) == 0;
+    vmath_file_reader_close(&reader);
+
+    /* A count larger than the chunk bytes is rejected */
+    patch = fopen(path, "r+b");
+    crafted = patch && fseek(patch, VMATH_FILE_ALIGN + offsetof(vmath_chunk_header_t, count), SEEK_SET) == 0
+           && fwrite(&huge, sizeof(huge), 1, patch) == 1;
+    if (patch) fclose(patch);
+    crafted = crafted && vmath_file_open(&file, path);
+    if (crafted)
+    {
+        crafted = !vmath_file_vec3s(&file, tag, &count) && count == 0;
+        vmath_file_close(&file);
+    }
+    remove(path);
+
+    test_assert(mapped && streamed && crafted, VOIDVAL);
+}
+
+void vmath_test_text(void)
+{
+    const char          text[] = "# points\nv 1.5 -2 3e2\nvn 0 0 1\nv 0.25,4,-8\r\nv 7 8 9";
+    const size_t        size   = sizeof(text) - 1;
+    const vec3_t        v      = vec3(0.1f, -1e-7f, 12345.678f);
+    vmath_text_parser_t parser;
+    vec3_t              row, rows[4], formatted;
+    char                buffer[64];
+    size_t              offset = 0, chunk = 1, used;
+    int                 count = 0;
+    bool                parsed;
+
+    /* Chunks of 1 to 7 bytes split lines and numbers, room for 1 row make the feed stop after each row */
+    vmath_text_init(&parser, "v", 3, 1);
+    vmath_text_vec3(&parser, 0, &row);
+    while (offset < size)
+    {
+        const size_t n = size - offset < chunk ? size - offset : chunk;
+        used    = vmath_text_feed(&parser, text + offset, n);
+        offset += used;
+        if (used < n)
+        {
+            rows[count++ & 3] = row;
+            vmath_text_rewind(&parser);
+        }
+        chunk = chunk % 7 + 1;
+    }
+    if (!vmath_text_finish(&parser))
+    {
+        rows[count++ & 3] = row;
+        vmath_text_rewind(&parser);
+        vmath_text_finish(&parser);
+    }
+    rows[count++ & 3] = row;
+    parsed = count == 3 && parser.skipped == 1 && rows[0].x == 1.5f && rows[0].y == -2.0f && rows[0].z == 300.0f
+          && rows[1].x == 0.25f && rows[1].z == -8.0f && rows[2].x == 7.0f && rows[2].z == 9.0f;
+
+    /* Formatted text parse back to the same floats */
+    vmath_text_init(&parser, "vec3(", 3, 1);
+    vmath_text_vec3(&parser, 0, &formatted);
+    vmath_text_feed(&parser, buffer, (size_t)vmath_format_vec3(buffer, sizeof(buffer), v));
+    vmath_text_finish(&parser);
+
+    test_assert(parsed && parser.rows == 1 && formatted.x == v.x && formatted.y == v.y && formatted.z == v.z, VOIDVAL);
+}
+
+void vmath_test_solve(void)
+{
+    const mat3_t       m = { { 2, 1, 0, -1, 3, 1, 0, 1, 4 } };
+    const vec3_t       b = vec3(1, 2, 3);
+    mat3_t             s = m;
+    vec3_t             x, y, z;
+    vmath_solve_info_t info;
+    bool               ls;
+
+    /* Rank 2 with the 2 first columns equal, the least squares residual is sqrt(1.08) */
+    const mat3_t d = { { 1, 2, 3, 1, 2, 3, 0, 1, 5 } };
+    ls = !mat3_solve(d, vec3(1, 0, 2), &z, VMATH_SOLVE_QR, &info) && info.rank == 2
+      && fabsf(vec3_distance(mat3_mulv3(d, z), vec3(1, 0, 2)) - sqrtf(1.08f)) < 1e-3f;
+
+    s.m[2][0] = 0.0f; s.m[2][1] = 0.0f; s.m[2][2] = 0.0f;
+    mat3_solve_batch(&m, &b, &y, 0, 1, VMATH_SOLVE_LU);
+    test_assert(mat3_solve(m, b, &x, VMATH_SOLVE_LU, &info) && info.rank == 3 && vec3_distance(mat3_mulv3(m, x), b) < 1e-5f
+                && vec3_distance(x, y) < 1e-5f && !mat3_solve(s, b, &x, VMATH_SOLVE_QR, &info) && info.rank == 2 && ls, VOIDVAL);
+}
+
+void vmath_test_svd(void)
+{
+    const mat3_t m = { { 2, 1, 0, -1, 3, 1, 0.5f, 1, -4 } };
+    mat3_t       u, v, r, p, d;
+    vec3_t       s;
+    double       a[3][3], e = 0.0;
+    int          i, j, k;
+
+    mat3_svd(m, &u, &s, &v);
+    mat3_polar(m, &r, &p);
+    memset(&d, 0, sizeof(d));
+    d.m[0][0] = s.x; d.m[1][1] = s.y; d.m[2][2] = s.z;
+    d = mat3_mul(mat3_mul(u, d), mat3_transpose(v));
+    p = mat3_mul(r, p);
+
+    /* Double reference: each s^2 is a root of det(transpose(m) m - s^2) */
+    for (i = 0; i < 3; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            a[i][j] = 0.0;
+            for (k = 0; k < 3; k++)
+            {
+                a[i][j] += (double)m.m[i][k] * m.m[j][k];
+            }
+        }
+    }
+    for (k = 0; k < 3; k++)
+    {
+        const double l = (double)s.m[k] * s.m[k];
+        const double f = (a[1][1] - l) * (a[2][2] - l) - a[1][2] * a[2][1];
+        const double g = a[1][0] * (a[2][2] - l) - a[1][2] * a[2][0];
+        const double h = a[1][0] * a[2][1] - (a[1][1] - l) * a[2][0];
+        const double det = (a[0][0] - l) * f - a[0][1] * g + a[0][2] * h;
+        e = fabs(det) > e ? fabs(det) : e;
+    }
+    for (i = 0; i < 9; i++)
+    {
+        e = fabs(d.data[i] - m.data[i]) > e ? fabs(d.data[i] - m.data[i]) : e;
+        e = fabs(p.data[i] - m.data[i]) > e ? fabs(p.data[i] - m.data[i]) : e;
+    }
+
+    test_assert(e < 2e-3 && s.x >= s.y && s.y >= fabsf(s.z) && s.z < 0.0f, VOIDVAL);
+}
+
+void vmath_test_rotation(void)
+{
+    const vec3_t e = vec3(0.3f, -1.2f, 2.5f);
+    const quat_t q = quat_fromeuler(e, VMATH_EULER_ZXY);
+    const quat_t m = quat_frommat3(quat_tomat3(q));
+    const vec3_t r = quat_toeulerorder(q, VMATH_EULER_ZXY);
+    const vec3_t f = vec3(0.3f, 1.2f, 2.5f);
+    const vec3_t p = quat_toeulerorder(quat_fromeuler(f, VMATH_EULER_YZY), VMATH_EULER_YZY);
+    vec4_t       a;
+    quat_t       b;
+
+    quat_toaxis_batch(&q, &a, 1);
+    quat_fromaxis_batch(&a, &b, 1);
+
+    /* Qz(0.3) then Qx(-1.2) then Qy(2.5) around the fixed axes */
+    test_assert(vec3_distance(r, e) < 1e-5f && vec3_distance(p, f) < 1e-5f && vec4_distance(m.vec4, q.vec4) < 1e-5f
+                && vec4_distance(b.vec4, q.vec4) < 1e-5f && fabsf(q.w - 0.177250f) < 1e-5f, VOIDVAL);
+}
+
+void vmath_test_geometry(void)
+{
+    const vec3_t     v[6] = { vec3(0, 0, 0), vec3(2, 0, 0), vec3(0, 2, 0), vec3(0, 0, 1), vec3(4, 0, 1), vec3(2, 0, 1) };
+    const vec3_t     p    = vec3(0.5f, 0.5f, 2.0f);
+    vmath_triangle8_t block;
+    vec3_t           bary, c, q;
+    float            d[2], d2, s, t;
+    int              index;
+
+    /* Second triangle is flat, its longest edge is from v[3] to v[4] */
+    vmath_triangle8_pack(v, NULL, 2, &block);
+    vmath_triangle8_distances(&block, 2, p, d);
+    index = vmath_triangle8_closest(&block, 2, p, &q, &d2);
+    c     = vmath_closest_triangle(vec3(3, 3, -1), v[0], v[1], v[2], &bary);
+    vmath_closest_segments(vec3(0, 0, 0), vec3(2, 0, 0), vec3(1, -1, 1), vec3(1, 1, 1), &s, &t, NULL, NULL);
+
+    test_assert(vec3_distance(c, vec3(1, 1, 0)) < 1e-6f && fabsf(bary.y - 0.5f) < 1e-6f && fabsf(bary.z - 0.5f) < 1e-6f
+                && fabsf(d[0] - 4.0f) < 1e-5f && fabsf(d[1] - 1.25f) < 1e-5f && index == 1 && vec3_distance(q, vec3(0.5f, 0, 1)) < 1e-6f
+                && fabsf(s - 0.5f) < 1e-6f && fabsf(t - 0.5f) < 1e-6f, VOIDVAL);
+}
+
+void vmath_test_gjk(void)
+{
+    const vec3_t      cube[8] = { vec3(-1, -1, -1), vec3(1, -1, -1), vec3(-1, 1, -1), vec3(1, 1, -1),
+                                  vec3(-1, -1, 1),  vec3(1, -1, 1),  vec3(-1, 1, 1),  vec3(1, 1, 1) };
+    float             blocks[24];
+    vmath_hull_t      hull;
+    vmath_convex_t    a, b, c;
+    vmath_gjk_cache_t cache = { 0 };
+    vec3_t            pa, pb, n;
+    float             d, w, depth, deep;
+    bool              hit, concentric = true;
+    int               i;
+
+    hull.blocks = blocks;
+    hull.count  = 8;
+    vmath_hull_pack(cube, 8, blocks);
+
+    /* Unit cube hull and a sphere of radius 0.5 at (3, 0.5, 0) */
+    a = vmath_convex_hull(&hull, vec3(0, 0, 0), quat(0, 0, 0, 1));
+    b = vmath_convex_sphere(vec3(3.0f, 0.5f, 0.0f), 0.5f);
+    d = vmath_gjk_distance(&a, &b, &cache, &pa, &pb);
+    b.position = vec3(2.9f, 0.5f, 0.0f);
+    w = vmath_gjk_distance(&a, &b, &cache, NULL, NULL);
+
+    /* Capsule lying along x, 0.25 deep into the top face of a box */
+    c   = vmath_convex_capsule(1.0f, 0.5f, vec3(0.0f, 1.25f, 0.0f), quat(0.0f, 0.0f, 0.70710678f, 0.70710678f));
+    a   = vmath_convex_box(vec3(2, 1, 2), vec3(0, 0, 0), quat(0, 0, 0, 1));
+    hit = vmath_epa_penetration(&a, &c, NULL, &n, &depth, NULL, NULL);
+
+    /* Concentric boxes: ties in the support points, the depth is the smallest sum of extents */
+    for (i = 0; i < 64; i++)
+    {
+        const vec3_t   ea = i ? vec3(0.6f + 0.4f * sinf(i * 1.7f), 0.5f + 0.4f * sinf(i * 2.3f), 0.4f + 0.3f * sinf(i * 3.1f))
+                          : vec3(0.987f, 0.840f, 0.527f);
+        const vec3_t   eb = i ? vec3(0.6f + 0.4f * cosf(i * 1.3f), 0.5f + 0.4f * cosf(i * 2.9f), 0.4f + 0.3f * cosf(i * 0.7f))
+                          : vec3(0.897f, 0.741f, 0.465f);
+        vmath_convex_t ba = vmath_convex_box(ea, vec3(0, 0, 0), quat(0, 0, 0, 1));
+        vmath_convex_t bb = vmath_convex_box(eb, vec3(0, 0, 0), quat(0, 0, 0, 1));
+        const vec3_t   e  = vec3_add(ba.extents, bb.extents);
+
+        concentric = concentric && vmath_epa_penetration(&ba, &bb, NULL, NULL, &deep, NULL, NULL)
+                                && fabsf(deep - fminf(e.x, fminf(e.y, e.z))) < 1e-3f;
+    }
+
+    test_assert(fabsf(d - 1.5f) < 1e-5f && fabsf(pa.x - 1.0f) < 1e-5f && fabsf(pa.y - 0.5f) < 1e-5f && fabsf(pb.x - 2.5f) < 1e-5f
+                && fabsf(w - 1.4f) < 1e-5f && hit && fabsf(depth - 0.25f) < 1e-4f && fabsf(n.y - 1.0f) < 1e-4f
+                && !vmath_gjk_intersect(&a, &b, NULL) && concentric, VOIDVAL);
+}
+
+void vmath_test_expr(void)
+{
+    static vmath_expr_t e;
+
+    const float  px[5] = { 0, 1, 2, 3, 4 }, py[5] = { 0 }, pz[5] = { 0 }, speed[5] = { 1, 1, 2, 2, 4 };
+    const float* inputs[] = { px, py, pz, speed };
+    float        rx[5], ry[5], rz[5], d[5];
+    float*       outputs[] = { rx, ry, rz, d };
+    bool         compiled, rejected, ordered;
+    int          operations;
+
+    vmath_expr_init(&e);
+    vmath_expr_input(&e, "p", VMATH_EXPR_VEC3);
+    vmath_expr_input(&e, "speed", VMATH_EXPR_FLOAT);
+    vmath_expr_output(&e, "r", VMATH_EXPR_VEC3);
+    vmath_expr_output(&e, "d", VMATH_EXPR_FLOAT);
+
+    /* p - vec3(1, 2, 0) is shared, 0.5 * 2.0 is folded away */
+    compiled = vmath_expr_compile(&e, "r = (p - vec3(1, 2, 0)).zxy * speed * (0.5 * 2.0); d = dot(p - vec3(1, 2, 0), p - vec3(1, 2, 0))");
+    vmath_expr_run(&e, inputs, outputs, 5);
+    operations = e.code_count;
+
+    /* 2 constants, 4 loads, 2 sub, 3 mul, 1 mul and 2 madd, 4 stores */
+    compiled = compiled && operations == 18 && ry[0] == -1.0f && rz[3] == -4.0f && rx[4] == 0.0f && ry[4] == 12.0f && d[2] == 5.0f;
+    rejected = !vmath_expr_compile(&e, "r = p + speed.xy") && e.error[0];
+    rejected = rejected && !vmath_expr_compile(&e, "d = sin()") && !vmath_expr_compile(&e, "d = unknown()") && e.error[0];
+
+    /* mat * vec is mat3_mulv3: the second row of mat3_t data */
+    ordered = vmath_expr_compile(&e, "r = mat3(1, 2, 3, 4, 5, 6, 7, 8, 9) * vec3(0, 1, 0); d = speed");
+    vmath_expr_run(&e, inputs, outputs, 1);
+    ordered = ordered && rx[0] == 4.0f && ry[0] == 5.0f && rz[0] == 6.0f;
+
+    test_assert(compiled && rejected && ordered, VOIDVAL);
+}
+
+void vmath_test_native(void)
+{
+    const vec3_t  t[2] = { vec3(1, 2, 3), vec3(-4, 0, 5) };
+    const quat_t  r[2] = { quat(0, 0.6f, 0, 0.8f), quat(0.5f, 0.5f, 0.5f, 0.5f) };
+    const vec3_t  s[2] = { vec3(1, 1, 1), vec3(2, 3, 4) };
+    const int     bones[8]   = { 0, 1, 0, 0, 1, 0, 0, 0 };
+    const float   weights[8] = { 0.25f, 0.75f, 0, 0, 1, 0, 0, 0 };
+    const float   spheres[6][4] = {
+        { 0, 0, -10, 1 }, { 0, 0, 10, 1 }, { 11, 0, -10, 2 }, { 100, 0, -10, 1 }, { 0, 0, -200, 1 }, { 0, 3, -50, 1 },
+    };
+    float         trs[2 * 16], points[2 * 3] = { 1, 2, 3, -4, 0, 5 }, skinned[2 * 3], planes[6 * 4];
+    float         palette[1 + 2 * 8]; /* palette + 1 is not 16 bytes aligned */
+    mat4_t        m[2];
+    vec3_t        p[2], expect[2];
+    dquat_t       dq[2];
+    int           visible[6], visible_count, i;
+    bool          same = true;
+
+    vmath_native_compose_trs(trs, t[0].m, r[0].m, s[0].m, 1);
+    vmath_native_compose_trs(trs + 16, t[1].m, r[1].m, s[1].m, 1);
+    mat4_composetrs(m, t, r, s, 2);
+    for (i = 0; i < 32; i++) same = same && fabsf(trs[i] - m[i / 16].data[i % 16]) < 1e-6f;
+
+    /* In place */
+    vmath_native_transform_points(m[1].data, points, points, 2);
+    for (i = 0; i < 2; i++)
+    {
+        expect[i] = mat4_mulv3(m[1], t[i]);
+        same = same && fabsf(points[3 * i] - expect[i].x) < 1e-4f && fabsf(points[3 * i + 1] - expect[i].y) < 1e-4f && fabsf(points[3 * i + 2] - expect[i].z) < 1e-4f;
+    }
+
+    dq[0] = dquat_fromquat(r[0], t[0]);
+    dq[1] = dquat_fromquat(r[1], t[1]);
+    memcpy(palette + 1, dq, sizeof(dq));
+    vmath_native_skin(skinned, NULL, t[0].m, NULL, bones, weights, 1, palette + 1, 2);
+    vmath_native_skin(skinned + 3, NULL, t[1].m, NULL, bones + 4, weights + 4, 1, palette + 1, 2);
+    dquat_skin(p, NULL, t, NULL, bones, weights, 2, dq);
+    for (i = 0; i < 2; i++)
+    {
+        same = same && fabsf(skinned[3 * i] - p[i].x) < 1e-5f && fabsf(skinned[3 * i + 1] - p[i].y) < 1e-5f && fabsf(skinned[3 * i + 2] - p[i].z) < 1e-5f;
+    }
+
+    /* 90 degree camera at origin looking at -z, near 1, far 100 */
+    vmath_native_frustum_planes(mat4_perspective(radians(90.0f), 1.0f, 1.0f, 100.0f).data, planes, 1);
+    visible_count = vmath_native_cull_spheres(planes, 6, spheres[0], 6, visible);
+
+    test_assert(vmath_native_abi_version() == VMATH_NATIVE_ABI_VERSION && same
+                && visible_count == 3 && visible[0] == 0 && visible[1] == 2 && visible[2] == 5, VOIDVAL);
+}
+
+void vmath_test_transform(void)
+{
+    transform_store_t store;
+    transform_id_t    root, child, other, grandchild, reused;
+    mat4_t            world;
+    int               first, second, moved;
+    bool              ok;
+
+    transform_store_init(&store, 4);
+    root       = transform_store_create(&store, transform_none());
+    child      = transform_store_create(&store, root);
+    other      = transform_store_create(&store, transform_none());
+    grandchild = transform_store_create(&store, child);
+
+    /* Child at (0, 2, 0) under a root at (1, 0, 0) rotated 90 degree around z */
+    transform_store_settrs(&store, root, vec3(1, 0, 0), quat_fromaxis(vec3(0, 0, 1), radians(90.0f)), vec3(1, 1, 1));
+    transform_store_setposition(&store, child, vec3(0, 2, 0));
+    transform_store_update(&store);
+    first = store.changed_count;
+    world = *transform_store_world(&store, child);
+
+    /* Moving the child update it and the grandchild only */
+    transform_store_setposition(&store, child, vec3(0, 3, 0));
+    transform_store_update(&store);
+    second = store.changed_count;
+
+    /* Reparent the root under a later node, then destroy the subtree */
+    transform_store_setparent(&store, root, other);
+    transform_store_setposition(&store, other, vec3(0, 0, 5));
+    transform_store_update(&store);
+    moved = transform_store_world(&store, grandchild)->m32 == 5.0f && store.parent[transform_store_index(&store, root)] == transform_store_index(&store, other);
+    transform_store_destroy(&store, root);
+    reused = transform_store_create(&store, other);
+    transform_store_update(&store);
+
+    ok = first == 4 && fabsf(world.m30 + 1.0f) < 1e-5f && fabsf(world.m31) < 1e-5f && second == 2 && moved
+      && !transform_store_valid(&store, grandchild) && transform_store_valid(&store, reused) && store.count == 2
+      && !transform_store_setparent(&store, other, reused);
+
+    transform_store_free(&store);
+    test_assert(ok, VOIDVAL);
+}
+
+void vmath_test_gpu(void)
+{
+    const vec3_t t[2] = { vec3(1, 2, 3), vec3(-4, 0, 5) };
+    const quat_t r[2] = { quat(0, 0.6f, 0, 0.8f), quat(0.5f, 0.5f, 0.5f, 0.5f) };
+    const vec3_t s[2] = { vec3(1, 1, 1), vec3(2, 3, 4) };
+    const vec3_t n[2] = { vec3(1, 0, -1), vec3(0, -0.5f, 2) };
+    mat4_t       m[2], inv;
+    vec4_t       buffer[2 * 4 + 1]; /* (float*)buffer + 1 is not 16 bytes aligned */
+    float*       out = buffer[0].m;
+    uint32_t     normal;
+    int          i, j, k;
+    bool         same = true;
+
+    mat4_composetrs(m, t, r, s, 2);
+
+    vmath_gpu_write_mat4(out, m, 2);
+    same = same && memcmp(out, m, sizeof(m)) == 0;
+
+    /* Unaligned dst take the normal stores */
+    vmath_gpu_write_mat3x4(out + 1, m, 2);
+    for (i = 0; i < 2; i++)
+    {
+        for (j = 0; j < 12; j++) same = same && out[1 + 12 * i + j] == m[i].m[j % 4][j / 4];
+    }
+
+    vmath_gpu_write_normal(out, m, 2);
+    for (i = 0; i < 2; i++)
+    {
+        inv = mat4_inverse(m[i]);
+        for (j = 0; j < 3; j++)
+        {
+            for (k = 0; k < 3; k++) same = same && fabsf(out[12 * i + 4 * j + k] - inv.m[k][j]) < 1e-5f;
+            same = same && out[12 * i + 4 * j + 3] == 0.0f;
+        }
+    }
+
+    vmath_gpu_write_vertices(out, t, n, 2);
+    memcpy(&normal, out + 3, sizeof(normal));
+    same = same && out[0] == 1.0f && out[1] == 2.0f && out[2] == 3.0f && normal == (511u | (513u << 20)) && out[4] == -4.0f;
+    memcpy(&normal, out + 7, sizeof(normal));
+    same = same && normal == ((768u << 10) | (511u << 20));
+
+    vmath_gpu_write_vec3(out, t, 1.0f, 2);
+    test_assert(same && out[4] == -4.0f && out[6] == 5.0f && out[7] == 1.0f && out[3] == 1.0f, VOIDVAL);
+}
+
+void vmath_test_reduce(void)
+{
+    enum { COUNT = 1001, MT_COUNT = 100000 };
+
+    static vec3_t       points[COUNT], many[MT_COUNT];
+    vmath_reduce_sums_t sums[3];
+    vmath_reduce_t      all, merged, mt;
+    double              mean[3] = { 0, 0, 0 }, cov[3][3] = { { 0 } };
+    int                 i, j, k, pass;
+    bool                same = true, inside = true, threaded = true;
+
+    /* Correlated points far from the origin, where plain float sums lose the covariance */
+    for (i = 0; i < COUNT; i++)
+    {
+        const float u = (float)(i % 17) - 8.0f, v = (float)(i % 11) - 5.0f;
+        points[i] = vec3(10000.0f + u, -5000.0f + 0.5f * u + v, 2000.0f - v);
+        for (j = 0; j < 3; j++) mean[j] += points[i].m[j] / COUNT;
+    }
+    for (i = 0; i < COUNT; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            for (k = 0; k < 3; k++) cov[j][k] += (points[i].m[j] - mean[j]) * (points[i].m[k] - mean[k]) / COUNT;
+        }
+    }
+
+    vmath_reduce(points, COUNT, VMATH_REDUCE_ALL, &all);
+
+    /* Split and merge */
+    for (i = 0; i < 3; i++)
+    {
+        vmath_reduce_begin(&sums[i], points[0]);
+        vmath_reduce_add(&sums[i], points + i * 400, i < 2 ? 400 : COUNT - 800, VMATH_REDUCE_ALL);
+    }
+    vmath_reduce_merge(&sums[0], &sums[1]);
+    vmath_reduce_merge(&sums[0], &sums[2]);
+    vmath_reduce_end(&sums[0], VMATH_REDUCE_ALL, &merged);
+    vmath_reduce_sphere(points, COUNT, &merged.center, &merged.radius);
+
+    for (j = 0; j < 3; j++)
+    {
+        same = same && fabs(all.centroid.m[j] - mean[j]) < 1e-3 && fabs(merged.centroid.m[j] - mean[j]) < 1e-3;
+        for (k = 0; k < 3; k++)
+        {
+            same = same && fabs(all.covariance.m[j][k] - cov[j][k]) < 1e-4 * (1.0 + fabs(cov[j][k]));
+            same = same && fabs(merged.covariance.m[j][k] - cov[j][k]) < 1e-4 * (1.0 + fabs(cov[j][k]));
+        }
+    }
+    /* Exact in double, the float results are the whole error */
+    for (i = 0; i < COUNT; i++)
+    {
+        double da = 0.0, dm = 0.0;
+        for (j = 0; j < 3; j++)
+        {
+            da += ((double)points[i].m[j] - all.center.m[j]) * ((double)points[i].m[j] - all.center.m[j]);
+            dm += ((double)points[i].m[j] - merged.center.m[j]) * ((double)points[i].m[j] - merged.center.m[j]);
+        }
+        inside = inside && da <= (double)all.radius * all.radius && dm <= (double)merged.radius * merged.radius;
+    }
+
+    /* Multi-threaded split and merge, identical and periodic points give chunk spheres which do not grow */
+    vmath_jobs_init(4);
+    for (pass = 0; pass < 2; pass++)
+    {
+        for (i = 0; i < MT_COUNT; i++)
+        {
+            many[i] = pass == 0 ? vec3(1.0f, 2.0f, 3.0f) : vec3((float)(i % 7) * 0.1f, (float)(i % 5), -1.0f);
+        }
+        vmath_reduce_mt(many, MT_COUNT, VMATH_REDUCE_ALL, &mt);
+        threaded = threaded && mt.radius == mt.radius && mt.center.x == mt.center.x && mt.center.y == mt.center.y && mt.center.z == mt.center.z;
+        for (i = 0; i < MT_COUNT; i++)
+        {
+            double dm = 0.0;
+            for (j = 0; j < 3; j++)
+            {
+                dm += ((double)many[i].m[j] - mt.center.m[j]) * ((double)many[i].m[j] - mt.center.m[j]);
+            }
+            threaded = threaded && dm <= (double)mt.radius * mt.radius;
+        }
+    }
+    vmath_jobs_shutdown();
+    threaded = threaded && fabsf(mt.centroid.y - 2.0f) < 1e-3f && mt.max.x == 0.6f;
+
+    test_assert(same && inside && threaded && all.min.x == 9992.0f && all.max.z == 2005.0f && merged.min.y == all.min.y
+                && all.radius < 1.2f * 0.5f * vec3_distance(all.min, all.max), VOIDVAL);
+}
+
+void vmath_test_spatial(void)
+{
+    enum { COUNT = 1000 };
+
+    static uint32_t keys[COUNT], orig[COUNT];
+    static uint64_t keys64[COUNT], orig64[COUNT];
+    static int      order[COUNT], ids[COUNT];
+    static vec3_t   points[COUNT];
+    ivec3_t         cells[64];
+    uint32_t        hkeys[64], akeys[7];
+    uint64_t        akeys64[7];
+    vmath_grid_t    grid = vmath_grid(vec3(-1.0f, -1.0f, -1.0f), vec3(1.0f, 1.0f, 1.0f));
+    void*           arrays[2] = { points, ids };
+    const int       sizes[2]  = { sizeof(vec3_t), sizeof(int) };
+    int             i;
+    bool            morton, hilbert = true, array = true, sorted = true;
+
+    morton = vmath_morton30(ivec3(1, 0, 0)) == 1 && vmath_morton30(ivec3(0, 1, 0)) == 2
+          && vmath_morton30(ivec3(0, 0, 1)) == 4 && vmath_morton30(ivec3(1023, 1023, 1023)) == 0x3FFFFFFFu
+          && vmath_morton63(ivec3(1 << 20, 0, 0)) == 1ull << 60
+          && vmath_morton30_decode(vmath_morton30(ivec3(5, 700, 1000))).y == 700
+          && vmath_morton63_decode(vmath_morton63(ivec3(5, 700, 2000000))).z == 2000000;
+
+    /* The 64 cells of a 4x4x4 cube are the first 64 keys of both curves, in face neighbour order */
+    for (i = 0; i < 64; i++)
+    {
+        const ivec3_t c = ivec3(i & 3, (i >> 2) & 3, i >> 4);
+        hkeys[i] = vmath_hilbert30(c);
+        hilbert  = hilbert && hkeys[i] < 64 && vmath_hilbert63(c) < 64;
+        if (hkeys[i] < 64) cells[hkeys[i]] = c;
+    }
+    for (i = 1; i < 64 && hilbert; i++)
+    {
+        const int d = abs(cells[i].x - cells[i - 1].x) + abs(cells[i].y - cells[i - 1].y) + abs(cells[i].z - cells[i - 1].z);
+        hilbert = d == 1;
+    }
+
+    for (i = 0; i < COUNT; i++)
+    {
+        points[i] = vec3(sinf(i * 0.37f), cosf(i * 1.13f), (float)(i % 13) / 6.0f - 1.0f);
+        ids[i]    = i;
+    }
+
+    /* Vector encoders against the scalar ones, 4 points and a tail */
+    vmath_morton30_array(akeys, points, 7, &grid);
+    for (i = 0; i < 7; i++) array = array && akeys[i] == vmath_morton30(vmath_grid_cell(&grid, points[i], 10));
+    vmath_hilbert30_array(akeys, points, 7, &grid);
+    for (i = 0; i < 7; i++) array = array && akeys[i] == vmath_hilbert30(vmath_grid_cell(&grid, points[i], 10));
+    vmath_hilbert63_array(akeys64, points, 7, &grid);
+    for (i = 0; i < 7; i++) array = array && akeys64[i] == vmath_hilbert63(vmath_grid_cell(&grid, points[i], 21));
+
+    /* Sort, keys have duplicates to check stability */
+    vmath_hilbert30_array(keys, points, COUNT, &grid);
+    for (i = 0; i < COUNT; i++) keys[i] >>= 20, orig[i] = keys[i];
+    sorted = vmath_radix_sort32(keys, order, COUNT);
+    for (i = 0; i < COUNT; i++)
+    {
+        sorted = sorted && keys[i] == orig[order[i]];
+        sorted = sorted && (i == 0 || keys[i - 1] < keys[i] || (keys[i - 1] == keys[i] && order[i - 1] < order[i]));
+    }
+
+    vmath_morton63_array(keys64, points, COUNT, &grid);
+    for (i = 0; i < COUNT; i++) orig64[i] = keys64[i];
+    sorted = sorted && vmath_radix_sort64(keys64, order, COUNT);
+    for (i = 0; i < COUNT; i++)
+    {
+        sorted = sorted && keys64[i] == orig64[order[i]] && (i == 0 || keys64[i - 1] <= keys64[i]);
+    }
+
+    sorted = sorted && vmath_reorder(order, COUNT, arrays, sizes, 2);
+    for (i = 0; i < COUNT; i++)
+    {
+        sorted = sorted && ids[i] == order[i] && vmath_morton63(vmath_grid_cell(&grid, points[i], 21)) == keys64[i];
+    }
+
+    test_assert(morton && hilbert && array && sorted, VOIDVAL);
+}
+
 void* csfx_main(void* userdata, int old_state, int state)
 {
     vmath_test_vec2();
+    vmath_test_dquat();
+    vmath_test_noise();
+    vmath_test_random();
+    vmath_test_spline();
+    vmath_test_anim();
+    vmath_test_color();
+    vmath_test_jobs();
+    vmath_test_memory();
+    vmath_test_file();
+    vmath_test_text();
+    vmath_test_solve();
+    vmath_test_svd();
+    vmath_test_rotation();
+    vmath_test_geometry();
+    vmath_test_gjk();
+    vmath_test_expr();
+    vmath_test_native();
+    vmath_test_transform();
+    vmath_test_gpu();
+    vmath_test_reduce();
+    vmath_test_spatial();
     
     return userdata;
 }
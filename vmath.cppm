@@ -0,0 +1,46 @@
+/******************************************************
+ * vmath - C++20 module interface
+ *
+ * @author: MaiHD
+ * @license: NULL
+ * @copyright: MaiHD @ ${HOME}, 2017 - 2018
+ ******************************************************/
+
+/**
+ * import vmath; exports every type, constant and function of vmath.h,
+ * so a translation unit reads the compiled interface instead of parsing
+ * 6000 lines of inline functions again.
+ *
+ * The VMATH_BUILD_* switches on the command line of the interface select
+ * which types the module holds, e.g. -DVMATH_BUILD_MAT2=0 -DVMATH_BUILD_DQUAT=0
+ *
+ * Build:
+ *   GCC  : g++ -std=c++20 -fmodules-ts -fpermissive -c -x c++ vmath.cppm
+ *   Clang: clang++ -std=c++20 --precompile vmath.cppm -o vmath.pcm
+ *   MSVC : cl /std:c++20 /interface /TP /c vmath.cppm
+ *
+ * Macros are not exported: VMATH_PI, vec3_arg_t... stay vmath.h only.
+ * Do not include vmath.h in a translation unit that imports vmath.
+ */
+module;
+
+/* System headers belong to the global module, vmath.h reuses them through their guards */
+#include <math.h>
+#include <float.h>
+#include <limits.h>
+#include <assert.h>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+#elif defined(__SSE__) || defined(__SSE2__) || defined(__SSSE3__) || defined(_M_IX86) || defined(_M_X64)
+# include <mmintrin.h>
+# include <emmintrin.h>
+#endif
+
+export module vmath;
+
+#define VMATH_MODULE 1
+
+export
+{
+#include "vmath.h"
+}
@@ -48,7 +48,37 @@
 #else /* Windows MSVC */
 # define __vmath_attr__     __forceinline __vmath_nothrow__
 #endif
-#define __vmath__ /*{space}*/ __vmath_attr__ static __vmath_inline__ 
+/* The module interface (vmath.cppm) needs external linkage to export functions and constants.
+ * Constants are constexpr: GCC 12 imports inline const objects without their initializers, as zeros */
+#if defined(VMATH_MODULE)
+# define __vmath_static__ /*{space}*/
+# define __vmath_const__  /*{space}*/ inline constexpr
+#else
+# define __vmath_static__ /*{space}*/ static
+# define __vmath_const__  /*{space}*/ static const
+#endif
+
+#define __vmath__ /*{space}*/ __vmath_attr__ __vmath_static__ __vmath_inline__ 
+
+/* Loop kernels over arrays, leave the inlining decision to the compiler */
+#define __vmath_batch__ /*{space}*/ __vmath_nothrow__ __vmath_static__ __vmath_inline__
+
+/* Heavy functions: cold run once per setup or frame, hot per object, see VMATH_OUTLINE */
+#if VMATH_OUTLINE >= 1 && defined(__GNUC__)
+# define __vmath_cold__ /*{space}*/ __attribute__((cold)) __vmath_nothrow__
+#elif VMATH_OUTLINE >= 1
+# define __vmath_cold__ /*{space}*/ __vmath_nothrow__
+#else
+# define __vmath_cold__ /*{space}*/ __vmath__
+#endif
+
+#if VMATH_OUTLINE >= 2 && defined(__GNUC__)
+# define __vmath_hot__  /*{space}*/ __attribute__((hot)) __vmath_nothrow__
+#elif VMATH_OUTLINE >= 2
+# define __vmath_hot__  /*{space}*/ __vmath_nothrow__
+#else
+# define __vmath_hot__  /*{space}*/ __vmath__
+#endif
 
 #ifndef VMATH_PI
 #define VMATH_PI 3.14159265358979f
@@ -77,6 +107,10 @@
 #define VMATH_BUILD_QUAT 1
 #endif
 
+#ifndef VMATH_BUILD_DQUAT
+#define VMATH_BUILD_DQUAT 1
+#endif
+
 #ifndef VMATH_BUILD_MAT2
 #define VMATH_BUILD_MAT2 1
 #endif
@@ -89,6 +123,12 @@
 #define VMATH_BUILD_MAT4 1
 #endif
 
+/* Compile heavy functions once in the VMATH_IMPL translation unit: 1 the cold ones, 2 the hot ones too,
+ * the VMATH_IMPL unit must be compiled in the language of its users (C or C++) */
+#ifndef VMATH_OUTLINE
+#define VMATH_OUTLINE 0
+#endif
+
 #ifndef VMATH_GLSL_LIKE
 #define VMATH_GLSL_LIKE 1
 #endif
@@ -130,6 +170,12 @@
 # endif
 #endif
 
+#if !VMATH_BUILD_QUAT
+# if VMATH_BUILD_DQUAT
+#  error "Dual quaternion module require Quaternion module"
+# endif
+#endif
+
 /**
  * ARM NEON support checking
  */
@@ -231,7 +277,7 @@ typedef float32x4_t float4_t;
 typedef __m64       float2_t;
 typedef __m128      float3_t;
 typedef __m128      float4_t;
-static const __m128 __M128_ZERO = { 0, 0, 0, 0 };
+__vmath_const__ __m128 __M128_ZERO = { 0, 0, 0, 0 };
 #else
 typedef float       float2_t[2];
 typedef float       float3_t[3];
@@ -328,6 +374,22 @@ typedef union vmath_quat
     float4_t data;
 } quat_t;
 
+/**
+ * Dual quaternion data structure
+ * Rigid transform (rotation + translation) in 8 floats:
+ * real part is the rotation, dual part is 0.5 * translation * real
+ */
+typedef union vmath_dquat
+{
+    struct
+    {
+        quat_t real;
+        quat_t dual;
+    };
+    quat_t   parts[2];
+    float    data[8];
+} dquat_t;
+
 /**
  * Matrix 2x2 data structure
  */
@@ -381,6 +443,7 @@ static_assert(sizeof(vec2_t) == sizeof(float2_t)  , "Size of vec2_t is not valid
 static_assert(sizeof(vec3_t) == sizeof(float3_t)  , "Size of vec3_t is not valid");
 static_assert(sizeof(vec4_t) == sizeof(float4_t)  , "Size of vec3_t is not valid");
 static_assert(sizeof(quat_t) == sizeof(float4_t)  , "Size of quat_t is not valid");
+static_assert(sizeof(dquat_t) == 2 * sizeof(quat_t), "Size of dquat_t is not valid");
 static_assert(sizeof(mat2_t) == 4  * sizeof(float), "Size of mat2_t is not valid");
 static_assert(sizeof(mat3_t) == 9  * sizeof(float), "Size of mat3_t is not valid");
 static_assert(sizeof(mat4_t) == 16 * sizeof(float), "Size of mat4_t is not valid");
@@ -392,6 +455,7 @@ static_assert(sizeof(mat4_t) == 16 * sizeof(float), "Size of mat4_t is not valid
 #define vec3_arg_t const vec3_t&
 #define vec4_arg_t const vec4_t&
 #define quat_arg_t const quat_t&
+#define dquat_arg_t const dquat_t&
 #define mat2_arg_t const mat2_t&
 #define mat3_arg_t const mat3_t&
 #define mat4_arg_t const mat4_t&
@@ -400,6 +464,7 @@ static_assert(sizeof(mat4_t) == 16 * sizeof(float), "Size of mat4_t is not valid
 #define vec3_arg_t vec3_t
 #define vec4_arg_t vec4_t
 #define quat_arg_t quat_t
+#define dquat_arg_t dquat_t
 #define mat2_arg_t mat2_t
 #define mat3_arg_t mat3_t
 #define mat4_arg_t mat4_t
@@ -415,64 +480,66 @@ static_assert(sizeof(mat4_t) == 16 * sizeof(float), "Size of mat4_t is not valid
  ********************/
 #if VMATH_CONSTANTS
 
-static const vec2_t VEC2_ZERO  = {  0,  0 };
-static const vec2_t VEC2_UNIT  = {  1,  1 };
-static const vec2_t VEC2_UNITX = {  1,  1 };
-static const vec2_t VEC2_UNITY = {  0,  1 };
-static const vec2_t VEC2_LEFT  = { -1,  0 };
-static const vec2_t VEC2_RIGHT = {  1,  0 };
-static const vec2_t VEC2_UP    = {  0,  1 };
-static const vec2_t VEC2_DOWN  = {  0, -1 };
-
-static const vec3_t VEC3_ZERO  = {  0,  0,  0 };
-static const vec3_t VEC3_UNIT  = {  1,  1,  1 };
-static const vec3_t VEC3_UNITX = {  1,  0,  0 };
-static const vec3_t VEC3_UNITY = {  0,  1,  0 };
-static const vec3_t VEC3_UNITZ = {  0,  0,  1 };
-static const vec3_t VEC3_LEFT  = { -1,  0,  0 };
-static const vec3_t VEC3_RIGHT = {  1,  0,  0 };
-static const vec3_t VEC3_UP    = {  0,  1,  0 };
-static const vec3_t VEC3_DOWN  = {  0, -1,  0 };
-static const vec3_t VEC3_BACK  = {  0,  0, -1 };
-static const vec3_t VEC3_FORE  = {  0,  0,  1 };
-
-static const vec4_t VEC4_ZERO  = {  0,  0,  0, 0 };
-static const vec4_t VEC4_UNIT  = {  1,  1,  1, 1 };
-static const vec4_t VEC4_UNITX = {  1,  0,  0, 0 };
-static const vec4_t VEC4_UNITY = {  0,  1,  0, 0 };
-static const vec4_t VEC4_UNITZ = {  0,  0,  1, 0 };
-static const vec4_t VEC4_UNITW = {  0,  0,  0, 1 };
-static const vec4_t VEC4_LEFT  = { -1,  0,  0, 0 };
-static const vec4_t VEC4_RIGHT = {  1,  0,  0, 0 };
-static const vec4_t VEC4_UP    = {  0,  1,  0, 0 };
-static const vec4_t VEC4_DOWN  = {  0, -1,  0, 0 };
-static const vec4_t VEC4_BACK  = {  0,  0, -1, 0 };
-static const vec4_t VEC4_FORE  = {  0,  0,  1, 0 };
-
-static const quat_t QUAT_ZERO     = { 0, 0, 0, 0 };
-static const quat_t QUAT_IDENTITY = { 0, 0, 0, 1 };
-
-static const mat2_t MAT2_ZERO     = { 1, 0, 0, 1 };
-static const mat2_t MAT2_IDENTITY = { 1, 0, 0, 1 };
-
-static const mat3_t MAT3_ZERO     = {
+__vmath_const__ vec2_t VEC2_ZERO  = {  0,  0 };
+__vmath_const__ vec2_t VEC2_UNIT  = {  1,  1 };
+__vmath_const__ vec2_t VEC2_UNITX = {  1,  1 };
+__vmath_const__ vec2_t VEC2_UNITY = {  0,  1 };
+__vmath_const__ vec2_t VEC2_LEFT  = { -1,  0 };
+__vmath_const__ vec2_t VEC2_RIGHT = {  1,  0 };
+__vmath_const__ vec2_t VEC2_UP    = {  0,  1 };
+__vmath_const__ vec2_t VEC2_DOWN  = {  0, -1 };
+
+__vmath_const__ vec3_t VEC3_ZERO  = {  0,  0,  0 };
+__vmath_const__ vec3_t VEC3_UNIT  = {  1,  1,  1 };
+__vmath_const__ vec3_t VEC3_UNITX = {  1,  0,  0 };
+__vmath_const__ vec3_t VEC3_UNITY = {  0,  1,  0 };
+__vmath_const__ vec3_t VEC3_UNITZ = {  0,  0,  1 };
+__vmath_const__ vec3_t VEC3_LEFT  = { -1,  0,  0 };
+__vmath_const__ vec3_t VEC3_RIGHT = {  1,  0,  0 };
+__vmath_const__ vec3_t VEC3_UP    = {  0,  1,  0 };
+__vmath_const__ vec3_t VEC3_DOWN  = {  0, -1,  0 };
+__vmath_const__ vec3_t VEC3_BACK  = {  0,  0, -1 };
+__vmath_const__ vec3_t VEC3_FORE  = {  0,  0,  1 };
+
+__vmath_const__ vec4_t VEC4_ZERO  = {  0,  0,  0, 0 };
+__vmath_const__ vec4_t VEC4_UNIT  = {  1,  1,  1, 1 };
+__vmath_const__ vec4_t VEC4_UNITX = {  1,  0,  0, 0 };
+__vmath_const__ vec4_t VEC4_UNITY = {  0,  1,  0, 0 };
+__vmath_const__ vec4_t VEC4_UNITZ = {  0,  0,  1, 0 };
+__vmath_const__ vec4_t VEC4_UNITW = {  0,  0,  0, 1 };
+__vmath_const__ vec4_t VEC4_LEFT  = { -1,  0,  0, 0 };
+__vmath_const__ vec4_t VEC4_RIGHT = {  1,  0,  0, 0 };
+__vmath_const__ vec4_t VEC4_UP    = {  0,  1,  0, 0 };
+__vmath_const__ vec4_t VEC4_DOWN  = {  0, -1,  0, 0 };
+__vmath_const__ vec4_t VEC4_BACK  = {  0,  0, -1, 0 };
+__vmath_const__ vec4_t VEC4_FORE  = {  0,  0,  1, 0 };
+
+__vmath_const__ quat_t QUAT_ZERO     = { 0, 0, 0, 0 };
+__vmath_const__ quat_t QUAT_IDENTITY = { 0, 0, 0, 1 };
+
+__vmath_const__ dquat_t DQUAT_IDENTITY = { 0, 0, 0, 1, 0, 0, 0, 0 };
+
+__vmath_const__ mat2_t MAT2_ZERO     = { 1, 0, 0, 1 };
+__vmath_const__ mat2_t MAT2_IDENTITY = { 1, 0, 0, 1 };
+
+__vmath_const__ mat3_t MAT3_ZERO     = {
     0, 0, 0,
     0, 0, 0,
     0, 0, 0,
 };
-static const mat3_t MAT3_IDENTITY = {
+__vmath_const__ mat3_t MAT3_IDENTITY = {
     1, 0, 0,
     0, 1, 0,
     0, 0, 1,
 };
 
-static const mat4_t MAT4_ZERO     = {
+__vmath_const__ mat4_t MAT4_ZERO     = {
     0, 0, 0, 0,
     0, 0, 0, 0,
     0, 0, 0, 0,
     0, 0, 0, 0,
 };
-static const mat4_t MAT4_IDENTITY = {
+__vmath_const__ mat4_t MAT4_IDENTITY = {
     1, 0, 0, 0,
     0, 1, 0, 0,
     0, 0, 1, 0,
@@ -491,7 +558,7 @@ __vmath__ float vmath_rsqrt(float x)
     union
     {
         float x;
-        long  i;
+        int   i;
     } cvt; /* converter */
 
     cvt.x = x;
@@ -925,7 +992,7 @@ public: /* Constructors */
             r.y = 1;
             r.z = 1;
         }
-        r.w = 2.0f * cosf(c.w);
+        r.w = 2.0f * acosf(c.w < 1.0f ? c.w : 1.0f);
         return r;
     }
 
@@ -2318,6 +2385,36 @@ __vmath__ vec3_t vec3_refract(vec3_arg_t v, vec3_arg_t n, float eta)
         return vec3_sub(vec3_mulf(v, eta), vec3_mulf(v, (eta * vec3_dot(n, v) + vmath_fsqrt(k))));
 }
 
+/**
+ * Normalize an array of vectors
+ */
+__vmath_batch__ void vec3_normalizearray(vec3_t* out, const vec3_t* in, int count)
+{
+    int i;
+    for (i = 0; i < count; i++)
+    {
+        out[i] = vec3_normalize(in[i]);
+    }
+}
+
+/**
+ * Bounds of an array of points
+ * @note: count must be > 0
+ */
+__vmath_batch__ void vec3_bounds(const vec3_t* points, int count, vec3_t* min, vec3_t* max)
+{
+    vec3_t lo = points[0];
+    vec3_t hi = points[0];
+    int i;
+    for (i = 1; i < count; i++)
+    {
+        lo = vec3_min(lo, points[i]);
+        hi = vec3_max(hi, points[i]);
+    }
+    *min = lo;
+    *max = hi;
+}
+
 /* END OF VMATH_BUILD_VEC3 */
 #endif
 
@@ -2822,29 +2919,7 @@ __vmath__ quat_t quat_normalize(quat_arg_t q)
  * Create a quaternion with euler coordinate
  * @return: result quaternion
  */
-__vmath__ quat_t quat_euler(float x, float y, float z)
-{
-    float r;
-    float p;
-
-    r = z * 0.5f;
-    p = x * 0.5f;
-    y = y * 0.5f; // Now y min yaw
-
-    const float c1 = cosf(y);
-    const float c2 = cosf(p);
-    const float c3 = cosf(r);
-    const float s1 = sinf(y);
-    const float s2 = sinf(p);
-    const float s3 = sinf(r);
-
-    return quat(
-        s1 * s2 * c3 + c1 * c2 * s3,
-	    s1 * c2 * c3 + c1 * s2 * s3,
-	    c1 * s2 * c3 - s1 * c2 * s3,
-	    c1 * c2 * c3 - s1 * s2 * s3
-    );
-}
+__vmath_cold__ quat_t quat_euler(float x, float y, float z);
 
 /**
  * Create a quaternion with euler coordinate
@@ -2859,27 +2934,7 @@ __vmath__ quat_t quat_eulerv3(vec3_arg_t e)
  * Convert to an axis-angle representation.
  * @return: a axis-angle representation store in vec4_t union
  */
-__vmath__ vec4_t quat_toaxis(quat_arg_t q)
-{
-    quat_t c = q;
-    if (c.w != 0.0f)
-    {
-        c = quat_normalize(q);
-    }
-
-    vec4_t r;
-    const float den = sqrtf(1.0f - c.w * c.w);
-    if (den > 0.0001f)
-    {
-        r.xyz = vec3_divf(c.vec4.xyz, den);
-    } 
-    else
-    {
-        r.xyz = vec3(1, 0, 0);
-    }
-    r.w = 2.0f * cosf(c.w);
-    return r;
-}
+__vmath_cold__ vec4_t quat_toaxis(quat_arg_t q);
 
 /**
  * Convert axis-angle representation to quaternion 
@@ -2940,19 +2995,30 @@ __vmath__ quat_t quat_mul(quat_arg_t a, quat_arg_t b)
 /**
  * Get euler values present in Vector3D   
  */
-__vmath__ vec3_t quat_toeuler(quat_arg_t q)
+__vmath_cold__ vec3_t quat_toeuler(quat_arg_t q);
+
+/**
+ * Rotation matrix of an unit quaternion
+ */
+__vmath__ mat3_t quat_tomat3(quat_arg_t q)
 {
-    float s = 2.0f * (q.w * q.x + q.y * q.z);
-    float c = 1.0f - 2.0f * (q.x * q.x + q.y * q.y);
-    const float r = atan2f(s, c);
+    const float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
 
-    s = 2.0f * (q.w * q.y - q.z * q.x);
-    const float p = fabsf(s >= 1.0f) >= 1.0f ? copysignf(VMATH_PI * 0.5f, s) : s;
+    mat3_t r;
+    r.m[0][0] = 1.0f - 2.0f * (yy + zz);
+    r.m[0][1] = 2.0f * (xy + wz);
+    r.m[0][2] = 2.0f * (xz - wy);
 
-    s = 2.0f * (q.w * q.z + q.y * q.x);
-    c = 1.0f - 2.0f * (q.y * q.y + q.z * q.z);
-    const float y = atan2f(s, c);
-    return vec3(r, p, y);
+    r.m[1][0] = 2.0f * (xy - wz);
+    r.m[1][1] = 1.0f - 2.0f * (xx + zz);
+    r.m[1][2] = 2.0f * (yz + wx);
+
+    r.m[2][0] = 2.0f * (xz + wy);
+    r.m[2][1] = 2.0f * (yz - wx);
+    r.m[2][2] = 1.0f - 2.0f * (xx + yy);
+    return r;
 }
 
 /* END OF VMATH_BUILD_QUAT */
@@ -3142,7 +3208,7 @@ __vmath__ mat3_t mat3_transpose(mat3_arg_t m)
     mat3_t r;
     r.m00 = m.m00; r.m01 = m.m10; r.m02 = m.m20;
     r.m10 = m.m01; r.m11 = m.m11; r.m12 = m.m21;
-    r.m20 = m.m02; r.m12 = m.m12; r.m22 = m.m22;
+    r.m20 = m.m02; r.m21 = m.m12; r.m22 = m.m22;
     return r;
 }
 
@@ -3248,30 +3314,7 @@ __vmath__ float mat3_det(mat3_arg_t m)
 /**
  * Get inverted version of a matrix3x3
  */
-__vmath__ mat3_t mat3_inverse(mat3_arg_t m)
-{
-    float d = mat3_det(m);
-    if (d == 0.0f)
-    {
-        return m;
-    }
-
-    d = 1.0f / d;
-
-    mat3_t r;
-    r.m00 = d * (m.m11 * m.m22 - m.m12 * m.m21);
-    r.m01 = d * (m.m02 * m.m21 - m.m01 * m.m22);
-    r.m02 = d * (m.m01 * m.m12 - m.m02 * m.m11);
-
-    r.m10 = d * (m.m12 * m.m20 - m.m10 * m.m22);
-    r.m11 = d * (m.m00 * m.m22 - m.m02 * m.m20);
-    r.m12 = d * (m.m02 * m.m10 - m.m00 * m.m12);
-
-    r.m20 = d * (m.m10 * m.m21 - m.m11 * m.m20);
-    r.m21 = d * (m.m01 * m.m20 - m.m00 * m.m21);
-    r.m22 = d * (m.m00 * m.m11 - m.m01 * m.m10); 
-    return r;
-}
+__vmath_hot__ mat3_t mat3_inverse(mat3_arg_t m);
 
 /**
  * Multiplication between Matrix3x3 and Vector3D
@@ -3451,35 +3494,7 @@ __vmath__ mat4_t mat4_rotatez(float angle)
 /**
  * Create mat4 rotate matrix
  */
-__vmath__ mat4_t mat4_rotate3f(float x, float y, float z, float angle)
-{
-    const float c = cosf(-angle);
-    const float s = sinf(-angle);
-    const float t = 1.0f - c;
-  
-    mat4_t r;
-    /* Row 1 */
-    r.rows[0] = vec4(t * x * x + c,
-                     t * x * y - s * z,
-                     t * x * z + s * y,
-		     0.0f);
-
-    /* Row 2 */
-    r.rows[1] = vec4(t * x * y + s * z,
-		     t * y * y + c,
-		     t * y * z - s * x,
-		     0.0f);
-
-    /* Row 3 */
-    r.rows[2] = vec4(t * x * z - s * y,
-		     t * y * z + s * x,
-		     t * z * z + c,
-		     0.0f);
-
-    /* Row 4 */
-    r.rows[3] = vec4(0, 0, 0, 1.0f);
-    return r;
-}
+__vmath_cold__ mat4_t mat4_rotate3f(float x, float y, float z, float angle);
 
 /**
  * Create rotate matrix with axis and angle
@@ -3627,155 +3642,303 @@ __vmath__ mat4_t mat4_transpose(mat4_arg_t m)
 /**
  * Create orthographic projection matrix
  */
-__vmath__ mat4_t mat4_ortho(float l, float r,
-			                float b, float t,
-			                float n, float f)
+__vmath_cold__ mat4_t mat4_ortho(float l, float r,
+                                 float b, float t,
+                                 float n, float f);
+
+/**
+ * Create frustum matrix
+ */
+__vmath_cold__ mat4_t mat4_frustum(float l, float r,
+                                   float b, float t,
+                                   float n, float f);
+
+/**
+ * Create perspective projection matrix
+ */
+__vmath_cold__ mat4_t mat4_perspective(float fov, float aspect,
+                                       float znear, float zfar);
+
+/**
+ * Create view matrix when focus on the position
+ */
+__vmath_cold__ mat4_t mat4_lookat(vec3_arg_t eye, vec3_arg_t target, vec3_arg_t up);
+
+/**
+ * Calculate deternimant value
+ */
+__vmath_hot__ float mat4_det(mat4_arg_t m);
+
+/**
+ * Get inverse version of matrix4x4
+ */
+__vmath_hot__ mat4_t mat4_inverse(mat4_arg_t m);
+
+/**
+ * Transform an array of points by a matrix
+ */
+__vmath_batch__ void mat4_transformpoints(const mat4_t* m, vec3_t* out, const vec3_t* in, int count)
 {
-    const float x = 1.0f / (r - l);
-    const float y = 1.0f / (t - b);
-    const float z = 1.0f / (f - n);
-    
-    mat4_t m;
-    m.rows[0] = vec4(    2.0f * x,            0,            0,    0);
-    m.rows[1] = vec4(           0,     2.0f * y,            0,    0);
-    m.rows[2] = vec4(           0,            0,    -2.0f * z,    0);
-    m.rows[3] = vec4(-x * (l + r), -y * (b + t), -z * (n + f), 1.0f);
-    return m;
+    int i;
+    for (i = 0; i < count; i++)
+    {
+        out[i] = mat4_mulv3(*m, in[i]);
+    }
 }
 
+#if VMATH_BUILD_QUAT
 /**
- * Create frustum matrix
+ * Compose arrays of translation, rotation, scale to matrices (scale first)
  */
-__vmath__ mat4_t mat4_frustum(float l, float r,
-			                  float b, float t,
-			                  float n, float f)
+__vmath_batch__ void mat4_composetrs(mat4_t* out, const vec3_t* t, const quat_t* r, const vec3_t* s, int count)
 {
-    mat4_t m;
-    /* Row 1 */
-    m.rows[0] = vec4(2.0f / (r - l), 0, 0, 0);
-    /* Row 2 */
-    m.rows[1] = vec4(0, 2.0f / (t - b), 0, 0);
-    /* Row 3 */
-    m.rows[2] = vec4((r + l) / (r - l),
-		             (t + b) / (t - b),
-		             (f + b) / (f - n), 
-                     1.0f);
-    /* Row 4 */
-    m.rows[3] = vec4(0, 0, 2.0f / (f - n), 0);
-    return m;
+    int i;
+    for (i = 0; i < count; i++)
+    {
+        const quat_t q = r[i];
+        const float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+        const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+        const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+        out[i].rows[0] = vec4_mulf(vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f), s[i].x);
+        out[i].rows[1] = vec4_mulf(vec4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f), s[i].y);
+        out[i].rows[2] = vec4_mulf(vec4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f), s[i].z);
+        out[i].rows[3] = vec4(t[i].x, t[i].y, t[i].z, 1.0f);
+    }
 }
+#endif
+
+/* END OF VMATH_BUILD_MAT4 */
+#endif
 
+/**************************
+* Dual quaternion
+**************************/
+#if VMATH_BUILD_DQUAT
 /**
- * Create perspective projection matrix
+ * Create dual quaternion from real (rotation) and dual part
  */
-__vmath__ mat4_t mat4_perspective(float fov, float aspect,
-				                  float znear, float zfar)
+__vmath__ dquat_t dquat(quat_arg_t real, quat_arg_t dual)
 {
-    const float a = 1.0f / tanf(fov * 0.5f);
-    const float b = zfar / (znear - zfar);
-    
-    mat4_t r;
-    r.rows[0] = vec4(a / aspect,   0,         0,   0);
-    r.rows[1] = vec4(         0,   a,         0,   0);
-    r.rows[2] = vec4(         0,   0,         b,  -1);
-    r.rows[3] = vec4(         0,   0, znear * b,   0);
+    dquat_t r;
+    r.real = real;
+    r.dual = dual;
     return r;
 }
 
 /**
- * Create view matrix when focus on the position
+ * Create dual quaternion from rotation then translation
+ * @note: rotation should be unit quaternion
  */
-__vmath__ mat4_t mat4_lookat(vec3_arg_t eye, vec3_arg_t target, vec3_arg_t up)
+__vmath__ dquat_t dquat_fromquat(quat_arg_t q, vec3_arg_t t)
 {
-    const vec3_t z = vec3_normalize(vec3_sub(eye, target));
-    const vec3_t x = vec3_normalize(vec3_cross(up, z));
-    const vec3_t y = vec3_normalize(vec3_cross( z, x));
-
-    mat4_t r;
-    r.rows[0] = vec4(x.x, y.x, z.x, 0);
-    r.rows[1] = vec4(x.y, y.y, z.y, 0);
-    r.rows[2] = vec4(x.z, y.z, z.z, 0);
-
-    /* Row 4 */
-    r.rows[3] = vec4(-vec3_dot(x, eye), 
-                     -vec3_dot(y, eye), 
-                     -vec3_dot(z, eye), 
-                     1.0f);
+    /* equation: dual = 0.5 * quat(t, 0) * q */
+    dquat_t r;
+    r.real          = q;
+    r.dual.vec4.xyz = vec3_mulf(vec3_add(vec3_mulf(t, q.w), vec3_cross(t, q.vec4.xyz)), 0.5f);
+    r.dual.vec4.w   = -0.5f * vec3_dot(t, q.vec4.xyz);
     return r;
 }
 
 /**
- * Calculate deternimant value
+ * Create dual quaternion that contain translation only
  */
-__vmath__ float mat4_det(mat4_arg_t m)
+__vmath__ dquat_t dquat_translate(vec3_arg_t t)
 {
-    const float s1 = m.m00 * m.m11 - m.m10 * m.m01;
-    const float s2 = m.m00 * m.m12 - m.m10 * m.m02;
-    const float s3 = m.m00 * m.m13 - m.m10 * m.m03;
-    const float s4 = m.m01 * m.m12 - m.m11 * m.m02;
-    const float s5 = m.m01 * m.m13 - m.m11 * m.m03;
-    const float s6 = m.m02 * m.m13 - m.m12 * m.m03;
-  
-    const float c1 = m.m20 * m.m31 - m.m30 * m.m21;
-    const float c2 = m.m20 * m.m32 - m.m30 * m.m22;
-    const float c3 = m.m20 * m.m33 - m.m30 * m.m23;
-    const float c4 = m.m21 * m.m32 - m.m31 * m.m22;
-    const float c5 = m.m21 * m.m32 - m.m31 * m.m23;
-    const float c6 = m.m22 * m.m33 - m.m32 * m.m23;
+    return dquat_fromquat(QUAT_IDENTITY, t);
+}
 
-    return s1 * c6 - s2 * c5 + s3 * c4 + s4 * c3 - s5 * c2 + s6 * c1;
+/**
+ * Get translation part of an unit dual quaternion
+ */
+__vmath__ vec3_t dquat_translation(dquat_arg_t dq)
+{
+    /* equation: t = 2 * dual * conjugate(real) */
+    const vec3_t t = vec3_add(
+        vec3_sub(vec3_mulf(dq.dual.vec4.xyz, dq.real.w), vec3_mulf(dq.real.vec4.xyz, dq.dual.w)),
+        vec3_cross(dq.real.vec4.xyz, dq.dual.vec4.xyz)
+    );
+    return vec3_mulf(t, 2.0f);
 }
 
 /**
- * Get inverse version of matrix4x4
+ * Addition of two dual quaternions
  */
-__vmath__ mat4_t mat4_inverse(mat4_arg_t m)
+__vmath__ dquat_t dquat_add(dquat_arg_t a, dquat_arg_t b)
 {
-    const float s1 = m.m00 * m.m11 - m.m10 * m.m01;
-    const float s2 = m.m00 * m.m12 - m.m10 * m.m02;
-    const float s3 = m.m00 * m.m13 - m.m10 * m.m03;
-    const float s4 = m.m01 * m.m12 - m.m11 * m.m02;
-    const float s5 = m.m01 * m.m13 - m.m11 * m.m03;
-    const float s6 = m.m02 * m.m13 - m.m12 * m.m03;
-  
-    const float c1 = m.m20 * m.m31 - m.m30 * m.m21;
-    const float c2 = m.m20 * m.m32 - m.m30 * m.m22;
-    const float c3 = m.m20 * m.m33 - m.m30 * m.m23;
-    const float c4 = m.m21 * m.m32 - m.m31 * m.m22;
-    const float c5 = m.m21 * m.m32 - m.m31 * m.m23;
-    const float c6 = m.m22 * m.m33 - m.m32 * m.m23;
-  
-    float d = s1 * c6 - s2 * c5 + s3 * c4 + s4 * c3 - s5 * c2 + s6 * c1;
-    if (d == 0.0f)
+    dquat_t r;
+    r.real.vec4 = vec4_add(a.real.vec4, b.real.vec4);
+    r.dual.vec4 = vec4_add(a.dual.vec4, b.dual.vec4);
+    return r;
+}
+
+/**
+ * Multiplication of a dual quaternion with a scalar
+ */
+__vmath__ dquat_t dquat_mulf(dquat_arg_t dq, float s)
+{
+    dquat_t r;
+    r.real.vec4 = vec4_mulf(dq.real.vec4, s);
+    r.dual.vec4 = vec4_mulf(dq.dual.vec4, s);
+    return r;
+}
+
+/**
+ * Multiplication of two dual quaternions, result apply b then a
+ */
+__vmath__ dquat_t dquat_mul(dquat_arg_t a, dquat_arg_t b)
+{
+    dquat_t r;
+    r.real      = quat_mul(a.real, b.real);
+    r.dual.vec4 = vec4_add(quat_mul(a.real, b.dual).vec4, quat_mul(a.dual, b.real).vec4);
+    return r;
+}
+
+/**
+ * Test if two dual quaternions is equal
+ */
+__vmath__ bool dquat_equal(dquat_arg_t a, dquat_arg_t b)
+{
+    return quat_equal(a.real, b.real) && quat_equal(a.dual, b.dual);
+}
+
+/**
+ * Get conjugate dual quaternion (quaternion conjugate of both parts),
+ * for an unit dual quaternion it is the inverse transform
+ */
+__vmath__ dquat_t dquat_conjugate(dquat_arg_t dq)
+{
+    dquat_t r;
+    r.real = quat_conjugate(dq.real);
+    r.dual = quat_conjugate(dq.dual);
+    return r;
+}
+
+/**
+ * Normalize the dual quaternion (unit real part, dual part orthogonal to real part)
+ */
+__vmath__ dquat_t dquat_normalize(dquat_arg_t dq)
+{
+    const float lsqr = vec4_lengthsquared(dq.real.vec4);
+    if (lsqr <= 0.0f)
     {
-        return m;
+        return dq;
     }
-    d = 1.0f / d;
-  
-    mat4_t r;
-    r.m00 = d *  (m.m11 * c6 - m.m12 * c5 + m.m13 * c4);
-    r.m01 = d * -(m.m01 * c6 - m.m02 * c5 + m.m03 * c4);
-    r.m02 = d *  (m.m31 * s6 - m.m32 * s5 + m.m33 * s4);
-    r.m03 = d * -(m.m21 * s6 - m.m22 * s5 + m.m23 * s4);
-      
-    r.m10 = d * -(m.m10 * c6 - m.m12 * c3 + m.m13 * c2);
-    r.m11 = d *  (m.m00 * c6 - m.m02 * c3 + m.m03 * c2);
-    r.m12 = d * -(m.m30 * s6 - m.m32 * s3 + m.m33 * s2);
-    r.m13 = d *  (m.m20 * s6 - m.m22 * s3 + m.m23 * s2);
-      
-    r.m20 = d *  (m.m10 * c5 - m.m11 * c3 + m.m13 * c1);
-    r.m21 = d * -(m.m00 * c5 - m.m01 * c3 + m.m03 * c1);
-    r.m22 = d *  (m.m30 * s5 - m.m31 * s3 + m.m33 * s1);
-    r.m23 = d * -(m.m20 * s5 - m.m21 * s3 + m.m23 * s1);
 
-    r.m30 = d * -(m.m10 * c4 - m.m11 * c2 + m.m12 * c1);
-    r.m31 = d *  (m.m00 * c4 - m.m01 * c2 + m.m02 * c1);
-    r.m32 = d * -(m.m30 * s4 - m.m31 * s2 + m.m32 * s1);
-    r.m33 = d *  (m.m20 * s4 - m.m21 * s2 + m.m22 * s1);
+    const float  inv  = 1.0f / sqrtf(lsqr);
+    const vec4_t real = vec4_mulf(dq.real.vec4, inv);
+    const vec4_t dual = vec4_mulf(dq.dual.vec4, inv);
+
+    dquat_t r;
+    r.real.vec4 = real;
+    r.dual.vec4 = vec4_sub(dual, vec4_mulf(real, vec4_dot(real, dual)));
     return r;
 }
 
-/* END OF VMATH_BUILD_MAT4 */
+/**
+ * Blend dual quaternions with weights (dual quaternion linear blending)
+ * Quaternions which are in the other hemisphere with the first one are flipped
+ * @return: normalized blended dual quaternion
+ */
+__vmath_hot__ dquat_t dquat_blend(const dquat_t* dqs, const float* weights, int count);
+
+/**
+ * Linear blending of two dual quaternions, shortest path
+ */
+__vmath__ dquat_t dquat_mix(dquat_arg_t a, dquat_arg_t b, float t)
+{
+    const float w = vec4_dot(a.real.vec4, b.real.vec4) < 0.0f ? -t : t;
+    return dquat_normalize(dquat_add(dquat_mulf(a, 1.0f - t), dquat_mulf(b, w)));
+}
+
+/**
+ * Rotate a vector (normal, direction) with an unit dual quaternion, ignore translation
+ */
+__vmath__ vec3_t dquat_rotate(dquat_arg_t dq, vec3_arg_t v)
+{
+    /* equation: v' = v + 2 * cross(q.xyz, cross(q.xyz, v) + q.w * v) */
+    const vec3_t c = vec3_add(vec3_cross(dq.real.vec4.xyz, v), vec3_mulf(v, dq.real.w));
+    return vec3_add(v, vec3_mulf(vec3_cross(dq.real.vec4.xyz, c), 2.0f));
+}
+
+/**
+ * Transform a point with an unit dual quaternion
+ */
+__vmath__ vec3_t dquat_transform(dquat_arg_t dq, vec3_arg_t p)
+{
+    return vec3_add(dquat_rotate(dq, p), dquat_translation(dq));
+}
+
+#if VMATH_BUILD_MAT4
+/**
+ * Create dual quaternion from an affine (rotation + translation) matrix 4x4
+ * @note: scale and shear are not support
+ */
+__vmath_cold__ dquat_t dquat_frommat4(mat4_arg_t m);
+
+/**
+ * Convert an unit dual quaternion to affine matrix 4x4
+ */
+__vmath_hot__ mat4_t dquat_tomat4(dquat_arg_t dq);
+#endif
+
+/**
+ * Dual quaternion skinning, 4 bone influences per vertex
+ *
+ * @param out_positions: skinned positions, count elements
+ * @param out_normals:   skinned normals, count elements, can be NULL
+ * @param positions:     bind pose positions
+ * @param normals:       bind pose normals, can be NULL
+ * @param bones:         4 palette indices per vertex
+ * @param weights:       4 weights per vertex, sum to 1
+ * @param count:         number of vertices
+ * @param palette:       unit dual quaternions of bones (skinning transform)
+ */
+__vmath_batch__ void dquat_skin(vec3_t* out_positions, vec3_t* out_normals,
+                                const vec3_t* positions, const vec3_t* normals,
+                                const int* bones, const float* weights, int count,
+                                const dquat_t* palette)
+{
+    int i;
+    for (i = 0; i < count; i++, bones += 4, weights += 4)
+    {
+        const dquat_t* b0 = &palette[bones[0]];
+        const dquat_t* b1 = &palette[bones[1]];
+        const dquat_t* b2 = &palette[bones[2]];
+        const dquat_t* b3 = &palette[bones[3]];
+
+        /* Flip the weight of bones in the other hemisphere with the first bone */
+        const float w0 = weights[0];
+        const float w1 = vec4_dot(b0->real.vec4, b1->real.vec4) < 0.0f ? -weights[1] : weights[1];
+        const float w2 = vec4_dot(b0->real.vec4, b2->real.vec4) < 0.0f ? -weights[2] : weights[2];
+        const float w3 = vec4_dot(b0->real.vec4, b3->real.vec4) < 0.0f ? -weights[3] : weights[3];
+
+        /* Blend both parts in 4-wide registers */
+        vec4_t real = vec4_mulf(b0->real.vec4, w0);
+        vec4_t dual = vec4_mulf(b0->dual.vec4, w0);
+        real = vec4_add(real, vec4_mulf(b1->real.vec4, w1));
+        dual = vec4_add(dual, vec4_mulf(b1->dual.vec4, w1));
+        real = vec4_add(real, vec4_mulf(b2->real.vec4, w2));
+        dual = vec4_add(dual, vec4_mulf(b2->dual.vec4, w2));
+        real = vec4_add(real, vec4_mulf(b3->real.vec4, w3));
+        dual = vec4_add(dual, vec4_mulf(b3->dual.vec4, w3));
+
+        /* Only scale is needed, the translation formula drop the non-orthogonal part */
+        const float inv = 1.0f / sqrtf(vec4_lengthsquared(real));
+
+        dquat_t dq;
+        dq.real.vec4 = vec4_mulf(real, inv);
+        dq.dual.vec4 = vec4_mulf(dual, inv);
+
+        out_positions[i] = dquat_transform(dq, positions[i]);
+        if (out_normals && normals)
+        {
+            out_normals[i] = dquat_rotate(dq, normals[i]);
+        }
+    }
+}
+
+/* END OF VMATH_BUILD_DQUAT */
 #endif
 
 /********
@@ -4744,6 +4907,46 @@ __vmath__ mat4_t translate(float x, float y, float z)
 /* END OF VMATH_BUILD_MAT4 */
 #endif
 
+/**************************
+ * Dual quaternion functions
+ **************************/
+#if VMATH_BUILD_DQUAT
+__vmath__ dquat_t add(const dquat_t& a, const dquat_t& b)
+{
+    return dquat_add(a, b);
+}
+
+__vmath__ dquat_t mul(const dquat_t& a, const dquat_t& b)
+{
+    return dquat_mul(a, b);
+}
+
+__vmath__ dquat_t mul(float s, const dquat_t& dq)
+{
+    return dquat_mulf(dq, s);
+}
+
+__vmath__ dquat_t mul(const dquat_t& dq, float s)
+{
+    return dquat_mulf(dq, s);
+}
+
+__vmath__ vec3_t mul(const dquat_t& dq, const vec3_t& p)
+{
+    return dquat_transform(dq, p);
+}
+
+__vmath__ dquat_t normalize(const dquat_t& dq)
+{
+    return dquat_normalize(dq);
+}
+
+__vmath__ dquat_t mix(const dquat_t& a, const dquat_t& b, float t)
+{
+    return dquat_mix(a, b, t);
+}
+#endif
+
 /* END OF VMATH_FUNCTION_OVERLOADING */
 #endif
 
@@ -5520,6 +5723,53 @@ __vmath__ vec4_t operator*(const mat4_t& a, const vec4_t& b)
 /* END OF VMATH_BUILD_MAT4 */
 #endif
 
+/************************
+* Dual quaternion
+************************/
+#if VMATH_BUILD_DQUAT
+__vmath__ dquat_t operator+(const dquat_t& a, const dquat_t& b)
+{
+    return dquat_add(a, b);
+}
+
+__vmath__ dquat_t operator*(const dquat_t& a, const dquat_t& b)
+{
+    return dquat_mul(a, b);
+}
+
+__vmath__ dquat_t operator*(const dquat_t& a, float b)
+{
+    return dquat_mulf(a, b);
+}
+
+__vmath__ dquat_t operator*(float b, const dquat_t& a)
+{
+    return dquat_mulf(a, b);
+}
+
+__vmath__ vec3_t operator*(const dquat_t& a, const vec3_t& b)
+{
+    return dquat_transform(a, b);
+}
+
+__vmath__ bool operator==(const dquat_t& a, const dquat_t& b)
+{
+    return dquat_equal(a, b);
+}
+
+__vmath__ bool operator!=(const dquat_t& a, const dquat_t& b)
+{
+    return !dquat_equal(a, b);
+}
+
+__vmath__ dquat_t& operator*=(dquat_t& a, const dquat_t& b)
+{
+    return (a = a * b);
+}
+
+/* END OF VMATH_BUILD_DQUAT */
+#endif
+
 /* END OF VMATH_OPERATOR_OVERLOADING */
 #endif
 
@@ -5537,3 +5787,387 @@ __vmath__ vec4_t operator*(const mat4_t& a, const vec4_t& b)
 
 #endif /* __VMATH_H__ */
 
+/********************************************
+ * @region: Heavy functions
+ * Inline in every translation unit by default. With VMATH_OUTLINE they are
+ * compiled once, out of line, in the translation unit that defines VMATH_IMPL:
+ * the cold ones from VMATH_OUTLINE 1, the hot ones too from VMATH_OUTLINE 2.
+ * The outlined functions have the linkage and the argument passing of the
+ * language they are compiled in: C++ mangle the names and pass the *_arg_t
+ * by reference, C pass them by value. The VMATH_IMPL translation unit must be
+ * compiled in the same language as its users, a C++ program link against a
+ * VMATH_IMPL unit compiled as C++ (-x c++, not -x c).
+ ********************************************/
+#if VMATH_OUTLINE >= 1
+# if defined(VMATH_IMPL) && !defined(__VMATH_COLD_IMPL__)
+#  define __VMATH_COLD_IMPL__
+#  define __VMATH_COLD__ 1
+# endif
+#elif !defined(__VMATH_COLD_INLINE__)
+# define __VMATH_COLD_INLINE__
+# define __VMATH_COLD__ 1
+#endif
+
+#if defined(__VMATH_COLD__)
+
+#if VMATH_BUILD_QUAT
+__vmath_cold__ quat_t quat_euler(float x, float y, float z)
+{
+    float r;
+    float p;
+
+    r = z * 0.5f;
+    p = x * 0.5f;
+    y = y * 0.5f; // Now y min yaw
+
+    const float c1 = cosf(y);
+    const float c2 = cosf(p);
+    const float c3 = cosf(r);
+    const float s1 = sinf(y);
+    const float s2 = sinf(p);
+    const float s3 = sinf(r);
+
+    return quat(
+        s1 * s2 * c3 + c1 * c2 * s3,
+	    s1 * c2 * c3 + c1 * s2 * s3,
+	    c1 * s2 * c3 - s1 * c2 * s3,
+	    c1 * c2 * c3 - s1 * s2 * s3
+    );
+}
+
+__vmath_cold__ vec4_t quat_toaxis(quat_arg_t q)
+{
+    quat_t c = q;
+    if (c.w != 0.0f)
+    {
+        c = quat_normalize(q);
+    }
+
+    vec4_t r;
+    const float den = sqrtf(1.0f - c.w * c.w);
+    if (den > 0.0001f)
+    {
+        r.xyz = vec3_divf(c.vec4.xyz, den);
+    } 
+    else
+    {
+        r.xyz = vec3(1, 0, 0);
+    }
+    r.w = 2.0f * acosf(c.w < 1.0f ? c.w : 1.0f);
+    return r;
+}
+
+__vmath_cold__ vec3_t quat_toeuler(quat_arg_t q)
+{
+    float s = 2.0f * (q.w * q.x + q.y * q.z);
+    float c = 1.0f - 2.0f * (q.x * q.x + q.y * q.y);
+    const float r = atan2f(s, c);
+
+    s = 2.0f * (q.w * q.y - q.z * q.x);
+    const float p = fabsf(s >= 1.0f) >= 1.0f ? copysignf(VMATH_PI * 0.5f, s) : s;
+
+    s = 2.0f * (q.w * q.z + q.y * q.x);
+    c = 1.0f - 2.0f * (q.y * q.y + q.z * q.z);
+    const float y = atan2f(s, c);
+    return vec3(r, p, y);
+}
+
+/* END OF VMATH_BUILD_QUAT */
+#endif
+
+#if VMATH_BUILD_MAT4
+__vmath_cold__ mat4_t mat4_rotate3f(float x, float y, float z, float angle)
+{
+    const float c = cosf(-angle);
+    const float s = sinf(-angle);
+    const float t = 1.0f - c;
+  
+    mat4_t r;
+    /* Row 1 */
+    r.rows[0] = vec4(t * x * x + c,
+                     t * x * y - s * z,
+                     t * x * z + s * y,
+		     0.0f);
+
+    /* Row 2 */
+    r.rows[1] = vec4(t * x * y + s * z,
+		     t * y * y + c,
+		     t * y * z - s * x,
+		     0.0f);
+
+    /* Row 3 */
+    r.rows[2] = vec4(t * x * z - s * y,
+		     t * y * z + s * x,
+		     t * z * z + c,
+		     0.0f);
+
+    /* Row 4 */
+    r.rows[3] = vec4(0, 0, 0, 1.0f);
+    return r;
+}
+
+__vmath_cold__ mat4_t mat4_ortho(float l, float r,
+                                 float b, float t,
+                                 float n, float f)
+{
+    const float x = 1.0f / (r - l);
+    const float y = 1.0f / (t - b);
+    const float z = 1.0f / (f - n);
+    
+    mat4_t m;
+    m.rows[0] = vec4(    2.0f * x,            0,            0,    0);
+    m.rows[1] = vec4(           0,     2.0f * y,            0,    0);
+    m.rows[2] = vec4(           0,            0,    -2.0f * z,    0);
+    m.rows[3] = vec4(-x * (l + r), -y * (b + t), -z * (n + f), 1.0f);
+    return m;
+}
+
+__vmath_cold__ mat4_t mat4_frustum(float l, float r,
+                                   float b, float t,
+                                   float n, float f)
+{
+    mat4_t m;
+    /* Row 1 */
+    m.rows[0] = vec4(2.0f / (r - l), 0, 0, 0);
+    /* Row 2 */
+    m.rows[1] = vec4(0, 2.0f / (t - b), 0, 0);
+    /* Row 3 */
+    m.rows[2] = vec4((r + l) / (r - l),
+		             (t + b) / (t - b),
+		             (f + b) / (f - n), 
+                     1.0f);
+    /* Row 4 */
+    m.rows[3] = vec4(0, 0, 2.0f / (f - n), 0);
+    return m;
+}
+
+__vmath_cold__ mat4_t mat4_perspective(float fov, float aspect,
+                                       float znear, float zfar)
+{
+    const float a = 1.0f / tanf(fov * 0.5f);
+    const float b = zfar / (znear - zfar);
+    
+    mat4_t r;
+    r.rows[0] = vec4(a / aspect,   0,         0,   0);
+    r.rows[1] = vec4(         0,   a,         0,   0);
+    r.rows[2] = vec4(         0,   0,         b,  -1);
+    r.rows[3] = vec4(         0,   0, znear * b,   0);
+    return r;
+}
+
+__vmath_cold__ mat4_t mat4_lookat(vec3_arg_t eye, vec3_arg_t target, vec3_arg_t up)
+{
+    const vec3_t z = vec3_normalize(vec3_sub(eye, target));
+    const vec3_t x = vec3_normalize(vec3_cross(up, z));
+    const vec3_t y = vec3_normalize(vec3_cross( z, x));
+
+    mat4_t r;
+    r.rows[0] = vec4(x.x, y.x, z.x, 0);
+    r.rows[1] = vec4(x.y, y.y, z.y, 0);
+    r.rows[2] = vec4(x.z, y.z, z.z, 0);
+
+    /* Row 4 */
+    r.rows[3] = vec4(-vec3_dot(x, eye), 
+                     -vec3_dot(y, eye), 
+                     -vec3_dot(z, eye), 
+                     1.0f);
+    return r;
+}
+
+/* END OF VMATH_BUILD_MAT4 */
+#endif
+
+#if VMATH_BUILD_DQUAT
+#if VMATH_BUILD_MAT4
+__vmath_cold__ dquat_t dquat_frommat4(mat4_arg_t m)
+{
+    quat_t      q;
+    const float trace = m.m00 + m.m11 + m.m22;
+    if (trace > 0.0f)
+    {
+        const float s = 0.5f / sqrtf(trace + 1.0f);
+        q = quat((m.m12 - m.m21) * s, (m.m20 - m.m02) * s, (m.m01 - m.m10) * s, 0.25f / s);
+    }
+    else if (m.m00 > m.m11 && m.m00 > m.m22)
+    {
+        const float s = 2.0f * sqrtf(1.0f + m.m00 - m.m11 - m.m22);
+        q = quat(0.25f * s, (m.m01 + m.m10) / s, (m.m20 + m.m02) / s, (m.m12 - m.m21) / s);
+    }
+    else if (m.m11 > m.m22)
+    {
+        const float s = 2.0f * sqrtf(1.0f + m.m11 - m.m00 - m.m22);
+        q = quat((m.m01 + m.m10) / s, 0.25f * s, (m.m12 + m.m21) / s, (m.m20 - m.m02) / s);
+    }
+    else
+    {
+        const float s = 2.0f * sqrtf(1.0f + m.m22 - m.m00 - m.m11);
+        q = quat((m.m20 + m.m02) / s, (m.m12 + m.m21) / s, 0.25f * s, (m.m01 - m.m10) / s);
+    }
+
+    return dquat_fromquat(q, vec3(m.m30, m.m31, m.m32));
+}
+#endif
+
+/* END OF VMATH_BUILD_DQUAT */
+#endif
+
+#undef __VMATH_COLD__
+#endif
+
+#if VMATH_OUTLINE >= 2
+# if defined(VMATH_IMPL) && !defined(__VMATH_HOT_IMPL__)
+#  define __VMATH_HOT_IMPL__
+#  define __VMATH_HOT__ 1
+# endif
+#elif !defined(__VMATH_HOT_INLINE__)
+# define __VMATH_HOT_INLINE__
+# define __VMATH_HOT__ 1
+#endif
+
+#if defined(__VMATH_HOT__)
+
+#if VMATH_BUILD_MAT3
+__vmath_hot__ mat3_t mat3_inverse(mat3_arg_t m)
+{
+    float d = mat3_det(m);
+    if (d == 0.0f)
+    {
+        return m;
+    }
+
+    d = 1.0f / d;
+
+    mat3_t r;
+    r.m00 = d * (m.m11 * m.m22 - m.m12 * m.m21);
+    r.m01 = d * (m.m02 * m.m21 - m.m01 * m.m22);
+    r.m02 = d * (m.m01 * m.m12 - m.m02 * m.m11);
+
+    r.m10 = d * (m.m12 * m.m20 - m.m10 * m.m22);
+    r.m11 = d * (m.m00 * m.m22 - m.m02 * m.m20);
+    r.m12 = d * (m.m02 * m.m10 - m.m00 * m.m12);
+
+    r.m20 = d * (m.m10 * m.m21 - m.m11 * m.m20);
+    r.m21 = d * (m.m01 * m.m20 - m.m00 * m.m21);
+    r.m22 = d * (m.m00 * m.m11 - m.m01 * m.m10); 
+    return r;
+}
+
+/* END OF VMATH_BUILD_MAT3 */
+#endif
+
+#if VMATH_BUILD_MAT4
+__vmath_hot__ float mat4_det(mat4_arg_t m)
+{
+    const float s1 = m.m00 * m.m11 - m.m10 * m.m01;
+    const float s2 = m.m00 * m.m12 - m.m10 * m.m02;
+    const float s3 = m.m00 * m.m13 - m.m10 * m.m03;
+    const float s4 = m.m01 * m.m12 - m.m11 * m.m02;
+    const float s5 = m.m01 * m.m13 - m.m11 * m.m03;
+    const float s6 = m.m02 * m.m13 - m.m12 * m.m03;
+  
+    const float c1 = m.m20 * m.m31 - m.m30 * m.m21;
+    const float c2 = m.m20 * m.m32 - m.m30 * m.m22;
+    const float c3 = m.m20 * m.m33 - m.m30 * m.m23;
+    const float c4 = m.m21 * m.m32 - m.m31 * m.m22;
+    const float c5 = m.m21 * m.m32 - m.m31 * m.m23;
+    const float c6 = m.m22 * m.m33 - m.m32 * m.m23;
+
+    return s1 * c6 - s2 * c5 + s3 * c4 + s4 * c3 - s5 * c2 + s6 * c1;
+}
+
+__vmath_hot__ mat4_t mat4_inverse(mat4_arg_t m)
+{
+    const float s1 = m.m00 * m.m11 - m.m10 * m.m01;
+    const float s2 = m.m00 * m.m12 - m.m10 * m.m02;
+    const float s3 = m.m00 * m.m13 - m.m10 * m.m03;
+    const float s4 = m.m01 * m.m12 - m.m11 * m.m02;
+    const float s5 = m.m01 * m.m13 - m.m11 * m.m03;
+    const float s6 = m.m02 * m.m13 - m.m12 * m.m03;
+  
+    const float c1 = m.m20 * m.m31 - m.m30 * m.m21;
+    const float c2 = m.m20 * m.m32 - m.m30 * m.m22;
+    const float c3 = m.m20 * m.m33 - m.m30 * m.m23;
+    const float c4 = m.m21 * m.m32 - m.m31 * m.m22;
+    const float c5 = m.m21 * m.m32 - m.m31 * m.m23;
+    const float c6 = m.m22 * m.m33 - m.m32 * m.m23;
+  
+    float d = s1 * c6 - s2 * c5 + s3 * c4 + s4 * c3 - s5 * c2 + s6 * c1;
+    if (d == 0.0f)
+    {
+        return m;
+    }
+    d = 1.0f / d;
+  
+    mat4_t r;
+    r.m00 = d *  (m.m11 * c6 - m.m12 * c5 + m.m13 * c4);
+    r.m01 = d * -(m.m01 * c6 - m.m02 * c5 + m.m03 * c4);
+    r.m02 = d *  (m.m31 * s6 - m.m32 * s5 + m.m33 * s4);
+    r.m03 = d * -(m.m21 * s6 - m.m22 * s5 + m.m23 * s4);
+      
+    r.m10 = d * -(m.m10 * c6 - m.m12 * c3 + m.m13 * c2);
+    r.m11 = d *  (m.m00 * c6 - m.m02 * c3 + m.m03 * c2);
+    r.m12 = d * -(m.m30 * s6 - m.m32 * s3 + m.m33 * s2);
+    r.m13 = d *  (m.m20 * s6 - m.m22 * s3 + m.m23 * s2);
+      
+    r.m20 = d *  (m.m10 * c5 - m.m11 * c3 + m.m13 * c1);
+    r.m21 = d * -(m.m00 * c5 - m.m01 * c3 + m.m03 * c1);
+    r.m22 = d *  (m.m30 * s5 - m.m31 * s3 + m.m33 * s1);
+    r.m23 = d * -(m.m20 * s5 - m.m21 * s3 + m.m23 * s1);
+
+    r.m30 = d * -(m.m10 * c4 - m.m11 * c2 + m.m12 * c1);
+    r.m31 = d *  (m.m00 * c4 - m.m01 * c2 + m.m02 * c1);
+    r.m32 = d * -(m.m30 * s4 - m.m31 * s2 + m.m32 * s1);
+    r.m33 = d *  (m.m20 * s4 - m.m21 * s2 + m.m22 * s1);
+    return r;
+}
+
+/* END OF VMATH_BUILD_MAT4 */
+#endif
+
+#if VMATH_BUILD_DQUAT
+__vmath_hot__ dquat_t dquat_blend(const dquat_t* dqs, const float* weights, int count)
+{
+    vec4_t real = VEC4_ZERO;
+    vec4_t dual = VEC4_ZERO;
+
+    int i;
+    for (i = 0; i < count; i++)
+    {
+        const float w = vec4_dot(dqs[0].real.vec4, dqs[i].real.vec4) < 0.0f ? -weights[i] : weights[i];
+        real = vec4_add(real, vec4_mulf(dqs[i].real.vec4, w));
+        dual = vec4_add(dual, vec4_mulf(dqs[i].dual.vec4, w));
+    }
+
+    dquat_t r;
+    r.real.vec4 = real;
+    r.dual.vec4 = dual;
+    return dquat_normalize(r);
+}
+
+#if VMATH_BUILD_MAT4
+__vmath_hot__ mat4_t dquat_tomat4(dquat_arg_t dq)
+{
+    const float x = dq.real.x;
+    const float y = dq.real.y;
+    const float z = dq.real.z;
+    const float w = dq.real.w;
+    const vec3_t t = dquat_translation(dq);
+
+    mat4_t r;
+    r.rows[0] = vec4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y), 0.0f);
+    r.rows[1] = vec4(2.0f * (x * y - w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + w * x), 0.0f);
+    r.rows[2] = vec4(2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y), 0.0f);
+    r.rows[3] = vec4(t.x, t.y, t.z, 1.0f);
+    return r;
+}
+#endif
+
+/* END OF VMATH_BUILD_DQUAT */
+#endif
+
+#undef __VMATH_HOT__
+#endif
+
+/********
+* @endregion: Heavy functions
+********/
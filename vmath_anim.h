@@ -0,0 +1,275 @@
+/******************************************************
+ * vmath_anim - Keyframe animation sampling
+ *
+ * @author: MaiHD
+ * @license: NULL
+ * @copyright: MaiHD @ ${HOME}, 2017 - 2018
+ ******************************************************/
+
+#ifndef __VMATH_ANIM_H__
+#define __VMATH_ANIM_H__
+
+#include "vmath_soa.h"
+
+/**
+ * A track is a sorted array of key times and an array of key values with
+ * 4 components per key (vec3 tracks leave w unused), kept apart so the key
+ * search only touches times.
+ *
+ * Each animated instance own one cursor per track (the last key used), so
+ * forward playback move the cursor a few keys at most: amortized O(1).
+ * Tracks are sampled 4 at a time, one track per lane.
+ */
+
+/* Track type */
+#define ANIM_TRACK_VEC3     0   /* translation, scale: linear      */
+#define ANIM_TRACK_QUAT     1   /* rotation: normalized lerp       */
+
+/* Key format */
+#define ANIM_KEY_FLOAT      0   /* 4 floats per key                */
+#define ANIM_KEY_INT16      1   /* 4 int16 per key, offset + scale */
+
+/**
+ * Animation track
+ */
+typedef struct vmath_anim_track
+{
+    int          type;
+    int          format;
+    int          count;
+    const float* times;
+    const void*  values;
+    vec4_t       offset;    /* Dequantize: value = offset + key * scale */
+    vec4_t       scale;
+} anim_track_t;
+
+/**
+ * Animation clip: tracks of a skeleton
+ */
+typedef struct vmath_anim_clip
+{
+    float               duration;
+    int                 track_count;
+    const anim_track_t* tracks;
+} anim_clip_t;
+
+/**
+ * Quantize float keys to int16, find offset and scale of the track
+ */
+__vmath_batch__ void anim_quantize(const float* values, int count, short* keys, vec4_t* offset, vec4_t* scale)
+{
+    float lo[4], hi[4], s[4];
+    int i, c;
+
+    for (c = 0; c < 4; c++)
+    {
+        lo[c] = hi[c] = count > 0 ? values[c] : 0.0f;
+    }
+    for (i = 1; i < count; i++)
+    {
+        for (c = 0; c < 4; c++)
+        {
+            const float v = values[i * 4 + c];
+            lo[c] = v < lo[c] ? v : lo[c];
+            hi[c] = v > hi[c] ? v : hi[c];
+        }
+    }
+
+    /* Map [lo, hi] to [-32767, 32767] */
+    for (c = 0; c < 4; c++)
+    {
+        s[c] = (hi[c] - lo[c]) / 65534.0f;
+    }
+    for (i = 0; i < count; i++)
+    {
+        for (c = 0; c < 4; c++)
+        {
+            const float v = values[i * 4 + c] - lo[c];
+            keys[i * 4 + c] = (short)(s[c] > 0.0f ? (int)floorf(v / s[c] + 0.5f) - 32767 : 0);
+        }
+    }
+
+    *offset = vec4(lo[0] + 32767.0f * s[0], lo[1] + 32767.0f * s[1], lo[2] + 32767.0f * s[2], lo[3] + 32767.0f * s[3]);
+    *scale  = vec4(s[0], s[1], s[2], s[3]);
+}
+
+/**
+ * Key index k of time, which times[k] <= time < times[k + 1],
+ * start from cursor and fallback to binary search when time go backward
+ */
+__vmath__ int anim_seek(const float* times, int count, float time, int cursor)
+{
+    const int last = count - 2;
+    if (last <= 0)
+    {
+        return 0;
+    }
+
+    if (cursor < 0 || cursor > last || time < times[cursor])
+    {
+        int lo = 0, hi = last + 1;
+        while (hi - lo > 1)
+        {
+            const int mid = (lo + hi) >> 1;
+            if (times[mid] <= time)
+            {
+                lo = mid;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    while (cursor < last && times[cursor + 1] <= time)
+    {
+        cursor++;
+    }
+    return cursor;
+}
+
+/**
+ * Decode a key of a track
+ */
+__vmath__ vfloat4_t anim_key_x4(const anim_track_t* track, int key)
+{
+    if (track->format == ANIM_KEY_INT16)
+    {
+        const vint4_t q = vint4_loadi16((const short*)track->values + 4 * key);
+        return vfloat4_madd(vint4_tofloat(q), vfloat4_load(track->scale.m), vfloat4_load(track->offset.m));
+    }
+    else
+    {
+        return vfloat4_load((const float*)track->values + 4 * key);
+    }
+}
+
+/**
+ * Sample 4 tracks of the same type at time, one track per lane
+ * @param cursors: cursor of each track, updated
+ * @param count:   number of tracks (1..4)
+ * @param v:       values as SoA lanes (x, y, z, w)
+ */
+__vmath__ void anim_sample_x4(const anim_track_t* tracks, int count, float time, int* cursors, vfloat4_t* v)
+{
+    vfloat4_t a[4], b[4];
+    float     alpha[4] = { 0, 0, 0, 0 };
+    int       i;
+
+    for (i = 0; i < 4; i++)
+    {
+        const anim_track_t* track = &tracks[i < count ? i : count - 1];
+        if (track->count <= 1)
+        {
+            a[i] = b[i] = track->count == 1 ? anim_key_x4(track, 0) : vfloat4_zero();
+            continue;
+        }
+
+        {
+            const int   k  = anim_seek(track->times, track->count, time, cursors[i < count ? i : count - 1]);
+            const float t0 = track->times[k];
+            const float t1 = track->times[k + 1];
+            const float f  = t1 > t0 ? (time - t0) / (t1 - t0) : 0.0f;
+
+            if (i < count)
+            {
+                cursors[i] = k;
+            }
+            alpha[i] = f < 0.0f ? 0.0f : (f > 1.0f ? 1.0f : f);
+            a[i]     = anim_key_x4(track, k);
+            b[i]     = anim_key_x4(track, k + 1);
+        }
+    }
+
+    /* Keys to SoA lanes */
+    vfloat4_transpose(&a[0], &a[1], &a[2], &a[3]);
+    vfloat4_transpose(&b[0], &b[1], &b[2], &b[3]);
+
+    {
+        const vfloat4_t t = vfloat4_load(alpha);
+        if (tracks[0].type == ANIM_TRACK_QUAT)
+        {
+            /* Shortest path: flip b where dot(a, b) < 0 */
+            vfloat4_t d = vfloat4_mul(a[0], b[0]);
+            d = vfloat4_madd(a[1], b[1], d);
+            d = vfloat4_madd(a[2], b[2], d);
+            d = vfloat4_madd(a[3], b[3], d);
+
+            const vfloat4_t sign = vfloat4_and(d, vfloat4_set1(-0.0f));
+            for (i = 0; i < 4; i++)
+            {
+                v[i] = vfloat4_madd(t, vfloat4_sub(vfloat4_xor(b[i], sign), a[i]), a[i]);
+            }
+
+            vfloat4_t len = vfloat4_mul(v[0], v[0]);
+            len = vfloat4_madd(v[1], v[1], len);
+            len = vfloat4_madd(v[2], v[2], len);
+            len = vfloat4_madd(v[3], v[3], len);
+            len = vfloat4_div(vfloat4_set1(1.0f), vfloat4_sqrt(len));
+            for (i = 0; i < 4; i++)
+            {
+                v[i] = vfloat4_mul(v[i], len);
+            }
+        }
+        else
+        {
+            for (i = 0; i < 4; i++)
+            {
+                v[i] = vfloat4_madd(t, vfloat4_sub(b[i], a[i]), a[i]);
+            }
+        }
+    }
+}
+
+/**
+ * Sample every track of a clip at time
+ * @param cursors: one per track, start with zeros
+ * @param out:     one value per track, vec3 in xyz or quat in xyzw
+ * @note: tracks are grouped by 4, keep tracks of the same type together
+ */
+__vmath_batch__ void anim_sample(const anim_clip_t* clip, float time, int* cursors, vec4_t* out)
+{
+    int i = 0;
+    while (i < clip->track_count)
+    {
+        /* Group consecutive tracks of the same type */
+        int n = 1;
+        while (n < 4 && i + n < clip->track_count && clip->tracks[i + n].type == clip->tracks[i].type)
+        {
+            n++;
+        }
+
+        {
+            vfloat4_t v[4];
+            int k;
+            anim_sample_x4(clip->tracks + i, n, time, cursors + i, v);
+            vfloat4_transpose(&v[0], &v[1], &v[2], &v[3]);
+            for (k = 0; k < n; k++)
+            {
+                vfloat4_store(out[i + k].m, v[k]);
+            }
+        }
+
+        i += n;
+    }
+}
+
+/**
+ * Sample a clip for many instances
+ * @param times:   time of each instance
+ * @param cursors: track_count cursors per instance
+ * @param out:     track_count values per instance
+ */
+__vmath_batch__ void anim_sample_instances(const anim_clip_t* clip, const float* times, int instance_count,
+                                           int* cursors, vec4_t* out)
+{
+    int i;
+    for (i = 0; i < instance_count; i++)
+    {
+        anim_sample(clip, times[i], cursors + i * clip->track_count, out + i * clip->track_count);
+    }
+}
+
+#endif /* __VMATH_ANIM_H__ */
@@ -0,0 +1,490 @@
+/******************************************************
+ * vmath_color - Color spaces, tone mapping and blending
+ *
+ * @author: MaiHD
+ * @license: NULL
+ * @copyright: MaiHD @ ${HOME}, 2017 - 2018
+ ******************************************************/
+
+#ifndef __VMATH_COLOR_H__
+#define __VMATH_COLOR_H__
+
+#include "vmath_soa.h"
+
+/**
+ * Pixels are vec4_t (r, g, b, a) in float4 buffers, or 4 bytes (r, g, b, a)
+ * in RGBA8 buffers. Kernels load 4 pixels, turn them into r, g, b, a lanes,
+ * and process 4 pixels per operation. Buffers are processed by ranges, so
+ * a caller can split an image between threads, color_convert_mt and
+ * color_blend_mt in vmath_jobs.h do so over the job pool.
+ */
+
+/* Color operations */
+#define COLOR_SRGB_TO_LINEAR        0   /* Exact sRGB curve                       */
+#define COLOR_LINEAR_TO_SRGB        1
+#define COLOR_SRGB_TO_LINEAR_FAST   2   /* Fitted curves, max error ~0.2% / ~1%   */
+#define COLOR_LINEAR_TO_SRGB_FAST   3
+#define COLOR_RGB_TO_HSV            4   /* h, s, v in [0, 1]                      */
+#define COLOR_HSV_TO_RGB            5
+#define COLOR_RGB_TO_YCOCG          6
+#define COLOR_YCOCG_TO_RGB          7
+#define COLOR_PREMULTIPLY           8
+#define COLOR_UNPREMULTIPLY         9
+#define COLOR_TONEMAP_REINHARD      10  /* c / (1 + c)                            */
+#define COLOR_TONEMAP_ACES          11  /* Narkowicz fit of ACES filmic curve     */
+
+/* Porter-Duff operators, on premultiplied colors: dst = src op dst */
+#define COLOR_BLEND_CLEAR           0
+#define COLOR_BLEND_SRC             1
+#define COLOR_BLEND_DST             2
+#define COLOR_BLEND_SRC_OVER        3
+#define COLOR_BLEND_DST_OVER        4
+#define COLOR_BLEND_SRC_IN          5
+#define COLOR_BLEND_DST_IN          6
+#define COLOR_BLEND_SRC_OUT         7
+#define COLOR_BLEND_DST_OUT         8
+#define COLOR_BLEND_SRC_ATOP        9
+#define COLOR_BLEND_DST_ATOP        10
+#define COLOR_BLEND_XOR             11
+#define COLOR_BLEND_PLUS            12
+
+/**************************
+ * Channels of 4 pixels
+ **************************/
+
+/**
+ * sRGB curve to linear
+ */
+__vmath__ vfloat4_t color_srgb_tolinear_x4(vfloat4_t c)
+{
+    const vfloat4_t lo = vfloat4_mul(c, vfloat4_set1(1.0f / 12.92f));
+    const vfloat4_t hi = vfloat4_pow(vfloat4_max(vfloat4_mul(vfloat4_add(c, vfloat4_set1(0.055f)), vfloat4_set1(1.0f / 1.055f)),
+                                                 vfloat4_set1(1e-6f)),
+                                     vfloat4_set1(2.4f));
+    return vfloat4_select(hi, lo, vfloat4_cmple(c, vfloat4_set1(0.04045f)));
+}
+
+/**
+ * Linear to sRGB curve
+ */
+__vmath__ vfloat4_t color_linear_tosrgb_x4(vfloat4_t c)
+{
+    const vfloat4_t lo = vfloat4_mul(c, vfloat4_set1(12.92f));
+    const vfloat4_t hi = vfloat4_sub(vfloat4_mul(vfloat4_pow(vfloat4_max(c, vfloat4_set1(1e-6f)), vfloat4_set1(1.0f / 2.4f)),
+                                                 vfloat4_set1(1.055f)),
+                                     vfloat4_set1(0.055f));
+    return vfloat4_select(hi, lo, vfloat4_cmple(c, vfloat4_set1(0.0031308f)));
+}
+
+/**
+ * sRGB curve to linear, polynomial fit
+ */
+__vmath__ vfloat4_t color_srgb_tolinear_fast_x4(vfloat4_t c)
+{
+    const vfloat4_t p = vfloat4_madd(c, vfloat4_set1(0.305306011f), vfloat4_set1(0.682171111f));
+    return vfloat4_mul(c, vfloat4_madd(c, p, vfloat4_set1(0.012522878f)));
+}
+
+/**
+ * Linear to sRGB curve, fit of roots
+ */
+__vmath__ vfloat4_t color_linear_tosrgb_fast_x4(vfloat4_t c)
+{
+    const vfloat4_t s1 = vfloat4_sqrt(vfloat4_max(c, vfloat4_zero()));
+    const vfloat4_t s2 = vfloat4_sqrt(s1);
+    const vfloat4_t s3 = vfloat4_sqrt(s2);
+    const vfloat4_t r  = vfloat4_madd(s1, vfloat4_set1(0.585122381f),
+                                      vfloat4_nmadd(s3, vfloat4_set1(0.368262736f), vfloat4_mul(s2, vfloat4_set1(0.783140355f))));
+    return vfloat4_max(r, vfloat4_zero());
+}
+
+/**
+ * Apply a color operation to r, g, b, a lanes
+ */
+__vmath__ void color_apply_x4(int op, vfloat4_t* r, vfloat4_t* g, vfloat4_t* b, vfloat4_t* a)
+{
+    const vfloat4_t zero = vfloat4_zero();
+    const vfloat4_t one  = vfloat4_set1(1.0f);
+
+    switch (op)
+    {
+    case COLOR_SRGB_TO_LINEAR:
+        *r = color_srgb_tolinear_x4(*r);
+        *g = color_srgb_tolinear_x4(*g);
+        *b = color_srgb_tolinear_x4(*b);
+        break;
+
+    case COLOR_LINEAR_TO_SRGB:
+        *r = color_linear_tosrgb_x4(*r);
+        *g = color_linear_tosrgb_x4(*g);
+        *b = color_linear_tosrgb_x4(*b);
+        break;
+
+    case COLOR_SRGB_TO_LINEAR_FAST:
+        *r = color_srgb_tolinear_fast_x4(*r);
+        *g = color_srgb_tolinear_fast_x4(*g);
+        *b = color_srgb_tolinear_fast_x4(*b);
+        break;
+
+    case COLOR_LINEAR_TO_SRGB_FAST:
+        *r = color_linear_tosrgb_fast_x4(*r);
+        *g = color_linear_tosrgb_fast_x4(*g);
+        *b = color_linear_tosrgb_fast_x4(*b);
+        break;
+
+    case COLOR_RGB_TO_HSV:
+    {
+        const vfloat4_t max = vfloat4_max(*r, vfloat4_max(*g, *b));
+        const vfloat4_t min = vfloat4_min(*r, vfloat4_min(*g, *b));
+        const vfloat4_t d   = vfloat4_sub(max, min);
+        const vfloat4_t dz  = vfloat4_cmpeq(d, zero);
+        const vfloat4_t inv = vfloat4_div(one, vfloat4_select(d, one, dz));
+
+        /* Sector of the hue, from the channel which is max */
+        const vfloat4_t isr = vfloat4_cmpeq(max, *r);
+        const vfloat4_t isg = vfloat4_andnot(isr, vfloat4_cmpeq(max, *g));
+        vfloat4_t h = vfloat4_mul(vfloat4_sub(*r, *g), inv);
+        h = vfloat4_add(h, vfloat4_set1(4.0f));
+        h = vfloat4_select(h, vfloat4_add(vfloat4_mul(vfloat4_sub(*b, *r), inv), vfloat4_set1(2.0f)), isg);
+        h = vfloat4_select(h, vfloat4_mul(vfloat4_sub(*g, *b), inv), isr);
+        h = vfloat4_add(h, vfloat4_and(vfloat4_cmplt(h, zero), vfloat4_set1(6.0f)));
+        h = vfloat4_andnot(dz, vfloat4_mul(h, vfloat4_set1(1.0f / 6.0f)));
+
+        const vfloat4_t mz = vfloat4_cmple(max, zero);
+        *g = vfloat4_andnot(mz, vfloat4_div(d, vfloat4_select(max, one, mz)));
+        *r = h;
+        *b = max;
+        break;
+    }
+
+    case COLOR_HSV_TO_RGB:
+    {
+        /* equation: c(n) = v - v * s * clamp(min(k, 4 - k), 0, 1), k = (n + 6h) mod 6 */
+        const vfloat4_t h6 = vfloat4_mul(vfloat4_frac(*r), vfloat4_set1(6.0f));
+        const vfloat4_t vs = vfloat4_mul(*b, *g);
+        const vfloat4_t v  = *b;
+        vfloat4_t c[3];
+        int i;
+        for (i = 0; i < 3; i++)
+        {
+            vfloat4_t k = vfloat4_add(h6, vfloat4_set1((float)(5 - 2 * i)));
+            k = vfloat4_sub(k, vfloat4_and(vfloat4_cmpge(k, vfloat4_set1(6.0f)), vfloat4_set1(6.0f)));
+            k = vfloat4_clamp(vfloat4_min(k, vfloat4_sub(vfloat4_set1(4.0f), k)), zero, one);
+            c[i] = vfloat4_nmadd(vs, k, v);
+        }
+        *r = c[0];
+        *g = c[1];
+        *b = c[2];
+        break;
+    }
+
+    case COLOR_RGB_TO_YCOCG:
+    {
+        const vfloat4_t rb = vfloat4_add(*r, *b);
+        const vfloat4_t y  = vfloat4_mul(vfloat4_add(rb, vfloat4_add(*g, *g)), vfloat4_set1(0.25f));
+        const vfloat4_t co = vfloat4_mul(vfloat4_sub(*r, *b), vfloat4_set1(0.5f));
+        const vfloat4_t cg = vfloat4_mul(vfloat4_sub(vfloat4_add(*g, *g), rb), vfloat4_set1(0.25f));
+        *r = y;
+        *g = co;
+        *b = cg;
+        break;
+    }
+
+    case COLOR_YCOCG_TO_RGB:
+    {
+        const vfloat4_t t  = vfloat4_sub(*r, *b);
+        const vfloat4_t co = *g;
+        *g = vfloat4_add(*r, *b);
+        *r = vfloat4_add(t, co);
+        *b = vfloat4_sub(t, co);
+        break;
+    }
+
+    case COLOR_PREMULTIPLY:
+        *r = vfloat4_mul(*r, *a);
+        *g = vfloat4_mul(*g, *a);
+        *b = vfloat4_mul(*b, *a);
+        break;
+
+    case COLOR_UNPREMULTIPLY:
+    {
+        const vfloat4_t az  = vfloat4_cmple(*a, zero);
+        const vfloat4_t inv = vfloat4_andnot(az, vfloat4_div(one, vfloat4_select(*a, one, az)));
+        *r = vfloat4_mul(*r, inv);
+        *g = vfloat4_mul(*g, inv);
+        *b = vfloat4_mul(*b, inv);
+        break;
+    }
+
+    case COLOR_TONEMAP_REINHARD:
+        *r = vfloat4_div(*r, vfloat4_add(*r, one));
+        *g = vfloat4_div(*g, vfloat4_add(*g, one));
+        *b = vfloat4_div(*b, vfloat4_add(*b, one));
+        break;
+
+    case COLOR_TONEMAP_ACES:
+    {
+        /* equation: x * (2.51x + 0.03) / (x * (2.43x + 0.59) + 0.14) */
+        vfloat4_t* c[3];
+        int i;
+        c[0] = r; c[1] = g; c[2] = b;
+        for (i = 0; i < 3; i++)
+        {
+            const vfloat4_t x = *c[i];
+            const vfloat4_t n = vfloat4_mul(x, vfloat4_madd(x, vfloat4_set1(2.51f), vfloat4_set1(0.03f)));
+            const vfloat4_t d = vfloat4_madd(x, vfloat4_madd(x, vfloat4_set1(2.43f), vfloat4_set1(0.59f)), vfloat4_set1(0.14f));
+            *c[i] = vfloat4_clamp(vfloat4_div(n, d), zero, one);
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+/**
+ * Porter-Duff factors of an operator: F = k0 + k1 * alpha
+ * { src k0, src k1 (of dst alpha), dst k0, dst k1 (of src alpha) }
+ */
+static const float COLOR_BLEND_FACTORS[13][4] = {
+    { 0, 0, 0, 0  }, /* clear    */
+    { 1, 0, 0, 0  }, /* src      */
+    { 0, 0, 1, 0  }, /* dst      */
+    { 1, 0, 1, -1 }, /* src over */
+    { 1, -1, 1, 0 }, /* dst over */
+    { 0, 1, 0, 0  }, /* src in   */
+    { 0, 0, 0, 1  }, /* dst in   */
+    { 1, -1, 0, 0 }, /* src out  */
+    { 0, 0, 1, -1 }, /* dst out  */
+    { 0, 1, 1, -1 }, /* src atop */
+    { 1, -1, 0, 1 }, /* dst atop */
+    { 1, -1, 1, -1}, /* xor      */
+    { 1, 0, 1, 0  }, /* plus     */
+};
+
+/**
+ * Blend src into dst lanes with a Porter-Duff operator
+ */
+__vmath__ void color_blend_x4(int op, const vfloat4_t* src, vfloat4_t* dst)
+{
+    const float*    k  = COLOR_BLEND_FACTORS[op];
+    const vfloat4_t fs = vfloat4_madd(dst[3], vfloat4_set1(k[1]), vfloat4_set1(k[0]));
+    const vfloat4_t fd = vfloat4_madd(src[3], vfloat4_set1(k[3]), vfloat4_set1(k[2]));
+    int i;
+    for (i = 0; i < 4; i++)
+    {
+        dst[i] = vfloat4_madd(src[i], fs, vfloat4_mul(dst[i], fd));
+    }
+    dst[3] = vfloat4_min(dst[3], vfloat4_set1(1.0f));
+}
+
+/**************************
+ * Pixels load and store
+ **************************/
+
+/**
+ * Load n (1..4) float4 pixels as r, g, b, a lanes
+ */
+__vmath__ void color_load_x4(const vec4_t* pixels, int n, vfloat4_t* c)
+{
+    int i;
+    for (i = 0; i < 4; i++)
+    {
+        c[i] = i < n ? vfloat4_load(pixels[i].m) : vfloat4_zero();
+    }
+    vfloat4_transpose(&c[0], &c[1], &c[2], &c[3]);
+}
+
+/**
+ * Store r, g, b, a lanes to n (1..4) float4 pixels
+ */
+__vmath__ void color_store_x4(vec4_t* pixels, int n, vfloat4_t* c)
+{
+    int i;
+    vfloat4_transpose(&c[0], &c[1], &c[2], &c[3]);
+    for (i = 0; i < n; i++)
+    {
+        vfloat4_store(pixels[i].m, c[i]);
+    }
+}
+
+/**
+ * Load n (1..4) RGBA8 pixels as r, g, b, a lanes in [0, 1]
+ */
+__vmath__ void color_load8_x4(const unsigned char* pixels, int n, vfloat4_t* c)
+{
+    int     tmp[4] = { 0, 0, 0, 0 };
+    vint4_t p;
+    int     i;
+
+    if (n == 4)
+    {
+        memcpy(tmp, pixels, sizeof(tmp));
+    }
+    else
+    {
+        memcpy(tmp, pixels, (size_t)n * 4);
+    }
+    p = vint4_load(tmp);
+    for (i = 0; i < 4; i++)
+    {
+        const vint4_t channel = vint4_and(vint4_srl(p, 8 * i), vint4_set1(0xff));
+        c[i] = vfloat4_mul(vint4_tofloat(channel), vfloat4_set1(1.0f / 255.0f));
+    }
+}
+
+/**
+ * Store r, g, b, a lanes to n (1..4) RGBA8 pixels, with rounding
+ */
+__vmath__ void color_store8_x4(unsigned char* pixels, int n, const vfloat4_t* c)
+{
+    vint4_t p = vint4_set1(0);
+    int     tmp[4];
+    int     i;
+
+    for (i = 0; i < 4; i++)
+    {
+        const vfloat4_t v = vfloat4_clamp(c[i], vfloat4_zero(), vfloat4_set1(1.0f));
+        const vint4_t   q = vfloat4_toint(vfloat4_madd(v, vfloat4_set1(255.0f), vfloat4_set1(0.5f)));
+        p = vint4_or(p, vint4_sll(q, 8 * i));
+    }
+    vint4_store(tmp, p);
+    if (n == 4)
+    {
+        memcpy(pixels, tmp, sizeof(tmp));
+    }
+    else
+    {
+        memcpy(pixels, tmp, (size_t)n * 4);
+    }
+}
+
+/**************************
+ * Buffers
+ * 8 pixels per iteration, as two groups of 4
+ **************************/
+
+/**
+ * Apply a color operation to float4 pixels, out can be in
+ */
+__vmath_batch__ void color_convert(vec4_t* out, const vec4_t* in, int count, int op)
+{
+    int i, g;
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = i; g < i + 8 && g < count; g += 4)
+        {
+            const int n = count - g < 4 ? count - g : 4;
+            vfloat4_t c[4];
+            color_load_x4(in + g, n, c);
+            color_apply_x4(op, &c[0], &c[1], &c[2], &c[3]);
+            color_store_x4(out + g, n, c);
+        }
+    }
+}
+
+/**
+ * Apply a color operation to RGBA8 pixels, out can be in
+ */
+__vmath_batch__ void color_convert8(unsigned char* out, const unsigned char* in, int count, int op)
+{
+    int i, g;
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = i; g < i + 8 && g < count; g += 4)
+        {
+            const int n = count - g < 4 ? count - g : 4;
+            vfloat4_t c[4];
+            color_load8_x4(in + 4 * g, n, c);
+            color_apply_x4(op, &c[0], &c[1], &c[2], &c[3]);
+            color_store8_x4(out + 4 * g, n, c);
+        }
+    }
+}
+
+/**
+ * Decode RGBA8 pixels to float4, optionally from sRGB to linear
+ */
+__vmath_batch__ void color_decode8(vec4_t* out, const unsigned char* in, int count, bool srgb)
+{
+    int i, g;
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = i; g < i + 8 && g < count; g += 4)
+        {
+            const int n = count - g < 4 ? count - g : 4;
+            vfloat4_t c[4];
+            color_load8_x4(in + 4 * g, n, c);
+            if (srgb)
+            {
+                color_apply_x4(COLOR_SRGB_TO_LINEAR, &c[0], &c[1], &c[2], &c[3]);
+            }
+            color_store_x4(out + g, n, c);
+        }
+    }
+}
+
+/**
+ * Encode float4 pixels to RGBA8, optionally from linear to sRGB
+ */
+__vmath_batch__ void color_encode8(unsigned char* out, const vec4_t* in, int count, bool srgb)
+{
+    int i, g;
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = i; g < i + 8 && g < count; g += 4)
+        {
+            const int n = count - g < 4 ? count - g : 4;
+            vfloat4_t c[4];
+            color_load_x4(in + g, n, c);
+            if (srgb)
+            {
+                color_apply_x4(COLOR_LINEAR_TO_SRGB, &c[0], &c[1], &c[2], &c[3]);
+            }
+            color_store8_x4(out + 4 * g, n, c);
+        }
+    }
+}
+
+/**
+ * Blend premultiplied float4 pixels: dst = src op dst
+ */
+__vmath_batch__ void color_blend(vec4_t* dst, const vec4_t* src, int count, int op)
+{
+    int i, g;
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = i; g < i + 8 && g < count; g += 4)
+        {
+            const int n = count - g < 4 ? count - g : 4;
+            vfloat4_t s[4], d[4];
+            color_load_x4(src + g, n, s);
+            color_load_x4(dst + g, n, d);
+            color_blend_x4(op, s, d);
+            color_store_x4(dst + g, n, d);
+        }
+    }
+}
+
+/**
+ * Blend premultiplied RGBA8 pixels: dst = src op dst
+ */
+__vmath_batch__ void color_blend8(unsigned char* dst, const unsigned char* src, int count, int op)
+{
+    int i, g;
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = i; g < i + 8 && g < count; g += 4)
+        {
+            const int n = count - g < 4 ? count - g : 4;
+            vfloat4_t s[4], d[4];
+            color_load8_x4(src + 4 * g, n, s);
+            color_load8_x4(dst + 4 * g, n, d);
+            color_blend_x4(op, s, d);
+            color_store8_x4(dst + 4 * g, n, d);
+        }
+    }
+}
+
+#endif /* __VMATH_COLOR_H__ */
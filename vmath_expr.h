@@ -0,0 +1,1299 @@
+/******************************************************
+ * vmath_expr - Vector expressions compiled to batched bytecode
+ *
+ * @author: MaiHD
+ * @license: NULL
+ * @copyright: MaiHD @ ${HOME}, 2017 - 2018
+ ******************************************************/
+
+#ifndef __VMATH_EXPR_H__
+#define __VMATH_EXPR_H__
+
+#include <string.h>
+
+#include "vmath_soa.h"
+#include "vmath_text.h"
+
+/**
+ * GLSL like formulas over float, vec2, vec3, vec4, quat, mat3 and mat4,
+ * evaluated over SoA arrays:
+ *
+ *   dir   = normalize(target - position)
+ *   speed = clamp(length(velocity) + accel * dt, 0.0, 10.0)
+ *   position = position + dir * speed * dt
+ *
+ * Inputs and outputs are declared before the compile, each of them is a
+ * SoA array per component (vec3 is x, y, z arrays, mat3 is 9 arrays in
+ * the order of mat3_t data).
+ *
+ * The compiler lower every typed operation to float operations on single
+ * components, so dot is 1 mul and 2 madd, cross is 6 mul and 3 sub, and
+ * so on. While emitting, constant operands are folded, identities as
+ * x * 1 and x + 0 are removed and identical operations are shared. Unused
+ * results are removed, constants are set once per run, and registers are
+ * reused as soon as their last reader is done.
+ *
+ * The bytecode run one operation at a time over chunks of
+ * VMATH_EXPR_CHUNK entities with the vfloat4_t kernels, so the cost of
+ * decoding an operation is shared by a whole chunk.
+ *
+ * Operators: + - * / unary -, * of mat by vec/mat and of quat by quat/vec3
+ * Swizzles:  .x .xy .zyx .rgba ...
+ * Functions: vec2 vec3 vec4 quat mat3 mat4 (constructors), dot cross
+ *            length distance normalize mix clamp min max abs sqrt floor
+ *            fract step sin cos exp2 log2 pow atan2
+ */
+
+#ifndef VMATH_EXPR_MAX_CODE
+#define VMATH_EXPR_MAX_CODE     1024
+#endif
+
+#ifndef VMATH_EXPR_MAX_VARS
+#define VMATH_EXPR_MAX_VARS     32
+#endif
+
+#ifndef VMATH_EXPR_MAX_REGISTERS
+#define VMATH_EXPR_MAX_REGISTERS 64
+#endif
+
+/**
+ * Entities per chunk, a multiple of 4
+ */
+#ifndef VMATH_EXPR_CHUNK
+#define VMATH_EXPR_CHUNK        128
+#endif
+
+typedef enum vmath_expr_type
+{
+    VMATH_EXPR_FLOAT,
+    VMATH_EXPR_VEC2,
+    VMATH_EXPR_VEC3,
+    VMATH_EXPR_VEC4,
+    VMATH_EXPR_QUAT,
+    VMATH_EXPR_MAT3,
+    VMATH_EXPR_MAT4,
+} vmath_expr_type_t;
+
+typedef enum vmath_expr_op
+{
+    VMATH_EXPR_CONST,
+    VMATH_EXPR_LOAD,
+    VMATH_EXPR_STORE,
+    VMATH_EXPR_ADD,
+    VMATH_EXPR_SUB,
+    VMATH_EXPR_MUL,
+    VMATH_EXPR_DIV,
+    VMATH_EXPR_MADD,
+    VMATH_EXPR_MIN,
+    VMATH_EXPR_MAX,
+    VMATH_EXPR_NEG,
+    VMATH_EXPR_ABS,
+    VMATH_EXPR_SQRT,
+    VMATH_EXPR_FLOOR,
+    VMATH_EXPR_FRACT,
+    VMATH_EXPR_STEP,
+    VMATH_EXPR_SIN,
+    VMATH_EXPR_COS,
+    VMATH_EXPR_EXP2,
+    VMATH_EXPR_LOG2,
+    VMATH_EXPR_POW,
+    VMATH_EXPR_ATAN2,
+} vmath_expr_op_t;
+
+/**
+ * One operation, a, b and c are values while compiling and registers
+ * after, LOAD read stream a, STORE write a to stream b
+ */
+typedef struct vmath_expr_code
+{
+    unsigned char op;
+    short         dst, a, b, c;
+    float         value;
+} vmath_expr_code_t;
+
+typedef struct vmath_expr_var
+{
+    char              name[16];
+    vmath_expr_type_t type;
+    int               stream;       /* First stream, -1 for temporaries */
+    bool              output;
+    bool              assigned;
+    short             value[16];
+} vmath_expr_var_t;
+
+typedef struct vmath_expr
+{
+    vmath_expr_code_t code[VMATH_EXPR_MAX_CODE];
+    int               code_count;
+    int               prologue;         /* Constants at the front of code  */
+    int               register_count;
+
+    vmath_expr_var_t  vars[VMATH_EXPR_MAX_VARS];
+    int               var_count;
+    int               input_streams;
+    int               output_streams;
+
+    const char*       source;
+    const char*       cursor;
+    const char*       end;
+    char              error[128];
+} vmath_expr_t;
+
+/**
+ * Value while compiling: a type and one code index per component
+ */
+typedef struct vmath_expr_value
+{
+    vmath_expr_type_t type;
+    short             c[16];
+} vmath_expr_value_t;
+
+/********************
+ * Declarations
+ ********************/
+
+__vmath__ int vmath_expr_components(vmath_expr_type_t type)
+{
+    static const int components[] = { 1, 2, 3, 4, 4, 9, 16 };
+    return components[type];
+}
+
+/**
+ * Number of operands of an operation
+ */
+__vmath__ int vmath_expr_args(int op)
+{
+    switch (op)
+    {
+    case VMATH_EXPR_CONST:
+    case VMATH_EXPR_LOAD:
+        return 0;
+
+    case VMATH_EXPR_STORE:
+        return 1;
+
+    case VMATH_EXPR_MADD:
+        return 3;
+
+    case VMATH_EXPR_ADD:
+    case VMATH_EXPR_SUB:
+    case VMATH_EXPR_MUL:
+    case VMATH_EXPR_DIV:
+    case VMATH_EXPR_MIN:
+    case VMATH_EXPR_MAX:
+    case VMATH_EXPR_STEP:
+    case VMATH_EXPR_POW:
+    case VMATH_EXPR_ATAN2:
+        return 2;
+
+    default:
+        return 1;
+    }
+}
+
+__vmath_batch__ void vmath_expr_init(vmath_expr_t* e)
+{
+    e->code_count     = 0;
+    e->prologue       = 0;
+    e->register_count = 0;
+    e->var_count      = 0;
+    e->input_streams  = 0;
+    e->output_streams = 0;
+    e->source         = NULL;
+    e->cursor         = NULL;
+    e->end            = NULL;
+    e->error[0]       = 0;
+}
+
+__vmath_batch__ void vmath_expr_fail(vmath_expr_t* e, const char* message)
+{
+    if (!e->error[0])
+    {
+        const int at = e->source ? (int)(e->cursor - e->source) : 0;
+        snprintf(e->error, sizeof(e->error), "%s at %d", message, at);
+    }
+    e->cursor = e->end;
+}
+
+__vmath_batch__ vmath_expr_var_t* vmath_expr_find(vmath_expr_t* e, const char* name, int length)
+{
+    int i;
+    for (i = 0; i < e->var_count; i++)
+    {
+        if ((int)strlen(e->vars[i].name) == length && memcmp(e->vars[i].name, name, length) == 0)
+        {
+            return &e->vars[i];
+        }
+    }
+    return NULL;
+}
+
+__vmath_batch__ vmath_expr_var_t* vmath_expr_declare(vmath_expr_t* e, const char* name, int length, vmath_expr_type_t type)
+{
+    vmath_expr_var_t* var;
+
+    if (vmath_expr_find(e, name, length))
+    {
+        vmath_expr_fail(e, "name declared twice");
+        return NULL;
+    }
+    if (e->var_count == VMATH_EXPR_MAX_VARS || length >= (int)sizeof(var->name))
+    {
+        vmath_expr_fail(e, "too many variables or name too long");
+        return NULL;
+    }
+
+    var = &e->vars[e->var_count++];
+    memcpy(var->name, name, length);
+    var->name[length] = 0;
+    var->type     = type;
+    var->stream   = -1;
+    var->output   = false;
+    var->assigned = false;
+    return var;
+}
+
+/**
+ * Declare an input, its components are the next streams of the inputs
+ * @return: first stream of the input
+ */
+__vmath_batch__ int vmath_expr_input(vmath_expr_t* e, const char* name, vmath_expr_type_t type)
+{
+    vmath_expr_var_t* var = vmath_expr_declare(e, name, (int)strlen(name), type);
+    if (!var)
+    {
+        return -1;
+    }
+    var->stream       = e->input_streams;
+    e->input_streams += vmath_expr_components(type);
+    return var->stream;
+}
+
+/**
+ * Declare an output, its components are the next streams of the outputs
+ * @return: first stream of the output
+ */
+__vmath_batch__ int vmath_expr_output(vmath_expr_t* e, const char* name, vmath_expr_type_t type)
+{
+    vmath_expr_var_t* var = vmath_expr_declare(e, name, (int)strlen(name), type);
+    if (!var)
+    {
+        return -1;
+    }
+    var->stream        = e->output_streams;
+    var->output        = true;
+    e->output_streams += vmath_expr_components(type);
+    return var->stream;
+}
+
+/********************
+ * Emitter
+ ********************/
+
+__vmath__ bool vmath_expr_isconst(const vmath_expr_t* e, int value, float x)
+{
+    return e->code[value].op == VMATH_EXPR_CONST && e->code[value].value == x;
+}
+
+/**
+ * Scalar version of an operation, for constant folding
+ */
+__vmath__ float vmath_expr_fold(int op, float a, float b, float c)
+{
+    switch (op)
+    {
+    case VMATH_EXPR_ADD:   return a + b;
+    case VMATH_EXPR_SUB:   return a - b;
+    case VMATH_EXPR_MUL:   return a * b;
+    case VMATH_EXPR_DIV:   return a / b;
+    case VMATH_EXPR_MADD:  return a * b + c;
+    case VMATH_EXPR_MIN:   return a < b ? a : b;
+    case VMATH_EXPR_MAX:   return a > b ? a : b;
+    case VMATH_EXPR_NEG:   return -a;
+    case VMATH_EXPR_ABS:   return fabsf(a);
+    case VMATH_EXPR_SQRT:  return sqrtf(a);
+    case VMATH_EXPR_FLOOR: return floorf(a);
+    case VMATH_EXPR_FRACT: return a - floorf(a);
+    case VMATH_EXPR_STEP:  return b >= a ? 1.0f : 0.0f;
+    case VMATH_EXPR_SIN:   return sinf(a);
+    case VMATH_EXPR_COS:   return cosf(a);
+    case VMATH_EXPR_EXP2:  return powf(2.0f, a);
+    case VMATH_EXPR_LOG2:  return logf(a) * 1.44269504f;
+    case VMATH_EXPR_POW:   return powf(a, b);
+    case VMATH_EXPR_ATAN2: return atan2f(a, b);
+    default:               return 0.0f;
+    }
+}
+
+/**
+ * Append an operation, or return an equal one already emitted
+ * @return: value of the result
+ */
+__vmath_batch__ short vmath_expr_emit(vmath_expr_t* e, int op, int a, int b, int c, float value)
+{
+    const int args = op == VMATH_EXPR_STORE ? 0 : vmath_expr_args(op);
+
+    vmath_expr_code_t* code;
+    int                i;
+
+    if (e->error[0])
+    {
+        return 0;
+    }
+
+    /* Fold constants */
+    if (args > 0
+        && e->code[a].op == VMATH_EXPR_CONST
+        && (args < 2 || e->code[b].op == VMATH_EXPR_CONST)
+        && (args < 3 || e->code[c].op == VMATH_EXPR_CONST))
+    {
+        return vmath_expr_emit(e, VMATH_EXPR_CONST, 0, 0, 0,
+                               vmath_expr_fold(op, e->code[a].value, args > 1 ? e->code[b].value : 0.0f, args > 2 ? e->code[c].value : 0.0f));
+    }
+
+    /* Identities */
+    switch (op)
+    {
+    case VMATH_EXPR_ADD:
+        if (vmath_expr_isconst(e, a, 0.0f)) return (short)b;
+        if (vmath_expr_isconst(e, b, 0.0f)) return (short)a;
+        break;
+    case VMATH_EXPR_SUB:
+        if (vmath_expr_isconst(e, b, 0.0f)) return (short)a;
+        if (vmath_expr_isconst(e, a, 0.0f)) return vmath_expr_emit(e, VMATH_EXPR_NEG, b, 0, 0, 0.0f);
+        break;
+    case VMATH_EXPR_MUL:
+        if (vmath_expr_isconst(e, a, 1.0f)) return (short)b;
+        if (vmath_expr_isconst(e, b, 1.0f)) return (short)a;
+        if (vmath_expr_isconst(e, a, -1.0f)) return vmath_expr_emit(e, VMATH_EXPR_NEG, b, 0, 0, 0.0f);
+        if (vmath_expr_isconst(e, b, -1.0f)) return vmath_expr_emit(e, VMATH_EXPR_NEG, a, 0, 0, 0.0f);
+        break;
+    case VMATH_EXPR_DIV:
+        if (vmath_expr_isconst(e, b, 1.0f)) return (short)a;
+        break;
+    case VMATH_EXPR_MADD:
+        if (vmath_expr_isconst(e, c, 0.0f)) return vmath_expr_emit(e, VMATH_EXPR_MUL, a, b, 0, 0.0f);
+        if (vmath_expr_isconst(e, a, 1.0f)) return vmath_expr_emit(e, VMATH_EXPR_ADD, b, c, 0, 0.0f);
+        if (vmath_expr_isconst(e, b, 1.0f)) return vmath_expr_emit(e, VMATH_EXPR_ADD, a, c, 0, 0.0f);
+        break;
+    case VMATH_EXPR_NEG:
+        if (e->code[a].op == VMATH_EXPR_NEG) return e->code[a].a;
+        break;
+    }
+
+    /* Commutative operations have their operands sorted, so a + b and
+       b + a are shared */
+    if ((op == VMATH_EXPR_ADD || op == VMATH_EXPR_MUL || op == VMATH_EXPR_MIN || op == VMATH_EXPR_MAX || op == VMATH_EXPR_MADD) && a > b)
+    {
+        const int t = a;
+        a = b;
+        b = t;
+    }
+
+    for (i = 0; i < e->code_count; i++)
+    {
+        code = &e->code[i];
+        if (code->op == op && code->a == a && code->b == b && code->c == c
+            && memcmp(&code->value, &value, sizeof(value)) == 0)
+        {
+            return (short)i;
+        }
+    }
+
+    if (e->code_count == VMATH_EXPR_MAX_CODE)
+    {
+        vmath_expr_fail(e, "expression too long");
+        return 0;
+    }
+
+    code        = &e->code[e->code_count];
+    code->op    = (unsigned char)op;
+    code->dst   = (short)e->code_count;
+    code->a     = (short)a;
+    code->b     = (short)b;
+    code->c     = (short)c;
+    code->value = value;
+    return (short)e->code_count++;
+}
+
+__vmath_batch__ short vmath_expr_const(vmath_expr_t* e, float value)
+{
+    return vmath_expr_emit(e, VMATH_EXPR_CONST, 0, 0, 0, value);
+}
+
+/********************
+ * Typed operations
+ ********************/
+
+__vmath__ vmath_expr_value_t vmath_expr_scalar(short c)
+{
+    vmath_expr_value_t v;
+    v.type = VMATH_EXPR_FLOAT;
+    v.c[0] = c;
+    return v;
+}
+
+__vmath_batch__ vmath_expr_value_t vmath_expr_map1(vmath_expr_t* e, int op, vmath_expr_value_t x)
+{
+    int i, n = vmath_expr_components(x.type);
+    for (i = 0; i < n; i++)
+    {
+        x.c[i] = vmath_expr_emit(e, op, x.c[i], 0, 0, 0.0f);
+    }
+    return x;
+}
+
+/**
+ * Component wise operation, a float operand is broadcast
+ */
+__vmath_batch__ vmath_expr_value_t vmath_expr_map2(vmath_expr_t* e, int op, vmath_expr_value_t x, vmath_expr_value_t y)
+{
+    vmath_expr_value_t r = x.type == VMATH_EXPR_FLOAT ? y : x;
+    int                i, n = vmath_expr_components(r.type);
+
+    if (x.type != y.type && x.type != VMATH_EXPR_FLOAT && y.type != VMATH_EXPR_FLOAT)
+    {
+        vmath_expr_fail(e, "operands have different types");
+        return x;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        r.c[i] = vmath_expr_emit(e, op, x.c[x.type == VMATH_EXPR_FLOAT ? 0 : i], y.c[y.type == VMATH_EXPR_FLOAT ? 0 : i], 0, 0.0f);
+    }
+    return r;
+}
+
+__vmath_batch__ vmath_expr_value_t vmath_expr_map3(vmath_expr_t* e, int op, vmath_expr_value_t x, vmath_expr_value_t y, vmath_expr_value_t z)
+{
+    vmath_expr_value_t r = x.type != VMATH_EXPR_FLOAT ? x : y.type != VMATH_EXPR_FLOAT ? y : z;
+    int                i, n = vmath_expr_components(r.type);
+
+    if ((x.type != r.type && x.type != VMATH_EXPR_FLOAT) || (y.type != r.type && y.type != VMATH_EXPR_FLOAT) || (z.type != r.type && z.type != VMATH_EXPR_FLOAT))
+    {
+        vmath_expr_fail(e, "operands have different types");
+        return x;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        r.c[i] = vmath_expr_emit(e, op, x.c[x.type == VMATH_EXPR_FLOAT ? 0 : i], y.c[y.type == VMATH_EXPR_FLOAT ? 0 : i],
+                                 z.c[z.type == VMATH_EXPR_FLOAT ? 0 : i], 0.0f);
+    }
+    return r;
+}
+
+/**
+ * Sum of the products of the first n components of x and y
+ */
+__vmath_batch__ short vmath_expr_dotn(vmath_expr_t* e, const short* x, int xstride, const short* y, int n)
+{
+    short r = vmath_expr_emit(e, VMATH_EXPR_MUL, x[0], y[0], 0, 0.0f);
+    int   i;
+    for (i = 1; i < n; i++)
+    {
+        r = vmath_expr_emit(e, VMATH_EXPR_MADD, x[i * xstride], y[i], r, 0.0f);
+    }
+    return r;
+}
+
+__vmath_batch__ vmath_expr_value_t vmath_expr_dot(vmath_expr_t* e, vmath_expr_value_t x, vmath_expr_value_t y)
+{
+    if (x.type != y.type || x.type > VMATH_EXPR_QUAT)
+    {
+        vmath_expr_fail(e, "dot needs two vectors of the same type");
+        return x;
+    }
+    return vmath_expr_scalar(vmath_expr_dotn(e, x.c, 1, y.c, vmath_expr_components(x.type)));
+}
+
+__vmath_batch__ vmath_expr_value_t vmath_expr_cross(vmath_expr_t* e, vmath_expr_value_t x, vmath_expr_value_t y)
+{
+    vmath_expr_value_t r;
+    int                i;
+
+    if (x.type != VMATH_EXPR_VEC3 || y.type != VMATH_EXPR_VEC3)
+    {
+        vmath_expr_fail(e, "cross needs two vec3");
+        return x;
+    }
+
+    r.type = VMATH_EXPR_VEC3;
+    for (i = 0; i < 3; i++)
+    {
+        const int j = (i + 1) % 3, k = (i + 2) % 3;
+        r.c[i] = vmath_expr_emit(e, VMATH_EXPR_SUB,
+                                 vmath_expr_emit(e, VMATH_EXPR_MUL, x.c[j], y.c[k], 0, 0.0f),
+                                 vmath_expr_emit(e, VMATH_EXPR_MUL, x.c[k], y.c[j], 0, 0.0f), 0, 0.0f);
+    }
+    return r;
+}
+
+__vmath_batch__ vmath_expr_value_t vmath_expr_length(vmath_expr_t* e, vmath_expr_value_t x)
+{
+    if (x.type == VMATH_EXPR_FLOAT)
+    {
+        return vmath_expr_map1(e, VMATH_EXPR_ABS, x);
+    }
+    return vmath_expr_map1(e, VMATH_EXPR_SQRT, vmath_expr_dot(e, x, x));
+}
+
+__vmath_batch__ vmath_expr_value_t vmath_expr_normalize(vmath_expr_t* e, vmath_expr_value_t x)
+{
+    const vmath_expr_value_t l = vmath_expr_length(e, x);
+    const short              s = vmath_expr_emit(e, VMATH_EXPR_DIV, vmath_expr_const(e, 1.0f), l.c[0], 0, 0.0f);
+    return vmath_expr_map2(e, VMATH_EXPR_MUL, x, vmath_expr_scalar(s));
+}
+
+/**
+ * a * b: matrix products, quaternion products and rotations, component
+ * wise for everything else. Operands are in the order of vmath.h:
+ *  - mat * mat:   mat4_mul(a, b), b is applied first
+ *  - mat * vec:   mat3_mulv3(a, v) and mat4_mulv4(a, v)
+ *  - quat * quat: quat_mul(a, b), quat * vec3: v rotated by the unit quat a
+ */
+__vmath_batch__ vmath_expr_value_t vmath_expr_mul(vmath_expr_t* e, vmath_expr_value_t x, vmath_expr_value_t y)
+{
+    vmath_expr_value_t r;
+    int                i, j;
+
+    memset(&r, 0, sizeof(r));
+
+    if ((x.type == VMATH_EXPR_MAT3 || x.type == VMATH_EXPR_MAT4) && y.type != VMATH_EXPR_FLOAT)
+    {
+        const int n = x.type == VMATH_EXPR_MAT3 ? 3 : 4;
+        const int m = y.type == x.type ? n : 1;
+
+        if (y.type != x.type && y.type != (n == 3 ? VMATH_EXPR_VEC3 : VMATH_EXPR_VEC4))
+        {
+            vmath_expr_fail(e, "matrix and vector sizes do not match");
+            return x;
+        }
+
+        /* Column j of the result is x times column j of y */
+        r.type = y.type;
+        for (j = 0; j < m; j++)
+        {
+            for (i = 0; i < n; i++)
+            {
+                r.c[j * n + i] = vmath_expr_dotn(e, &x.c[i], n, &y.c[j * n], n);
+            }
+        }
+        return r;
+    }
+
+    if (x.type == VMATH_EXPR_QUAT && y.type == VMATH_EXPR_QUAT)
+    {
+        /* xyz = a.xyz * b.w + b.xyz * a.w + cross(a.xyz, b.xyz) */
+        vmath_expr_value_t a = x, b = y, c;
+        a.type = VMATH_EXPR_VEC3;
+        b.type = VMATH_EXPR_VEC3;
+        c = vmath_expr_cross(e, a, b);
+        c = vmath_expr_map3(e, VMATH_EXPR_MADD, a, vmath_expr_scalar(y.c[3]), c);
+        c = vmath_expr_map3(e, VMATH_EXPR_MADD, b, vmath_expr_scalar(x.c[3]), c);
+
+        r.type = VMATH_EXPR_QUAT;
+        r.c[0] = c.c[0];
+        r.c[1] = c.c[1];
+        r.c[2] = c.c[2];
+        r.c[3] = vmath_expr_emit(e, VMATH_EXPR_SUB, vmath_expr_emit(e, VMATH_EXPR_MUL, x.c[3], y.c[3], 0, 0.0f),
+                                 vmath_expr_dotn(e, a.c, 1, b.c, 3), 0, 0.0f);
+        return r;
+    }
+
+    if (x.type == VMATH_EXPR_QUAT && y.type == VMATH_EXPR_VEC3)
+    {
+        /* t = 2 cross(u, v), v + w t + cross(u, t) */
+        vmath_expr_value_t u = x, t;
+        u.type = VMATH_EXPR_VEC3;
+        t = vmath_expr_map2(e, VMATH_EXPR_MUL, vmath_expr_cross(e, u, y), vmath_expr_scalar(vmath_expr_const(e, 2.0f)));
+        return vmath_expr_map2(e, VMATH_EXPR_ADD, vmath_expr_map3(e, VMATH_EXPR_MADD, t, vmath_expr_scalar(x.c[3]), y), vmath_expr_cross(e, u, t));
+    }
+
+    if (x.type != y.type && x.type != VMATH_EXPR_FLOAT && y.type != VMATH_EXPR_FLOAT)
+    {
+        vmath_expr_fail(e, "operands have different types");
+        return x;
+    }
+    return vmath_expr_map2(e, VMATH_EXPR_MUL, x, y);
+}
+
+/********************
+ * Parser
+ ********************/
+
+__vmath_batch__ void vmath_expr_skip(vmath_expr_t* e)
+{
+    while (e->cursor < e->end && (*e->cursor == ' ' || *e->cursor == '\t' || *e->cursor == '\r'))
+    {
+        e->cursor++;
+    }
+}
+
+__vmath_batch__ bool vmath_expr_accept(vmath_expr_t* e, char c)
+{
+    vmath_expr_skip(e);
+    if (e->cursor < e->end && *e->cursor == c)
+    {
+        e->cursor++;
+        return true;
+    }
+    return false;
+}
+
+__vmath_batch__ void vmath_expr_expect(vmath_expr_t* e, char c)
+{
+    if (!vmath_expr_accept(e, c))
+    {
+        char message[32];
+        snprintf(message, sizeof(message), "'%c' expected", c);
+        vmath_expr_fail(e, message);
+    }
+}
+
+__vmath__ bool vmath_expr_isname(char c, bool first)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || (!first && c >= '0' && c <= '9');
+}
+
+__vmath_batch__ int vmath_expr_name(vmath_expr_t* e, const char** name)
+{
+    vmath_expr_skip(e);
+    *name = e->cursor;
+    if (e->cursor < e->end && vmath_expr_isname(*e->cursor, true))
+    {
+        while (e->cursor < e->end && vmath_expr_isname(*e->cursor, false))
+        {
+            e->cursor++;
+        }
+    }
+    return (int)(e->cursor - *name);
+}
+
+__vmath__ bool vmath_expr_is(const char* name, int length, const char* word)
+{
+    return (int)strlen(word) == length && memcmp(name, word, length) == 0;
+}
+
+__vmath_batch__ vmath_expr_value_t vmath_expr_parse(vmath_expr_t* e);
+
+/**
+ * Call of a function or a constructor, the arguments are parsed
+ */
+__vmath_batch__ vmath_expr_value_t vmath_expr_call(vmath_expr_t* e, const char* name, int length)
+{
+    static const char* types[] = { "float", "vec2", "vec3", "vec4", "quat", "mat3", "mat4" };
+
+    static const struct { const char* name; int op; int args; } maps[] = {
+        { "abs",   VMATH_EXPR_ABS,   1 }, { "sqrt",  VMATH_EXPR_SQRT,  1 }, { "floor", VMATH_EXPR_FLOOR, 1 },
+        { "fract", VMATH_EXPR_FRACT, 1 }, { "sin",   VMATH_EXPR_SIN,   1 }, { "cos",   VMATH_EXPR_COS,   1 },
+        { "exp2",  VMATH_EXPR_EXP2,  1 }, { "log2",  VMATH_EXPR_LOG2,  1 }, { "min",   VMATH_EXPR_MIN,   2 },
+        { "max",   VMATH_EXPR_MAX,   2 }, { "pow",   VMATH_EXPR_POW,   2 }, { "atan2", VMATH_EXPR_ATAN2, 2 },
+        { "step",  VMATH_EXPR_STEP,  2 },
+    };
+
+    vmath_expr_value_t args[16];
+    int                count = 0, i;
+
+    if (!vmath_expr_accept(e, ')'))
+    {
+        do
+        {
+            if (count == 16)
+            {
+                vmath_expr_fail(e, "too many arguments");
+                return args[0];
+            }
+            args[count++] = vmath_expr_parse(e);
+        } while (vmath_expr_accept(e, ','));
+        vmath_expr_expect(e, ')');
+    }
+    if (e->error[0])
+    {
+        return vmath_expr_scalar(0);
+    }
+
+    /* Constructors take the components of their arguments in order */
+    for (i = 0; i < 7; i++)
+    {
+        if (vmath_expr_is(name, length, types[i]))
+        {
+            vmath_expr_value_t r;
+            const int          n = vmath_expr_components((vmath_expr_type_t)i);
+            int                k = 0, j, c;
+
+            r.type = (vmath_expr_type_t)i;
+            if (count == 1 && args[0].type == VMATH_EXPR_FLOAT)
+            {
+                /* Broadcast for vectors, scaled identity for matrices */
+                const int size = i == VMATH_EXPR_MAT3 ? 3 : i == VMATH_EXPR_MAT4 ? 4 : 0;
+                for (c = 0; c < n; c++)
+                {
+                    r.c[c] = size == 0 || c % (size + 1) == 0 ? args[0].c[0] : vmath_expr_const(e, 0.0f);
+                }
+                return r;
+            }
+
+            for (j = 0; j < count; j++)
+            {
+                for (c = 0; c < vmath_expr_components(args[j].type); c++)
+                {
+                    if (k == n)
+                    {
+                        vmath_expr_fail(e, "too many components");
+                        return r;
+                    }
+                    r.c[k++] = args[j].c[c];
+                }
+            }
+            if (k != n)
+            {
+                vmath_expr_fail(e, "not enough components");
+            }
+            return r;
+        }
+    }
+
+    for (i = 0; i < (int)(sizeof(maps) / sizeof(maps[0])); i++)
+    {
+        if (vmath_expr_is(name, length, maps[i].name))
+        {
+            if (count != maps[i].args)
+            {
+                vmath_expr_fail(e, "wrong number of arguments");
+                return vmath_expr_scalar(0);
+            }
+            return maps[i].args == 1 ? vmath_expr_map1(e, maps[i].op, args[0]) : vmath_expr_map2(e, maps[i].op, args[0], args[1]);
+        }
+    }
+
+    if (vmath_expr_is(name, length, "dot") && count == 2)
+    {
+        return vmath_expr_dot(e, args[0], args[1]);
+    }
+    if (vmath_expr_is(name, length, "cross") && count == 2)
+    {
+        return vmath_expr_cross(e, args[0], args[1]);
+    }
+    if (vmath_expr_is(name, length, "length") && count == 1)
+    {
+        return vmath_expr_length(e, args[0]);
+    }
+    if (vmath_expr_is(name, length, "distance") && count == 2)
+    {
+        return vmath_expr_length(e, vmath_expr_map2(e, VMATH_EXPR_SUB, args[0], args[1]));
+    }
+    if (vmath_expr_is(name, length, "normalize") && count == 1)
+    {
+        return vmath_expr_normalize(e, args[0]);
+    }
+    if (vmath_expr_is(name, length, "mix") && count == 3)
+    {
+        /* a + (b - a) * t */
+        return vmath_expr_map3(e, VMATH_EXPR_MADD, vmath_expr_map2(e, VMATH_EXPR_SUB, args[1], args[0]), args[2], args[0]);
+    }
+    if (vmath_expr_is(name, length, "clamp") && count == 3)
+    {
+        return vmath_expr_map2(e, VMATH_EXPR_MIN, vmath_expr_map2(e, VMATH_EXPR_MAX, args[0], args[1]), args[2]);
+    }
+
+    vmath_expr_fail(e, "unknown function or wrong number of arguments");
+    return vmath_expr_scalar(0);
+}
+
+__vmath_batch__ vmath_expr_value_t vmath_expr_swizzle(vmath_expr_t* e, vmath_expr_value_t x)
+{
+    static const vmath_expr_type_t types[] = { VMATH_EXPR_FLOAT, VMATH_EXPR_VEC2, VMATH_EXPR_VEC3, VMATH_EXPR_VEC4 };
+
+    vmath_expr_value_t r;
+    const char*        name;
+    const int          length = vmath_expr_name(e, &name);
+    const int          n      = vmath_expr_components(x.type);
+    int                i;
+
+    if (length < 1 || length > 4 || x.type > VMATH_EXPR_QUAT)
+    {
+        vmath_expr_fail(e, "bad swizzle");
+        return x;
+    }
+
+    r.type = types[length - 1];
+    for (i = 0; i < length; i++)
+    {
+        const char* xyzw = strchr("xyzw", name[i]);
+        const char* rgba = strchr("rgba", name[i]);
+        const int   c    = xyzw ? (int)(xyzw - "xyzw") : rgba ? (int)(rgba - "rgba") : -1;
+        if (c < 0 || c >= n)
+        {
+            vmath_expr_fail(e, "bad swizzle");
+            return x;
+        }
+        r.c[i] = x.c[c];
+    }
+    return r;
+}
+
+__vmath_batch__ vmath_expr_value_t vmath_expr_primary(vmath_expr_t* e)
+{
+    vmath_expr_value_t r = vmath_expr_scalar(0);
+    const char*        name;
+    int                length;
+    float              number;
+    const char*        next;
+
+    vmath_expr_skip(e);
+    if (e->cursor >= e->end)
+    {
+        vmath_expr_fail(e, "unexpected end");
+        return r;
+    }
+
+    if (vmath_expr_accept(e, '('))
+    {
+        r = vmath_expr_parse(e);
+        vmath_expr_expect(e, ')');
+    }
+    else if ((next = vmath_parse_float(e->cursor, e->end, &number)) != NULL)
+    {
+        e->cursor = next;
+        r = vmath_expr_scalar(vmath_expr_const(e, number));
+    }
+    else if ((length = vmath_expr_name(e, &name)) > 0)
+    {
+        if (vmath_expr_accept(e, '('))
+        {
+            r = vmath_expr_call(e, name, length);
+        }
+        else if (vmath_expr_is(name, length, "pi"))
+        {
+            r = vmath_expr_scalar(vmath_expr_const(e, 3.14159265f));
+        }
+        else
+        {
+            vmath_expr_var_t* var = vmath_expr_find(e, name, length);
+            int               i;
+
+            if (!var || (var->stream < 0 && !var->assigned) || (var->output && !var->assigned))
+            {
+                vmath_expr_fail(e, "unknown or unassigned variable");
+                return r;
+            }
+
+            r.type = var->type;
+            for (i = 0; i < vmath_expr_components(var->type); i++)
+            {
+                r.c[i] = var->assigned ? var->value[i] : vmath_expr_emit(e, VMATH_EXPR_LOAD, var->stream + i, 0, 0, 0.0f);
+            }
+        }
+    }
+    else
+    {
+        vmath_expr_fail(e, "unexpected character");
+    }
+
+    while (!e->error[0] && vmath_expr_accept(e, '.'))
+    {
+        r = vmath_expr_swizzle(e, r);
+    }
+    return r;
+}
+
+__vmath_batch__ vmath_expr_value_t vmath_expr_unary(vmath_expr_t* e)
+{
+    if (vmath_expr_accept(e, '-'))
+    {
+        return vmath_expr_map1(e, VMATH_EXPR_NEG, vmath_expr_unary(e));
+    }
+    if (vmath_expr_accept(e, '+'))
+    {
+        return vmath_expr_unary(e);
+    }
+    return vmath_expr_primary(e);
+}
+
+__vmath_batch__ vmath_expr_value_t vmath_expr_term(vmath_expr_t* e)
+{
+    vmath_expr_value_t r = vmath_expr_unary(e);
+    while (!e->error[0])
+    {
+        if (vmath_expr_accept(e, '*'))
+        {
+            r = vmath_expr_mul(e, r, vmath_expr_unary(e));
+        }
+        else if (vmath_expr_accept(e, '/'))
+        {
+            const vmath_expr_value_t y = vmath_expr_unary(e);
+            if (y.type != VMATH_EXPR_FLOAT && y.type != r.type)
+            {
+                vmath_expr_fail(e, "operands have different types");
+            }
+            r = vmath_expr_map2(e, VMATH_EXPR_DIV, r, y);
+        }
+        else
+        {
+            break;
+        }
+    }
+    return r;
+}
+
+__vmath_batch__ vmath_expr_value_t vmath_expr_parse(vmath_expr_t* e)
+{
+    vmath_expr_value_t r = vmath_expr_term(e);
+    while (!e->error[0])
+    {
+        if (vmath_expr_accept(e, '+'))
+        {
+            r = vmath_expr_map2(e, VMATH_EXPR_ADD, r, vmath_expr_term(e));
+        }
+        else if (vmath_expr_accept(e, '-'))
+        {
+            r = vmath_expr_map2(e, VMATH_EXPR_SUB, r, vmath_expr_term(e));
+        }
+        else
+        {
+            break;
+        }
+    }
+    return r;
+}
+
+/**
+ * name = expression, a new name is a temporary
+ */
+__vmath_batch__ void vmath_expr_statement(vmath_expr_t* e)
+{
+    vmath_expr_value_t r;
+    vmath_expr_var_t*  var;
+    const char*        name;
+    const int          length = vmath_expr_name(e, &name);
+    int                i;
+
+    if (length == 0)
+    {
+        vmath_expr_fail(e, "name expected");
+        return;
+    }
+    vmath_expr_expect(e, '=');
+    r = vmath_expr_parse(e);
+    if (e->error[0])
+    {
+        return;
+    }
+
+    var = vmath_expr_find(e, name, length);
+    if (!var)
+    {
+        var = vmath_expr_declare(e, name, length, r.type);
+    }
+    else if (var->stream >= 0 && !var->output)
+    {
+        vmath_expr_fail(e, "inputs are read only");
+        return;
+    }
+    else if (var->type != r.type)
+    {
+        vmath_expr_fail(e, "assigned value has a different type");
+        return;
+    }
+
+    if (var)
+    {
+        var->type     = r.type;
+        var->assigned = true;
+        for (i = 0; i < vmath_expr_components(r.type); i++)
+        {
+            var->value[i] = r.c[i];
+        }
+    }
+}
+
+/********************
+ * Compiler
+ ********************/
+
+/**
+ * Keep the operations the outputs depend on, constants first, and give
+ * them registers
+ */
+__vmath_batch__ void vmath_expr_allocate(vmath_expr_t* e)
+{
+    short             last[VMATH_EXPR_MAX_CODE];
+    short             remap[VMATH_EXPR_MAX_CODE];
+    short             reg[VMATH_EXPR_MAX_CODE];
+    bool              live[VMATH_EXPR_MAX_CODE];
+    bool              busy[VMATH_EXPR_MAX_REGISTERS];
+    vmath_expr_code_t code[VMATH_EXPR_MAX_CODE];
+    int               i, j, n = 0, pass;
+
+    /* Values read by the stores, and the values they read */
+    memset(live, 0, sizeof(live));
+    memset(busy, 0, sizeof(busy));
+    for (i = e->code_count - 1; i >= 0; i--)
+    {
+        const vmath_expr_code_t* c    = &e->code[i];
+        const int                args = vmath_expr_args(c->op);
+
+        if (c->op == VMATH_EXPR_STORE) live[i] = true;
+        if (!live[i]) continue;
+        if (args > 0) live[c->a] = true;
+        if (args > 1) live[c->b] = true;
+        if (args > 2) live[c->c] = true;
+    }
+
+    /* Constants first, they are set once per run */
+    for (pass = 0; pass < 2; pass++)
+    {
+        for (i = 0; i < e->code_count; i++)
+        {
+            if (live[i] && (e->code[i].op == VMATH_EXPR_CONST) == (pass == 0))
+            {
+                const vmath_expr_code_t* c    = &e->code[i];
+                const int                args = vmath_expr_args(c->op);
+
+                remap[i]  = (short)n;
+                code[n]   = *c;
+                code[n].a = args > 0 ? remap[c->a] : c->a;
+                code[n].b = args > 1 ? remap[c->b] : c->op == VMATH_EXPR_STORE ? c->b : 0;
+                code[n].c = args > 2 ? remap[c->c] : 0;
+                n++;
+            }
+        }
+        if (pass == 0)
+        {
+            e->prologue = n;
+        }
+    }
+
+    /* Last reader of each value, constants are never released */
+    for (i = 0; i < n; i++)
+    {
+        last[i] = (short)(code[i].op == VMATH_EXPR_CONST ? n : i);
+    }
+    for (i = 0; i < n; i++)
+    {
+        const vmath_expr_code_t* c    = &code[i];
+        const int                args = vmath_expr_args(c->op);
+
+        if (args > 0 && last[c->a] < i) last[c->a] = (short)i;
+        if (args > 1 && last[c->b] < i) last[c->b] = (short)i;
+        if (args > 2 && last[c->c] < i) last[c->c] = (short)i;
+    }
+
+    /* Operands are released before the result is placed, an operation can
+       write over its last operand, the kernels read each 4 lanes before
+       writing them */
+    for (i = 0; i < n; i++)
+    {
+        vmath_expr_code_t* c    = &code[i];
+        const int          args = vmath_expr_args(c->op);
+        const short        a = c->a, b = c->b, d = c->c;
+
+        if (args > 0) { c->a = reg[a]; if (last[a] == i) busy[reg[a]] = false; }
+        if (args > 1) { c->b = reg[b]; if (last[b] == i) busy[reg[b]] = false; }
+        if (args > 2) { c->c = reg[d]; if (last[d] == i) busy[reg[d]] = false; }
+
+        if (c->op == VMATH_EXPR_STORE)
+        {
+            c->dst = 0;
+            continue;
+        }
+
+        for (j = 0; j < VMATH_EXPR_MAX_REGISTERS && busy[j]; j++)
+        {
+        }
+        if (j == VMATH_EXPR_MAX_REGISTERS)
+        {
+            vmath_expr_fail(e, "expression needs too many registers");
+            return;
+        }
+
+        busy[j] = last[i] > i;
+        reg[i]  = (short)j;
+        c->dst  = (short)j;
+        if (j + 1 > e->register_count)
+        {
+            e->register_count = j + 1;
+        }
+    }
+
+    memcpy(e->code, code, n * sizeof(code[0]));
+    e->code_count = n;
+}
+
+/**
+ * Compile a program, statements are separated by ';' or new lines
+ * @return: false on error, see e->error
+ */
+__vmath_batch__ bool vmath_expr_compile(vmath_expr_t* e, const char* source)
+{
+    int i, j;
+
+    e->code_count     = 0;
+    e->register_count = 0;
+    e->error[0]       = 0;
+    e->source         = source;
+    e->cursor         = source;
+    e->end            = source + strlen(source);
+
+    /* Drop the temporaries and values of a previous compile */
+    for (i = 0, j = 0; i < e->var_count; i++)
+    {
+        if (e->vars[i].stream >= 0)
+        {
+            e->vars[j] = e->vars[i];
+            e->vars[j].assigned = false;
+            j++;
+        }
+    }
+    e->var_count = j;
+
+    /* Code 0 is the constant 0, an operand index of 0 is always valid */
+    vmath_expr_const(e, 0.0f);
+
+    while (!e->error[0])
+    {
+        while (vmath_expr_accept(e, ';') || vmath_expr_accept(e, '\n'))
+        {
+        }
+        if (e->cursor >= e->end)
+        {
+            break;
+        }
+        vmath_expr_statement(e);
+        vmath_expr_skip(e);
+        if (!e->error[0] && e->cursor < e->end && *e->cursor != ';' && *e->cursor != '\n')
+        {
+            vmath_expr_fail(e, "end of statement expected");
+        }
+    }
+
+    for (i = 0; i < e->var_count && !e->error[0]; i++)
+    {
+        const vmath_expr_var_t* var = &e->vars[i];
+        if (var->output)
+        {
+            if (!var->assigned)
+            {
+                e->cursor = e->end;
+                vmath_expr_fail(e, "output not assigned");
+                break;
+            }
+            for (j = 0; j < vmath_expr_components(var->type); j++)
+            {
+                vmath_expr_emit(e, VMATH_EXPR_STORE, var->value[j], var->stream + j, 0, 0.0f);
+            }
+        }
+    }
+
+    if (!e->error[0])
+    {
+        vmath_expr_allocate(e);
+    }
+    if (e->error[0])
+    {
+        e->code_count = 0;
+        e->prologue   = 0;
+        return false;
+    }
+    return true;
+}
+
+/********************
+ * Evaluation
+ ********************/
+
+/**
+ * Run the program over count entities
+ *
+ * @param inputs:  one array per input stream, in declaration order
+ * @param outputs: one array per output stream, in declaration order
+ */
+__vmath_batch__ void vmath_expr_run(const vmath_expr_t* e, const float* const* inputs, float* const* outputs, int count)
+{
+    float regs[VMATH_EXPR_MAX_REGISTERS][VMATH_EXPR_CHUNK];
+    int   base, i, k;
+
+    for (k = 0; k < e->prologue; k++)
+    {
+        const vmath_expr_code_t* c = &e->code[k];
+        const vfloat4_t          v = vfloat4_set1(c->value);
+        for (i = 0; i < VMATH_EXPR_CHUNK; i += 4)
+        {
+            vfloat4_store(&regs[c->dst][i], v);
+        }
+    }
+
+    for (base = 0; base < count; base += VMATH_EXPR_CHUNK)
+    {
+        const int n     = count - base < VMATH_EXPR_CHUNK ? count - base : VMATH_EXPR_CHUNK;
+        const int lanes = (n + 3) & ~3;
+
+        for (k = e->prologue; k < e->code_count; k++)
+        {
+            const vmath_expr_code_t* c = &e->code[k];
+            float*                   d = regs[c->dst];
+            const float*             a = regs[c->a];
+            const float*             b = regs[c->b];
+            const float*             x = regs[c->c];
+
+            switch (c->op)
+            {
+            case VMATH_EXPR_LOAD:
+                memcpy(d, inputs[c->a] + base, n * sizeof(float));
+                for (i = n; i < lanes; i++) d[i] = 0.0f;
+                break;
+
+            case VMATH_EXPR_STORE:
+                memcpy(outputs[c->b] + base, a, n * sizeof(float));
+                break;
+
+#define VMATH_EXPR_KERNEL(OP, EXPR) \
+            case OP: \
+                for (i = 0; i < lanes; i += 4) \
+                { \
+                    const vfloat4_t va = vfloat4_load(a + i); \
+                    const vfloat4_t vb = vfloat4_load(b + i); \
+                    const vfloat4_t vc = vfloat4_load(x + i); \
+                    (void)vb; (void)vc; \
+                    vfloat4_store(d + i, EXPR); \
+                } \
+                break
+
+            VMATH_EXPR_KERNEL(VMATH_EXPR_ADD,   vfloat4_add(va, vb));
+            VMATH_EXPR_KERNEL(VMATH_EXPR_SUB,   vfloat4_sub(va, vb));
+            VMATH_EXPR_KERNEL(VMATH_EXPR_MUL,   vfloat4_mul(va, vb));
+            VMATH_EXPR_KERNEL(VMATH_EXPR_DIV,   vfloat4_div(va, vb));
+            VMATH_EXPR_KERNEL(VMATH_EXPR_MADD,  vfloat4_madd(va, vb, vc));
+            VMATH_EXPR_KERNEL(VMATH_EXPR_MIN,   vfloat4_min(va, vb));
+            VMATH_EXPR_KERNEL(VMATH_EXPR_MAX,   vfloat4_max(va, vb));
+            VMATH_EXPR_KERNEL(VMATH_EXPR_NEG,   vfloat4_neg(va));
+            VMATH_EXPR_KERNEL(VMATH_EXPR_ABS,   vfloat4_abs(va));
+            VMATH_EXPR_KERNEL(VMATH_EXPR_SQRT,  vfloat4_sqrt(va));
+            VMATH_EXPR_KERNEL(VMATH_EXPR_FLOOR, vfloat4_floor(va));
+            VMATH_EXPR_KERNEL(VMATH_EXPR_FRACT, vfloat4_frac(va));
+            VMATH_EXPR_KERNEL(VMATH_EXPR_STEP,  vfloat4_and(vfloat4_cmpge(vb, va), vfloat4_set1(1.0f)));
+            VMATH_EXPR_KERNEL(VMATH_EXPR_EXP2,  vfloat4_exp2(va));
+            VMATH_EXPR_KERNEL(VMATH_EXPR_LOG2,  vfloat4_log2(va));
+            VMATH_EXPR_KERNEL(VMATH_EXPR_POW,   vfloat4_pow(va, vb));
+            VMATH_EXPR_KERNEL(VMATH_EXPR_ATAN2, vfloat4_atan2(va, vb));
+#undef VMATH_EXPR_KERNEL
+
+            case VMATH_EXPR_SIN:
+            case VMATH_EXPR_COS:
+                for (i = 0; i < lanes; i += 4)
+                {
+                    vfloat4_t s, co;
+                    vfloat4_sincos(vfloat4_load(a + i), &s, &co);
+                    vfloat4_store(d + i, c->op == VMATH_EXPR_SIN ? s : co);
+                }
+                break;
+
+            default:
+                break;
+            }
+        }
+    }
+}
+
+#endif /* __VMATH_EXPR_H__ */
@@ -0,0 +1,715 @@
+/******************************************************
+ * vmath_file - Binary container for vector and matrix arrays
+ *
+ * @author: MaiHD
+ * @license: NULL
+ * @copyright: MaiHD @ ${HOME}, 2017 - 2018
+ ******************************************************/
+
+#ifndef __VMATH_FILE_H__
+#define __VMATH_FILE_H__
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "vmath.h"
+
+/**
+ * Usage: define VMATH_IMPL before include this file in one source file.
+ *
+ * Layout, every block start on a 64 bytes boundary:
+ *   file header   (64 bytes)
+ *   chunk header  (64 bytes) | chunk data | padding
+ *   chunk header  (64 bytes) | chunk data | padding
+ *   ...
+ *
+ * Chunk data is stored with the in-memory layout of the element type, so
+ * a mapped file is used in place: vmath_file_find() return a pointer into
+ * the mapping, aligned for __m128 loads. The element stride is stored and
+ * checked, vec3_t is 12 bytes without SSE and 16 bytes with it.
+ */
+
+#define VMATH_FILE_VERSION      1
+#define VMATH_FILE_ALIGN        64
+
+/* Element types of a chunk */
+#define VMATH_CHUNK_BYTES       0
+#define VMATH_CHUNK_FLOAT       1
+#define VMATH_CHUNK_VEC2        2
+#define VMATH_CHUNK_VEC3        3
+#define VMATH_CHUNK_VEC4        4
+#define VMATH_CHUNK_QUAT        5
+#define VMATH_CHUNK_MAT3        6
+#define VMATH_CHUNK_MAT4        7
+
+/**
+ * Tag of a chunk from 4 characters
+ */
+#define VMATH_FOURCC(a, b, c, d) \
+    ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+/**
+ * File header
+ */
+typedef struct vmath_file_header
+{
+    uint32_t magic;         /* VMATH_FOURCC('V', 'M', 'T', 'H') */
+    uint32_t version;
+    uint32_t chunk_count;
+    uint32_t endian;        /* 0x01020304 as written */
+    uint64_t file_size;
+    uint64_t reserved[5];
+} vmath_file_header_t;
+
+/**
+ * Chunk header, data follow right after it
+ */
+typedef struct vmath_chunk_header
+{
+    uint32_t type;          /* VMATH_CHUNK_* */
+    uint32_t tag;           /* User id, see VMATH_FOURCC */
+    uint32_t stride;        /* Bytes per element */
+    uint32_t reserved0;
+    uint64_t count;         /* Number of elements */
+    uint64_t bytes;         /* count * stride */
+    uint64_t checksum;      /* vmath_checksum of the data */
+    uint64_t reserved[3];
+} vmath_chunk_header_t;
+
+/**
+ * Chunk description
+ */
+typedef struct vmath_chunk
+{
+    uint32_t    type;
+    uint32_t    tag;
+    uint32_t    stride;
+    uint64_t    count;
+    uint64_t    checksum;
+    const void* data;       /* NULL with the streaming reader */
+} vmath_chunk_t;
+
+/**
+ * Mapped file, read-only
+ */
+typedef struct vmath_file
+{
+    const unsigned char* base;
+    uint64_t             size;
+    uint32_t             chunk_count;
+    void*                handle;    /* Platform handle of the mapping */
+} vmath_file_t;
+
+/**
+ * Streaming writer: chunks are written in order, counts and checksums are
+ * patched when a chunk end
+ */
+typedef struct vmath_file_writer
+{
+    FILE*                file;
+    uint64_t             offset;
+    uint64_t             chunk_offset;
+    uint32_t             chunk_count;
+    uint64_t             sum[2];
+    unsigned char        tail[4];   /* Bytes of the checksum word not complete yet */
+    uint32_t             tail_bytes;
+    vmath_chunk_header_t chunk;
+} vmath_file_writer_t;
+
+/**
+ * Streaming reader: read chunk data in blocks, for files larger than memory
+ */
+typedef struct vmath_file_reader
+{
+    FILE*                file;
+    uint64_t             offset;
+    uint64_t             remain;
+    uint32_t             chunk_index;
+    uint32_t             chunk_count;
+    uint64_t             sum[2];
+    unsigned char        tail[4];   /* Bytes of the checksum word not complete yet */
+    uint32_t             tail_bytes;
+    vmath_chunk_header_t chunk;
+} vmath_file_reader_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Map a file, return 0 when the file cannot be opened or is not valid
+ */
+int vmath_file_open(vmath_file_t* file, const char* path);
+
+/**
+ * Unmap a file, views of the file are invalid after this
+ */
+void vmath_file_close(vmath_file_t* file);
+
+/**
+ * Write the file header and get ready for chunks
+ */
+int vmath_file_writer_open(vmath_file_writer_t* writer, const char* path);
+
+/**
+ * Start a chunk of elements of type
+ */
+int vmath_file_writer_begin(vmath_file_writer_t* writer, uint32_t type, uint32_t tag);
+
+/**
+ * Append count elements to the current chunk
+ */
+int vmath_file_writer_write(vmath_file_writer_t* writer, const void* data, uint64_t count);
+
+/**
+ * Finish the current chunk
+ */
+int vmath_file_writer_end(vmath_file_writer_t* writer);
+
+/**
+ * Finish the file, return 0 when any write failed
+ */
+int vmath_file_writer_close(vmath_file_writer_t* writer);
+
+/**
+ * Open a file for streaming read
+ */
+int vmath_file_reader_open(vmath_file_reader_t* reader, const char* path);
+
+/**
+ * Move to the next chunk, skip the rest of the current one
+ * @return: 0 when there is no more chunk
+ */
+int vmath_file_reader_next(vmath_file_reader_t* reader, vmath_chunk_t* chunk);
+
+/**
+ * Read up to max_count elements of the current chunk to buffer
+ * @return: number of elements read, 0 at the end of the chunk
+ */
+uint64_t vmath_file_reader_read(vmath_file_reader_t* reader, void* buffer, uint64_t max_count);
+
+/**
+ * Check the checksum of the current chunk after all of it was read
+ */
+int vmath_file_reader_verify(const vmath_file_reader_t* reader);
+
+/**
+ * Close the file
+ */
+void vmath_file_reader_close(vmath_file_reader_t* reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * Bytes per element of a chunk type, 1 for VMATH_CHUNK_BYTES
+ */
+__vmath__ uint32_t vmath_chunk_stride(uint32_t type)
+{
+    switch (type)
+    {
+    case VMATH_CHUNK_FLOAT: return sizeof(float);
+    case VMATH_CHUNK_VEC2:  return sizeof(vec2_t);
+    case VMATH_CHUNK_VEC3:  return sizeof(vec3_t);
+    case VMATH_CHUNK_VEC4:  return sizeof(vec4_t);
+    case VMATH_CHUNK_QUAT:  return sizeof(quat_t);
+    case VMATH_CHUNK_MAT3:  return sizeof(mat3_t);
+    case VMATH_CHUNK_MAT4:  return sizeof(mat4_t);
+    default:                return 1;
+    }
+}
+
+/**
+ * Update a Fletcher-style checksum over 32-bit words, the tail bytes are
+ * summed as a zero-padded word
+ */
+__vmath_batch__ void vmath_checksum_update(uint64_t sum[2], const void* data, uint64_t bytes)
+{
+    const unsigned char* p = (const unsigned char*)data;
+    uint64_t a = sum[0], b = sum[1];
+    uint64_t i;
+
+    for (i = 0; i + 4 <= bytes; i += 4)
+    {
+        uint32_t w;
+        memcpy(&w, p + i, 4);
+        a += w;
+        b += a;
+    }
+    if (i < bytes)
+    {
+        uint32_t w = 0;
+        memcpy(&w, p + i, (size_t)(bytes - i));
+        a += w;
+        b += a;
+    }
+
+    sum[0] = a;
+    sum[1] = b;
+}
+
+/**
+ * Final value of a checksum
+ */
+__vmath__ uint64_t vmath_checksum_final(const uint64_t sum[2])
+{
+    return (sum[1] << 32) ^ sum[0];
+}
+
+/**
+ * Checksum of a buffer
+ */
+__vmath__ uint64_t vmath_checksum(const void* data, uint64_t bytes)
+{
+    uint64_t sum[2] = { 0, 0 };
+    vmath_checksum_update(sum, data, bytes);
+    return vmath_checksum_final(sum);
+}
+
+/**
+ * Update a checksum with data cut at any byte, tail keep the bytes of the
+ * word not complete yet. Flush with vmath_checksum_update(sum, tail, tail_bytes).
+ */
+__vmath_batch__ void vmath_checksum_stream(uint64_t sum[2], unsigned char tail[4], uint32_t* tail_bytes, const void* data, uint64_t bytes)
+{
+    const unsigned char* p = (const unsigned char*)data;
+    uint64_t words;
+
+    if (*tail_bytes > 0)
+    {
+        const uint32_t n = (uint32_t)(bytes < 4 - *tail_bytes ? bytes : 4 - *tail_bytes);
+        memcpy(tail + *tail_bytes, p, n);
+        *tail_bytes += n;
+        p           += n;
+        bytes       -= n;
+        if (*tail_bytes < 4)
+        {
+            return;
+        }
+        vmath_checksum_update(sum, tail, 4);
+        *tail_bytes = 0;
+    }
+
+    words = bytes & ~(uint64_t)3;
+    vmath_checksum_update(sum, p, words);
+    *tail_bytes = (uint32_t)(bytes - words);
+    memcpy(tail, p + words, *tail_bytes);
+}
+
+__vmath__ uint64_t vmath_file_alignup(uint64_t offset)
+{
+    return (offset + (VMATH_FILE_ALIGN - 1)) & ~(uint64_t)(VMATH_FILE_ALIGN - 1);
+}
+
+/**
+ * Is count * stride of a chunk header within its bytes, without overflow
+ */
+__vmath__ int vmath_chunk_checkheader(const vmath_chunk_header_t* header)
+{
+    return header->stride > 0 ? header->count <= header->bytes / header->stride : header->count == 0;
+}
+
+/**
+ * Get chunk at index of a mapped file, O(index)
+ */
+__vmath_batch__ int vmath_file_chunk(const vmath_file_t* file, uint32_t index, vmath_chunk_t* chunk)
+{
+    uint64_t offset = VMATH_FILE_ALIGN;
+    uint32_t i;
+    for (i = 0; i < file->chunk_count; i++)
+    {
+        const vmath_chunk_header_t* header = (const vmath_chunk_header_t*)(file->base + offset);
+        if (offset + sizeof(*header) > file->size || header->bytes > file->size - offset - sizeof(*header)
+            || !vmath_chunk_checkheader(header))
+        {
+            return 0;
+        }
+
+        if (i == index)
+        {
+            chunk->type     = header->type;
+            chunk->tag      = header->tag;
+            chunk->stride   = header->stride;
+            chunk->count    = header->count;
+            chunk->checksum = header->checksum;
+            chunk->data     = header + 1;
+            return 1;
+        }
+        offset = vmath_file_alignup(offset + sizeof(vmath_chunk_header_t) + header->bytes);
+    }
+    return 0;
+}
+
+/**
+ * View of the first chunk with tag and type, zero-copy
+ * @return: NULL when not found or the stride do not match this build
+ */
+__vmath_batch__ const void* vmath_file_find(const vmath_file_t* file, uint32_t tag, uint32_t type, uint64_t* count)
+{
+    vmath_chunk_t chunk;
+    uint32_t i;
+    for (i = 0; vmath_file_chunk(file, i, &chunk); i++)
+    {
+        if (chunk.tag == tag && chunk.type == type && chunk.stride == vmath_chunk_stride(type))
+        {
+            *count = chunk.count;
+            return chunk.data;
+        }
+    }
+    *count = 0;
+    return 0;
+}
+
+__vmath__ const vec3_t* vmath_file_vec3s(const vmath_file_t* file, uint32_t tag, uint64_t* count)
+{
+    return (const vec3_t*)vmath_file_find(file, tag, VMATH_CHUNK_VEC3, count);
+}
+
+__vmath__ const vec4_t* vmath_file_vec4s(const vmath_file_t* file, uint32_t tag, uint64_t* count)
+{
+    return (const vec4_t*)vmath_file_find(file, tag, VMATH_CHUNK_VEC4, count);
+}
+
+__vmath__ const quat_t* vmath_file_quats(const vmath_file_t* file, uint32_t tag, uint64_t* count)
+{
+    return (const quat_t*)vmath_file_find(file, tag, VMATH_CHUNK_QUAT, count);
+}
+
+__vmath__ const mat4_t* vmath_file_mat4s(const vmath_file_t* file, uint32_t tag, uint64_t* count)
+{
+    return (const mat4_t*)vmath_file_find(file, tag, VMATH_CHUNK_MAT4, count);
+}
+
+/**
+ * Check the checksum of a chunk, touch every page of the chunk
+ */
+__vmath__ int vmath_file_verify(const vmath_chunk_t* chunk)
+{
+    return chunk->data && vmath_checksum(chunk->data, chunk->count * chunk->stride) == chunk->checksum;
+}
+
+/**
+ * Write a whole array as a chunk
+ */
+__vmath__ int vmath_file_writer_chunk(vmath_file_writer_t* writer, uint32_t type, uint32_t tag, const void* data, uint64_t count)
+{
+    return vmath_file_writer_begin(writer, type, tag)
+        && vmath_file_writer_write(writer, data, count)
+        && vmath_file_writer_end(writer);
+}
+
+#endif /* __VMATH_FILE_H__ */
+
+/********************
+ * Implementation
+ ********************/
+
+#if defined(VMATH_IMPL) && !defined(__VMATH_FILE_IMPL__)
+#define __VMATH_FILE_IMPL__
+
+#if defined(_WIN32)
+#  ifndef WIN32_LEAN_AND_MEAN
+#  define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <Windows.h>
+#else
+#  include <limits.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif
+
+/* fseeko is POSIX, hidden by a strict C mode without feature macros */
+#ifndef VMATH_FILE_FSEEKO
+#  if !defined(_WIN32) && (!defined(__STRICT_ANSI__) || defined(_POSIX_C_SOURCE) || defined(_XOPEN_SOURCE) || defined(_GNU_SOURCE) || defined(__APPLE__))
+#    define VMATH_FILE_FSEEKO 1
+#  else
+#    define VMATH_FILE_FSEEKO 0
+#  endif
+#endif
+
+/**
+ * Seek from the start, fail on an offset the platform cannot address.
+ * 32 bits POSIX targets need -D_FILE_OFFSET_BITS=64 for files over 2 GB.
+ */
+static int vmath_file_seek(FILE* file, uint64_t offset)
+{
+#if defined(_WIN32)
+    return _fseeki64(file, (__int64)offset, SEEK_SET);
+#elif VMATH_FILE_FSEEKO
+    return (uint64_t)(off_t)offset == offset ? fseeko(file, (off_t)offset, SEEK_SET) : -1;
+#else
+    return offset <= (uint64_t)LONG_MAX ? fseek(file, (long)offset, SEEK_SET) : -1;
+#endif
+}
+
+static int vmath_file_checkheader(const vmath_file_header_t* header, uint64_t size)
+{
+    return size >= sizeof(vmath_file_header_t)
+        && header->magic == VMATH_FOURCC('V', 'M', 'T', 'H')
+        && header->version == VMATH_FILE_VERSION
+        && header->endian == 0x01020304
+        && header->file_size <= size;
+}
+
+int vmath_file_open(vmath_file_t* file, const char* path)
+{
+    const vmath_file_header_t* header;
+    memset(file, 0, sizeof(*file));
+
+#if defined(_WIN32)
+    {
+        HANDLE        handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        HANDLE        mapping;
+        LARGE_INTEGER size;
+        if (handle == INVALID_HANDLE_VALUE)
+        {
+            return 0;
+        }
+
+        GetFileSizeEx(handle, &size);
+        mapping = size.QuadPart > 0 ? CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+        CloseHandle(handle);
+        if (!mapping)
+        {
+            return 0;
+        }
+
+        file->base   = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        file->size   = (uint64_t)size.QuadPart;
+        file->handle = mapping;
+        if (!file->base)
+        {
+            CloseHandle(mapping);
+            return 0;
+        }
+    }
+#else
+    {
+        struct stat st;
+        void*       base;
+        const int   fd = open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            return 0;
+        }
+
+        base = fstat(fd, &st) == 0 && st.st_size > 0 ? mmap(0, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        close(fd);
+        if (base == MAP_FAILED)
+        {
+            return 0;
+        }
+
+        file->base = (const unsigned char*)base;
+        file->size = (uint64_t)st.st_size;
+    }
+#endif
+
+    header = (const vmath_file_header_t*)file->base;
+    if (!vmath_file_checkheader(header, file->size))
+    {
+        vmath_file_close(file);
+        return 0;
+    }
+    file->chunk_count = header->chunk_count;
+    return 1;
+}
+
+void vmath_file_close(vmath_file_t* file)
+{
+    if (file->base)
+    {
+#if defined(_WIN32)
+        UnmapViewOfFile(file->base);
+        CloseHandle((HANDLE)file->handle);
+#else
+        munmap((void*)file->base, (size_t)file->size);
+#endif
+    }
+    memset(file, 0, sizeof(*file));
+}
+
+/**
+ * Write zeros until offset is aligned
+ */
+static int vmath_file_writer_pad(vmath_file_writer_t* writer)
+{
+    static const unsigned char zeros[VMATH_FILE_ALIGN] = { 0 };
+    const size_t pad = (size_t)(vmath_file_alignup(writer->offset) - writer->offset);
+    writer->offset += pad;
+    return fwrite(zeros, 1, pad, writer->file) == pad;
+}
+
+int vmath_file_writer_open(vmath_file_writer_t* writer, const char* path)
+{
+    vmath_file_header_t header;
+
+    memset(writer, 0, sizeof(*writer));
+    writer->file = fopen(path, "wb");
+    if (!writer->file)
+    {
+        return 0;
+    }
+
+    /* Placeholder, patched on close */
+    memset(&header, 0, sizeof(header));
+    writer->offset = sizeof(header);
+    return fwrite(&header, sizeof(header), 1, writer->file) == 1 && vmath_file_writer_pad(writer);
+}
+
+int vmath_file_writer_begin(vmath_file_writer_t* writer, uint32_t type, uint32_t tag)
+{
+    memset(&writer->chunk, 0, sizeof(writer->chunk));
+    writer->chunk.type   = type;
+    writer->chunk.tag    = tag;
+    writer->chunk.stride = vmath_chunk_stride(type);
+    writer->chunk_offset = writer->offset;
+    writer->sum[0]       = 0;
+    writer->sum[1]       = 0;
+    writer->tail_bytes   = 0;
+
+    /* Placeholder, patched on end */
+    writer->offset += sizeof(writer->chunk);
+    return fwrite(&writer->chunk, sizeof(writer->chunk), 1, writer->file) == 1;
+}
+
+int vmath_file_writer_write(vmath_file_writer_t* writer, const void* data, uint64_t count)
+{
+    const uint64_t bytes = count * writer->chunk.stride;
+    vmath_checksum_stream(writer->sum, writer->tail, &writer->tail_bytes, data, bytes);
+    writer->chunk.count += count;
+    writer->chunk.bytes += bytes;
+    writer->offset      += bytes;
+    return fwrite(data, 1, (size_t)bytes, writer->file) == (size_t)bytes;
+}
+
+int vmath_file_writer_end(vmath_file_writer_t* writer)
+{
+    int ok;
+    vmath_checksum_update(writer->sum, writer->tail, writer->tail_bytes);
+    writer->chunk.checksum = vmath_checksum_final(writer->sum);
+    writer->chunk_count++;
+
+    ok = vmath_file_seek(writer->file, writer->chunk_offset) == 0
+        && fwrite(&writer->chunk, sizeof(writer->chunk), 1, writer->file) == 1
+        && vmath_file_seek(writer->file, writer->offset) == 0;
+    return ok && vmath_file_writer_pad(writer);
+}
+
+int vmath_file_writer_close(vmath_file_writer_t* writer)
+{
+    vmath_file_header_t header;
+    int ok;
+
+    memset(&header, 0, sizeof(header));
+    header.magic       = VMATH_FOURCC('V', 'M', 'T', 'H');
+    header.version     = VMATH_FILE_VERSION;
+    header.chunk_count = writer->chunk_count;
+    header.endian      = 0x01020304;
+    header.file_size   = writer->offset;
+
+    ok = vmath_file_seek(writer->file, 0) == 0 && fwrite(&header, sizeof(header), 1, writer->file) == 1;
+    ok = fclose(writer->file) == 0 && ok;
+    writer->file = 0;
+    return ok;
+}
+
+int vmath_file_reader_open(vmath_file_reader_t* reader, const char* path)
+{
+    vmath_file_header_t header;
+
+    memset(reader, 0, sizeof(*reader));
+    reader->file = fopen(path, "rb");
+    if (!reader->file)
+    {
+        return 0;
+    }
+
+    if (fread(&header, sizeof(header), 1, reader->file) != 1 || !vmath_file_checkheader(&header, header.file_size))
+    {
+        vmath_file_reader_close(reader);
+        return 0;
+    }
+
+    reader->chunk_count = header.chunk_count;
+    reader->offset      = VMATH_FILE_ALIGN;
+    return 1;
+}
+
+int vmath_file_reader_next(vmath_file_reader_t* reader, vmath_chunk_t* chunk)
+{
+    /* Skip the rest of the current chunk */
+    if (reader->chunk_index > 0)
+    {
+        reader->offset = vmath_file_alignup(reader->offset + reader->remain);
+    }
+
+    if (reader->chunk_index >= reader->chunk_count
+        || vmath_file_seek(reader->file, reader->offset) != 0
+        || fread(&reader->chunk, sizeof(reader->chunk), 1, reader->file) != 1
+        || !vmath_chunk_checkheader(&reader->chunk))
+    {
+        return 0;
+    }
+
+    reader->chunk_index++;
+    reader->offset += sizeof(reader->chunk);
+    reader->remain  = reader->chunk.bytes;
+    reader->sum[0]  = 0;
+    reader->sum[1]  = 0;
+    reader->tail_bytes = 0;
+
+    chunk->type     = reader->chunk.type;
+    chunk->tag      = reader->chunk.tag;
+    chunk->stride   = reader->chunk.stride;
+    chunk->count    = reader->chunk.count;
+    chunk->checksum = reader->chunk.checksum;
+    chunk->data     = 0;
+    return 1;
+}
+
+uint64_t vmath_file_reader_read(vmath_file_reader_t* reader, void* buffer, uint64_t max_count)
+{
+    const uint64_t stride = reader->chunk.stride ? reader->chunk.stride : 1;
+    uint64_t count = reader->remain / stride;
+    uint64_t bytes;
+
+    count = count < max_count ? count : max_count;
+    bytes = count * stride;
+    if (count == 0 || fread(buffer, 1, (size_t)bytes, reader->file) != (size_t)bytes)
+    {
+        return 0;
+    }
+
+    /* Checksum go by words, reads may end inside a word */
+    vmath_checksum_stream(reader->sum, reader->tail, &reader->tail_bytes, buffer, bytes);
+    reader->offset += bytes;
+    reader->remain -= bytes;
+    if (reader->remain == 0)
+    {
+        vmath_checksum_update(reader->sum, reader->tail, reader->tail_bytes);
+        reader->tail_bytes = 0;
+    }
+    return count;
+}
+
+int vmath_file_reader_verify(const vmath_file_reader_t* reader)
+{
+    return reader->remain == 0 && vmath_checksum_final(reader->sum) == reader->chunk.checksum;
+}
+
+void vmath_file_reader_close(vmath_file_reader_t* reader)
+{
+    if (reader->file)
+    {
+        fclose(reader->file);
+    }
+    reader->file = 0;
+}
+
+#endif /* VMATH_IMPL */
@@ -0,0 +1,527 @@
+/******************************************************
+ * vmath_geometry - Closest point and distance queries
+ *
+ * @author: MaiHD
+ * @license: NULL
+ * @copyright: MaiHD @ ${HOME}, 2017 - 2018
+ ******************************************************/
+
+#ifndef __VMATH_GEOMETRY_H__
+#define __VMATH_GEOMETRY_H__
+
+#include "vmath_soa.h"
+
+/**
+ * Closest points between points, segments, triangles and boxes.
+ * Distances are squared, take the sqrtf when needed.
+ *
+ * Degenerate inputs are handled: a zero length segment is a point, a zero
+ * area triangle is a segment or a point, the results stay finite.
+ *
+ * Many triangles against one point use vmath_triangle8_t blocks, 8
+ * triangles in SoA with precomputed edges, so a query cost 2 dot
+ * products per triangle and no branch.
+ */
+
+/********************
+ * Point queries
+ ********************/
+
+/**
+ * A triangle of edges ab and ac is flat when the sine of its angle is
+ * below 1e-5, barycentric coordinates are not reliable anymore
+ */
+__vmath__ bool vmath_triangle_flat(vec3_t ab, vec3_t ac)
+{
+    const vec3_t n = vec3_cross(ab, ac);
+    return vec3_dot(n, n) <= 1e-10f * vec3_dot(ab, ab) * vec3_dot(ac, ac);
+}
+
+/**
+ * Closest point of segment [a, b] to p
+ * @param t: parameter of the point on the segment, may be NULL
+ */
+__vmath__ vec3_t vmath_closest_segment(vec3_t p, vec3_t a, vec3_t b, float* t)
+{
+    const vec3_t ab = vec3_sub(b, a);
+    const float  l  = vec3_dot(ab, ab);
+    float        s  = l > 0.0f ? vec3_dot(vec3_sub(p, a), ab) / l : 0.0f;
+
+    s = s < 0.0f ? 0.0f : (s > 1.0f ? 1.0f : s);
+    if (t)
+    {
+        *t = s;
+    }
+    return vec3_add(a, vec3_mulf(ab, s));
+}
+
+/**
+ * Closest point of box [min, max] to p, p itself when inside
+ */
+__vmath__ vec3_t vmath_closest_aabb(vec3_t p, vec3_t min, vec3_t max)
+{
+    return vec3_min(vec3_max(p, min), max);
+}
+
+/**
+ * Closest point of triangle abc to p (Ericson, Real-Time Collision
+ * Detection 5.1.5)
+ * @param bary: barycentric coordinates of the point, may be NULL
+ */
+__vmath__ vec3_t vmath_closest_triangle(vec3_t p, vec3_t a, vec3_t b, vec3_t c, vec3_t* bary)
+{
+    const vec3_t ab = vec3_sub(b, a);
+    const vec3_t ac = vec3_sub(c, a);
+    const vec3_t ap = vec3_sub(p, a);
+    const float  d1 = vec3_dot(ab, ap);
+    const float  d2 = vec3_dot(ac, ap);
+    float        d3, d4, d5, d6, va, vb, vc, v, w;
+
+    /* Flat triangle: the closest point is on the longest edge */
+    if (vmath_triangle_flat(ab, ac))
+    {
+        const vec3_t bc = vec3_sub(c, b);
+        const float  lb = vec3_dot(ab, ab), lc = vec3_dot(ac, ac), la = vec3_dot(bc, bc);
+        float        t;
+
+        if (la >= lb && la >= lc)
+        {
+            vmath_closest_segment(p, b, c, &t);
+            v = 1.0f - t;
+            w = t;
+        }
+        else if (lb >= lc)
+        {
+            vmath_closest_segment(p, a, b, &v);
+            w = 0.0f;
+        }
+        else
+        {
+            vmath_closest_segment(p, a, c, &w);
+            v = 0.0f;
+        }
+        goto done;
+    }
+
+    /* Vertex regions and edge regions in order, the first match wins */
+    if (d1 <= 0.0f && d2 <= 0.0f)
+    {
+        v = 0.0f;
+        w = 0.0f;
+        goto done;
+    }
+
+    d3 = d1 - vec3_dot(ab, ab);
+    d4 = d2 - vec3_dot(ab, ac);
+    if (d3 >= 0.0f && d4 <= d3)
+    {
+        v = 1.0f;
+        w = 0.0f;
+        goto done;
+    }
+
+    vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+    {
+        v = d1 - d3 > 0.0f ? d1 / (d1 - d3) : 0.0f;
+        w = 0.0f;
+        goto done;
+    }
+
+    d5 = d1 - vec3_dot(ab, ac);
+    d6 = d2 - vec3_dot(ac, ac);
+    if (d6 >= 0.0f && d5 <= d6)
+    {
+        v = 0.0f;
+        w = 1.0f;
+        goto done;
+    }
+
+    vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+    {
+        v = 0.0f;
+        w = d2 - d6 > 0.0f ? d2 / (d2 - d6) : 0.0f;
+        goto done;
+    }
+
+    va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+    {
+        const float e = (d4 - d3) + (d5 - d6);
+        w = e > 0.0f ? (d4 - d3) / e : 0.0f;
+        v = 1.0f - w;
+        goto done;
+    }
+
+    /* Inside */
+    {
+        const float f = 1.0f / (va + vb + vc);
+        v = vb * f;
+        w = vc * f;
+    }
+
+done:
+    if (bary)
+    {
+        *bary = vec3(1.0f - v - w, v, w);
+    }
+    return vec3_add(a, vec3_add(vec3_mulf(ab, v), vec3_mulf(ac, w)));
+}
+
+/**
+ * Squared distance from p to segment [a, b]
+ */
+__vmath__ float vmath_distance2_segment(vec3_t p, vec3_t a, vec3_t b)
+{
+    return vec3_distancesquared(p, vmath_closest_segment(p, a, b, 0));
+}
+
+/**
+ * Squared distance from p to box [min, max], 0 inside
+ */
+__vmath__ float vmath_distance2_aabb(vec3_t p, vec3_t min, vec3_t max)
+{
+    return vec3_distancesquared(p, vmath_closest_aabb(p, min, max));
+}
+
+/**
+ * Squared distance from p to triangle abc
+ */
+__vmath__ float vmath_distance2_triangle(vec3_t p, vec3_t a, vec3_t b, vec3_t c)
+{
+    return vec3_distancesquared(p, vmath_closest_triangle(p, a, b, c, 0));
+}
+
+/********************
+ * Segment queries
+ ********************/
+
+/**
+ * Closest points between segments [p0, p1] and [q0, q1] (Ericson 5.1.9),
+ * parallel segments give one of the closest pairs
+ * @param s, t:   parameters of the points on each segment, may be NULL
+ * @param c0, c1: closest points, may be NULL
+ * @return: squared distance
+ */
+__vmath__ float vmath_closest_segments(vec3_t p0, vec3_t p1, vec3_t q0, vec3_t q1, float* s, float* t, vec3_t* c0, vec3_t* c1)
+{
+    const vec3_t d1 = vec3_sub(p1, p0);
+    const vec3_t d2 = vec3_sub(q1, q0);
+    const vec3_t r  = vec3_sub(p0, q0);
+    const float  a  = vec3_dot(d1, d1);
+    const float  e  = vec3_dot(d2, d2);
+    const float  f  = vec3_dot(d2, r);
+    float        u, v;
+    vec3_t       x, y;
+
+    if (a <= FLT_MIN && e <= FLT_MIN)
+    {
+        u = 0.0f;
+        v = 0.0f;
+    }
+    else if (a <= FLT_MIN)
+    {
+        u = 0.0f;
+        v = f / e;
+        v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+    }
+    else
+    {
+        const float c = vec3_dot(d1, r);
+        if (e <= FLT_MIN)
+        {
+            v = 0.0f;
+            u = -c / a;
+            u = u < 0.0f ? 0.0f : (u > 1.0f ? 1.0f : u);
+        }
+        else
+        {
+            const float b     = vec3_dot(d1, d2);
+            const float denom = a * e - b * b;
+
+            u = denom > 0.0f ? (b * f - c * e) / denom : 0.0f;
+            u = u < 0.0f ? 0.0f : (u > 1.0f ? 1.0f : u);
+
+            /* Clamp v then recompute u for the clamped v */
+            v = (b * u + f) / e;
+            if (v < 0.0f)
+            {
+                v = 0.0f;
+                u = -c / a;
+                u = u < 0.0f ? 0.0f : (u > 1.0f ? 1.0f : u);
+            }
+            else if (v > 1.0f)
+            {
+                v = 1.0f;
+                u = (b - c) / a;
+                u = u < 0.0f ? 0.0f : (u > 1.0f ? 1.0f : u);
+            }
+        }
+    }
+
+    x = vec3_add(p0, vec3_mulf(d1, u));
+    y = vec3_add(q0, vec3_mulf(d2, v));
+    if (s)  *s  = u;
+    if (t)  *t  = v;
+    if (c0) *c0 = x;
+    if (c1) *c1 = y;
+    return vec3_distancesquared(x, y);
+}
+
+/********************
+ * Triangle blocks
+ ********************/
+
+/**
+ * 8 triangles in SoA: first vertex, both edges from it and their dot
+ * products, [axis][triangle]
+ */
+typedef struct vmath_triangle8
+{
+    float a[3][8];
+    float ab[3][8];
+    float ac[3][8];
+    float abab[8];
+    float abac[8];
+    float acac[8];
+} vmath_triangle8_t;
+
+/**
+ * Closest point of triangles to points in lanes, returns the squared
+ * distances and the barycentric coordinates (v, w) of b and c
+ */
+__vmath__ vfloat4_t vmath_closest_triangle_x4(const vfloat4_t p[3], const vfloat4_t a[3], const vfloat4_t ab[3], const vfloat4_t ac[3],
+                                              vfloat4_t abab, vfloat4_t abac, vfloat4_t acac, vfloat4_t* v, vfloat4_t* w)
+{
+    const vfloat4_t zero = vfloat4_zero();
+    const vfloat4_t one  = vfloat4_set1(1.0f);
+    const vfloat4_t ap0  = vfloat4_sub(p[0], a[0]);
+    const vfloat4_t ap1  = vfloat4_sub(p[1], a[1]);
+    const vfloat4_t ap2  = vfloat4_sub(p[2], a[2]);
+
+    const vfloat4_t d1 = vfloat4_madd(ab[0], ap0, vfloat4_madd(ab[1], ap1, vfloat4_mul(ab[2], ap2)));
+    const vfloat4_t d2 = vfloat4_madd(ac[0], ap0, vfloat4_madd(ac[1], ap1, vfloat4_mul(ac[2], ap2)));
+    const vfloat4_t d3 = vfloat4_sub(d1, abab);
+    const vfloat4_t d4 = vfloat4_sub(d2, abac);
+    const vfloat4_t d5 = vfloat4_sub(d1, abac);
+    const vfloat4_t d6 = vfloat4_sub(d2, acac);
+
+    const vfloat4_t va = vfloat4_sub(vfloat4_mul(d3, d6), vfloat4_mul(d5, d4));
+    const vfloat4_t vb = vfloat4_sub(vfloat4_mul(d5, d2), vfloat4_mul(d1, d6));
+    const vfloat4_t vc = vfloat4_sub(vfloat4_mul(d1, d4), vfloat4_mul(d3, d2));
+
+    const vfloat4_t e43 = vfloat4_sub(d4, d3);
+    const vfloat4_t e56 = vfloat4_sub(d5, d6);
+    vfloat4_t       m, t, bv, bw, x, y, z;
+
+    /* Inside, then the regions from last to first so the first match wins */
+    t  = vfloat4_div(one, vfloat4_max(vfloat4_add(va, vfloat4_add(vb, vc)), vfloat4_set1(FLT_MIN)));
+    bv = vfloat4_mul(vb, t);
+    bw = vfloat4_mul(vc, t);
+
+    /* Edge bc */
+    m  = vfloat4_and(vfloat4_cmple(va, zero), vfloat4_and(vfloat4_cmpge(e43, zero), vfloat4_cmpge(e56, zero)));
+    t  = vfloat4_div(e43, vfloat4_max(vfloat4_add(e43, e56), vfloat4_set1(FLT_MIN)));
+    bv = vfloat4_select(bv, vfloat4_sub(one, t), m);
+    bw = vfloat4_select(bw, t, m);
+
+    /* Edge ac */
+    m  = vfloat4_and(vfloat4_cmple(vb, zero), vfloat4_and(vfloat4_cmpge(d2, zero), vfloat4_cmple(d6, zero)));
+    t  = vfloat4_div(d2, vfloat4_max(vfloat4_sub(d2, d6), vfloat4_set1(FLT_MIN)));
+    bv = vfloat4_andnot(m, bv);
+    bw = vfloat4_select(bw, t, m);
+
+    /* Vertex c */
+    m  = vfloat4_and(vfloat4_cmpge(d6, zero), vfloat4_cmple(d5, d6));
+    bv = vfloat4_andnot(m, bv);
+    bw = vfloat4_select(bw, one, m);
+
+    /* Edge ab */
+    m  = vfloat4_and(vfloat4_cmple(vc, zero), vfloat4_and(vfloat4_cmpge(d1, zero), vfloat4_cmple(d3, zero)));
+    t  = vfloat4_div(d1, vfloat4_max(abab, vfloat4_set1(FLT_MIN)));
+    bv = vfloat4_select(bv, t, m);
+    bw = vfloat4_andnot(m, bw);
+
+    /* Vertex b */
+    m  = vfloat4_and(vfloat4_cmpge(d3, zero), vfloat4_cmple(d4, d3));
+    bv = vfloat4_select(bv, one, m);
+    bw = vfloat4_andnot(m, bw);
+
+    /* Vertex a */
+    m  = vfloat4_and(vfloat4_cmple(d1, zero), vfloat4_cmple(d2, zero));
+    bv = vfloat4_andnot(m, bv);
+    bw = vfloat4_andnot(m, bw);
+
+    /* p - closest = ap - v ab - w ac */
+    x = vfloat4_nmadd(bw, ac[0], vfloat4_nmadd(bv, ab[0], ap0));
+    y = vfloat4_nmadd(bw, ac[1], vfloat4_nmadd(bv, ab[1], ap1));
+    z = vfloat4_nmadd(bw, ac[2], vfloat4_nmadd(bv, ab[2], ap2));
+
+    *v = bv;
+    *w = bw;
+    return vfloat4_madd(x, x, vfloat4_madd(y, y, vfloat4_mul(z, z)));
+}
+
+/**
+ * Load 4 triangles of a block to lanes, half is 0 or 4
+ */
+__vmath__ void vmath_triangle8_load_x4(const vmath_triangle8_t* block, int half, vfloat4_t a[3], vfloat4_t ab[3], vfloat4_t ac[3],
+                                       vfloat4_t* abab, vfloat4_t* abac, vfloat4_t* acac)
+{
+    int i;
+    for (i = 0; i < 3; i++)
+    {
+        a[i]  = vfloat4_load(block->a[i] + half);
+        ab[i] = vfloat4_load(block->ab[i] + half);
+        ac[i] = vfloat4_load(block->ac[i] + half);
+    }
+    *abab = vfloat4_load(block->abab + half);
+    *abac = vfloat4_load(block->abac + half);
+    *acac = vfloat4_load(block->acac + half);
+}
+
+/**
+ * Pack triangles to blocks, the last block is padded with the last
+ * triangle, flat triangles are stored as their longest edge
+ * @param indices: 3 vertices per triangle, NULL when the vertices are
+ *                 already in triangle order
+ * @return: number of blocks, (count + 7) / 8
+ */
+__vmath_batch__ int vmath_triangle8_pack(const vec3_t* vertices, const int* indices, int count, vmath_triangle8_t* blocks)
+{
+    const int n = (count + 7) / 8;
+    int i;
+
+    for (i = 0; i < n * 8; i++)
+    {
+        vmath_triangle8_t* block = blocks + i / 8;
+        const int t = i < count ? i : count - 1;
+        const int l = i % 8;
+
+        vec3_t a  = vertices[indices ? indices[t * 3 + 0] : t * 3 + 0];
+        vec3_t b  = vertices[indices ? indices[t * 3 + 1] : t * 3 + 1];
+        vec3_t c  = vertices[indices ? indices[t * 3 + 2] : t * 3 + 2];
+        vec3_t ab = vec3_sub(b, a);
+        vec3_t ac = vec3_sub(c, a);
+
+        /* Flat triangles become their longest edge with c = b, which the
+           regions of the kernel handle exactly */
+        if (vmath_triangle_flat(ab, ac))
+        {
+            const vec3_t bc = vec3_sub(c, b);
+            if (vec3_dot(bc, bc) > vec3_dot(ab, ab) && vec3_dot(bc, bc) >= vec3_dot(ac, ac))
+            {
+                a  = b;
+                ab = bc;
+            }
+            else if (vec3_dot(ac, ac) > vec3_dot(ab, ab))
+            {
+                ab = ac;
+            }
+            ac = ab;
+        }
+
+        block->a[0][l]  = a.x;  block->a[1][l]  = a.y;  block->a[2][l]  = a.z;
+        block->ab[0][l] = ab.x; block->ab[1][l] = ab.y; block->ab[2][l] = ab.z;
+        block->ac[0][l] = ac.x; block->ac[1][l] = ac.y; block->ac[2][l] = ac.z;
+        block->abab[l]  = vec3_dot(ab, ab);
+        block->abac[l]  = vec3_dot(ab, ac);
+        block->acac[l]  = vec3_dot(ac, ac);
+    }
+    return n;
+}
+
+/**
+ * Squared distances from p to count packed triangles, 8 per loop
+ */
+__vmath_batch__ void vmath_triangle8_distances(const vmath_triangle8_t* blocks, int count, vec3_t p, float* dist2)
+{
+    vfloat4_t q[3];
+    int       i, h;
+
+    q[0] = vfloat4_set1(p.x);
+    q[1] = vfloat4_set1(p.y);
+    q[2] = vfloat4_set1(p.z);
+    for (i = 0; i < count; i += 8)
+    {
+        for (h = 0; h < 8 && i + h < count; h += 4)
+        {
+            vfloat4_t a[3], ab[3], ac[3], abab, abac, acac, v, w, d;
+
+            vmath_triangle8_load_x4(blocks + i / 8, h, a, ab, ac, &abab, &abac, &acac);
+            d = vmath_closest_triangle_x4(q, a, ab, ac, abab, abac, acac, &v, &w);
+            vfloat4_storen(dist2 + i + h, d, count - i - h < 4 ? count - i - h : 4);
+        }
+    }
+}
+
+/**
+ * Closest of count packed triangles to p, 8 per loop
+ * @param point: closest point, may be NULL
+ * @param dist2: squared distance, may be NULL
+ * @return: index of the triangle, -1 when count is 0
+ */
+__vmath_batch__ int vmath_triangle8_closest(const vmath_triangle8_t* blocks, int count, vec3_t p, vec3_t* point, float* dist2)
+{
+    const vfloat4_t n = vfloat4_set1((float)count);
+    vfloat4_t       q[3], bd, bv, bw, bi;
+    float           ds[4], vs[4], ws[4], is[4];
+    int             index = -1, lane = 0, i, h, l;
+
+    q[0] = vfloat4_set1(p.x);
+    q[1] = vfloat4_set1(p.y);
+    q[2] = vfloat4_set1(p.z);
+
+    /* Best per lane, reduced once at the end */
+    bd = vfloat4_set1(FLT_MAX);
+    bv = bw = vfloat4_zero();
+    bi = vfloat4_set1(-1.0f);
+    for (i = 0; i < count; i += 8)
+    {
+        for (h = 0; h < 8 && i + h < count; h += 4)
+        {
+            const vfloat4_t id = vfloat4_add(vfloat4_set1((float)(i + h)), vfloat4_set(0, 1, 2, 3));
+            vfloat4_t a[3], ab[3], ac[3], abab, abac, acac, v, w, d, m;
+
+            vmath_triangle8_load_x4(blocks + i / 8, h, a, ab, ac, &abab, &abac, &acac);
+            d = vmath_closest_triangle_x4(q, a, ab, ac, abab, abac, acac, &v, &w);
+
+            /* Padding lanes never win, ties keep the first */
+            m  = vfloat4_and(vfloat4_cmplt(d, bd), vfloat4_cmplt(id, n));
+            bd = vfloat4_select(bd, d, m);
+            bv = vfloat4_select(bv, v, m);
+            bw = vfloat4_select(bw, w, m);
+            bi = vfloat4_select(bi, id, m);
+        }
+    }
+
+    vfloat4_store(ds, bd);
+    vfloat4_store(vs, bv);
+    vfloat4_store(ws, bw);
+    vfloat4_store(is, bi);
+    for (l = 0; l < 4; l++)
+    {
+        const int t = (int)is[l];
+        if (t >= 0 && (index < 0 || ds[l] < ds[lane] || (ds[l] == ds[lane] && t < index)))
+        {
+            index = t;
+            lane  = l;
+        }
+    }
+
+    if (index >= 0)
+    {
+        const vmath_triangle8_t* block = blocks + index / 8;
+        const int    t  = index % 8;
+        const vec3_t a  = vec3(block->a[0][t], block->a[1][t], block->a[2][t]);
+        const vec3_t ab = vec3(block->ab[0][t], block->ab[1][t], block->ab[2][t]);
+        const vec3_t ac = vec3(block->ac[0][t], block->ac[1][t], block->ac[2][t]);
+
+        if (point) *point = vec3_add(a, vec3_add(vec3_mulf(ab, vs[lane]), vec3_mulf(ac, ws[lane])));
+        if (dist2) *dist2 = ds[lane];
+    }
+    return index;
+}
+
+#endif /* __VMATH_GEOMETRY_H__ */
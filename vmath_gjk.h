@@ -0,0 +1,949 @@
+/******************************************************
+ * vmath_gjk - GJK distance and EPA penetration between convex shapes
+ *
+ * @author: MaiHD
+ * @license: NULL
+ * @copyright: MaiHD @ ${HOME}, 2017 - 2018
+ ******************************************************/
+
+#ifndef __VMATH_GJK_H__
+#define __VMATH_GJK_H__
+
+#include "vmath_soa.h"
+#include "vmath_geometry.h"
+
+/**
+ * A convex shape is a support function in local space, a transform and a
+ * radius. The radius rounds the shape: a sphere is a point with a radius,
+ * a capsule is a segment with a radius. GJK and EPA run on the core shapes,
+ * the radii are added at the end, so rounded shapes converge as fast as
+ * polytopes.
+ *
+ * Every query takes an optional vmath_gjk_cache_t, zero it before the first
+ * use. It keeps the search directions of the last simplex, the next query
+ * on the same pair starts from them and usually ends in 1 or 2 iterations
+ * when the shapes moved a little.
+ *
+ * Normals point from a to b.
+ */
+
+#ifndef VMATH_GJK_MAX_ITERATIONS
+#define VMATH_GJK_MAX_ITERATIONS 32
+#endif
+
+#ifndef VMATH_GJK_EPSILON
+#define VMATH_GJK_EPSILON 1e-6f
+#endif
+
+#ifndef VMATH_EPA_MAX_VERTICES
+#define VMATH_EPA_MAX_VERTICES 64
+#endif
+
+#ifndef VMATH_EPA_MAX_FACES
+#define VMATH_EPA_MAX_FACES 128
+#endif
+
+#ifndef VMATH_EPA_EPSILON
+#define VMATH_EPA_EPSILON 1e-4f
+#endif
+
+struct vmath_convex;
+
+/**
+ * Support function: the farthest point of the shape along dir, in local
+ * space, dir is not normalized
+ */
+typedef vec3_t (*vmath_support_t)(const struct vmath_convex* shape, vec3_t dir);
+
+typedef struct vmath_convex
+{
+    vmath_support_t support;
+    const void*     data;       /* Shape data, vmath_hull_t for hulls */
+    vec3_t          extents;    /* Half extents for boxes, half height in y for capsules */
+    float           radius;
+    vec3_t          position;
+    quat_t          rotation;
+} vmath_convex_t;
+
+/**
+ * Hull vertices in blocks of 4, x[4] y[4] z[4] per block
+ */
+typedef struct vmath_hull
+{
+    const float* blocks;
+    int          count;
+} vmath_hull_t;
+
+typedef struct vmath_gjk_cache
+{
+    vec3_t dirs[4];
+    int    count;
+} vmath_gjk_cache_t;
+
+/********************
+ * Support functions
+ ********************/
+
+__vmath__ vec3_t vmath_support_point(const vmath_convex_t* shape, vec3_t dir)
+{
+    (void)shape;
+    (void)dir;
+    return vec3(0.0f, 0.0f, 0.0f);
+}
+
+__vmath__ vec3_t vmath_support_box(const vmath_convex_t* shape, vec3_t dir)
+{
+    return vec3(dir.x < 0.0f ? -shape->extents.x : shape->extents.x,
+                dir.y < 0.0f ? -shape->extents.y : shape->extents.y,
+                dir.z < 0.0f ? -shape->extents.z : shape->extents.z);
+}
+
+__vmath__ vec3_t vmath_support_segment(const vmath_convex_t* shape, vec3_t dir)
+{
+    return vec3(0.0f, dir.y < 0.0f ? -shape->extents.y : shape->extents.y, 0.0f);
+}
+
+/**
+ * Pack hull vertices into blocks of 4, the last block is padded with the
+ * last vertex
+ *
+ * @param blocks: 12 floats per block
+ * @return: number of blocks, (count + 3) / 4
+ */
+__vmath_batch__ int vmath_hull_pack(const vec3_t* vertices, int count, float* blocks)
+{
+    int i, n = (count + 3) / 4;
+    for (i = 0; i < n * 4; i++)
+    {
+        const vec3_t v     = vertices[i < count ? i : count - 1];
+        float*       block = blocks + (i / 4) * 12 + (i & 3);
+
+        block[0] = v.x;
+        block[4] = v.y;
+        block[8] = v.z;
+    }
+    return n;
+}
+
+/**
+ * Index of the hull vertex farthest along dir, 4 vertices per step
+ */
+__vmath__ int vmath_hull_search(const vmath_hull_t* hull, vec3_t dir)
+{
+    const vfloat4_t dx = vfloat4_set1(dir.x);
+    const vfloat4_t dy = vfloat4_set1(dir.y);
+    const vfloat4_t dz = vfloat4_set1(dir.z);
+
+    vfloat4_t best  = vfloat4_set1(-FLT_MAX);
+    vfloat4_t index = vfloat4_zero();
+    vfloat4_t ids   = vfloat4_set(0.0f, 1.0f, 2.0f, 3.0f);
+    float     values[4], indices[4];
+    int       i, lane;
+
+    for (i = 0; i < hull->count; i += 4)
+    {
+        const float*    block = hull->blocks + i * 3;
+        const vfloat4_t d     = vfloat4_madd(vfloat4_load(block + 8), dz,
+                                             vfloat4_madd(vfloat4_load(block + 4), dy,
+                                                          vfloat4_mul(vfloat4_load(block), dx)));
+        const vfloat4_t m     = vfloat4_cmpgt(d, best);
+
+        best  = vfloat4_select(best, d, m);
+        index = vfloat4_select(index, ids, m);
+        ids   = vfloat4_add(ids, vfloat4_set1(4.0f));
+    }
+
+    vfloat4_store(values, best);
+    vfloat4_store(indices, index);
+    for (i = 1, lane = 0; i < 4; i++)
+    {
+        if (values[i] > values[lane] || (values[i] == values[lane] && indices[i] < indices[lane])) lane = i;
+    }
+    return (int)indices[lane];
+}
+
+__vmath__ vec3_t vmath_support_hull(const vmath_convex_t* shape, vec3_t dir)
+{
+    const vmath_hull_t* hull  = (const vmath_hull_t*)shape->data;
+    const int           i     = vmath_hull_search(hull, dir);
+    const float*        block = hull->blocks + (i / 4) * 12 + (i & 3);
+    return vec3(block[0], block[4], block[8]);
+}
+
+/********************
+ * Shapes
+ ********************/
+
+__vmath__ vmath_convex_t vmath_convex(vmath_support_t support, const void* data, vec3_t extents, float radius, vec3_t position, quat_t rotation)
+{
+    vmath_convex_t shape;
+    shape.support  = support;
+    shape.data     = data;
+    shape.extents  = extents;
+    shape.radius   = radius;
+    shape.position = position;
+    shape.rotation = rotation;
+    return shape;
+}
+
+__vmath__ vmath_convex_t vmath_convex_sphere(vec3_t position, float radius)
+{
+    return vmath_convex(vmath_support_point, NULL, vec3(0.0f, 0.0f, 0.0f), radius, position, quat(0.0f, 0.0f, 0.0f, 1.0f));
+}
+
+__vmath__ vmath_convex_t vmath_convex_box(vec3_t extents, vec3_t position, quat_t rotation)
+{
+    return vmath_convex(vmath_support_box, NULL, extents, 0.0f, position, rotation);
+}
+
+/**
+ * Capsule along the local y axis, half height excludes the caps
+ */
+__vmath__ vmath_convex_t vmath_convex_capsule(float half_height, float radius, vec3_t position, quat_t rotation)
+{
+    return vmath_convex(vmath_support_segment, NULL, vec3(0.0f, half_height, 0.0f), radius, position, rotation);
+}
+
+__vmath__ vmath_convex_t vmath_convex_hull(const vmath_hull_t* hull, vec3_t position, quat_t rotation)
+{
+    return vmath_convex(vmath_support_hull, hull, vec3(0.0f, 0.0f, 0.0f), 0.0f, position, rotation);
+}
+
+/**
+ * Rotate v by the unit quaternion q
+ */
+__vmath__ vec3_t vmath_convex_rotate(quat_t q, vec3_t v)
+{
+    const vec3_t u = vec3(q.x, q.y, q.z);
+    const vec3_t t = vec3_mulf(vec3_cross(u, v), 2.0f);
+    return vec3_add(vec3_add(v, vec3_mulf(t, q.w)), vec3_cross(u, t));
+}
+
+/**
+ * Support point of the core shape in world space
+ */
+__vmath__ vec3_t vmath_convex_support(const vmath_convex_t* shape, vec3_t dir)
+{
+    const quat_t inv = quat(-shape->rotation.x, -shape->rotation.y, -shape->rotation.z, shape->rotation.w);
+    const vec3_t p   = shape->support(shape, vmath_convex_rotate(inv, dir));
+    return vec3_add(shape->position, vmath_convex_rotate(shape->rotation, p));
+}
+
+/********************
+ * GJK
+ ********************/
+
+typedef struct vmath_gjk_vertex
+{
+    vec3_t w;   /* a - b */
+    vec3_t a;
+    vec3_t b;
+    vec3_t d;   /* Search direction */
+} vmath_gjk_vertex_t;
+
+__vmath__ vmath_gjk_vertex_t vmath_gjk_support(const vmath_convex_t* a, const vmath_convex_t* b, vec3_t d)
+{
+    vmath_gjk_vertex_t v;
+    v.d = d;
+    v.a = vmath_convex_support(a, d);
+    v.b = vmath_convex_support(b, vec3_neg(d));
+    v.w = vec3_sub(v.a, v.b);
+    return v;
+}
+
+/**
+ * Closest point of the triangle i, j, k of the simplex to the origin
+ */
+__vmath__ vec3_t vmath_gjk_triangle(const vmath_gjk_vertex_t* s, int i, int j, int k, float* lambda)
+{
+    vec3_t bary;
+    const vec3_t v = vmath_closest_triangle(vec3(0.0f, 0.0f, 0.0f), s[i].w, s[j].w, s[k].w, &bary);
+    lambda[0] = 0.0f; lambda[1] = 0.0f; lambda[2] = 0.0f; lambda[3] = 0.0f;
+    lambda[i] = bary.x;
+    lambda[j] = bary.y;
+    lambda[k] = bary.z;
+    return v;
+}
+
+/**
+ * Closest point of the simplex to the origin, drop the vertices that do not
+ * support it
+ *
+ * @return: closest point, zero when the origin is inside a tetrahedron
+ */
+__vmath__ vec3_t vmath_gjk_closest(vmath_gjk_vertex_t* s, int* count, float* lambda)
+{
+    vec3_t v;
+    int    i, n;
+
+    lambda[0] = 1.0f; lambda[1] = 0.0f; lambda[2] = 0.0f; lambda[3] = 0.0f;
+
+    switch (*count)
+    {
+    case 1:
+        v = s[0].w;
+        break;
+
+    case 2:
+        v = vmath_closest_segment(vec3(0.0f, 0.0f, 0.0f), s[0].w, s[1].w, &lambda[1]);
+        lambda[0] = 1.0f - lambda[1];
+        break;
+
+    case 3:
+        v = vmath_gjk_triangle(s, 0, 1, 2, lambda);
+        break;
+
+    default:
+    {
+        static const int faces[4][4] = { { 1, 2, 3, 0 }, { 0, 3, 2, 1 }, { 0, 1, 3, 2 }, { 0, 2, 1, 3 } };
+
+        const vec3_t n   = vec3_cross(vec3_sub(s[1].w, s[0].w), vec3_sub(s[2].w, s[0].w));
+        const float  det = vec3_dot(n, vec3_sub(s[3].w, s[0].w));
+        const bool   flat = det * det <= 1e-12f * vec3_dot(n, n) * vec3_lengthsquared(vec3_sub(s[3].w, s[0].w));
+        float        best = FLT_MAX;
+        bool         inside = !flat;
+
+        v = vec3(0.0f, 0.0f, 0.0f);
+        for (i = 0; i < 4; i++)
+        {
+            const vmath_gjk_vertex_t* a  = &s[faces[i][0]];
+            const vec3_t              fn = vec3_cross(vec3_sub(s[faces[i][1]].w, a->w), vec3_sub(s[faces[i][2]].w, a->w));
+            float                     l[4], d;
+            vec3_t                    p;
+
+            /* Only the faces with the origin and the opposite vertex on
+               different sides, all of them when flat */
+            if (!flat && vec3_dot(fn, a->w) * vec3_dot(fn, vec3_sub(s[faces[i][3]].w, a->w)) < 0.0f)
+            {
+                continue;
+            }
+
+            inside = false;
+            p      = vmath_gjk_triangle(s, faces[i][0], faces[i][1], faces[i][2], l);
+            d      = vec3_lengthsquared(p);
+            if (d < best)
+            {
+                best = d;
+                v    = p;
+                lambda[0] = l[0]; lambda[1] = l[1]; lambda[2] = l[2]; lambda[3] = l[3];
+            }
+        }
+
+        if (inside)
+        {
+            return vec3(0.0f, 0.0f, 0.0f);
+        }
+        break;
+    }
+    }
+
+    /* Keep the supporting vertices */
+    for (i = 0, n = 0; i < *count; i++)
+    {
+        if (lambda[i] > 0.0f)
+        {
+            s[n]      = s[i];
+            lambda[n] = lambda[i];
+            n++;
+        }
+    }
+    if (n == 0)
+    {
+        n         = 1;
+        lambda[0] = 1.0f;
+    }
+    *count = n;
+    return v;
+}
+
+/**
+ * GJK on the core shapes
+ *
+ * @param simplex: final simplex, 4 vertices
+ * @param count:   number of vertices of the final simplex
+ * @param margin:  stop as soon as the core distance is proven above it,
+ *                 FLT_MAX to always converge
+ * @return: closest point of the Minkowski difference a - b to the origin,
+ *          zero when the cores intersect
+ */
+__vmath_batch__ vec3_t vmath_gjk(const vmath_convex_t* a, const vmath_convex_t* b, vmath_gjk_cache_t* cache,
+                                 vmath_gjk_vertex_t* simplex, int* count, float* lambda, float margin)
+{
+    vec3_t v;
+    float  vv;
+    int    i, iterations;
+
+    *count = 0;
+    if (cache && cache->count > 0)
+    {
+        for (i = 0; i < cache->count; i++)
+        {
+            simplex[(*count)++] = vmath_gjk_support(a, b, cache->dirs[i]);
+        }
+    }
+    else
+    {
+        vec3_t d = vec3_sub(a->position, b->position);
+        if (vec3_lengthsquared(d) <= 0.0f) d = vec3(1.0f, 0.0f, 0.0f);
+        simplex[(*count)++] = vmath_gjk_support(a, b, vec3_neg(d));
+    }
+
+    v  = vmath_gjk_closest(simplex, count, lambda);
+    vv = vec3_lengthsquared(v);
+
+    for (iterations = 0; iterations < VMATH_GJK_MAX_ITERATIONS; iterations++)
+    {
+        vmath_gjk_vertex_t w;
+        float              vw;
+        vmath_gjk_vertex_t saved[4];
+        float              saved_lambda[4];
+        int                saved_count;
+
+        if (*count == 4 || vv <= VMATH_GJK_EPSILON * VMATH_GJK_EPSILON * vec3_lengthsquared(simplex[0].w))
+        {
+            v = vec3(0.0f, 0.0f, 0.0f);
+            break;
+        }
+
+        w  = vmath_gjk_support(a, b, vec3_neg(v));
+        vw = vec3_dot(v, w.w);
+
+        /* Separating axis farther than the margin */
+        if (vw > 0.0f && vw * vw > margin * margin * vv)
+        {
+            break;
+        }
+
+        /* No progress, v is the closest point up to the tolerance */
+        if (vv - vw <= VMATH_GJK_EPSILON * vv)
+        {
+            break;
+        }
+        for (i = 0; i < *count; i++)
+        {
+            if (vec3_equal(simplex[i].w, w.w)) break;
+        }
+        if (i < *count)
+        {
+            break;
+        }
+
+        for (i = 0; i < *count; i++) saved[i] = simplex[i];
+        for (i = 0; i < *count; i++) saved_lambda[i] = lambda[i];
+        saved_count = *count;
+
+        simplex[(*count)++] = w;
+        {
+            const vec3_t next = vmath_gjk_closest(simplex, count, lambda);
+            const float  nn   = vec3_lengthsquared(next);
+            if (nn >= vv && *count < 4)
+            {
+                /* Rounding made it worse, keep the previous simplex */
+                for (i = 0; i < saved_count; i++) simplex[i] = saved[i];
+                for (i = 0; i < saved_count; i++) lambda[i] = saved_lambda[i];
+                *count = saved_count;
+                break;
+            }
+            v    = next;
+            vv   = nn;
+        }
+    }
+
+    if (cache)
+    {
+        cache->count = *count;
+        for (i = 0; i < *count; i++)
+        {
+            cache->dirs[i] = simplex[i].d;
+        }
+    }
+    return v;
+}
+
+/**
+ * Distance between two convex shapes
+ *
+ * @param cache:  warm start cache, may be NULL
+ * @param pa, pb: closest points on each shape, may be NULL
+ * @return: distance, 0 when the shapes overlap
+ */
+__vmath_batch__ float vmath_gjk_distance(const vmath_convex_t* a, const vmath_convex_t* b, vmath_gjk_cache_t* cache, vec3_t* pa, vec3_t* pb)
+{
+    vmath_gjk_vertex_t simplex[4];
+    float              lambda[4];
+    int                i, count;
+
+    const vec3_t v = vmath_gjk(a, b, cache, simplex, &count, lambda, FLT_MAX);
+    const float  d = sqrtf(vec3_lengthsquared(v));
+    vec3_t       ca = vec3(0.0f, 0.0f, 0.0f), cb = vec3(0.0f, 0.0f, 0.0f), n;
+
+    for (i = 0; i < count; i++)
+    {
+        ca = vec3_add(ca, vec3_mulf(simplex[i].a, lambda[i]));
+        cb = vec3_add(cb, vec3_mulf(simplex[i].b, lambda[i]));
+    }
+
+    /* v = ca - cb, the normal from a to b is -v */
+    n = vec3(0.0f, 0.0f, 0.0f);
+    if (d > 0.0f)
+    {
+        n = vec3_mulf(v, -1.0f / d);
+    }
+    if (pa) *pa = vec3_add(ca, vec3_mulf(n, a->radius));
+    if (pb) *pb = vec3_sub(cb, vec3_mulf(n, b->radius));
+
+    return d > a->radius + b->radius ? d - a->radius - b->radius : 0.0f;
+}
+
+/**
+ * Overlap test, stops at the first separating axis
+ */
+__vmath_batch__ bool vmath_gjk_intersect(const vmath_convex_t* a, const vmath_convex_t* b, vmath_gjk_cache_t* cache)
+{
+    vmath_gjk_vertex_t simplex[4];
+    float              lambda[4];
+    int                count;
+
+    const float  margin = a->radius + b->radius;
+    const vec3_t v      = vmath_gjk(a, b, cache, simplex, &count, lambda, margin);
+    return vec3_lengthsquared(v) <= margin * margin;
+}
+
+/********************
+ * EPA
+ ********************/
+
+typedef struct vmath_epa_face
+{
+    int    v[3];
+    vec3_t n;
+    float  d;
+} vmath_epa_face_t;
+
+typedef struct vmath_epa
+{
+    vmath_gjk_vertex_t vertices[VMATH_EPA_MAX_VERTICES];
+    vmath_epa_face_t   faces[VMATH_EPA_MAX_FACES];
+    vec3_t             center;      /* Interior point, orients the faces */
+    int                vertex_count;
+    int                face_count;
+} vmath_epa_t;
+
+/**
+ * Add the face i, j, k, wound so that its normal points out of the
+ * polytope. The origin is inside or on a face: the faces through it are
+ * oriented by the interior point, their distance to the origin is 0.
+ *
+ * @return: false when out of faces or the face is degenerate, the polytope
+ *          has a hole then
+ */
+__vmath__ bool vmath_epa_face(vmath_epa_t* epa, int i, int j, int k)
+{
+    vmath_epa_face_t* f;
+    vec3_t            e0, e1, n;
+    float             l;
+
+    if (epa->face_count == VMATH_EPA_MAX_FACES)
+    {
+        return false;
+    }
+
+    e0 = vec3_sub(epa->vertices[j].w, epa->vertices[i].w);
+    e1 = vec3_sub(epa->vertices[k].w, epa->vertices[i].w);
+    n  = vec3_cross(e0, e1);
+    l  = sqrtf(vec3_lengthsquared(n));
+    if (l <= 1e-6f * sqrtf(vec3_lengthsquared(e0) * vec3_lengthsquared(e1)) || l <= 0.0f)
+    {
+        return false;
+    }
+
+    f    = &epa->faces[epa->face_count++];
+    f->n = vec3_mulf(n, 1.0f / l);
+    f->v[0] = i;
+    f->v[1] = j;
+    f->v[2] = k;
+    if (vec3_dot(f->n, vec3_sub(epa->vertices[i].w, epa->center)) < 0.0f)
+    {
+        f->n    = vec3_neg(f->n);
+        f->v[1] = k;
+        f->v[2] = j;
+    }
+    f->d = vec3_dot(f->n, epa->vertices[i].w);
+    f->d = f->d > 0.0f ? f->d : 0.0f;
+    return true;
+}
+
+__vmath__ int vmath_epa_vertex(vmath_epa_t* epa, vmath_gjk_vertex_t v)
+{
+    epa->vertices[epa->vertex_count] = v;
+    return epa->vertex_count++;
+}
+
+/**
+ * Interior point of the first polytope, the mean of its vertices
+ */
+__vmath__ void vmath_epa_center(vmath_epa_t* epa)
+{
+    int i;
+    epa->center = vec3(0.0f, 0.0f, 0.0f);
+    for (i = 0; i < epa->vertex_count; i++)
+    {
+        epa->center = vec3_add(epa->center, epa->vertices[i].w);
+    }
+    epa->center = vec3_mulf(epa->center, 1.0f / epa->vertex_count);
+}
+
+/**
+ * Grow the GJK simplex to a polytope around the origin
+ */
+__vmath_batch__ bool vmath_epa_init(vmath_epa_t* epa, const vmath_convex_t* a, const vmath_convex_t* b, const vmath_gjk_vertex_t* simplex, int count)
+{
+    int i;
+
+    epa->vertex_count = 0;
+    epa->face_count   = 0;
+    for (i = 0; i < count; i++)
+    {
+        vmath_epa_vertex(epa, simplex[i]);
+    }
+
+    /* A point: touching contact, grow to a segment */
+    if (epa->vertex_count == 1)
+    {
+        static const float axes[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+        for (i = 0; i < 6 && epa->vertex_count == 1; i++)
+        {
+            const vmath_gjk_vertex_t w = vmath_gjk_support(a, b, vec3(axes[i][0], axes[i][1], axes[i][2]));
+            if (vec3_distancesquared(w.w, epa->vertices[0].w) > 1e-12f)
+            {
+                vmath_epa_vertex(epa, w);
+            }
+        }
+        if (epa->vertex_count == 1)
+        {
+            return false;
+        }
+    }
+
+    /* A segment through the origin: 3 points around it, a bipyramid */
+    if (epa->vertex_count == 2)
+    {
+        const vec3_t axis = vec3_sub(epa->vertices[1].w, epa->vertices[0].w);
+        const vec3_t pick = fabsf(axis.x) < fabsf(axis.y) ? (fabsf(axis.x) < fabsf(axis.z) ? vec3(1, 0, 0) : vec3(0, 0, 1))
+                                                          : (fabsf(axis.y) < fabsf(axis.z) ? vec3(0, 1, 0) : vec3(0, 0, 1));
+        const vec3_t e0   = vec3_normalize(vec3_cross(axis, pick));
+        const vec3_t e1   = vec3_normalize(vec3_cross(axis, e0));
+
+        vmath_epa_vertex(epa, vmath_gjk_support(a, b, e0));
+        vmath_epa_vertex(epa, vmath_gjk_support(a, b, vec3_add(vec3_mulf(e0, -0.5f), vec3_mulf(e1, 0.8660254f))));
+        vmath_epa_vertex(epa, vmath_gjk_support(a, b, vec3_add(vec3_mulf(e0, -0.5f), vec3_mulf(e1, -0.8660254f))));
+        vmath_epa_center(epa);
+
+        vmath_epa_face(epa, 0, 2, 3);
+        vmath_epa_face(epa, 0, 3, 4);
+        vmath_epa_face(epa, 0, 4, 2);
+        vmath_epa_face(epa, 1, 3, 2);
+        vmath_epa_face(epa, 1, 4, 3);
+        vmath_epa_face(epa, 1, 2, 4);
+        return epa->face_count == 6;
+    }
+
+    /* A triangle around the origin: a bipyramid on both sides */
+    if (epa->vertex_count == 3)
+    {
+        const vec3_t n = vec3_cross(vec3_sub(epa->vertices[1].w, epa->vertices[0].w), vec3_sub(epa->vertices[2].w, epa->vertices[0].w));
+
+        vmath_epa_vertex(epa, vmath_gjk_support(a, b, n));
+        vmath_epa_vertex(epa, vmath_gjk_support(a, b, vec3_neg(n)));
+        vmath_epa_center(epa);
+
+        vmath_epa_face(epa, 0, 1, 3);
+        vmath_epa_face(epa, 1, 2, 3);
+        vmath_epa_face(epa, 2, 0, 3);
+        vmath_epa_face(epa, 1, 0, 4);
+        vmath_epa_face(epa, 2, 1, 4);
+        vmath_epa_face(epa, 0, 2, 4);
+        return epa->face_count == 6;
+    }
+
+    vmath_epa_center(epa);
+    vmath_epa_face(epa, 0, 1, 2);
+    vmath_epa_face(epa, 0, 3, 1);
+    vmath_epa_face(epa, 0, 2, 3);
+    vmath_epa_face(epa, 1, 3, 2);
+    return epa->face_count == 4;
+}
+
+/**
+ * Do the faces f and g share an edge
+ */
+__vmath__ bool vmath_epa_adjacent(const vmath_epa_face_t* f, const vmath_epa_face_t* g)
+{
+    int i, j;
+    for (i = 0; i < 3; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            if (f->v[i] == g->v[(j + 1) % 3] && f->v[(i + 1) % 3] == g->v[j]) return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Expand the polytope until its closest face to the origin is on the
+ * boundary of the Minkowski difference
+ *
+ * @return: index of the closest face, -1 when the polytope runs out of
+ *          vertices or faces, or degenerates, before
+ */
+__vmath_batch__ int vmath_epa_expand(vmath_epa_t* epa, const vmath_convex_t* a, const vmath_convex_t* b)
+{
+    int i, best;
+
+    while (epa->face_count > 0)
+    {
+        int                edges[VMATH_EPA_MAX_FACES * 3][2];
+        bool               visible[VMATH_EPA_MAX_FACES];
+        int                edge_count = 0;
+        int                j, k, w;
+        bool               grown;
+        float              tolerance;
+        vmath_gjk_vertex_t p;
+        vec3_t             n;
+
+        for (i = 1, best = 0; i < epa->face_count; i++)
+        {
+            if (epa->faces[i].d < epa->faces[best].d) best = i;
+        }
+
+        n = epa->faces[best].n;
+        p = vmath_gjk_support(a, b, n);
+        tolerance = VMATH_EPA_EPSILON * (1.0f + epa->faces[best].d);
+        if (vec3_dot(p.w, n) - epa->faces[best].d <= tolerance)
+        {
+            return best;
+        }
+
+        /* A support point on a vertex already: the polytope is not convex anymore */
+        if (epa->vertex_count == VMATH_EPA_MAX_VERTICES)
+        {
+            return -1;
+        }
+        for (i = 0; i < epa->vertex_count; i++)
+        {
+            if (vec3_distancesquared(p.w, epa->vertices[i].w) <= tolerance * tolerance) return -1;
+        }
+
+        /* Faces seen from p, grown from the closest face. The faces p is
+           coplanar with, within the tolerance, merge into the new fan:
+           left in place they would leave slivers which pile up on ties */
+        for (i = 0; i < epa->face_count; i++)
+        {
+            visible[i] = i == best;
+        }
+        do
+        {
+            grown = false;
+            for (i = 0; i < epa->face_count; i++)
+            {
+                const vmath_epa_face_t* f = &epa->faces[i];
+                if (visible[i] || vec3_dot(f->n, vec3_sub(p.w, epa->vertices[f->v[0]].w)) <= -tolerance)
+                {
+                    continue;
+                }
+                for (j = 0; j < epa->face_count; j++)
+                {
+                    if (visible[j] && vmath_epa_adjacent(f, &epa->faces[j]))
+                    {
+                        visible[i] = true;
+                        grown      = true;
+                        break;
+                    }
+                }
+            }
+        } while (grown);
+
+        /* Remove them and keep their horizon */
+        for (i = 0; i < epa->face_count; )
+        {
+            const vmath_epa_face_t* f = &epa->faces[i];
+            if (!visible[i])
+            {
+                i++;
+                continue;
+            }
+
+            for (j = 0; j < 3; j++)
+            {
+                const int e0 = f->v[j];
+                const int e1 = f->v[(j + 1) % 3];
+
+                for (k = 0; k < edge_count; k++)
+                {
+                    if (edges[k][0] == e1 && edges[k][1] == e0) break;
+                }
+                if (k < edge_count)
+                {
+                    edges[k][0] = edges[edge_count - 1][0];
+                    edges[k][1] = edges[edge_count - 1][1];
+                    edge_count--;
+                }
+                else
+                {
+                    edges[edge_count][0] = e0;
+                    edges[edge_count][1] = e1;
+                    edge_count++;
+                }
+            }
+
+            epa->face_count--;
+            epa->faces[i] = epa->faces[epa->face_count];
+            visible[i]    = visible[epa->face_count];
+        }
+
+        /* Out of faces or a degenerate face: the polytope has a hole */
+        w = vmath_epa_vertex(epa, p);
+        for (i = 0; i < edge_count; i++)
+        {
+            if (!vmath_epa_face(epa, edges[i][0], edges[i][1], w))
+            {
+                return -1;
+            }
+        }
+    }
+    return -1;
+}
+
+/**
+ * Shallowest penetration along the axes of both shapes and the face normals
+ * of the polytope, when EPA cannot finish. Exact for boxes in face contact,
+ * an upper bound of the depth otherwise: moving b by depth along the normal
+ * always separates the cores.
+ *
+ * @return: core depth
+ */
+__vmath_batch__ float vmath_epa_fallback(const vmath_epa_t* epa, const vmath_convex_t* a, const vmath_convex_t* b,
+                                         vec3_t* normal, vmath_gjk_vertex_t* support)
+{
+    static const float axes[3][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+    float best = FLT_MAX;
+    int   i, count = 12 + epa->face_count;
+
+    for (i = 0; i < count; i++)
+    {
+        vmath_gjk_vertex_t p;
+        vec3_t             n;
+        float              d;
+
+        if (i < 12)
+        {
+            const vmath_convex_t* shape = i < 6 ? a : b;
+            const int             axis  = (i % 6) >> 1;
+            n = vmath_convex_rotate(shape->rotation, vec3(axes[axis][0], axes[axis][1], axes[axis][2]));
+            n = i & 1 ? vec3_neg(n) : n;
+        }
+        else
+        {
+            n = epa->faces[i - 12].n;
+        }
+
+        p = vmath_gjk_support(a, b, n);
+        d = vec3_dot(p.w, n);
+        if (d < best)
+        {
+            best     = d;
+            *normal  = n;
+            *support = p;
+        }
+    }
+    return best;
+}
+
+/**
+ * Penetration between two convex shapes
+ *
+ * @param cache:  warm start cache, may be NULL
+ * @param normal: unit direction to move b out of a, may be NULL
+ * @param depth:  distance to move b along normal, may be NULL
+ * @param pa, pb: deepest points of each shape, may be NULL
+ * @return: true when the shapes overlap
+ */
+__vmath_batch__ bool vmath_epa_penetration(const vmath_convex_t* a, const vmath_convex_t* b, vmath_gjk_cache_t* cache,
+                                           vec3_t* normal, float* depth, vec3_t* pa, vec3_t* pb)
+{
+    vmath_gjk_vertex_t simplex[4];
+    float              lambda[4];
+    int                i, count;
+
+    const float  margin = a->radius + b->radius;
+    const vec3_t v      = vmath_gjk(a, b, cache, simplex, &count, lambda, margin);
+    const float  d      = sqrtf(vec3_lengthsquared(v));
+    vec3_t       ca = vec3(0.0f, 0.0f, 0.0f), cb = vec3(0.0f, 0.0f, 0.0f), n;
+    float        core;
+
+    if (d > margin)
+    {
+        return false;
+    }
+
+    if (d > 0.0f)
+    {
+        /* Only the rounded parts overlap */
+        for (i = 0; i < count; i++)
+        {
+            ca = vec3_add(ca, vec3_mulf(simplex[i].a, lambda[i]));
+            cb = vec3_add(cb, vec3_mulf(simplex[i].b, lambda[i]));
+        }
+        n    = vec3_mulf(v, -1.0f / d);
+        core = -d;
+    }
+    else
+    {
+        vmath_epa_t epa;
+        int         face;
+
+        if (!vmath_epa_init(&epa, a, b, simplex, count))
+        {
+            /* Touching cores */
+            n    = vec3(0.0f, 1.0f, 0.0f);
+            if (vec3_lengthsquared(vec3_sub(b->position, a->position)) > 0.0f)
+            {
+                n = vec3_sub(b->position, a->position);
+                n = vec3_mulf(n, 1.0f / sqrtf(vec3_lengthsquared(n)));
+            }
+            ca   = simplex[0].a;
+            cb   = simplex[0].b;
+            core = 0.0f;
+        }
+        else if ((face = vmath_epa_expand(&epa, a, b)) < 0)
+        {
+            vmath_gjk_vertex_t p;
+            core = vmath_epa_fallback(&epa, a, b, &n, &p);
+            ca   = p.a;
+            cb   = p.b;
+        }
+        else
+        {
+            const vmath_epa_face_t* f = &epa.faces[face];
+            vec3_t                  bary;
+
+            vmath_closest_triangle(vec3_mulf(f->n, f->d), epa.vertices[f->v[0]].w, epa.vertices[f->v[1]].w, epa.vertices[f->v[2]].w, &bary);
+            for (i = 0; i < 3; i++)
+            {
+                ca = vec3_add(ca, vec3_mulf(epa.vertices[f->v[i]].a, bary.m[i]));
+                cb = vec3_add(cb, vec3_mulf(epa.vertices[f->v[i]].b, bary.m[i]));
+            }
+            n    = f->n;
+            core = f->d;
+        }
+    }
+
+    if (normal) *normal = n;
+    if (depth)  *depth  = core + margin;
+    if (pa)     *pa     = vec3_add(ca, vec3_mulf(n, a->radius));
+    if (pb)     *pb     = vec3_sub(cb, vec3_mulf(n, b->radius));
+    return true;
+}
+
+#endif /* __VMATH_GJK_H__ */
@@ -0,0 +1,292 @@
+/******************************************************
+ * vmath_gpu - Streaming writers into GPU buffer layouts
+ *
+ * @author: MaiHD
+ * @license: NULL
+ * @copyright: MaiHD @ ${HOME}, 2017 - 2018
+ ******************************************************/
+
+#ifndef __VMATH_GPU_H__
+#define __VMATH_GPU_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "vmath.h"
+
+/**
+ * Writers convert vmath arrays into the layout of a GPU buffer in one pass.
+ * They are meant for mapped upload buffers, which the CPU write once and
+ * never read back:
+ *  - vmath_gpu_write_vec4:     vec4 array
+ *  - vmath_gpu_write_vec3:     vec3 array, padded to vec4 with a given w
+ *  - vmath_gpu_write_mat4:     mat4 array, column-major
+ *  - vmath_gpu_write_mat3x4:   3 rows of 4 floats, the transposed affine part
+ *                              (VkTransformMatrixKHR, D3D12 raytracing and
+ *                              row-major float3x4 instance data)
+ *  - vmath_gpu_write_normal:   inverse-transpose of the upper 3x3, as mat3
+ *                              (3 columns padded to vec4)
+ *  - vmath_gpu_write_vertices: position and normal packed to 16 bytes
+ *
+ * vec3 and vec4 arrays, mat3 and mat4 have the same layout in std140 and
+ * std430: 16 bytes stride, mat3 columns padded to vec4.
+ *
+ * With SSE and a 16 bytes aligned dst, writes are non-temporal
+ * (_mm_stream_ps). The lines go to memory through the write-combining
+ * buffers, without the read for ownership of a normal store and without
+ * evicting the data of the caller from the cache. Every writer end with a
+ * store fence, so the data is globally visible before the GPU is signaled.
+ * A 64 bytes aligned dst let the writers fill whole lines.
+ */
+
+/**
+ * Use non-temporal stores, set to 0 to compare with normal stores
+ */
+#ifndef VMATH_GPU_STREAM
+#define VMATH_GPU_STREAM 1
+#endif
+
+/**
+ * Vertex with a 10:10:10:2 signed normalized normal
+ * (GL_INT_2_10_10_10_REV, VK_FORMAT_A2B10G10R10_SNORM_PACK32, x in the low bits)
+ */
+typedef struct vmath_gpu_vertex
+{
+    float    x, y, z;
+    uint32_t normal;
+} vmath_gpu_vertex_t;
+
+/**
+ * Can dst be written with non-temporal stores
+ */
+__vmath__ int vmath_gpu_stream(const void* dst)
+{
+#if VMATH_SSE_ENABLE && VMATH_GPU_STREAM
+    return ((uintptr_t)dst & 15) == 0;
+#else
+    (void)dst;
+    return 0;
+#endif
+}
+
+/**
+ * Store 4 floats, non-temporal when stream is set
+ */
+__vmath__ void vmath_gpu_store(float* dst, vec4_t v, int stream)
+{
+#if VMATH_NEON_ENABLE
+    (void)stream;
+    vst1q_f32(dst, v.data);
+#elif VMATH_SSE_ENABLE
+    if (stream)
+    {
+        _mm_stream_ps(dst, v.data);
+    }
+    else
+    {
+        _mm_storeu_ps(dst, v.data);
+    }
+#else
+    (void)stream;
+    memcpy(dst, v.m, sizeof(v.m));
+#endif
+}
+
+/**
+ * Order the non-temporal stores before the stores that follow,
+ * like the write of a fence value or a command buffer submit
+ */
+__vmath__ void vmath_gpu_fence(int stream)
+{
+#if VMATH_SSE_ENABLE
+    if (stream)
+    {
+        _mm_sfence();
+    }
+#else
+    (void)stream;
+#endif
+}
+
+/**
+ * vec4_t from the xyz of v and w
+ */
+__vmath__ vec4_t vmath_gpu_vec4(vec3_t v, float w)
+{
+    vec4_t r;
+#if VMATH_NEON_ENABLE
+    r.data = vsetq_lane_f32(w, v.data, 3);
+#elif VMATH_SSE_ENABLE
+    const __m128 zw = _mm_shuffle_ps(v.data, _mm_set1_ps(w), _MM_SHUFFLE(0, 0, 2, 2));
+    r.data = _mm_shuffle_ps(v.data, zw, _MM_SHUFFLE(2, 0, 1, 0));
+#else
+    r = vec4(v.x, v.y, v.z, w);
+#endif
+    return r;
+}
+
+/**
+ * Pack a normal to 10:10:10:2 signed normalized, components are clamped to [-1, 1]
+ */
+__vmath__ uint32_t vmath_gpu_snorm10(vec3_t n)
+{
+#if VMATH_SSE_ENABLE
+    /* Round to nearest even, the rounding GPUs use for snorm conversions too */
+    const __m128  v = _mm_min_ps(_mm_max_ps(n.data, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+    const __m128i q = _mm_and_si128(_mm_cvtps_epi32(_mm_mul_ps(v, _mm_set1_ps(511.0f))), _mm_set1_epi32(0x3FF));
+    return (uint32_t)_mm_cvtsi128_si32(q)
+         | ((uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(q, 4)) << 10)
+         | ((uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(q, 8)) << 20);
+#else
+    uint32_t r = 0;
+    int i;
+    for (i = 0; i < 3; i++)
+    {
+        const float v = n.m[i] < -1.0f ? -1.0f : (n.m[i] > 1.0f ? 1.0f : n.m[i]);
+        const int   q = (int)(v * 511.0f + (v < 0.0f ? -0.5f : 0.5f));
+        r |= ((uint32_t)q & 0x3FF) << (10 * i);
+    }
+    return r;
+#endif
+}
+
+/**
+ * Write count vec4_t to dst
+ */
+__vmath_batch__ void vmath_gpu_write_vec4(void* dst, const vec4_t* src, int count)
+{
+    float*    out    = (float*)dst;
+    const int stream = vmath_gpu_stream(dst);
+    int i;
+    for (i = 0; i < count; i++, out += 4)
+    {
+        vmath_gpu_store(out, src[i], stream);
+    }
+    vmath_gpu_fence(stream);
+}
+
+/**
+ * Write count vec3_t to dst as vec4 with w
+ */
+__vmath_batch__ void vmath_gpu_write_vec3(void* dst, const vec3_t* src, float w, int count)
+{
+    float*    out    = (float*)dst;
+    const int stream = vmath_gpu_stream(dst);
+    int i;
+    for (i = 0; i < count; i++, out += 4)
+    {
+        vmath_gpu_store(out, vmath_gpu_vec4(src[i], w), stream);
+    }
+    vmath_gpu_fence(stream);
+}
+
+/**
+ * Write count mat4_t to dst, 64 bytes per matrix
+ */
+__vmath_batch__ void vmath_gpu_write_mat4(void* dst, const mat4_t* src, int count)
+{
+    float*    out    = (float*)dst;
+    const int stream = vmath_gpu_stream(dst);
+    int i;
+    for (i = 0; i < count; i++, out += 16)
+    {
+        vmath_gpu_store(out,      src[i].rows[0], stream);
+        vmath_gpu_store(out + 4,  src[i].rows[1], stream);
+        vmath_gpu_store(out + 8,  src[i].rows[2], stream);
+        vmath_gpu_store(out + 12, src[i].rows[3], stream);
+    }
+    vmath_gpu_fence(stream);
+}
+
+/**
+ * Write the affine part of count mat4_t to dst as 3 rows of 4 floats,
+ * 48 bytes per matrix: row r is (m0r, m1r, m2r, m3r), translation in the w column
+ */
+__vmath_batch__ void vmath_gpu_write_mat3x4(void* dst, const mat4_t* src, int count)
+{
+    float*    out    = (float*)dst;
+    const int stream = vmath_gpu_stream(dst);
+    int i;
+    for (i = 0; i < count; i++, out += 12)
+    {
+#if VMATH_SSE_ENABLE
+        __m128 r0 = src[i].rows[0].data;
+        __m128 r1 = src[i].rows[1].data;
+        __m128 r2 = src[i].rows[2].data;
+        __m128 r3 = src[i].rows[3].data;
+        vec4_t t0, t1, t2;
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        t0.data = r0;
+        t1.data = r1;
+        t2.data = r2;
+#else
+        const mat4_t m = src[i];
+        const vec4_t t0 = vec4(m.m00, m.m10, m.m20, m.m30);
+        const vec4_t t1 = vec4(m.m01, m.m11, m.m21, m.m31);
+        const vec4_t t2 = vec4(m.m02, m.m12, m.m22, m.m32);
+#endif
+        vmath_gpu_store(out,     t0, stream);
+        vmath_gpu_store(out + 4, t1, stream);
+        vmath_gpu_store(out + 8, t2, stream);
+    }
+    vmath_gpu_fence(stream);
+}
+
+/**
+ * Write the normal matrices of count mat4_t to dst, 48 bytes per matrix:
+ * inverse-transpose of the upper 3x3 as 3 columns padded with w = 0.
+ * A singular 3x3 write its cofactors, which keep the directions.
+ */
+__vmath_batch__ void vmath_gpu_write_normal(void* dst, const mat4_t* src, int count)
+{
+    float*    out    = (float*)dst;
+    const int stream = vmath_gpu_stream(dst);
+    int i;
+    for (i = 0; i < count; i++, out += 12)
+    {
+        /* With columns a, b, c the inverse-transpose is (b x c, c x a, a x b) / det */
+        const vec3_t a   = src[i].rows[0].xyz;
+        const vec3_t b   = src[i].rows[1].xyz;
+        const vec3_t c   = src[i].rows[2].xyz;
+        const vec3_t bc  = vec3_cross(b, c);
+        const float  det = vec3_dot(a, bc);
+        const float  inv = det != 0.0f ? 1.0f / det : 1.0f;
+
+        vmath_gpu_store(out,     vmath_gpu_vec4(vec3_mulf(bc, inv), 0.0f), stream);
+        vmath_gpu_store(out + 4, vmath_gpu_vec4(vec3_mulf(vec3_cross(c, a), inv), 0.0f), stream);
+        vmath_gpu_store(out + 8, vmath_gpu_vec4(vec3_mulf(vec3_cross(a, b), inv), 0.0f), stream);
+    }
+    vmath_gpu_fence(stream);
+}
+
+/**
+ * Write count vertices to dst as vmath_gpu_vertex_t, normals may be NULL
+ */
+__vmath_batch__ void vmath_gpu_write_vertices(void* dst, const vec3_t* positions, const vec3_t* normals, int count)
+{
+    float*    out    = (float*)dst;
+    const int stream = vmath_gpu_stream(dst);
+    int i;
+    for (i = 0; i < count; i++, out += 4)
+    {
+        const uint32_t normal = normals ? vmath_gpu_snorm10(normals[i]) : 0;
+#if VMATH_SSE_ENABLE
+        /* The packed normal go through integer lanes, a float copy may change NaN bits */
+        vec4_t v;
+        const __m128 zn = _mm_shuffle_ps(positions[i].data, _mm_castsi128_ps(_mm_set1_epi32((int)normal)), _MM_SHUFFLE(0, 0, 2, 2));
+        v.data = _mm_shuffle_ps(positions[i].data, zn, _MM_SHUFFLE(2, 0, 1, 0));
+        vmath_gpu_store(out, v, stream);
+#else
+        vmath_gpu_vertex_t v;
+        v.x      = positions[i].x;
+        v.y      = positions[i].y;
+        v.z      = positions[i].z;
+        v.normal = normal;
+        memcpy(out, &v, sizeof(v));
+#endif
+    }
+    vmath_gpu_fence(stream);
+}
+
+#endif /* __VMATH_GPU_H__ */
@@ -0,0 +1,599 @@
+/******************************************************
+ * vmath_jobs - Parallel-for over a work-stealing thread pool
+ *
+ * @author: MaiHD
+ * @license: NULL
+ * @copyright: MaiHD @ ${HOME}, 2017 - 2018
+ ******************************************************/
+
+#ifndef __VMATH_JOBS_H__
+#define __VMATH_JOBS_H__
+
+#include "vmath.h"
+#include "vmath_color.h"
+#include "vmath_reduce.h"
+
+/**
+ * Usage: define VMATH_IMPL before include this file in one source file.
+ *
+ * A parallel-for split [0, n) into chunks of grain items. Each thread own a
+ * contiguous run of chunks and take them front to back, a thread which run
+ * out of chunks steal from the others, so uneven work still balance.
+ * The calling thread work too, calls from inside a job run serially.
+ */
+
+#ifndef VMATH_JOBS_MAX_THREADS
+#define VMATH_JOBS_MAX_THREADS 64
+#endif
+
+/**
+ * Data per chunk which keep the working set of a chunk in L2
+ */
+#ifndef VMATH_JOBS_CHUNK_BYTES
+#define VMATH_JOBS_CHUNK_BYTES (32 * 1024)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Job function, process items in [begin, end)
+ */
+typedef void (*vmath_job_fn)(void* user, int begin, int end);
+
+/**
+ * Start the pool
+ * @param thread_count: number of threads include the caller, 0 for all cores
+ */
+void vmath_jobs_init(int thread_count);
+
+/**
+ * Stop and join the pool threads
+ */
+void vmath_jobs_shutdown(void);
+
+/**
+ * Number of threads include the caller, 1 when the pool is not started
+ */
+int vmath_jobs_threads(void);
+
+/**
+ * Run fn over [0, n) in chunks of grain items, return when all are done
+ * @param grain: items per chunk, 0 to pick one from the thread count
+ */
+void vmath_parallel_for(int n, int grain, vmath_job_fn fn, void* user);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * Grain which make a chunk of VMATH_JOBS_CHUNK_BYTES
+ */
+__vmath__ int vmath_jobs_grain(int item_bytes)
+{
+    const int grain = VMATH_JOBS_CHUNK_BYTES / (item_bytes > 0 ? item_bytes : 1);
+    return grain > 0 ? grain : 1;
+}
+
+/**
+ * Number of chunks of grain items in count, without overflow near INT_MAX
+ */
+__vmath__ int vmath_jobs_ceildiv(int count, int grain)
+{
+    return count / grain + (count % grain != 0);
+}
+
+/********************
+ * Multi-threaded bulk operations
+ ********************/
+
+typedef struct vmath_jobs_args
+{
+    void*       out;
+    const void* in[3];
+    mat4_t      m;
+    int         op;
+} vmath_jobs_args_t;
+
+static void vmath_jobs_transformpoints(void* user, int begin, int end)
+{
+    const vmath_jobs_args_t* args = (const vmath_jobs_args_t*)user;
+    mat4_transformpoints(&args->m, (vec3_t*)args->out + begin, (const vec3_t*)args->in[0] + begin, end - begin);
+}
+
+static void vmath_jobs_normalizearray(void* user, int begin, int end)
+{
+    const vmath_jobs_args_t* args = (const vmath_jobs_args_t*)user;
+    vec3_normalizearray((vec3_t*)args->out + begin, (const vec3_t*)args->in[0] + begin, end - begin);
+}
+
+static void vmath_jobs_composetrs(void* user, int begin, int end)
+{
+    const vmath_jobs_args_t* args = (const vmath_jobs_args_t*)user;
+    mat4_composetrs((mat4_t*)args->out + begin,
+                    (const vec3_t*)args->in[0] + begin,
+                    (const quat_t*)args->in[1] + begin,
+                    (const vec3_t*)args->in[2] + begin,
+                    end - begin);
+}
+
+static void vmath_jobs_colorconvert(void* user, int begin, int end)
+{
+    const vmath_jobs_args_t* args = (const vmath_jobs_args_t*)user;
+    color_convert((vec4_t*)args->out + begin, (const vec4_t*)args->in[0] + begin, end - begin, args->op);
+}
+
+static void vmath_jobs_colorblend(void* user, int begin, int end)
+{
+    const vmath_jobs_args_t* args = (const vmath_jobs_args_t*)user;
+    color_blend((vec4_t*)args->out + begin, (const vec4_t*)args->in[0] + begin, end - begin, args->op);
+}
+
+/**
+ * Transform points by a matrix, multi-threaded
+ */
+__vmath__ void mat4_transformpoints_mt(const mat4_t* m, vec3_t* out, const vec3_t* in, int count)
+{
+    vmath_jobs_args_t args;
+    args.out   = out;
+    args.in[0] = in;
+    args.m     = *m;
+    vmath_parallel_for(count, vmath_jobs_grain(2 * sizeof(vec3_t)), vmath_jobs_transformpoints, &args);
+}
+
+/**
+ * Normalize vectors, multi-threaded
+ */
+__vmath__ void vec3_normalizearray_mt(vec3_t* out, const vec3_t* in, int count)
+{
+    vmath_jobs_args_t args;
+    args.out   = out;
+    args.in[0] = in;
+    vmath_parallel_for(count, vmath_jobs_grain(2 * sizeof(vec3_t)), vmath_jobs_normalizearray, &args);
+}
+
+/**
+ * Compose translation, rotation, scale to matrices, multi-threaded
+ */
+__vmath__ void mat4_composetrs_mt(mat4_t* out, const vec3_t* t, const quat_t* r, const vec3_t* s, int count)
+{
+    vmath_jobs_args_t args;
+    args.out   = out;
+    args.in[0] = t;
+    args.in[1] = r;
+    args.in[2] = s;
+    vmath_parallel_for(count, vmath_jobs_grain(sizeof(mat4_t) + 2 * sizeof(vec3_t) + sizeof(quat_t)),
+                       vmath_jobs_composetrs, &args);
+}
+
+/**
+ * Apply a color operation to float4 pixels, multi-threaded, out can be in
+ */
+__vmath__ void color_convert_mt(vec4_t* out, const vec4_t* in, int count, int op)
+{
+    vmath_jobs_args_t args;
+    args.out   = out;
+    args.in[0] = in;
+    args.op    = op;
+    vmath_parallel_for(count, vmath_jobs_grain(2 * sizeof(vec4_t)), vmath_jobs_colorconvert, &args);
+}
+
+/**
+ * Blend premultiplied float4 pixels: dst = src op dst, multi-threaded
+ */
+__vmath__ void color_blend_mt(vec4_t* dst, const vec4_t* src, int count, int op)
+{
+    vmath_jobs_args_t args;
+    args.out   = dst;
+    args.in[0] = src;
+    args.op    = op;
+    vmath_parallel_for(count, vmath_jobs_grain(2 * sizeof(vec4_t)), vmath_jobs_colorblend, &args);
+}
+
+/**
+ * Partial bounds of chunks, merged by the caller
+ */
+typedef struct vmath_jobs_bounds
+{
+    const vec3_t* points;
+    int           count;
+    int           grain;
+    vec3_t*       mins;
+    vec3_t*       maxs;
+} vmath_jobs_bounds_t;
+
+static void vmath_jobs_boundschunk(void* user, int begin, int end)
+{
+    const vmath_jobs_bounds_t* args = (const vmath_jobs_bounds_t*)user;
+    int c;
+    for (c = begin; c < end; c++)
+    {
+        const size_t first = (size_t)c * (size_t)args->grain;
+        const int    count = args->count - (int)first < args->grain ? args->count - (int)first : args->grain;
+        vec3_bounds(args->points + first, count, &args->mins[c], &args->maxs[c]);
+    }
+}
+
+/**
+ * Bounds of points, multi-threaded
+ * @note: count must be > 0
+ */
+__vmath__ void vec3_bounds_mt(const vec3_t* points, int count, vec3_t* min, vec3_t* max)
+{
+    enum { CHUNKS = 4 * VMATH_JOBS_MAX_THREADS };
+
+    vec3_t mins[CHUNKS], maxs[CHUNKS];
+    vmath_jobs_bounds_t args;
+    int chunks, c;
+
+    /* One partial per chunk, the grain is rounded up so there are at most CHUNKS */
+    args.grain  = vmath_jobs_grain(sizeof(vec3_t));
+    args.grain  = vmath_jobs_ceildiv(count, CHUNKS) > args.grain ? vmath_jobs_ceildiv(count, CHUNKS) : args.grain;
+    args.points = points;
+    args.count  = count;
+    args.mins   = mins;
+    args.maxs   = maxs;
+    chunks      = vmath_jobs_ceildiv(count, args.grain);
+
+    vmath_parallel_for(chunks, 1, vmath_jobs_boundschunk, &args);
+
+    *min = mins[0];
+    *max = maxs[0];
+    for (c = 1; c < chunks; c++)
+    {
+        *min = vec3_min(*min, mins[c]);
+        *max = vec3_max(*max, maxs[c]);
+    }
+}
+
+typedef struct vmath_jobs_reduce
+{
+    const vec3_t*        points;
+    int                  count;
+    int                  grain;
+    int                  flags;
+    vmath_reduce_sums_t* sums;
+    vec3_t*              centers;
+    float*               radii;
+} vmath_jobs_reduce_t;
+
+static void vmath_jobs_reducechunk(void* user, int begin, int end)
+{
+    const vmath_jobs_reduce_t* args = (const vmath_jobs_reduce_t*)user;
+    int c;
+    for (c = begin; c < end; c++)
+    {
+        const int first = c * args->grain;
+        const int count = args->count - first < args->grain ? args->count - first : args->grain;
+        vmath_reduce_add(&args->sums[c], args->points + first, count, args->flags);
+    }
+}
+
+static void vmath_jobs_spherechunk(void* user, int begin, int end)
+{
+    const vmath_jobs_reduce_t* args = (const vmath_jobs_reduce_t*)user;
+    int c;
+    for (c = begin; c < end; c++)
+    {
+        const int first = c * args->grain;
+        const int count = args->count - first < args->grain ? args->count - first : args->grain;
+        vmath_reduce_sphere(args->points + first, count, &args->centers[c], &args->radii[c]);
+    }
+}
+
+/**
+ * Reduce points, multi-threaded: partial sums per chunk are merged, then
+ * each chunk grow its own copy of the first sphere and the copies are merged
+ * @note: count must be > 0
+ */
+__vmath__ void vmath_reduce_mt(const vec3_t* points, int count, int flags, vmath_reduce_t* out)
+{
+    enum { CHUNKS = 2 * VMATH_JOBS_MAX_THREADS };
+
+    vmath_reduce_sums_t sums[CHUNKS];
+    vec3_t              centers[CHUNKS];
+    float               radii[CHUNKS];
+    vmath_jobs_reduce_t args;
+    int chunks, c;
+
+    args.grain   = vmath_jobs_grain(sizeof(vec3_t));
+    args.grain   = vmath_jobs_ceildiv(count, CHUNKS) > args.grain ? vmath_jobs_ceildiv(count, CHUNKS) : args.grain;
+    args.points  = points;
+    args.count   = count;
+    args.flags   = flags;
+    args.sums    = sums;
+    args.centers = centers;
+    args.radii   = radii;
+    chunks       = vmath_jobs_ceildiv(count, args.grain);
+
+    for (c = 0; c < chunks; c++)
+    {
+        vmath_reduce_begin(&sums[c], points[0]);
+    }
+    vmath_parallel_for(chunks, 1, vmath_jobs_reducechunk, &args);
+    for (c = 1; c < chunks; c++)
+    {
+        vmath_reduce_merge(&sums[0], &sums[c]);
+    }
+    vmath_reduce_end(&sums[0], flags, out);
+
+    if (flags & VMATH_REDUCE_SPHERE)
+    {
+        for (c = 0; c < chunks; c++)
+        {
+            centers[c] = out->center;
+            radii[c]   = out->radius;
+        }
+        vmath_parallel_for(chunks, 1, vmath_jobs_spherechunk, &args);
+        for (c = 0; c < chunks; c++)
+        {
+            vmath_reduce_mergesphere(&out->center, &out->radius, centers[c], radii[c]);
+        }
+    }
+}
+
+#endif /* __VMATH_JOBS_H__ */
+
+/********************
+ * Implementation
+ ********************/
+
+#if defined(VMATH_IMPL) && !defined(__VMATH_JOBS_IMPL__)
+#define __VMATH_JOBS_IMPL__
+
+#if defined(_WIN32)
+#  ifndef WIN32_LEAN_AND_MEAN
+#  define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <Windows.h>
+typedef HANDLE                  vmath_thread_t;
+typedef CRITICAL_SECTION        vmath_mutex_t;
+typedef CONDITION_VARIABLE      vmath_cond_t;
+#  define vmath_atomic_add(p, v) InterlockedExchangeAdd((volatile LONG*)(p), (LONG)(v))
+#  define vmath_thread_yield()  SwitchToThread()
+#else
+#  include <pthread.h>
+#  include <sched.h>
+#  include <unistd.h>
+typedef pthread_t               vmath_thread_t;
+typedef pthread_mutex_t         vmath_mutex_t;
+typedef pthread_cond_t          vmath_cond_t;
+#  define vmath_atomic_add(p, v) __sync_fetch_and_add((p), (v))
+#  define vmath_thread_yield()  sched_yield()
+#endif
+
+/**
+ * Chunks own by a thread, padded to a cache line against false sharing
+ */
+typedef struct vmath_jobs_range
+{
+    volatile long next;
+    long          end;
+    char          pad[64 - 2 * sizeof(long)];
+} vmath_jobs_range_t;
+
+static struct
+{
+    int                 thread_count;
+    vmath_thread_t      threads[VMATH_JOBS_MAX_THREADS];
+    vmath_mutex_t       mutex;
+    vmath_cond_t        wake;
+
+    /* Current job */
+    vmath_job_fn        fn;
+    void*               user;
+    int                 n;
+    int                 grain;
+    volatile long       generation;
+    volatile long       active;
+    volatile long       busy;
+    int                 quit;
+    vmath_jobs_range_t  ranges[VMATH_JOBS_MAX_THREADS];
+} vmath_jobs;
+
+/**
+ * Take chunks of the own range, then steal from the others
+ */
+static void vmath_jobs_run(int index)
+{
+    const int count = vmath_jobs.thread_count;
+    int i;
+    for (i = 0; i < count; i++)
+    {
+        vmath_jobs_range_t* range = &vmath_jobs.ranges[(index + i) % count];
+        for (;;)
+        {
+            const long chunk = vmath_atomic_add(&range->next, 1);
+            if (chunk >= range->end)
+            {
+                break;
+            }
+
+            {
+                const int begin = (int)chunk * vmath_jobs.grain;
+                const int end   = vmath_jobs.n - begin < vmath_jobs.grain ? vmath_jobs.n : begin + vmath_jobs.grain;
+                vmath_jobs.fn(vmath_jobs.user, begin, end);
+            }
+        }
+    }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI vmath_jobs_worker(LPVOID arg)
+#else
+static void* vmath_jobs_worker(void* arg)
+#endif
+{
+    const int index = (int)(size_t)arg;
+    long      seen  = 0;
+    for (;;)
+    {
+#if defined(_WIN32)
+        EnterCriticalSection(&vmath_jobs.mutex);
+        while (vmath_jobs.generation == seen && !vmath_jobs.quit)
+        {
+            SleepConditionVariableCS(&vmath_jobs.wake, &vmath_jobs.mutex, INFINITE);
+        }
+        LeaveCriticalSection(&vmath_jobs.mutex);
+#else
+        pthread_mutex_lock(&vmath_jobs.mutex);
+        while (vmath_jobs.generation == seen && !vmath_jobs.quit)
+        {
+            pthread_cond_wait(&vmath_jobs.wake, &vmath_jobs.mutex);
+        }
+        pthread_mutex_unlock(&vmath_jobs.mutex);
+#endif
+
+        if (vmath_jobs.quit)
+        {
+            break;
+        }
+
+        seen = vmath_jobs.generation;
+        vmath_jobs_run(index);
+        vmath_atomic_add(&vmath_jobs.active, -1);
+    }
+    return 0;
+}
+
+void vmath_jobs_init(int thread_count)
+{
+    int i;
+    if (vmath_jobs.thread_count > 0)
+    {
+        return;
+    }
+
+    if (thread_count <= 0)
+    {
+#if defined(_WIN32)
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        thread_count = (int)info.dwNumberOfProcessors;
+#else
+        thread_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    }
+    thread_count = thread_count < 1 ? 1 : thread_count;
+    thread_count = thread_count > VMATH_JOBS_MAX_THREADS ? VMATH_JOBS_MAX_THREADS : thread_count;
+
+    vmath_jobs.thread_count = thread_count;
+    vmath_jobs.generation   = 0;
+    vmath_jobs.quit         = 0;
+#if defined(_WIN32)
+    InitializeCriticalSection(&vmath_jobs.mutex);
+    InitializeConditionVariable(&vmath_jobs.wake);
+    for (i = 1; i < thread_count; i++)
+    {
+        vmath_jobs.threads[i] = CreateThread(NULL, 0, vmath_jobs_worker, (LPVOID)(size_t)i, 0, NULL);
+    }
+#else
+    pthread_mutex_init(&vmath_jobs.mutex, NULL);
+    pthread_cond_init(&vmath_jobs.wake, NULL);
+    for (i = 1; i < thread_count; i++)
+    {
+        pthread_create(&vmath_jobs.threads[i], NULL, vmath_jobs_worker, (void*)(size_t)i);
+    }
+#endif
+}
+
+void vmath_jobs_shutdown(void)
+{
+    int i;
+    if (vmath_jobs.thread_count == 0)
+    {
+        return;
+    }
+
+#if defined(_WIN32)
+    EnterCriticalSection(&vmath_jobs.mutex);
+    vmath_jobs.quit = 1;
+    WakeAllConditionVariable(&vmath_jobs.wake);
+    LeaveCriticalSection(&vmath_jobs.mutex);
+    for (i = 1; i < vmath_jobs.thread_count; i++)
+    {
+        WaitForSingleObject(vmath_jobs.threads[i], INFINITE);
+        CloseHandle(vmath_jobs.threads[i]);
+    }
+    DeleteCriticalSection(&vmath_jobs.mutex);
+#else
+    pthread_mutex_lock(&vmath_jobs.mutex);
+    vmath_jobs.quit = 1;
+    pthread_cond_broadcast(&vmath_jobs.wake);
+    pthread_mutex_unlock(&vmath_jobs.mutex);
+    for (i = 1; i < vmath_jobs.thread_count; i++)
+    {
+        pthread_join(vmath_jobs.threads[i], NULL);
+    }
+    pthread_cond_destroy(&vmath_jobs.wake);
+    pthread_mutex_destroy(&vmath_jobs.mutex);
+#endif
+
+    vmath_jobs.thread_count = 0;
+}
+
+int vmath_jobs_threads(void)
+{
+    return vmath_jobs.thread_count > 0 ? vmath_jobs.thread_count : 1;
+}
+
+void vmath_parallel_for(int n, int grain, vmath_job_fn fn, void* user)
+{
+    const int threads = vmath_jobs.thread_count;
+    int       chunks, i;
+
+    if (n <= 0)
+    {
+        return;
+    }
+
+    /* Default: 8 chunks per thread, enough to balance by stealing */
+    grain  = grain > 0 ? grain : vmath_jobs_ceildiv(n, 8 * vmath_jobs_threads());
+    chunks = vmath_jobs_ceildiv(n, grain);
+
+    /* Serial when there is no pool, one chunk, or a job is running (nested) */
+    if (threads <= 1 || chunks <= 1 || vmath_atomic_add(&vmath_jobs.busy, 1) != 0)
+    {
+        if (threads > 1 && chunks > 1)
+        {
+            vmath_atomic_add(&vmath_jobs.busy, -1);
+        }
+        fn(user, 0, n);
+        return;
+    }
+
+    vmath_jobs.fn    = fn;
+    vmath_jobs.user  = user;
+    vmath_jobs.n     = n;
+    vmath_jobs.grain = grain;
+    for (i = 0; i < threads; i++)
+    {
+        vmath_jobs.ranges[i].next = (long)chunks * i / threads;
+        vmath_jobs.ranges[i].end  = (long)chunks * (i + 1) / threads;
+    }
+    vmath_jobs.active = threads - 1;
+
+#if defined(_WIN32)
+    EnterCriticalSection(&vmath_jobs.mutex);
+    vmath_jobs.generation++;
+    WakeAllConditionVariable(&vmath_jobs.wake);
+    LeaveCriticalSection(&vmath_jobs.mutex);
+#else
+    pthread_mutex_lock(&vmath_jobs.mutex);
+    vmath_jobs.generation++;
+    pthread_cond_broadcast(&vmath_jobs.wake);
+    pthread_mutex_unlock(&vmath_jobs.mutex);
+#endif
+
+    vmath_jobs_run(0);
+    while (vmath_atomic_add(&vmath_jobs.active, 0) != 0)
+    {
+        vmath_thread_yield();
+    }
+
+    vmath_atomic_add(&vmath_jobs.busy, -1);
+}
+
+#endif /* VMATH_IMPL */
@@ -0,0 +1,495 @@
+/******************************************************
+ * vmath_memory - Aligned arrays, arenas and pools
+ *
+ * @author: MaiHD
+ * @license: NULL
+ * @copyright: MaiHD @ ${HOME}, 2017 - 2018
+ ******************************************************/
+
+#ifndef __VMATH_MEMORY_H__
+#define __VMATH_MEMORY_H__
+
+#include <stddef.h>
+#include <string.h>
+
+#include "vmath.h"
+
+/**
+ * Usage: define VMATH_IMPL before include this file in one source file.
+ *
+ * vec4_t, mat4_t... hold __m128 and are loaded with aligned loads, but
+ * malloc only promise 8 bytes on some platforms. Every allocator here
+ * return memory aligned to VMATH_MEMORY_ALIGN at least:
+ *  - vec3_array_t, mat4_array_t: growable arrays
+ *  - vmath_arena_t:              linear allocator, reset once per frame
+ *  - vmath_pool_t:               fixed-size blocks, O(1) alloc and release
+ *  - vmath_scratch_*:            thread-local arena for temporary buffers
+ */
+
+#ifndef VMATH_MEMORY_ALIGN
+#define VMATH_MEMORY_ALIGN 16
+#endif
+
+/**
+ * Size of the scratch arena of each thread
+ */
+#ifndef VMATH_SCRATCH_BYTES
+#define VMATH_SCRATCH_BYTES (1024 * 1024)
+#endif
+
+/**
+ * Count heap allocations, see vmath_memory_stats()
+ */
+#ifndef VMATH_MEMORY_STATS
+#define VMATH_MEMORY_STATS 1
+#endif
+
+#if defined(_MSC_VER)
+#define VMATH_THREAD_LOCAL __declspec(thread)
+#else
+#define VMATH_THREAD_LOCAL __thread
+#endif
+
+/**
+ * Heap counters
+ */
+typedef struct vmath_memory_stats
+{
+    long allocs;        /* Number of vmath_aligned_alloc */
+    long frees;         /* Number of vmath_aligned_free  */
+    long bytes;         /* Bytes in use                  */
+    long peak;          /* Highest bytes in use          */
+} vmath_memory_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Allocate size bytes aligned to align (power of two), NULL on failure
+ */
+void* vmath_aligned_alloc(size_t size, size_t align);
+
+/**
+ * Free memory from vmath_aligned_alloc, NULL is ignored
+ */
+void vmath_aligned_free(void* ptr);
+
+/**
+ * Current heap counters
+ */
+vmath_memory_stats_t vmath_memory_stats(void);
+
+/**
+ * Allocate from the scratch arena of the calling thread, NULL when full
+ * @note: wrap allocations with vmath_scratch_begin/end
+ */
+void* vmath_scratch_alloc(size_t size);
+
+/**
+ * Mark the scratch arena of the calling thread
+ */
+size_t vmath_scratch_begin(void);
+
+/**
+ * Release every scratch allocation since the mark
+ */
+void vmath_scratch_end(size_t mark);
+
+/**
+ * Free the scratch arena of the calling thread, call before the thread exit
+ */
+void vmath_scratch_release(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/********************
+ * Arrays
+ ********************/
+
+/**
+ * Grow capacity of an array to hold count items at least
+ */
+__vmath_batch__ int vmath_array_reserve(void** data, int* capacity, int count, size_t item_size)
+{
+    if (count > *capacity)
+    {
+        int   grow = *capacity + *capacity / 2;
+        void* data_new;
+
+        grow     = grow > count ? grow : count;
+        grow     = grow > 16 ? grow : 16;
+        data_new = vmath_aligned_alloc((size_t)grow * item_size, VMATH_MEMORY_ALIGN);
+        if (!data_new)
+        {
+            return 0;
+        }
+
+        if (*data)
+        {
+            memcpy(data_new, *data, (size_t)*capacity * item_size);
+            vmath_aligned_free(*data);
+        }
+        *data     = data_new;
+        *capacity = grow;
+    }
+    return 1;
+}
+
+/**
+ * Growable array of vec3_t
+ */
+typedef struct vmath_vec3_array
+{
+    vec3_t* data;
+    int     count;
+    int     capacity;
+} vec3_array_t;
+
+/**
+ * Growable array of mat4_t
+ */
+typedef struct vmath_mat4_array
+{
+    mat4_t* data;
+    int     count;
+    int     capacity;
+} mat4_array_t;
+
+__vmath__ vec3_array_t vec3_array(void)
+{
+    vec3_array_t array = { 0, 0, 0 };
+    return array;
+}
+
+__vmath__ void vec3_array_free(vec3_array_t* array)
+{
+    vmath_aligned_free(array->data);
+    array->data     = 0;
+    array->count    = 0;
+    array->capacity = 0;
+}
+
+__vmath__ int vec3_array_reserve(vec3_array_t* array, int capacity)
+{
+    return vmath_array_reserve((void**)&array->data, &array->capacity, capacity, sizeof(vec3_t));
+}
+
+/**
+ * Resize the array, new items are not initialized
+ */
+__vmath__ int vec3_array_resize(vec3_array_t* array, int count)
+{
+    if (!vec3_array_reserve(array, count))
+    {
+        return 0;
+    }
+    array->count = count;
+    return 1;
+}
+
+__vmath__ int vec3_array_push(vec3_array_t* array, vec3_t v)
+{
+    if (!vec3_array_reserve(array, array->count + 1))
+    {
+        return 0;
+    }
+    array->data[array->count++] = v;
+    return 1;
+}
+
+__vmath__ void vec3_array_clear(vec3_array_t* array)
+{
+    array->count = 0;
+}
+
+__vmath__ mat4_array_t mat4_array(void)
+{
+    mat4_array_t array = { 0, 0, 0 };
+    return array;
+}
+
+__vmath__ void mat4_array_free(mat4_array_t* array)
+{
+    vmath_aligned_free(array->data);
+    array->data     = 0;
+    array->count    = 0;
+    array->capacity = 0;
+}
+
+__vmath__ int mat4_array_reserve(mat4_array_t* array, int capacity)
+{
+    return vmath_array_reserve((void**)&array->data, &array->capacity, capacity, sizeof(mat4_t));
+}
+
+/**
+ * Resize the array, new items are not initialized
+ */
+__vmath__ int mat4_array_resize(mat4_array_t* array, int count)
+{
+    if (!mat4_array_reserve(array, count))
+    {
+        return 0;
+    }
+    array->count = count;
+    return 1;
+}
+
+__vmath__ int mat4_array_push(mat4_array_t* array, mat4_t m)
+{
+    if (!mat4_array_reserve(array, array->count + 1))
+    {
+        return 0;
+    }
+    array->data[array->count++] = m;
+    return 1;
+}
+
+__vmath__ void mat4_array_clear(mat4_array_t* array)
+{
+    array->count = 0;
+}
+
+/********************
+ * Arena
+ ********************/
+
+/**
+ * Linear allocator over one buffer, free everything at once with reset
+ */
+typedef struct vmath_arena
+{
+    unsigned char* base;
+    size_t         size;
+    size_t         used;
+    size_t         peak;    /* Highest used since init */
+    long           allocs;  /* Allocations since init  */
+} vmath_arena_t;
+
+/**
+ * Create an arena of size bytes, return 0 on failure
+ */
+__vmath__ int vmath_arena_init(vmath_arena_t* arena, size_t size)
+{
+    arena->base   = (unsigned char*)vmath_aligned_alloc(size, VMATH_MEMORY_ALIGN);
+    arena->size   = arena->base ? size : 0;
+    arena->used   = 0;
+    arena->peak   = 0;
+    arena->allocs = 0;
+    return arena->base != 0;
+}
+
+__vmath__ void vmath_arena_free(vmath_arena_t* arena)
+{
+    vmath_aligned_free(arena->base);
+    arena->base = 0;
+    arena->size = 0;
+    arena->used = 0;
+}
+
+/**
+ * Allocate size bytes aligned to align (power of two), NULL when full
+ */
+__vmath__ void* vmath_arena_alloc(vmath_arena_t* arena, size_t size, size_t align)
+{
+    const size_t start  = (size_t)(arena->base + arena->used);
+    const size_t offset = ((start + (align - 1)) & ~(align - 1)) - (size_t)arena->base;
+    if (offset + size > arena->size)
+    {
+        return 0;
+    }
+
+    arena->used = offset + size;
+    arena->peak = arena->used > arena->peak ? arena->used : arena->peak;
+    arena->allocs++;
+    return arena->base + offset;
+}
+
+/**
+ * Release every allocation, call at the start of a frame
+ */
+__vmath__ void vmath_arena_reset(vmath_arena_t* arena)
+{
+    arena->used = 0;
+}
+
+/**
+ * Release allocations made after the mark, mark is a value of arena->used
+ */
+__vmath__ void vmath_arena_rewind(vmath_arena_t* arena, size_t mark)
+{
+    arena->used = mark < arena->used ? mark : arena->used;
+}
+
+/********************
+ * Pool
+ ********************/
+
+/**
+ * Fixed-size blocks with a free list threaded through the free blocks
+ */
+typedef struct vmath_pool
+{
+    unsigned char* base;
+    size_t         block_size;
+    int            capacity;
+    int            used;
+    void*          free_list;
+} vmath_pool_t;
+
+/**
+ * Create a pool of capacity blocks, return 0 on failure
+ * @note: blocks are VMATH_MEMORY_ALIGN aligned, block_size is rounded up
+ */
+__vmath_batch__ int vmath_pool_init(vmath_pool_t* pool, size_t block_size, int capacity)
+{
+    int i;
+
+    block_size       = block_size > sizeof(void*) ? block_size : sizeof(void*);
+    block_size       = (block_size + (VMATH_MEMORY_ALIGN - 1)) & ~(size_t)(VMATH_MEMORY_ALIGN - 1);
+    pool->base       = (unsigned char*)vmath_aligned_alloc(block_size * capacity, VMATH_MEMORY_ALIGN);
+    pool->block_size = block_size;
+    pool->capacity   = pool->base ? capacity : 0;
+    pool->used       = 0;
+    pool->free_list  = 0;
+
+    /* Link blocks front to back */
+    for (i = pool->capacity - 1; i >= 0; i--)
+    {
+        void* block = pool->base + (size_t)i * block_size;
+        *(void**)block  = pool->free_list;
+        pool->free_list = block;
+    }
+    return pool->base != 0;
+}
+
+__vmath__ void vmath_pool_free(vmath_pool_t* pool)
+{
+    vmath_aligned_free(pool->base);
+    pool->base      = 0;
+    pool->capacity  = 0;
+    pool->used      = 0;
+    pool->free_list = 0;
+}
+
+/**
+ * Take a block, NULL when the pool is empty
+ */
+__vmath__ void* vmath_pool_alloc(vmath_pool_t* pool)
+{
+    void* block = pool->free_list;
+    if (block)
+    {
+        pool->free_list = *(void**)block;
+        pool->used++;
+    }
+    return block;
+}
+
+/**
+ * Give a block back to the pool
+ */
+__vmath__ void vmath_pool_release(vmath_pool_t* pool, void* block)
+{
+    if (block)
+    {
+        *(void**)block  = pool->free_list;
+        pool->free_list = block;
+        pool->used--;
+    }
+}
+
+#endif /* __VMATH_MEMORY_H__ */
+
+/********************
+ * Implementation
+ ********************/
+
+#if defined(VMATH_IMPL) && !defined(__VMATH_MEMORY_IMPL__)
+#define __VMATH_MEMORY_IMPL__
+
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#  define vmath_memory_atomic_add(p, v) _InterlockedExchangeAdd((volatile long*)(p), (long)(v))
+#  include <intrin.h>
+#else
+#  define vmath_memory_atomic_add(p, v) __sync_fetch_and_add((p), (v))
+#endif
+
+static vmath_memory_stats_t vmath_memory_counters;
+
+static VMATH_THREAD_LOCAL vmath_arena_t vmath_scratch;
+
+void* vmath_aligned_alloc(size_t size, size_t align)
+{
+    /* Over-allocate, keep the raw pointer and the size in front of the block */
+    const size_t   header = align > 2 * sizeof(size_t) ? align : 2 * sizeof(size_t);
+    unsigned char* raw    = (unsigned char*)malloc(size + header + align);
+    unsigned char* ptr;
+    if (!raw)
+    {
+        return 0;
+    }
+
+    ptr = (unsigned char*)(((size_t)raw + header + (align - 1)) & ~(align - 1));
+    ((size_t*)ptr)[-1] = (size_t)(ptr - raw);
+    ((size_t*)ptr)[-2] = size;
+
+#if VMATH_MEMORY_STATS
+    {
+        const long bytes = vmath_memory_atomic_add(&vmath_memory_counters.bytes, (long)size) + (long)size;
+        vmath_memory_atomic_add(&vmath_memory_counters.allocs, 1);
+        if (bytes > vmath_memory_counters.peak)
+        {
+            vmath_memory_counters.peak = bytes; /* Racy but only a watermark */
+        }
+    }
+#endif
+    return ptr;
+}
+
+void vmath_aligned_free(void* ptr)
+{
+    if (ptr)
+    {
+#if VMATH_MEMORY_STATS
+        vmath_memory_atomic_add(&vmath_memory_counters.bytes, -(long)((size_t*)ptr)[-2]);
+        vmath_memory_atomic_add(&vmath_memory_counters.frees, 1);
+#endif
+        free((unsigned char*)ptr - ((size_t*)ptr)[-1]);
+    }
+}
+
+vmath_memory_stats_t vmath_memory_stats(void)
+{
+    return vmath_memory_counters;
+}
+
+void* vmath_scratch_alloc(size_t size)
+{
+    if (!vmath_scratch.base && !vmath_arena_init(&vmath_scratch, VMATH_SCRATCH_BYTES))
+    {
+        return 0;
+    }
+    return vmath_arena_alloc(&vmath_scratch, size, VMATH_MEMORY_ALIGN);
+}
+
+size_t vmath_scratch_begin(void)
+{
+    return vmath_scratch.used;
+}
+
+void vmath_scratch_end(size_t mark)
+{
+    vmath_arena_rewind(&vmath_scratch, mark);
+}
+
+void vmath_scratch_release(void)
+{
+    vmath_arena_free(&vmath_scratch);
+}
+
+#endif /* VMATH_IMPL */
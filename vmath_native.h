@@ -0,0 +1,357 @@
+/******************************************************
+ * vmath_native - C ABI of batch kernels for libvmath
+ *
+ * @author: MaiHD
+ * @license: NULL
+ * @copyright: MaiHD @ ${HOME}, 2017 - 2018
+ ******************************************************/
+
+#ifndef __VMATH_NATIVE_H__
+#define __VMATH_NATIVE_H__
+
+#include "vmath_soa.h"
+
+/**
+ * Usage: define VMATH_IMPL before include this file in one source file,
+ * or build the shared library: make -C test libvmath
+ *
+ * The functions are not inline and take plain float arrays, so they can be
+ * called from other languages (csharp/vmath_native.cs, fsharp/vmath_native.fs)
+ * without knowing the SIMD layout of vmath.h types.
+ *
+ * Layout contract, every array is packed floats without padding:
+ *     point  : 3 floats x y z           (not vec3_t, which is 16 bytes with SIMD)
+ *     vector : 4 floats x y z w
+ *     quat   : 4 floats x y z w
+ *     sphere : 4 floats x y z radius
+ *     plane  : 4 floats nx ny nz d, dot(n, p) + d >= 0 is inside
+ *     matrix : 16 floats in mat4_t data order
+ *     dquat  : 8 floats, real x y z w then dual x y z w
+ *
+ * Alignment contract: pointers need float alignment (4 bytes) only.
+ * An output array may be the same array as the matching input,
+ * but must not partially overlap it. count <= 0 does nothing.
+ */
+
+/**
+ * Version of the layout and signatures, bump on every breaking change
+ */
+#define VMATH_NATIVE_ABI_VERSION 1
+
+/**
+ * Vertices per chunk of skinning, converted to vec3_t on the stack
+ */
+#ifndef VMATH_NATIVE_SKIN_CHUNK
+#define VMATH_NATIVE_SKIN_CHUNK 64
+#endif
+
+/**
+ * Bones of a palette which can be realigned on the stack, bigger palettes
+ * which are not 16 bytes aligned are copied to the heap
+ */
+#ifndef VMATH_NATIVE_STACK_BONES
+#define VMATH_NATIVE_STACK_BONES 256
+#endif
+
+#ifndef VMATH_NATIVE_API
+#  if defined(_WIN32)
+#    define VMATH_NATIVE_API __declspec(dllexport)
+#  elif defined(__GNUC__)
+#    define VMATH_NATIVE_API __attribute__((visibility("default")))
+#  else
+#    define VMATH_NATIVE_API
+#  endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * VMATH_NATIVE_ABI_VERSION of the library, check it before any other call
+ */
+VMATH_NATIVE_API int vmath_native_abi_version(void);
+
+/**
+ * out[i] = (m * vec4(points[i], 1)).xyz, affine: no perspective divide
+ */
+VMATH_NATIVE_API void vmath_native_transform_points(const float* m, const float* points, float* out, int count);
+
+/**
+ * out[i] = m * vectors[i]
+ */
+VMATH_NATIVE_API void vmath_native_transform_vectors(const float* m, const float* vectors, float* out, int count);
+
+/**
+ * out[i] = translate(t[i]) * rotate(r[i]) * scale(s[i]), same as mat4_composetrs
+ */
+VMATH_NATIVE_API void vmath_native_compose_trs(float* out, const float* t, const float* r, const float* s, int count);
+
+/**
+ * Dual quaternion skinning, same as dquat_skin
+ * @param out_normals: can be NULL, then normals are ignored
+ * @param bones:       4 indices per vertex, less than bone_count
+ * @param weights:     4 weights per vertex
+ * @param palette:     bone_count dquats
+ */
+VMATH_NATIVE_API void vmath_native_skin(float* out_positions, float* out_normals,
+                                        const float* positions, const float* normals,
+                                        const int* bones, const float* weights, int count,
+                                        const float* palette, int bone_count);
+
+/**
+ * Normalized planes of a view-projection matrix: left, right, bottom, top, near, far
+ * @param planes:            6 planes
+ * @param depth_zero_to_one: 1 when clip depth is 0..w (mat4_perspective),
+ *                           0 when it is -w..w (mat4_ortho, mat4_frustum)
+ */
+VMATH_NATIVE_API void vmath_native_frustum_planes(const float* viewproj, float* planes, int depth_zero_to_one);
+
+/**
+ * Find spheres which are inside or intersect all planes
+ * @param out_indices: indices of visible spheres, at least count elements
+ * @return: number of visible spheres
+ */
+VMATH_NATIVE_API int vmath_native_cull_spheres(const float* planes, int plane_count,
+                                               const float* spheres, int count, int* out_indices);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __VMATH_NATIVE_H__ */
+
+/********************
+ * Implementation
+ ********************/
+
+#if defined(VMATH_IMPL) && !defined(__VMATH_NATIVE_IMPL__)
+#define __VMATH_NATIVE_IMPL__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+VMATH_NATIVE_API int vmath_native_abi_version(void)
+{
+    return VMATH_NATIVE_ABI_VERSION;
+}
+
+VMATH_NATIVE_API void vmath_native_transform_points(const float* m, const float* points, float* out, int count)
+{
+    const vfloat4_t c0 = vfloat4_load(m + 0);
+    const vfloat4_t c1 = vfloat4_load(m + 4);
+    const vfloat4_t c2 = vfloat4_load(m + 8);
+    const vfloat4_t c3 = vfloat4_load(m + 12);
+    int i;
+    for (i = 0; i < count; i++, points += 3, out += 3)
+    {
+        /* Read the whole point before write, out can be points */
+        const vfloat4_t x = vfloat4_set1(points[0]);
+        const vfloat4_t y = vfloat4_set1(points[1]);
+        const vfloat4_t z = vfloat4_set1(points[2]);
+        vfloat4_storen(out, vfloat4_madd(c2, z, vfloat4_madd(c1, y, vfloat4_madd(c0, x, c3))), 3);
+    }
+}
+
+VMATH_NATIVE_API void vmath_native_transform_vectors(const float* m, const float* vectors, float* out, int count)
+{
+    const vfloat4_t c0 = vfloat4_load(m + 0);
+    const vfloat4_t c1 = vfloat4_load(m + 4);
+    const vfloat4_t c2 = vfloat4_load(m + 8);
+    const vfloat4_t c3 = vfloat4_load(m + 12);
+    int i;
+    for (i = 0; i < count; i++, vectors += 4, out += 4)
+    {
+        vfloat4_t r = vfloat4_mul(c0, vfloat4_set1(vectors[0]));
+        r = vfloat4_madd(c1, vfloat4_set1(vectors[1]), r);
+        r = vfloat4_madd(c2, vfloat4_set1(vectors[2]), r);
+        r = vfloat4_madd(c3, vfloat4_set1(vectors[3]), r);
+        vfloat4_store(out, r);
+    }
+}
+
+VMATH_NATIVE_API void vmath_native_compose_trs(float* out, const float* t, const float* r, const float* s, int count)
+{
+    int i;
+    for (i = 0; i < count; i++, out += 16, t += 3, r += 4, s += 3)
+    {
+        const vec3_t ti = vec3(t[0], t[1], t[2]);
+        const quat_t ri = quat(r[0], r[1], r[2], r[3]);
+        const vec3_t si = vec3(s[0], s[1], s[2]);
+        mat4_t m;
+        mat4_composetrs(&m, &ti, &ri, &si, 1);
+        memcpy(out, m.data, sizeof(m.data));
+    }
+}
+
+VMATH_NATIVE_API void vmath_native_skin(float* out_positions, float* out_normals,
+                                        const float* positions, const float* normals,
+                                        const int* bones, const float* weights, int count,
+                                        const float* palette, int bone_count)
+{
+    dquat_t        stack[VMATH_NATIVE_STACK_BONES];
+    void*          heap = NULL;
+    const dquat_t* bones_dq;
+
+    vec3_t         in_p[VMATH_NATIVE_SKIN_CHUNK], in_n[VMATH_NATIVE_SKIN_CHUNK];
+    vec3_t         out_p[VMATH_NATIVE_SKIN_CHUNK], out_n[VMATH_NATIVE_SKIN_CHUNK];
+    const int      has_normals = out_normals && normals;
+    int            i, j, n;
+
+    if (count <= 0 || bone_count <= 0)
+    {
+        return;
+    }
+
+    /* dquat_t is loaded with aligned SIMD moves, managed arrays are only 8 bytes aligned */
+    if (((uintptr_t)palette & (sizeof(float4_t) - 1)) == 0)
+    {
+        bones_dq = (const dquat_t*)palette;
+    }
+    else if (bone_count <= VMATH_NATIVE_STACK_BONES)
+    {
+        memcpy(stack, palette, (size_t)bone_count * sizeof(dquat_t));
+        bones_dq = stack;
+    }
+    else
+    {
+        heap = malloc((size_t)bone_count * sizeof(dquat_t) + sizeof(float4_t));
+        if (!heap)
+        {
+            return;
+        }
+        bones_dq = (const dquat_t*)(((uintptr_t)heap + sizeof(float4_t) - 1) & ~(uintptr_t)(sizeof(float4_t) - 1));
+        memcpy((void*)bones_dq, palette, (size_t)bone_count * sizeof(dquat_t));
+    }
+
+    for (i = 0; i < count; i += n)
+    {
+        n = count - i < VMATH_NATIVE_SKIN_CHUNK ? count - i : VMATH_NATIVE_SKIN_CHUNK;
+        for (j = 0; j < n; j++)
+        {
+            const float* p = positions + 3 * (i + j);
+            in_p[j] = vec3(p[0], p[1], p[2]);
+            if (has_normals)
+            {
+                const float* v = normals + 3 * (i + j);
+                in_n[j] = vec3(v[0], v[1], v[2]);
+            }
+        }
+
+        dquat_skin(out_p, has_normals ? out_n : NULL, in_p, in_n, bones + 4 * i, weights + 4 * i, n, bones_dq);
+
+        for (j = 0; j < n; j++)
+        {
+            float* p = out_positions + 3 * (i + j);
+            p[0] = out_p[j].x; p[1] = out_p[j].y; p[2] = out_p[j].z;
+            if (has_normals)
+            {
+                float* v = out_normals + 3 * (i + j);
+                v[0] = out_n[j].x; v[1] = out_n[j].y; v[2] = out_n[j].z;
+            }
+        }
+    }
+
+    free(heap);
+}
+
+VMATH_NATIVE_API void vmath_native_frustum_planes(const float* viewproj, float* planes, int depth_zero_to_one)
+{
+    /* Gribb-Hartmann: row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i]) */
+    const float* m = viewproj;
+    const float  rows[4][4] = {
+        { m[0], m[4], m[ 8], m[12] },
+        { m[1], m[5], m[ 9], m[13] },
+        { m[2], m[6], m[10], m[14] },
+        { m[3], m[7], m[11], m[15] },
+    };
+    int i, k;
+    for (i = 0; i < 6; i++)
+    {
+        float* p = planes + 4 * i;
+        float  l;
+        for (k = 0; k < 4; k++)
+        {
+            switch (i)
+            {
+            case 0:  p[k] = rows[3][k] + rows[0][k]; break;
+            case 1:  p[k] = rows[3][k] - rows[0][k]; break;
+            case 2:  p[k] = rows[3][k] + rows[1][k]; break;
+            case 3:  p[k] = rows[3][k] - rows[1][k]; break;
+            case 4:  p[k] = depth_zero_to_one ? rows[2][k] : rows[3][k] + rows[2][k]; break;
+            default: p[k] = rows[3][k] - rows[2][k]; break;
+            }
+        }
+
+        l = sqrtf(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+        if (l > 0.0f)
+        {
+            l = 1.0f / l;
+            p[0] *= l; p[1] *= l; p[2] *= l; p[3] *= l;
+        }
+    }
+}
+
+VMATH_NATIVE_API int vmath_native_cull_spheres(const float* planes, int plane_count,
+                                               const float* spheres, int count, int* out_indices)
+{
+    int visible = 0;
+    int i, k;
+
+    /* 4 spheres per loop, transposed to x, y, z, radius lanes */
+    for (i = 0; i + 4 <= count; i += 4)
+    {
+        vfloat4_t x = vfloat4_load(spheres + 4 * i);
+        vfloat4_t y = vfloat4_load(spheres + 4 * i + 4);
+        vfloat4_t z = vfloat4_load(spheres + 4 * i + 8);
+        vfloat4_t r = vfloat4_load(spheres + 4 * i + 12);
+        int       inside = 15;
+        vfloat4_transpose(&x, &y, &z, &r);
+        r = vfloat4_neg(r);
+
+        for (k = 0; k < plane_count && inside; k++)
+        {
+            const float* p = planes + 4 * k;
+            vfloat4_t    d = vfloat4_madd(x, vfloat4_set1(p[0]), vfloat4_set1(p[3]));
+            d = vfloat4_madd(y, vfloat4_set1(p[1]), d);
+            d = vfloat4_madd(z, vfloat4_set1(p[2]), d);
+            inside &= ~vfloat4_movemask(vfloat4_cmplt(d, r));
+        }
+
+        for (k = 0; k < 4; k++)
+        {
+            if (inside & (1 << k))
+            {
+                out_indices[visible++] = i + k;
+            }
+        }
+    }
+
+    for (; i < count; i++)
+    {
+        const float* s = spheres + 4 * i;
+        int          in = 1;
+        for (k = 0; k < plane_count && in; k++)
+        {
+            const float* p = planes + 4 * k;
+            in = p[0] * s[0] + p[1] * s[1] + p[2] * s[2] + p[3] >= -s[3];
+        }
+
+        if (in)
+        {
+            out_indices[visible++] = i;
+        }
+    }
+
+    return visible;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VMATH_IMPL */
@@ -0,0 +1,1095 @@
+/******************************************************
+ * vmath_noise - Gradient noise (Perlin, simplex, value)
+ *
+ * @author: MaiHD
+ * @license: NULL
+ * @copyright: MaiHD @ ${HOME}, 2017 - 2018
+ ******************************************************/
+
+#ifndef __VMATH_NOISE_H__
+#define __VMATH_NOISE_H__
+
+#include "vmath_soa.h"
+
+/**
+ * Every kernel evaluate 4 points per call (SoA lanes), lattice hashing is done
+ * with integer lanes, so results are the same bits on SSE, NEON and scalar
+ * backends (see vmath_soa.h). Lattice coordinates must be in range of int.
+ */
+
+/**
+ * Noise basis
+ */
+#define NOISE_PERLIN            0
+#define NOISE_SIMPLEX           1
+#define NOISE_VALUE             2
+
+/**
+ * Fractal sum of octaves
+ * FBM:    sum of amp * noise, normalized to [-1, 1]
+ * RIDGED: sum of amp * (1 - |noise|)^2, normalized to [0, 1]
+ */
+#define NOISE_FRACTAL_NONE      0
+#define NOISE_FRACTAL_FBM       1
+#define NOISE_FRACTAL_RIDGED    2
+
+/**
+ * Noise description
+ */
+typedef struct vmath_noise_desc
+{
+    int   basis;
+    int   fractal;
+    int   octaves;
+    int   seed;
+    float frequency;
+    float lacunarity;
+    float gain;
+} noise_desc_t;
+
+/**
+ * Create noise description with common fractal settings
+ */
+__vmath__ noise_desc_t noise_desc(int basis, int fractal, int octaves)
+{
+    noise_desc_t d;
+    d.basis      = basis;
+    d.fractal    = fractal;
+    d.octaves    = octaves;
+    d.seed       = 0;
+    d.frequency  = 1.0f;
+    d.lacunarity = 2.0f;
+    d.gain       = 0.5f;
+    return d;
+}
+
+/********************
+ * Lattice hashing
+ ********************/
+#define NOISE_PRIME_X ((int)0x8da6b343u)
+#define NOISE_PRIME_Y ((int)0xd8163841u)
+#define NOISE_PRIME_Z ((int)0xcb1ab31fu)
+#define NOISE_PRIME_W ((int)0x165667b1u)
+#define NOISE_PRIME_S ((int)0x9e3779b9u)
+
+/**
+ * Integer hash finalizer (lowbias32)
+ */
+__vmath__ vint4_t noise_hash_x4(vint4_t h)
+{
+    h = vint4_xor(h, vint4_srl(h, 16));
+    h = vint4_mul(h, vint4_set1((int)0x7feb352du));
+    h = vint4_xor(h, vint4_srl(h, 15));
+    h = vint4_mul(h, vint4_set1((int)0x846ca68bu));
+    h = vint4_xor(h, vint4_srl(h, 16));
+    return h;
+}
+
+/**
+ * Seed offset of the lattice hash
+ */
+__vmath__ vint4_t noise_seed_x4(int seed)
+{
+    return vint4_set1((int)((unsigned)seed * (unsigned)NOISE_PRIME_S));
+}
+
+/**
+ * Lattice cell of coordinates: floor, fraction and hashed coordinate
+ */
+__vmath__ vfloat4_t noise_cell_x4(vfloat4_t v, int prime, vint4_t* h)
+{
+    const vfloat4_t f = vfloat4_floor(v);
+    *h = vint4_mul(vfloat4_toint(f), vint4_set1(prime));
+    return vfloat4_sub(v, f);
+}
+
+/**
+ * Mask of lanes which (h & bits) == 0
+ */
+__vmath__ vfloat4_t noise_bitsclear_x4(vint4_t h, int bits)
+{
+    return vint4_asfloat(vint4_cmpeq(vint4_and(h, vint4_set1(bits)), vint4_set1(0)));
+}
+
+/**
+ * Signed value from a hash bit: bit ? -s : s
+ */
+__vmath__ vfloat4_t noise_signbit_x4(vint4_t h, int bit, float s)
+{
+    const vint4_t sign = vint4_sll(vint4_and(h, vint4_set1(1 << bit)), 31 - bit);
+    return vfloat4_xor(vfloat4_set1(s), vint4_asfloat(sign));
+}
+
+/**
+ * 8 gradients (1, 2) family, dot with offset (x, y)
+ */
+__vmath__ vfloat4_t noise_grad2_x4(vint4_t h, vfloat4_t x, vfloat4_t y,
+                                   vfloat4_t* gx, vfloat4_t* gy)
+{
+    const vfloat4_t m  = noise_bitsclear_x4(h, 4);
+    const vfloat4_t s0 = noise_signbit_x4(h, 0, 1.0f);
+    const vfloat4_t s1 = noise_signbit_x4(h, 1, 2.0f);
+
+    *gx = vfloat4_select(s1, s0, m);
+    *gy = vfloat4_select(s0, s1, m);
+    return vfloat4_madd(*gx, x, vfloat4_mul(*gy, y));
+}
+
+/**
+ * 12 edge gradients of the cube (improved Perlin), dot with offset (x, y, z)
+ */
+__vmath__ vfloat4_t noise_grad3_x4(vint4_t h, vfloat4_t x, vfloat4_t y, vfloat4_t z,
+                                   vfloat4_t* gx, vfloat4_t* gy, vfloat4_t* gz)
+{
+    const vfloat4_t ux = noise_bitsclear_x4(h, 8);
+    const vfloat4_t vy = noise_bitsclear_x4(h, 12);
+    const vfloat4_t vx = vint4_asfloat(vint4_cmpeq(vint4_and(h, vint4_set1(13)), vint4_set1(12)));
+    const vfloat4_t vz = vfloat4_andnot(vfloat4_or(vy, vx), vint4_asfloat(vint4_set1(-1)));
+    const vfloat4_t s0 = noise_signbit_x4(h, 0, 1.0f);
+    const vfloat4_t s1 = noise_signbit_x4(h, 1, 1.0f);
+
+    *gx = vfloat4_add(vfloat4_and(ux, s0), vfloat4_and(vx, s1));
+    *gy = vfloat4_add(vfloat4_andnot(ux, s0), vfloat4_and(vy, s1));
+    *gz = vfloat4_and(vz, s1);
+    return vfloat4_madd(*gx, x, vfloat4_madd(*gy, y, vfloat4_mul(*gz, z)));
+}
+
+/**
+ * 32 edge gradients of the tesseract, dot with offset (x, y, z, w)
+ */
+__vmath__ vfloat4_t noise_grad4_x4(vint4_t h, vfloat4_t x, vfloat4_t y, vfloat4_t z, vfloat4_t w,
+                                   vfloat4_t* gx, vfloat4_t* gy, vfloat4_t* gz, vfloat4_t* gw)
+{
+    const vfloat4_t a  = vfloat4_andnot(vint4_asfloat(vint4_cmpeq(vint4_and(h, vint4_set1(24)), vint4_set1(24))),
+                                        vint4_asfloat(vint4_set1(-1))); /* h < 24 */
+    const vfloat4_t b  = noise_bitsclear_x4(h, 16);                      /* h < 16 */
+    const vfloat4_t c  = noise_bitsclear_x4(h, 24);                      /* h < 8  */
+    const vfloat4_t s0 = noise_signbit_x4(h, 0, 1.0f);
+    const vfloat4_t s1 = noise_signbit_x4(h, 1, 1.0f);
+    const vfloat4_t s2 = noise_signbit_x4(h, 2, 1.0f);
+
+    *gx = vfloat4_and(a, s0);
+    *gy = vfloat4_add(vfloat4_andnot(a, s0), vfloat4_and(b, s1));
+    *gz = vfloat4_add(vfloat4_andnot(b, s1), vfloat4_and(c, s2));
+    *gw = vfloat4_andnot(c, s2);
+    return vfloat4_madd(*gx, x, vfloat4_madd(*gy, y, vfloat4_madd(*gz, z, vfloat4_mul(*gw, w))));
+}
+
+/**
+ * Hash to value in [-1, 1)
+ */
+__vmath__ vfloat4_t noise_hashvalue_x4(vint4_t h)
+{
+    const vfloat4_t v = vint4_tofloat(vint4_srl(h, 8));
+    return vfloat4_sub(vfloat4_mul(v, vfloat4_set1(1.0f / 8388608.0f)), vfloat4_set1(1.0f));
+}
+
+/**
+ * Quintic fade curve 6t^5 - 15t^4 + 10t^3 and its derivative
+ */
+__vmath__ vfloat4_t noise_fade_x4(vfloat4_t t, vfloat4_t* dt)
+{
+    const vfloat4_t t2 = vfloat4_mul(t, t);
+    const vfloat4_t p  = vfloat4_madd(t, vfloat4_madd(t, vfloat4_set1(6.0f), vfloat4_set1(-15.0f)), vfloat4_set1(10.0f));
+    const vfloat4_t q  = vfloat4_madd(t, vfloat4_sub(t, vfloat4_set1(2.0f)), vfloat4_set1(1.0f));
+    *dt = vfloat4_mul(vfloat4_mul(t2, vfloat4_set1(30.0f)), q);
+    return vfloat4_mul(vfloat4_mul(t2, t), p);
+}
+
+/********************
+ * Lattice interpolation with derivatives
+ ********************/
+
+/**
+ * Value and partial derivatives of 4 lanes
+ */
+typedef struct vmath_noise_sample_x4
+{
+    vfloat4_t value;
+    vfloat4_t d[4];
+} noise_sample_x4_t;
+
+/**
+ * Interpolate the corners of a lattice cell, one axis after another,
+ * result in corners[0]
+ */
+__vmath__ void noise_lerpcorners_x4(noise_sample_x4_t* corners, int dims, const vfloat4_t* t, const vfloat4_t* dt)
+{
+    int axis, c, k;
+    for (axis = 0; axis < dims; axis++)
+    {
+        const int step = 1 << axis;
+        for (c = 0; c < (1 << dims); c += 2 * step)
+        {
+            noise_sample_x4_t*       a = &corners[c];
+            const noise_sample_x4_t* b = &corners[c + step];
+
+            const vfloat4_t delta = vfloat4_sub(b->value, a->value);
+            for (k = 0; k < dims; k++)
+            {
+                a->d[k] = vfloat4_madd(t[axis], vfloat4_sub(b->d[k], a->d[k]), a->d[k]);
+            }
+            a->d[axis] = vfloat4_madd(dt[axis], delta, a->d[axis]);
+            a->value   = vfloat4_madd(t[axis], delta, a->value);
+        }
+    }
+}
+
+/**
+ * Store optional derivative outputs
+ */
+__vmath__ vfloat4_t noise_output_x4(const noise_sample_x4_t* s, float scale,
+                                    vfloat4_t* dx, vfloat4_t* dy, vfloat4_t* dz, vfloat4_t* dw)
+{
+    const vfloat4_t k = vfloat4_set1(scale);
+    if (dx) *dx = vfloat4_mul(s->d[0], k);
+    if (dy) *dy = vfloat4_mul(s->d[1], k);
+    if (dz) *dz = vfloat4_mul(s->d[2], k);
+    if (dw) *dw = vfloat4_mul(s->d[3], k);
+    return vfloat4_mul(s->value, k);
+}
+
+/********************
+ * Perlin noise
+ ********************/
+
+/**
+ * 2D Perlin noise of 4 points, range [-1, 1]
+ * @param dx, dy: partial derivatives, can be NULL
+ */
+__vmath__ vfloat4_t noise_perlin2_x4(vfloat4_t x, vfloat4_t y, int seed, vfloat4_t* dx, vfloat4_t* dy)
+{
+    vint4_t hx, hy;
+    vfloat4_t t[2], dt[2], p0[2], p1[2];
+    vint4_t   h0[2], h1[2];
+    noise_sample_x4_t c[4];
+    int i;
+
+    p0[0] = noise_cell_x4(x, NOISE_PRIME_X, &hx);
+    p0[1] = noise_cell_x4(y, NOISE_PRIME_Y, &hy);
+    for (i = 0; i < 2; i++)
+    {
+        p1[i] = vfloat4_sub(p0[i], vfloat4_set1(1.0f));
+        t[i]  = noise_fade_x4(p0[i], &dt[i]);
+    }
+    h0[0] = vint4_add(hx, noise_seed_x4(seed)); h1[0] = vint4_add(h0[0], vint4_set1(NOISE_PRIME_X));
+    h0[1] = hy;                                              h1[1] = vint4_add(h0[1], vint4_set1(NOISE_PRIME_Y));
+
+    for (i = 0; i < 4; i++)
+    {
+        const vint4_t h = noise_hash_x4(vint4_add(i & 1 ? h1[0] : h0[0], i & 2 ? h1[1] : h0[1]));
+        c[i].value = noise_grad2_x4(h, i & 1 ? p1[0] : p0[0], i & 2 ? p1[1] : p0[1], &c[i].d[0], &c[i].d[1]);
+    }
+
+    noise_lerpcorners_x4(c, 2, t, dt);
+    return noise_output_x4(&c[0], 0.507f, dx, dy, NULL, NULL);
+}
+
+/**
+ * 3D Perlin noise of 4 points, range [-1, 1]
+ * @param dx, dy, dz: partial derivatives, can be NULL
+ */
+__vmath__ vfloat4_t noise_perlin3_x4(vfloat4_t x, vfloat4_t y, vfloat4_t z, int seed,
+                                     vfloat4_t* dx, vfloat4_t* dy, vfloat4_t* dz)
+{
+    vint4_t hx, hy, hz;
+    vfloat4_t t[3], dt[3], p0[3], p1[3];
+    vint4_t   h0[3], h1[3];
+    noise_sample_x4_t c[8];
+    int i;
+
+    p0[0] = noise_cell_x4(x, NOISE_PRIME_X, &hx);
+    p0[1] = noise_cell_x4(y, NOISE_PRIME_Y, &hy);
+    p0[2] = noise_cell_x4(z, NOISE_PRIME_Z, &hz);
+    for (i = 0; i < 3; i++)
+    {
+        p1[i] = vfloat4_sub(p0[i], vfloat4_set1(1.0f));
+        t[i]  = noise_fade_x4(p0[i], &dt[i]);
+    }
+    h0[0] = vint4_add(hx, noise_seed_x4(seed)); h1[0] = vint4_add(h0[0], vint4_set1(NOISE_PRIME_X));
+    h0[1] = hy;                                              h1[1] = vint4_add(h0[1], vint4_set1(NOISE_PRIME_Y));
+    h0[2] = hz;                                              h1[2] = vint4_add(h0[2], vint4_set1(NOISE_PRIME_Z));
+
+    for (i = 0; i < 8; i++)
+    {
+        const vint4_t h = noise_hash_x4(vint4_add(vint4_add(i & 1 ? h1[0] : h0[0], i & 2 ? h1[1] : h0[1]), i & 4 ? h1[2] : h0[2]));
+        c[i].value = noise_grad3_x4(h, i & 1 ? p1[0] : p0[0], i & 2 ? p1[1] : p0[1], i & 4 ? p1[2] : p0[2],
+                                    &c[i].d[0], &c[i].d[1], &c[i].d[2]);
+    }
+
+    noise_lerpcorners_x4(c, 3, t, dt);
+    return noise_output_x4(&c[0], 0.936f, dx, dy, dz, NULL);
+}
+
+/**
+ * 4D Perlin noise of 4 points, range [-1, 1]
+ * @param dx, dy, dz, dw: partial derivatives, can be NULL
+ */
+__vmath__ vfloat4_t noise_perlin4_x4(vfloat4_t x, vfloat4_t y, vfloat4_t z, vfloat4_t w, int seed,
+                                     vfloat4_t* dx, vfloat4_t* dy, vfloat4_t* dz, vfloat4_t* dw)
+{
+    vint4_t hx, hy, hz, hw;
+    vfloat4_t t[4], dt[4], p0[4], p1[4];
+    vint4_t   h0[4], h1[4];
+    noise_sample_x4_t c[16];
+    int i;
+
+    p0[0] = noise_cell_x4(x, NOISE_PRIME_X, &hx);
+    p0[1] = noise_cell_x4(y, NOISE_PRIME_Y, &hy);
+    p0[2] = noise_cell_x4(z, NOISE_PRIME_Z, &hz);
+    p0[3] = noise_cell_x4(w, NOISE_PRIME_W, &hw);
+    for (i = 0; i < 4; i++)
+    {
+        p1[i] = vfloat4_sub(p0[i], vfloat4_set1(1.0f));
+        t[i]  = noise_fade_x4(p0[i], &dt[i]);
+    }
+    h0[0] = vint4_add(hx, noise_seed_x4(seed)); h1[0] = vint4_add(h0[0], vint4_set1(NOISE_PRIME_X));
+    h0[1] = hy;                                              h1[1] = vint4_add(h0[1], vint4_set1(NOISE_PRIME_Y));
+    h0[2] = hz;                                              h1[2] = vint4_add(h0[2], vint4_set1(NOISE_PRIME_Z));
+    h0[3] = hw;                                              h1[3] = vint4_add(h0[3], vint4_set1(NOISE_PRIME_W));
+
+    for (i = 0; i < 16; i++)
+    {
+        const vint4_t h = noise_hash_x4(vint4_add(vint4_add(i & 1 ? h1[0] : h0[0], i & 2 ? h1[1] : h0[1]),
+                                                  vint4_add(i & 4 ? h1[2] : h0[2], i & 8 ? h1[3] : h0[3])));
+        c[i].value = noise_grad4_x4(h, i & 1 ? p1[0] : p0[0], i & 2 ? p1[1] : p0[1],
+                                    i & 4 ? p1[2] : p0[2], i & 8 ? p1[3] : p0[3],
+                                    &c[i].d[0], &c[i].d[1], &c[i].d[2], &c[i].d[3]);
+    }
+
+    noise_lerpcorners_x4(c, 4, t, dt);
+    return noise_output_x4(&c[0], 0.87f, dx, dy, dz, dw);
+}
+
+/********************
+ * Value noise
+ ********************/
+
+/**
+ * 2D value noise of 4 points, range [-1, 1]
+ */
+__vmath__ vfloat4_t noise_value2_x4(vfloat4_t x, vfloat4_t y, int seed, vfloat4_t* dx, vfloat4_t* dy)
+{
+    vint4_t hx, hy;
+    vfloat4_t t[2], dt[2], p[2];
+    noise_sample_x4_t c[4];
+    int i;
+
+    p[0] = noise_cell_x4(x, NOISE_PRIME_X, &hx);
+    p[1] = noise_cell_x4(y, NOISE_PRIME_Y, &hy);
+    t[0] = noise_fade_x4(p[0], &dt[0]);
+    t[1] = noise_fade_x4(p[1], &dt[1]);
+    hx   = vint4_add(hx, noise_seed_x4(seed));
+
+    for (i = 0; i < 4; i++)
+    {
+        const vint4_t h = vint4_add(vint4_add(hx, vint4_set1(i & 1 ? NOISE_PRIME_X : 0)),
+                                    vint4_add(hy, vint4_set1(i & 2 ? NOISE_PRIME_Y : 0)));
+        c[i].value = noise_hashvalue_x4(noise_hash_x4(h));
+        c[i].d[0]  = c[i].d[1] = vfloat4_zero();
+    }
+
+    noise_lerpcorners_x4(c, 2, t, dt);
+    return noise_output_x4(&c[0], 1.0f, dx, dy, NULL, NULL);
+}
+
+/**
+ * 3D value noise of 4 points, range [-1, 1]
+ */
+__vmath__ vfloat4_t noise_value3_x4(vfloat4_t x, vfloat4_t y, vfloat4_t z, int seed,
+                                    vfloat4_t* dx, vfloat4_t* dy, vfloat4_t* dz)
+{
+    vint4_t hx, hy, hz;
+    vfloat4_t t[3], dt[3], p[3];
+    noise_sample_x4_t c[8];
+    int i;
+
+    p[0] = noise_cell_x4(x, NOISE_PRIME_X, &hx);
+    p[1] = noise_cell_x4(y, NOISE_PRIME_Y, &hy);
+    p[2] = noise_cell_x4(z, NOISE_PRIME_Z, &hz);
+    for (i = 0; i < 3; i++)
+    {
+        t[i] = noise_fade_x4(p[i], &dt[i]);
+    }
+    hx = vint4_add(hx, noise_seed_x4(seed));
+
+    for (i = 0; i < 8; i++)
+    {
+        const vint4_t h = vint4_add(vint4_add(vint4_add(hx, vint4_set1(i & 1 ? NOISE_PRIME_X : 0)),
+                                              vint4_add(hy, vint4_set1(i & 2 ? NOISE_PRIME_Y : 0))),
+                                    vint4_add(hz, vint4_set1(i & 4 ? NOISE_PRIME_Z : 0)));
+        c[i].value = noise_hashvalue_x4(noise_hash_x4(h));
+        c[i].d[0]  = c[i].d[1] = c[i].d[2] = vfloat4_zero();
+    }
+
+    noise_lerpcorners_x4(c, 3, t, dt);
+    return noise_output_x4(&c[0], 1.0f, dx, dy, dz, NULL);
+}
+
+/**
+ * 4D value noise of 4 points, range [-1, 1]
+ */
+__vmath__ vfloat4_t noise_value4_x4(vfloat4_t x, vfloat4_t y, vfloat4_t z, vfloat4_t w, int seed,
+                                    vfloat4_t* dx, vfloat4_t* dy, vfloat4_t* dz, vfloat4_t* dw)
+{
+    vint4_t hx, hy, hz, hw;
+    vfloat4_t t[4], dt[4], p[4];
+    noise_sample_x4_t c[16];
+    int i;
+
+    p[0] = noise_cell_x4(x, NOISE_PRIME_X, &hx);
+    p[1] = noise_cell_x4(y, NOISE_PRIME_Y, &hy);
+    p[2] = noise_cell_x4(z, NOISE_PRIME_Z, &hz);
+    p[3] = noise_cell_x4(w, NOISE_PRIME_W, &hw);
+    for (i = 0; i < 4; i++)
+    {
+        t[i] = noise_fade_x4(p[i], &dt[i]);
+    }
+    hx = vint4_add(hx, noise_seed_x4(seed));
+
+    for (i = 0; i < 16; i++)
+    {
+        const vint4_t h = vint4_add(vint4_add(vint4_add(hx, vint4_set1(i & 1 ? NOISE_PRIME_X : 0)),
+                                              vint4_add(hy, vint4_set1(i & 2 ? NOISE_PRIME_Y : 0))),
+                                    vint4_add(vint4_add(hz, vint4_set1(i & 4 ? NOISE_PRIME_Z : 0)),
+                                              vint4_add(hw, vint4_set1(i & 8 ? NOISE_PRIME_W : 0))));
+        c[i].value = noise_hashvalue_x4(noise_hash_x4(h));
+        c[i].d[0]  = c[i].d[1] = c[i].d[2] = c[i].d[3] = vfloat4_zero();
+    }
+
+    noise_lerpcorners_x4(c, 4, t, dt);
+    return noise_output_x4(&c[0], 1.0f, dx, dy, dz, dw);
+}
+
+/********************
+ * Simplex noise
+ ********************/
+
+/**
+ * Contribution of a simplex corner: (r - |d|^2)^4 * dot(g, d)
+ * Accumulate value and derivatives into s
+ */
+__vmath__ void noise_simplexcorner_x4(noise_sample_x4_t* s, int dims, float r,
+                                      vfloat4_t n, const vfloat4_t* d, const vfloat4_t* g)
+{
+    vfloat4_t t = vfloat4_set1(r);
+    int k;
+    for (k = 0; k < dims; k++)
+    {
+        t = vfloat4_nmadd(d[k], d[k], t);
+    }
+    t = vfloat4_max(t, vfloat4_zero());
+
+    {
+        const vfloat4_t t2 = vfloat4_mul(t, t);
+        const vfloat4_t t4 = vfloat4_mul(t2, t2);
+        const vfloat4_t k8 = vfloat4_mul(vfloat4_mul(t2, t), vfloat4_mul(n, vfloat4_set1(-8.0f)));
+
+        /* equation: d/dp (t^4 * n) = -8 * t^3 * n * d + t^4 * g */
+        s->value = vfloat4_madd(t4, n, s->value);
+        for (k = 0; k < dims; k++)
+        {
+            s->d[k] = vfloat4_add(s->d[k], vfloat4_madd(k8, d[k], vfloat4_mul(t4, g[k])));
+        }
+    }
+}
+
+/**
+ * 2D simplex noise of 4 points, range [-1, 1]
+ * @param dx, dy: partial derivatives, can be NULL
+ */
+__vmath__ vfloat4_t noise_simplex2_x4(vfloat4_t x, vfloat4_t y, int seed, vfloat4_t* dx, vfloat4_t* dy)
+{
+    const float F2 = 0.366025403f; /* 0.5 * (sqrt(3) - 1) */
+    const float G2 = 0.211324865f; /* (3 - sqrt(3)) / 6   */
+
+    const vfloat4_t s  = vfloat4_mul(vfloat4_add(x, y), vfloat4_set1(F2));
+    const vfloat4_t fi = vfloat4_floor(vfloat4_add(x, s));
+    const vfloat4_t fj = vfloat4_floor(vfloat4_add(y, s));
+    const vfloat4_t t  = vfloat4_mul(vfloat4_add(fi, fj), vfloat4_set1(G2));
+
+    vfloat4_t d0[2], d1[2], d2[2], g[2];
+    d0[0] = vfloat4_sub(x, vfloat4_sub(fi, t));
+    d0[1] = vfloat4_sub(y, vfloat4_sub(fj, t));
+
+    /* Lower or upper triangle of the cell */
+    const vfloat4_t m  = vfloat4_cmpgt(d0[0], d0[1]);
+    const vfloat4_t i1 = vfloat4_and(m, vfloat4_set1(1.0f));
+    const vfloat4_t j1 = vfloat4_andnot(m, vfloat4_set1(1.0f));
+    d1[0] = vfloat4_add(vfloat4_sub(d0[0], i1), vfloat4_set1(G2));
+    d1[1] = vfloat4_add(vfloat4_sub(d0[1], j1), vfloat4_set1(G2));
+    d2[0] = vfloat4_add(d0[0], vfloat4_set1(2.0f * G2 - 1.0f));
+    d2[1] = vfloat4_add(d0[1], vfloat4_set1(2.0f * G2 - 1.0f));
+
+    const vint4_t hi = vint4_add(vint4_mul(vfloat4_toint(fi), vint4_set1(NOISE_PRIME_X)), noise_seed_x4(seed));
+    const vint4_t hj = vint4_mul(vfloat4_toint(fj), vint4_set1(NOISE_PRIME_Y));
+    const vint4_t h0 = noise_hash_x4(vint4_add(hi, hj));
+    const vint4_t h1 = noise_hash_x4(vint4_add(vint4_add(hi, vint4_and(vfloat4_asint(m), vint4_set1(NOISE_PRIME_X))),
+                                               vint4_add(hj, vint4_and(vfloat4_asint(vfloat4_andnot(m, vint4_asfloat(vint4_set1(-1)))),
+                                                                       vint4_set1(NOISE_PRIME_Y)))));
+    const vint4_t h2 = noise_hash_x4(vint4_add(vint4_add(hi, vint4_set1(NOISE_PRIME_X)), vint4_add(hj, vint4_set1(NOISE_PRIME_Y))));
+
+    noise_sample_x4_t r;
+    r.value = r.d[0] = r.d[1] = vfloat4_zero();
+    noise_simplexcorner_x4(&r, 2, 0.5f, noise_grad2_x4(h0, d0[0], d0[1], &g[0], &g[1]), d0, g);
+    noise_simplexcorner_x4(&r, 2, 0.5f, noise_grad2_x4(h1, d1[0], d1[1], &g[0], &g[1]), d1, g);
+    noise_simplexcorner_x4(&r, 2, 0.5f, noise_grad2_x4(h2, d2[0], d2[1], &g[0], &g[1]), d2, g);
+    return noise_output_x4(&r, 40.0f, dx, dy, NULL, NULL);
+}
+
+/**
+ * 3D simplex noise of 4 points, range [-1, 1]
+ * @param dx, dy, dz: partial derivatives, can be NULL
+ */
+__vmath__ vfloat4_t noise_simplex3_x4(vfloat4_t x, vfloat4_t y, vfloat4_t z, int seed,
+                                      vfloat4_t* dx, vfloat4_t* dy, vfloat4_t* dz)
+{
+    const float F3 = 1.0f / 3.0f;
+    const float G3 = 1.0f / 6.0f;
+
+    const vfloat4_t s  = vfloat4_mul(vfloat4_add(vfloat4_add(x, y), z), vfloat4_set1(F3));
+    const vfloat4_t fi = vfloat4_floor(vfloat4_add(x, s));
+    const vfloat4_t fj = vfloat4_floor(vfloat4_add(y, s));
+    const vfloat4_t fk = vfloat4_floor(vfloat4_add(z, s));
+    const vfloat4_t t  = vfloat4_mul(vfloat4_add(vfloat4_add(fi, fj), fk), vfloat4_set1(G3));
+    const vfloat4_t on = vint4_asfloat(vint4_set1(-1));
+
+    vfloat4_t d[4][3], g[3];
+    d[0][0] = vfloat4_sub(x, vfloat4_sub(fi, t));
+    d[0][1] = vfloat4_sub(y, vfloat4_sub(fj, t));
+    d[0][2] = vfloat4_sub(z, vfloat4_sub(fk, t));
+
+    /* Rank the offsets to find the simplex of the cell */
+    const vfloat4_t cxy = vfloat4_cmpge(d[0][0], d[0][1]);
+    const vfloat4_t cyz = vfloat4_cmpge(d[0][1], d[0][2]);
+    const vfloat4_t cxz = vfloat4_cmpge(d[0][0], d[0][2]);
+
+    vfloat4_t o1[3], o2[3];
+    o1[0] = vfloat4_and(cxy, cxz);                          /* x is largest      */
+    o1[1] = vfloat4_andnot(cxy, cyz);                       /* y is largest      */
+    o1[2] = vfloat4_andnot(vfloat4_or(cxz, cyz), on);       /* z is largest      */
+    o2[0] = vfloat4_or(cxy, cxz);                           /* x is not smallest */
+    o2[1] = vfloat4_or(vfloat4_andnot(cxy, on), cyz);       /* y is not smallest */
+    o2[2] = vfloat4_andnot(vfloat4_and(cxz, cyz), on);      /* z is not smallest */
+
+    const vint4_t hi = vint4_add(vint4_mul(vfloat4_toint(fi), vint4_set1(NOISE_PRIME_X)), noise_seed_x4(seed));
+    const vint4_t hj = vint4_mul(vfloat4_toint(fj), vint4_set1(NOISE_PRIME_Y));
+    const vint4_t hk = vint4_mul(vfloat4_toint(fk), vint4_set1(NOISE_PRIME_Z));
+
+    vint4_t h[4];
+    h[0] = noise_hash_x4(vint4_add(vint4_add(hi, hj), hk));
+    h[1] = noise_hash_x4(vint4_add(vint4_add(vint4_add(hi, vint4_and(vfloat4_asint(o1[0]), vint4_set1(NOISE_PRIME_X))),
+                                             vint4_add(hj, vint4_and(vfloat4_asint(o1[1]), vint4_set1(NOISE_PRIME_Y)))),
+                                   vint4_add(hk, vint4_and(vfloat4_asint(o1[2]), vint4_set1(NOISE_PRIME_Z)))));
+    h[2] = noise_hash_x4(vint4_add(vint4_add(vint4_add(hi, vint4_and(vfloat4_asint(o2[0]), vint4_set1(NOISE_PRIME_X))),
+                                             vint4_add(hj, vint4_and(vfloat4_asint(o2[1]), vint4_set1(NOISE_PRIME_Y)))),
+                                   vint4_add(hk, vint4_and(vfloat4_asint(o2[2]), vint4_set1(NOISE_PRIME_Z)))));
+    h[3] = noise_hash_x4(vint4_add(vint4_add(vint4_add(hi, vint4_set1(NOISE_PRIME_X)),
+                                             vint4_add(hj, vint4_set1(NOISE_PRIME_Y))),
+                                   vint4_add(hk, vint4_set1(NOISE_PRIME_Z))));
+
+    int c, k;
+    for (k = 0; k < 3; k++)
+    {
+        d[1][k] = vfloat4_add(vfloat4_sub(d[0][k], vfloat4_and(o1[k], vfloat4_set1(1.0f))), vfloat4_set1(G3));
+        d[2][k] = vfloat4_add(vfloat4_sub(d[0][k], vfloat4_and(o2[k], vfloat4_set1(1.0f))), vfloat4_set1(2.0f * G3));
+        d[3][k] = vfloat4_add(d[0][k], vfloat4_set1(3.0f * G3 - 1.0f));
+    }
+
+    noise_sample_x4_t r;
+    r.value = r.d[0] = r.d[1] = r.d[2] = vfloat4_zero();
+    for (c = 0; c < 4; c++)
+    {
+        const vfloat4_t n = noise_grad3_x4(h[c], d[c][0], d[c][1], d[c][2], &g[0], &g[1], &g[2]);
+        noise_simplexcorner_x4(&r, 3, 0.5f, n, d[c], g);
+    }
+    return noise_output_x4(&r, 72.0f, dx, dy, dz, NULL);
+}
+
+/**
+ * 4D simplex noise of 4 points, range [-1, 1]
+ * @param dx, dy, dz, dw: partial derivatives, can be NULL
+ */
+__vmath__ vfloat4_t noise_simplex4_x4(vfloat4_t x, vfloat4_t y, vfloat4_t z, vfloat4_t w, int seed,
+                                      vfloat4_t* dx, vfloat4_t* dy, vfloat4_t* dz, vfloat4_t* dw)
+{
+    const float F4 = 0.309016994f; /* (sqrt(5) - 1) / 4  */
+    const float G4 = 0.138196601f; /* (5 - sqrt(5)) / 20 */
+
+    const vfloat4_t s = vfloat4_mul(vfloat4_add(vfloat4_add(x, y), vfloat4_add(z, w)), vfloat4_set1(F4));
+    vfloat4_t f[4], d[5][4], g[4];
+    f[0] = vfloat4_floor(vfloat4_add(x, s));
+    f[1] = vfloat4_floor(vfloat4_add(y, s));
+    f[2] = vfloat4_floor(vfloat4_add(z, s));
+    f[3] = vfloat4_floor(vfloat4_add(w, s));
+
+    const vfloat4_t t = vfloat4_mul(vfloat4_add(vfloat4_add(f[0], f[1]), vfloat4_add(f[2], f[3])), vfloat4_set1(G4));
+    d[0][0] = vfloat4_sub(x, vfloat4_sub(f[0], t));
+    d[0][1] = vfloat4_sub(y, vfloat4_sub(f[1], t));
+    d[0][2] = vfloat4_sub(z, vfloat4_sub(f[2], t));
+    d[0][3] = vfloat4_sub(w, vfloat4_sub(f[3], t));
+
+    /* Rank of each axis: number of axes with a smaller offset */
+    vint4_t rank[4];
+    int a, b, c, k;
+    for (a = 0; a < 4; a++)
+    {
+        rank[a] = vint4_set1(0);
+    }
+    for (a = 0; a < 4; a++)
+    {
+        for (b = a + 1; b < 4; b++)
+        {
+            const vint4_t m = vfloat4_asint(vfloat4_cmpgt(d[0][a], d[0][b])); /* -1 if a > b */
+            rank[a] = vint4_sub(rank[a], m);
+            rank[b] = vint4_add(rank[b], vint4_add(m, vint4_set1(1)));
+        }
+    }
+
+    static const int primes[4] = { NOISE_PRIME_X, NOISE_PRIME_Y, NOISE_PRIME_Z, NOISE_PRIME_W };
+    vint4_t hbase[4], h[5];
+    for (k = 0; k < 4; k++)
+    {
+        hbase[k] = vint4_mul(vfloat4_toint(f[k]), vint4_set1(primes[k]));
+    }
+    hbase[0] = vint4_add(hbase[0], noise_seed_x4(seed));
+
+    /* Corner c (1..3) step along the axes which rank >= 4 - c */
+    h[0] = noise_hash_x4(vint4_add(vint4_add(hbase[0], hbase[1]), vint4_add(hbase[2], hbase[3])));
+    for (c = 1; c < 4; c++)
+    {
+        vint4_t sum = vint4_set1(0);
+        for (k = 0; k < 4; k++)
+        {
+            const vint4_t m = vint4_cmplt(vint4_set1(3 - c), rank[k]);
+            sum = vint4_add(sum, vint4_add(hbase[k], vint4_and(m, vint4_set1(primes[k]))));
+            d[c][k] = vfloat4_add(vfloat4_sub(d[0][k], vfloat4_and(vint4_asfloat(m), vfloat4_set1(1.0f))),
+                                  vfloat4_set1(c * G4));
+        }
+        h[c] = noise_hash_x4(sum);
+    }
+    for (k = 0; k < 4; k++)
+    {
+        d[4][k] = vfloat4_add(d[0][k], vfloat4_set1(4.0f * G4 - 1.0f));
+    }
+    h[4] = noise_hash_x4(vint4_add(vint4_add(vint4_add(hbase[0], vint4_set1(NOISE_PRIME_X)), vint4_add(hbase[1], vint4_set1(NOISE_PRIME_Y))),
+                                   vint4_add(vint4_add(hbase[2], vint4_set1(NOISE_PRIME_Z)), vint4_add(hbase[3], vint4_set1(NOISE_PRIME_W)))));
+
+    noise_sample_x4_t r;
+    r.value = r.d[0] = r.d[1] = r.d[2] = r.d[3] = vfloat4_zero();
+    for (c = 0; c < 5; c++)
+    {
+        const vfloat4_t n = noise_grad4_x4(h[c], d[c][0], d[c][1], d[c][2], d[c][3], &g[0], &g[1], &g[2], &g[3]);
+        noise_simplexcorner_x4(&r, 4, 0.5f, n, d[c], g);
+    }
+    return noise_output_x4(&r, 60.0f, dx, dy, dz, dw);
+}
+
+/********************
+ * Fractal noise
+ ********************/
+
+/**
+ * Evaluate 2D noise description of 4 points
+ * @param dx, dy: partial derivatives, can be NULL
+ */
+__vmath__ vfloat4_t noise_eval2_x4(const noise_desc_t* desc, vfloat4_t x, vfloat4_t y, vfloat4_t* dx, vfloat4_t* dy)
+{
+    const int octaves = desc->fractal == NOISE_FRACTAL_NONE ? 1 : desc->octaves;
+
+    vfloat4_t sum = vfloat4_zero(), sx = sum, sy = sum;
+    float freq = desc->frequency, amp = 1.0f, norm = 0.0f;
+    int o;
+    for (o = 0; o < octaves; o++)
+    {
+        const vfloat4_t f = vfloat4_set1(freq);
+        vfloat4_t n, nx, ny;
+        switch (desc->basis)
+        {
+        case NOISE_SIMPLEX: n = noise_simplex2_x4(vfloat4_mul(x, f), vfloat4_mul(y, f), desc->seed + o, &nx, &ny); break;
+        case NOISE_VALUE:   n = noise_value2_x4(vfloat4_mul(x, f), vfloat4_mul(y, f), desc->seed + o, &nx, &ny);   break;
+        default:            n = noise_perlin2_x4(vfloat4_mul(x, f), vfloat4_mul(y, f), desc->seed + o, &nx, &ny);  break;
+        }
+
+        if (desc->fractal == NOISE_FRACTAL_RIDGED)
+        {
+            /* equation: (1 - |n|)^2, d = -2 * (1 - |n|) * sign(n) * dn */
+            const vfloat4_t r  = vfloat4_sub(vfloat4_set1(1.0f), vfloat4_abs(n));
+            const vfloat4_t k  = vfloat4_xor(vfloat4_mul(r, vfloat4_set1(-2.0f)), vfloat4_and(n, vfloat4_set1(-0.0f)));
+            nx = vfloat4_mul(k, nx);
+            ny = vfloat4_mul(k, ny);
+            n  = vfloat4_mul(r, r);
+        }
+
+        sum = vfloat4_madd(vfloat4_set1(amp), n, sum);
+        sx  = vfloat4_madd(vfloat4_set1(amp * freq), nx, sx);
+        sy  = vfloat4_madd(vfloat4_set1(amp * freq), ny, sy);
+
+        norm += amp;
+        amp  *= desc->gain;
+        freq *= desc->lacunarity;
+    }
+
+    const vfloat4_t inv = vfloat4_set1(1.0f / norm);
+    if (dx) *dx = vfloat4_mul(sx, inv);
+    if (dy) *dy = vfloat4_mul(sy, inv);
+    return vfloat4_mul(sum, inv);
+}
+
+/**
+ * Evaluate 3D noise description of 4 points
+ * @param dx, dy, dz: partial derivatives, can be NULL
+ */
+__vmath__ vfloat4_t noise_eval3_x4(const noise_desc_t* desc, vfloat4_t x, vfloat4_t y, vfloat4_t z,
+                                   vfloat4_t* dx, vfloat4_t* dy, vfloat4_t* dz)
+{
+    const int octaves = desc->fractal == NOISE_FRACTAL_NONE ? 1 : desc->octaves;
+
+    vfloat4_t sum = vfloat4_zero(), sx = sum, sy = sum, sz = sum;
+    float freq = desc->frequency, amp = 1.0f, norm = 0.0f;
+    int o;
+    for (o = 0; o < octaves; o++)
+    {
+        const vfloat4_t f  = vfloat4_set1(freq);
+        const vfloat4_t px = vfloat4_mul(x, f);
+        const vfloat4_t py = vfloat4_mul(y, f);
+        const vfloat4_t pz = vfloat4_mul(z, f);
+        vfloat4_t n, nx, ny, nz;
+        switch (desc->basis)
+        {
+        case NOISE_SIMPLEX: n = noise_simplex3_x4(px, py, pz, desc->seed + o, &nx, &ny, &nz); break;
+        case NOISE_VALUE:   n = noise_value3_x4(px, py, pz, desc->seed + o, &nx, &ny, &nz);   break;
+        default:            n = noise_perlin3_x4(px, py, pz, desc->seed + o, &nx, &ny, &nz);  break;
+        }
+
+        if (desc->fractal == NOISE_FRACTAL_RIDGED)
+        {
+            const vfloat4_t r  = vfloat4_sub(vfloat4_set1(1.0f), vfloat4_abs(n));
+            const vfloat4_t k  = vfloat4_xor(vfloat4_mul(r, vfloat4_set1(-2.0f)), vfloat4_and(n, vfloat4_set1(-0.0f)));
+            nx = vfloat4_mul(k, nx);
+            ny = vfloat4_mul(k, ny);
+            nz = vfloat4_mul(k, nz);
+            n  = vfloat4_mul(r, r);
+        }
+
+        sum = vfloat4_madd(vfloat4_set1(amp), n, sum);
+        sx  = vfloat4_madd(vfloat4_set1(amp * freq), nx, sx);
+        sy  = vfloat4_madd(vfloat4_set1(amp * freq), ny, sy);
+        sz  = vfloat4_madd(vfloat4_set1(amp * freq), nz, sz);
+
+        norm += amp;
+        amp  *= desc->gain;
+        freq *= desc->lacunarity;
+    }
+
+    const vfloat4_t inv = vfloat4_set1(1.0f / norm);
+    if (dx) *dx = vfloat4_mul(sx, inv);
+    if (dy) *dy = vfloat4_mul(sy, inv);
+    if (dz) *dz = vfloat4_mul(sz, inv);
+    return vfloat4_mul(sum, inv);
+}
+
+/**
+ * Evaluate 4D noise description of 4 points
+ * @param dx, dy, dz, dw: partial derivatives, can be NULL
+ */
+__vmath__ vfloat4_t noise_eval4_x4(const noise_desc_t* desc, vfloat4_t x, vfloat4_t y, vfloat4_t z, vfloat4_t w,
+                                   vfloat4_t* dx, vfloat4_t* dy, vfloat4_t* dz, vfloat4_t* dw)
+{
+    const int octaves = desc->fractal == NOISE_FRACTAL_NONE ? 1 : desc->octaves;
+
+    vfloat4_t sum = vfloat4_zero(), sx = sum, sy = sum, sz = sum, sw = sum;
+    float freq = desc->frequency, amp = 1.0f, norm = 0.0f;
+    int o;
+    for (o = 0; o < octaves; o++)
+    {
+        const vfloat4_t f  = vfloat4_set1(freq);
+        const vfloat4_t px = vfloat4_mul(x, f);
+        const vfloat4_t py = vfloat4_mul(y, f);
+        const vfloat4_t pz = vfloat4_mul(z, f);
+        const vfloat4_t pw = vfloat4_mul(w, f);
+        vfloat4_t n, nx, ny, nz, nw;
+        switch (desc->basis)
+        {
+        case NOISE_SIMPLEX: n = noise_simplex4_x4(px, py, pz, pw, desc->seed + o, &nx, &ny, &nz, &nw); break;
+        case NOISE_VALUE:   n = noise_value4_x4(px, py, pz, pw, desc->seed + o, &nx, &ny, &nz, &nw);   break;
+        default:            n = noise_perlin4_x4(px, py, pz, pw, desc->seed + o, &nx, &ny, &nz, &nw);  break;
+        }
+
+        if (desc->fractal == NOISE_FRACTAL_RIDGED)
+        {
+            const vfloat4_t r  = vfloat4_sub(vfloat4_set1(1.0f), vfloat4_abs(n));
+            const vfloat4_t k  = vfloat4_xor(vfloat4_mul(r, vfloat4_set1(-2.0f)), vfloat4_and(n, vfloat4_set1(-0.0f)));
+            nx = vfloat4_mul(k, nx);
+            ny = vfloat4_mul(k, ny);
+            nz = vfloat4_mul(k, nz);
+            nw = vfloat4_mul(k, nw);
+            n  = vfloat4_mul(r, r);
+        }
+
+        sum = vfloat4_madd(vfloat4_set1(amp), n, sum);
+        sx  = vfloat4_madd(vfloat4_set1(amp * freq), nx, sx);
+        sy  = vfloat4_madd(vfloat4_set1(amp * freq), ny, sy);
+        sz  = vfloat4_madd(vfloat4_set1(amp * freq), nz, sz);
+        sw  = vfloat4_madd(vfloat4_set1(amp * freq), nw, sw);
+
+        norm += amp;
+        amp  *= desc->gain;
+        freq *= desc->lacunarity;
+    }
+
+    const vfloat4_t inv = vfloat4_set1(1.0f / norm);
+    if (dx) *dx = vfloat4_mul(sx, inv);
+    if (dy) *dy = vfloat4_mul(sy, inv);
+    if (dz) *dz = vfloat4_mul(sz, inv);
+    if (dw) *dw = vfloat4_mul(sw, inv);
+    return vfloat4_mul(sum, inv);
+}
+
+/********************
+ * Batch over SoA arrays
+ * 8 points per iteration (two independent 4-lane streams), remainder
+ * is padded into one 4-lane step
+ ********************/
+
+/**
+ * Evaluate 2D noise of count points
+ * @param out_dx, out_dy: partial derivatives, each can be NULL
+ */
+__vmath_batch__ void noise_batch2(const noise_desc_t* desc, float* out, const float* x, const float* y, int count,
+                                  float* out_dx, float* out_dy)
+{
+    int i = 0;
+    if (out_dx || out_dy)
+    {
+        for (; i + 8 <= count; i += 8)
+        {
+            vfloat4_t dx0, dy0, dx1, dy1;
+            const vfloat4_t n0 = noise_eval2_x4(desc, vfloat4_load(x + i),     vfloat4_load(y + i),     &dx0, &dy0);
+            const vfloat4_t n1 = noise_eval2_x4(desc, vfloat4_load(x + i + 4), vfloat4_load(y + i + 4), &dx1, &dy1);
+            vfloat4_store(out + i, n0);        vfloat4_store(out + i + 4, n1);
+            if (out_dx) { vfloat4_store(out_dx + i, dx0); vfloat4_store(out_dx + i + 4, dx1); }
+            if (out_dy) { vfloat4_store(out_dy + i, dy0); vfloat4_store(out_dy + i + 4, dy1); }
+        }
+        for (; i < count; i += 4)
+        {
+            const int n = count - i < 4 ? count - i : 4;
+            vfloat4_t dx0, dy0;
+            vfloat4_storen(out + i, noise_eval2_x4(desc, vfloat4_loadn(x + i, n), vfloat4_loadn(y + i, n), &dx0, &dy0), n);
+            if (out_dx) vfloat4_storen(out_dx + i, dx0, n);
+            if (out_dy) vfloat4_storen(out_dy + i, dy0, n);
+        }
+    }
+    else
+    {
+        for (; i + 8 <= count; i += 8)
+        {
+            const vfloat4_t n0 = noise_eval2_x4(desc, vfloat4_load(x + i),     vfloat4_load(y + i),     NULL, NULL);
+            const vfloat4_t n1 = noise_eval2_x4(desc, vfloat4_load(x + i + 4), vfloat4_load(y + i + 4), NULL, NULL);
+            vfloat4_store(out + i, n0);
+            vfloat4_store(out + i + 4, n1);
+        }
+        for (; i < count; i += 4)
+        {
+            const int n = count - i < 4 ? count - i : 4;
+            vfloat4_storen(out + i, noise_eval2_x4(desc, vfloat4_loadn(x + i, n), vfloat4_loadn(y + i, n), NULL, NULL), n);
+        }
+    }
+}
+
+/**
+ * Evaluate 3D noise of count points
+ * @param out_dx, out_dy, out_dz: partial derivatives, each can be NULL
+ */
+__vmath_batch__ void noise_batch3(const noise_desc_t* desc, float* out, const float* x, const float* y, const float* z, int count,
+                                  float* out_dx, float* out_dy, float* out_dz)
+{
+    int i = 0;
+    if (out_dx || out_dy || out_dz)
+    {
+        for (; i + 8 <= count; i += 8)
+        {
+            vfloat4_t dx0, dy0, dz0, dx1, dy1, dz1;
+            const vfloat4_t n0 = noise_eval3_x4(desc, vfloat4_load(x + i),     vfloat4_load(y + i),     vfloat4_load(z + i),     &dx0, &dy0, &dz0);
+            const vfloat4_t n1 = noise_eval3_x4(desc, vfloat4_load(x + i + 4), vfloat4_load(y + i + 4), vfloat4_load(z + i + 4), &dx1, &dy1, &dz1);
+            vfloat4_store(out + i, n0);        vfloat4_store(out + i + 4, n1);
+            if (out_dx) { vfloat4_store(out_dx + i, dx0); vfloat4_store(out_dx + i + 4, dx1); }
+            if (out_dy) { vfloat4_store(out_dy + i, dy0); vfloat4_store(out_dy + i + 4, dy1); }
+            if (out_dz) { vfloat4_store(out_dz + i, dz0); vfloat4_store(out_dz + i + 4, dz1); }
+        }
+        for (; i < count; i += 4)
+        {
+            const int n = count - i < 4 ? count - i : 4;
+            vfloat4_t dx0, dy0, dz0;
+            vfloat4_storen(out + i, noise_eval3_x4(desc, vfloat4_loadn(x + i, n), vfloat4_loadn(y + i, n), vfloat4_loadn(z + i, n),
+                                                   &dx0, &dy0, &dz0), n);
+            if (out_dx) vfloat4_storen(out_dx + i, dx0, n);
+            if (out_dy) vfloat4_storen(out_dy + i, dy0, n);
+            if (out_dz) vfloat4_storen(out_dz + i, dz0, n);
+        }
+    }
+    else
+    {
+        for (; i + 8 <= count; i += 8)
+        {
+            const vfloat4_t n0 = noise_eval3_x4(desc, vfloat4_load(x + i),     vfloat4_load(y + i),     vfloat4_load(z + i),     NULL, NULL, NULL);
+            const vfloat4_t n1 = noise_eval3_x4(desc, vfloat4_load(x + i + 4), vfloat4_load(y + i + 4), vfloat4_load(z + i + 4), NULL, NULL, NULL);
+            vfloat4_store(out + i, n0);
+            vfloat4_store(out + i + 4, n1);
+        }
+        for (; i < count; i += 4)
+        {
+            const int n = count - i < 4 ? count - i : 4;
+            vfloat4_storen(out + i, noise_eval3_x4(desc, vfloat4_loadn(x + i, n), vfloat4_loadn(y + i, n), vfloat4_loadn(z + i, n),
+                                                   NULL, NULL, NULL), n);
+        }
+    }
+}
+
+/**
+ * Evaluate 4D noise of count points
+ * @param out_dx, out_dy, out_dz, out_dw: partial derivatives, each can be NULL
+ */
+__vmath_batch__ void noise_batch4(const noise_desc_t* desc, float* out,
+                                  const float* x, const float* y, const float* z, const float* w, int count,
+                                  float* out_dx, float* out_dy, float* out_dz, float* out_dw)
+{
+    int i = 0;
+    if (out_dx || out_dy || out_dz || out_dw)
+    {
+        for (; i + 8 <= count; i += 8)
+        {
+            vfloat4_t dx0, dy0, dz0, dw0, dx1, dy1, dz1, dw1;
+            const vfloat4_t n0 = noise_eval4_x4(desc, vfloat4_load(x + i), vfloat4_load(y + i), vfloat4_load(z + i), vfloat4_load(w + i),
+                                                &dx0, &dy0, &dz0, &dw0);
+            const vfloat4_t n1 = noise_eval4_x4(desc, vfloat4_load(x + i + 4), vfloat4_load(y + i + 4), vfloat4_load(z + i + 4), vfloat4_load(w + i + 4),
+                                                &dx1, &dy1, &dz1, &dw1);
+            vfloat4_store(out + i, n0);        vfloat4_store(out + i + 4, n1);
+            if (out_dx) { vfloat4_store(out_dx + i, dx0); vfloat4_store(out_dx + i + 4, dx1); }
+            if (out_dy) { vfloat4_store(out_dy + i, dy0); vfloat4_store(out_dy + i + 4, dy1); }
+            if (out_dz) { vfloat4_store(out_dz + i, dz0); vfloat4_store(out_dz + i + 4, dz1); }
+            if (out_dw) { vfloat4_store(out_dw + i, dw0); vfloat4_store(out_dw + i + 4, dw1); }
+        }
+        for (; i < count; i += 4)
+        {
+            const int n = count - i < 4 ? count - i : 4;
+            vfloat4_t dx0, dy0, dz0, dw0;
+            vfloat4_storen(out + i, noise_eval4_x4(desc, vfloat4_loadn(x + i, n), vfloat4_loadn(y + i, n),
+                                                   vfloat4_loadn(z + i, n), vfloat4_loadn(w + i, n),
+                                                   &dx0, &dy0, &dz0, &dw0), n);
+            if (out_dx) vfloat4_storen(out_dx + i, dx0, n);
+            if (out_dy) vfloat4_storen(out_dy + i, dy0, n);
+            if (out_dz) vfloat4_storen(out_dz + i, dz0, n);
+            if (out_dw) vfloat4_storen(out_dw + i, dw0, n);
+        }
+    }
+    else
+    {
+        for (; i + 8 <= count; i += 8)
+        {
+            const vfloat4_t n0 = noise_eval4_x4(desc, vfloat4_load(x + i), vfloat4_load(y + i), vfloat4_load(z + i), vfloat4_load(w + i),
+                                                NULL, NULL, NULL, NULL);
+            const vfloat4_t n1 = noise_eval4_x4(desc, vfloat4_load(x + i + 4), vfloat4_load(y + i + 4), vfloat4_load(z + i + 4), vfloat4_load(w + i + 4),
+                                                NULL, NULL, NULL, NULL);
+            vfloat4_store(out + i, n0);
+            vfloat4_store(out + i + 4, n1);
+        }
+        for (; i < count; i += 4)
+        {
+            const int n = count - i < 4 ? count - i : 4;
+            vfloat4_storen(out + i, noise_eval4_x4(desc, vfloat4_loadn(x + i, n), vfloat4_loadn(y + i, n),
+                                                   vfloat4_loadn(z + i, n), vfloat4_loadn(w + i, n),
+                                                   NULL, NULL, NULL, NULL), n);
+        }
+    }
+}
+
+/********************
+ * Single point, same results as the lanes
+ ********************/
+
+/**
+ * 2D noise at a point
+ * @param grad: gradient of noise at the point, can be NULL
+ */
+__vmath__ float noise2(const noise_desc_t* desc, vec2_arg_t p, vec2_t* grad)
+{
+    vfloat4_t dx, dy;
+    const vfloat4_t n = noise_eval2_x4(desc, vfloat4_set1(p.x), vfloat4_set1(p.y), &dx, &dy);
+    if (grad)
+    {
+        *grad = vec2(vfloat4_get(dx, 0), vfloat4_get(dy, 0));
+    }
+    return vfloat4_get(n, 0);
+}
+
+/**
+ * 3D noise at a point
+ * @param grad: gradient of noise at the point, can be NULL
+ */
+__vmath__ float noise3(const noise_desc_t* desc, vec3_arg_t p, vec3_t* grad)
+{
+    vfloat4_t dx, dy, dz;
+    const vfloat4_t n = noise_eval3_x4(desc, vfloat4_set1(p.x), vfloat4_set1(p.y), vfloat4_set1(p.z), &dx, &dy, &dz);
+    if (grad)
+    {
+        *grad = vec3(vfloat4_get(dx, 0), vfloat4_get(dy, 0), vfloat4_get(dz, 0));
+    }
+    return vfloat4_get(n, 0);
+}
+
+/**
+ * 4D noise at a point
+ * @param grad: gradient of noise at the point, can be NULL
+ */
+__vmath__ float noise4(const noise_desc_t* desc, vec4_arg_t p, vec4_t* grad)
+{
+    vfloat4_t dx, dy, dz, dw;
+    const vfloat4_t n = noise_eval4_x4(desc, vfloat4_set1(p.x), vfloat4_set1(p.y), vfloat4_set1(p.z), vfloat4_set1(p.w),
+                                       &dx, &dy, &dz, &dw);
+    if (grad)
+    {
+        *grad = vec4(vfloat4_get(dx, 0), vfloat4_get(dy, 0), vfloat4_get(dz, 0), vfloat4_get(dw, 0));
+    }
+    return vfloat4_get(n, 0);
+}
+
+/**
+ * Perlin noise at a point
+ */
+__vmath__ float noise_perlin2(vec2_arg_t p)
+{
+    return vfloat4_get(noise_perlin2_x4(vfloat4_set1(p.x), vfloat4_set1(p.y), 0, NULL, NULL), 0);
+}
+
+__vmath__ float noise_perlin3(vec3_arg_t p)
+{
+    return vfloat4_get(noise_perlin3_x4(vfloat4_set1(p.x), vfloat4_set1(p.y), vfloat4_set1(p.z), 0, NULL, NULL, NULL), 0);
+}
+
+__vmath__ float noise_perlin4(vec4_arg_t p)
+{
+    return vfloat4_get(noise_perlin4_x4(vfloat4_set1(p.x), vfloat4_set1(p.y), vfloat4_set1(p.z), vfloat4_set1(p.w),
+                                        0, NULL, NULL, NULL, NULL), 0);
+}
+
+/**
+ * Simplex noise at a point
+ */
+__vmath__ float noise_simplex2(vec2_arg_t p)
+{
+    return vfloat4_get(noise_simplex2_x4(vfloat4_set1(p.x), vfloat4_set1(p.y), 0, NULL, NULL), 0);
+}
+
+__vmath__ float noise_simplex3(vec3_arg_t p)
+{
+    return vfloat4_get(noise_simplex3_x4(vfloat4_set1(p.x), vfloat4_set1(p.y), vfloat4_set1(p.z), 0, NULL, NULL, NULL), 0);
+}
+
+__vmath__ float noise_simplex4(vec4_arg_t p)
+{
+    return vfloat4_get(noise_simplex4_x4(vfloat4_set1(p.x), vfloat4_set1(p.y), vfloat4_set1(p.z), vfloat4_set1(p.w),
+                                         0, NULL, NULL, NULL, NULL), 0);
+}
+
+#endif /* __VMATH_NOISE_H__ */
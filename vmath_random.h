@@ -0,0 +1,520 @@
+/******************************************************
+ * vmath_random - Vectorized random streams and sampling
+ *
+ * @author: MaiHD
+ * @license: NULL
+ * @copyright: MaiHD @ ${HOME}, 2017 - 2018
+ ******************************************************/
+
+#ifndef __VMATH_RANDOM_H__
+#define __VMATH_RANDOM_H__
+
+#include "vmath_soa.h"
+
+/**
+ * xoshiro128+ generators, one per lane.
+ * Lanes of a stream are 2^64 steps apart, split streams are 2^96 steps apart,
+ * so they never overlap in practice. Same seed give same numbers on every
+ * backend (see vmath_soa.h).
+ */
+
+/**
+ * 4 generators in lanes
+ */
+typedef struct vmath_random_x4
+{
+    vint4_t s[4];
+} random_x4_t;
+
+/**
+ * Random stream: 8 generators, as two groups of 4 lanes
+ */
+typedef struct vmath_random
+{
+    random_x4_t lanes[2];
+} random_t;
+
+/**************************
+ * Generators
+ **************************/
+
+/**
+ * Next 32 bits random of each lane
+ * @note: low bits are weaker, use high bits
+ */
+__vmath__ vint4_t random_x4_next(random_x4_t* r)
+{
+    const vint4_t result = vint4_add(r->s[0], r->s[3]);
+    const vint4_t t      = vint4_sll(r->s[1], 9);
+
+    r->s[2] = vint4_xor(r->s[2], r->s[0]);
+    r->s[3] = vint4_xor(r->s[3], r->s[1]);
+    r->s[1] = vint4_xor(r->s[1], r->s[2]);
+    r->s[0] = vint4_xor(r->s[0], r->s[3]);
+    r->s[2] = vint4_xor(r->s[2], t);
+    r->s[3] = vint4_or(vint4_sll(r->s[3], 11), vint4_srl(r->s[3], 21));
+    return result;
+}
+
+/**
+ * Advance every lane by a jump polynomial
+ */
+__vmath__ void random_x4_jumpby(random_x4_t* r, const unsigned int poly[4])
+{
+    vint4_t t0 = vint4_set1(0), t1 = t0, t2 = t0, t3 = t0;
+    int i, b;
+    for (i = 0; i < 4; i++)
+    {
+        for (b = 0; b < 32; b++)
+        {
+            if (poly[i] & (1u << b))
+            {
+                t0 = vint4_xor(t0, r->s[0]);
+                t1 = vint4_xor(t1, r->s[1]);
+                t2 = vint4_xor(t2, r->s[2]);
+                t3 = vint4_xor(t3, r->s[3]);
+            }
+            random_x4_next(r);
+        }
+    }
+
+    r->s[0] = t0;
+    r->s[1] = t1;
+    r->s[2] = t2;
+    r->s[3] = t3;
+}
+
+/**
+ * Advance every lane by 2^64 steps
+ */
+__vmath__ void random_x4_jump(random_x4_t* r)
+{
+    static const unsigned int poly[4] = { 0x8764000bu, 0xf542d2d3u, 0x6fa035c3u, 0x77f2db5bu };
+    random_x4_jumpby(r, poly);
+}
+
+/**
+ * Advance every lane by 2^96 steps
+ */
+__vmath__ void random_x4_longjump(random_x4_t* r)
+{
+    static const unsigned int poly[4] = { 0xb523952eu, 0x0b6f099fu, 0xccf5a0efu, 0x1c580662u };
+    random_x4_jumpby(r, poly);
+}
+
+/**
+ * Create random stream from seed
+ */
+__vmath__ random_t random_seed(unsigned int seed)
+{
+    random_t r;
+    int i, g, k;
+
+    /* Base state from the seed, hashed with lowbias32 */
+    for (i = 0; i < 4; i++)
+    {
+        unsigned int h = seed + (unsigned int)(i + 1) * 0x9e3779b9u;
+        h ^= h >> 16; h *= 0x7feb352du;
+        h ^= h >> 15; h *= 0x846ca68bu;
+        h ^= h >> 16;
+        r.lanes[0].s[i] = r.lanes[1].s[i] = vint4_set1((int)h);
+    }
+
+    /* Lane k is the base state jumped k times */
+    for (g = 0; g < 2; g++)
+    {
+        for (k = 1; k < 8; k++)
+        {
+            random_x4_t   jumped = r.lanes[g];
+            const vint4_t mask   = vint4_cmplt(vint4_set(4 * g - k, 4 * g + 1 - k, 4 * g + 2 - k, 4 * g + 3 - k), vint4_set1(0));
+            random_x4_jump(&jumped);
+            for (i = 0; i < 4; i++)
+            {
+                /* Lanes which index >= k take the jumped state */
+                r.lanes[g].s[i] = vint4_xor(jumped.s[i], vint4_and(mask, vint4_xor(jumped.s[i], r.lanes[g].s[i])));
+            }
+        }
+    }
+    return r;
+}
+
+/**
+ * Split a stream for another thread, the stream continue 2^96 steps later
+ */
+__vmath__ random_t random_split(random_t* r)
+{
+    const random_t result = *r;
+    random_x4_longjump(&r->lanes[0]);
+    random_x4_longjump(&r->lanes[1]);
+    return result;
+}
+
+/**************************
+ * Distributions of lanes
+ **************************/
+
+/**
+ * Uniform float in [0, 1)
+ */
+__vmath__ vfloat4_t random_x4_float(random_x4_t* r)
+{
+    const vint4_t bits = vint4_srl(random_x4_next(r), 8);
+    return vfloat4_mul(vint4_tofloat(bits), vfloat4_set1(1.0f / 16777216.0f));
+}
+
+/**
+ * Uniform float in [min, max)
+ */
+__vmath__ vfloat4_t random_x4_range(random_x4_t* r, float min, float max)
+{
+    return vfloat4_madd(random_x4_float(r), vfloat4_set1(max - min), vfloat4_set1(min));
+}
+
+/**
+ * Uniform angle in [0, 2pi), as cosine and sine
+ */
+__vmath__ void random_x4_angle(random_x4_t* r, vfloat4_t* c, vfloat4_t* s)
+{
+    vfloat4_sincos(vfloat4_mul(random_x4_float(r), vfloat4_set1(6.28318530718f)), s, c);
+}
+
+/**
+ * Uniform point in unit disk
+ */
+__vmath__ void random_x4_disk(random_x4_t* r, vfloat4_t* x, vfloat4_t* y)
+{
+    vfloat4_t c, s;
+    const vfloat4_t radius = vfloat4_sqrt(random_x4_float(r));
+    random_x4_angle(r, &c, &s);
+    *x = vfloat4_mul(radius, c);
+    *y = vfloat4_mul(radius, s);
+}
+
+/**
+ * Uniform point on unit sphere
+ */
+__vmath__ void random_x4_sphere(random_x4_t* r, vfloat4_t* x, vfloat4_t* y, vfloat4_t* z)
+{
+    vfloat4_t c, s;
+    const vfloat4_t h      = vfloat4_nmadd(random_x4_float(r), vfloat4_set1(2.0f), vfloat4_set1(1.0f));
+    const vfloat4_t radius = vfloat4_sqrt(vfloat4_max(vfloat4_nmadd(h, h, vfloat4_set1(1.0f)), vfloat4_zero()));
+    random_x4_angle(r, &c, &s);
+    *x = vfloat4_mul(radius, c);
+    *y = vfloat4_mul(radius, s);
+    *z = h;
+}
+
+/**
+ * Uniform point in unit ball
+ * @note: max of 3 uniforms has the density 3r^2 of the radius, no cbrt needed
+ */
+__vmath__ void random_x4_ball(random_x4_t* r, vfloat4_t* x, vfloat4_t* y, vfloat4_t* z)
+{
+    vfloat4_t radius = random_x4_float(r);
+    radius = vfloat4_max(radius, random_x4_float(r));
+    radius = vfloat4_max(radius, random_x4_float(r));
+
+    random_x4_sphere(r, x, y, z);
+    *x = vfloat4_mul(*x, radius);
+    *y = vfloat4_mul(*y, radius);
+    *z = vfloat4_mul(*z, radius);
+}
+
+/**
+ * Uniform direction in a cone around +z
+ * @param cosangle: cosine of the cone half angle
+ */
+__vmath__ void random_x4_cone(random_x4_t* r, float cosangle, vfloat4_t* x, vfloat4_t* y, vfloat4_t* z)
+{
+    vfloat4_t c, s;
+    const vfloat4_t h      = vfloat4_nmadd(random_x4_float(r), vfloat4_set1(1.0f - cosangle), vfloat4_set1(1.0f));
+    const vfloat4_t radius = vfloat4_sqrt(vfloat4_max(vfloat4_nmadd(h, h, vfloat4_set1(1.0f)), vfloat4_zero()));
+    random_x4_angle(r, &c, &s);
+    *x = vfloat4_mul(radius, c);
+    *y = vfloat4_mul(radius, s);
+    *z = h;
+}
+
+/**
+ * Cosine weighted direction on hemisphere around +z
+ */
+__vmath__ void random_x4_hemisphere(random_x4_t* r, vfloat4_t* x, vfloat4_t* y, vfloat4_t* z)
+{
+    vfloat4_t c, s;
+    const vfloat4_t u      = random_x4_float(r);
+    const vfloat4_t radius = vfloat4_sqrt(u);
+    random_x4_angle(r, &c, &s);
+    *x = vfloat4_mul(radius, c);
+    *y = vfloat4_mul(radius, s);
+    *z = vfloat4_sqrt(vfloat4_sub(vfloat4_set1(1.0f), u));
+}
+
+/**
+ * Uniform unit quaternion (Shoemake)
+ */
+__vmath__ void random_x4_quat(random_x4_t* r, vfloat4_t* x, vfloat4_t* y, vfloat4_t* z, vfloat4_t* w)
+{
+    vfloat4_t c1, s1, c2, s2;
+    const vfloat4_t u  = random_x4_float(r);
+    const vfloat4_t r1 = vfloat4_sqrt(vfloat4_sub(vfloat4_set1(1.0f), u));
+    const vfloat4_t r2 = vfloat4_sqrt(u);
+    random_x4_angle(r, &c1, &s1);
+    random_x4_angle(r, &c2, &s2);
+    *x = vfloat4_mul(r1, s1);
+    *y = vfloat4_mul(r1, c1);
+    *z = vfloat4_mul(r2, s2);
+    *w = vfloat4_mul(r2, c2);
+}
+
+/**************************
+ * Fill arrays
+ * 8 samples per iteration from the two lane groups
+ **************************/
+
+/**
+ * Orthonormal basis around a unit axis (Duff et al.), so local +z map to axis
+ */
+__vmath__ void random_basis(vec3_arg_t n, vec3_t* b1, vec3_t* b2)
+{
+    const float sign = n.z >= 0.0f ? 1.0f : -1.0f;
+    const float a    = -1.0f / (sign + n.z);
+    const float b    = n.x * n.y * a;
+    *b1 = vec3(1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x);
+    *b2 = vec3(b, sign + n.y * n.y * a, -n.y);
+}
+
+/**
+ * Transform local directions of lanes to the basis (b1, b2, n)
+ */
+__vmath__ void random_x4_tobasis(vec3_arg_t b1, vec3_arg_t b2, vec3_arg_t n, vfloat4_t* x, vfloat4_t* y, vfloat4_t* z)
+{
+    const vfloat4_t lx = *x, ly = *y, lz = *z;
+    *x = vfloat4_madd(lx, vfloat4_set1(b1.x), vfloat4_madd(ly, vfloat4_set1(b2.x), vfloat4_mul(lz, vfloat4_set1(n.x))));
+    *y = vfloat4_madd(lx, vfloat4_set1(b1.y), vfloat4_madd(ly, vfloat4_set1(b2.y), vfloat4_mul(lz, vfloat4_set1(n.y))));
+    *z = vfloat4_madd(lx, vfloat4_set1(b1.z), vfloat4_madd(ly, vfloat4_set1(b2.z), vfloat4_mul(lz, vfloat4_set1(n.z))));
+}
+
+/**
+ * Store the part of lanes which is in range of the array
+ */
+__vmath__ void random_storen(float* ptr, int index, int count, vfloat4_t v)
+{
+    if (index + 4 <= count)
+    {
+        vfloat4_store(ptr + index, v);
+    }
+    else if (index < count)
+    {
+        vfloat4_storen(ptr + index, v, count - index);
+    }
+}
+
+/**
+ * Uniform floats in [min, max)
+ */
+__vmath_batch__ void random_fill_float(random_t* r, float* out, int count, float min, float max)
+{
+    int i;
+    for (i = 0; i < count; i += 8)
+    {
+        const vfloat4_t v0 = random_x4_range(&r->lanes[0], min, max);
+        const vfloat4_t v1 = random_x4_range(&r->lanes[1], min, max);
+        random_storen(out, i,     count, v0);
+        random_storen(out, i + 4, count, v1);
+    }
+}
+
+/**
+ * Uniform points in disk, SoA
+ */
+__vmath_batch__ void random_fill_disk_soa(random_t* r, float* x, float* y, int count, float radius)
+{
+    int i, g;
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = 0; g < 2; g++)
+        {
+            vfloat4_t vx, vy;
+            random_x4_disk(&r->lanes[g], &vx, &vy);
+            random_storen(x, i + 4 * g, count, vfloat4_mul(vx, vfloat4_set1(radius)));
+            random_storen(y, i + 4 * g, count, vfloat4_mul(vy, vfloat4_set1(radius)));
+        }
+    }
+}
+
+/**
+ * Uniform points in disk, AoS
+ */
+__vmath_batch__ void random_fill_disk(random_t* r, vec2_t* out, int count, float radius)
+{
+    int i, g, k;
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = 0; g < 2; g++)
+        {
+            float x[4], y[4];
+            vfloat4_t vx, vy;
+            random_x4_disk(&r->lanes[g], &vx, &vy);
+            vfloat4_store(x, vfloat4_mul(vx, vfloat4_set1(radius)));
+            vfloat4_store(y, vfloat4_mul(vy, vfloat4_set1(radius)));
+            for (k = 0; k < 4 && i + 4 * g + k < count; k++)
+            {
+                out[i + 4 * g + k] = vec2(x[k], y[k]);
+            }
+        }
+    }
+}
+
+/* Sampler kind of random_fill3 */
+#define RANDOM_SPHERE       0
+#define RANDOM_BALL         1
+#define RANDOM_CONE         2
+#define RANDOM_HEMISPHERE   3
+
+/**
+ * Sample 4 directions or points of a kind, in world space
+ */
+__vmath__ void random_x4_sample3(random_x4_t* r, int kind, float cosangle,
+                                 vec3_arg_t b1, vec3_arg_t b2, vec3_arg_t axis,
+                                 vfloat4_t* x, vfloat4_t* y, vfloat4_t* z)
+{
+    switch (kind)
+    {
+    case RANDOM_BALL:
+        random_x4_ball(r, x, y, z);
+        break;
+
+    case RANDOM_CONE:
+        random_x4_cone(r, cosangle, x, y, z);
+        random_x4_tobasis(b1, b2, axis, x, y, z);
+        break;
+
+    case RANDOM_HEMISPHERE:
+        random_x4_hemisphere(r, x, y, z);
+        random_x4_tobasis(b1, b2, axis, x, y, z);
+        break;
+
+    default:
+        random_x4_sphere(r, x, y, z);
+        break;
+    }
+}
+
+/**
+ * 3D samples, SoA
+ * @param kind: RANDOM_SPHERE, RANDOM_BALL, RANDOM_CONE, RANDOM_HEMISPHERE
+ * @param axis: unit axis of cone and hemisphere
+ * @param angle: half angle of cone, in radians
+ */
+__vmath_batch__ void random_fill3_soa(random_t* r, float* x, float* y, float* z, int count,
+                                      int kind, vec3_arg_t axis, float angle)
+{
+    const float cosangle = cosf(angle);
+    vec3_t b1, b2;
+    int i, g;
+
+    random_basis(axis, &b1, &b2);
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = 0; g < 2; g++)
+        {
+            vfloat4_t vx, vy, vz;
+            random_x4_sample3(&r->lanes[g], kind, cosangle, b1, b2, axis, &vx, &vy, &vz);
+            random_storen(x, i + 4 * g, count, vx);
+            random_storen(y, i + 4 * g, count, vy);
+            random_storen(z, i + 4 * g, count, vz);
+        }
+    }
+}
+
+/**
+ * 3D samples, AoS
+ * @param kind: RANDOM_SPHERE, RANDOM_BALL, RANDOM_CONE, RANDOM_HEMISPHERE
+ * @param axis: unit axis of cone and hemisphere
+ * @param angle: half angle of cone, in radians
+ */
+__vmath_batch__ void random_fill3(random_t* r, vec3_t* out, int count, int kind, vec3_arg_t axis, float angle)
+{
+    const float cosangle = cosf(angle);
+    vec3_t b1, b2;
+    int i, g, k;
+
+    random_basis(axis, &b1, &b2);
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = 0; g < 2; g++)
+        {
+            float x[4], y[4], z[4];
+            vfloat4_t vx, vy, vz;
+            random_x4_sample3(&r->lanes[g], kind, cosangle, b1, b2, axis, &vx, &vy, &vz);
+            vfloat4_store(x, vx);
+            vfloat4_store(y, vy);
+            vfloat4_store(z, vz);
+            for (k = 0; k < 4 && i + 4 * g + k < count; k++)
+            {
+                out[i + 4 * g + k] = vec3(x[k], y[k], z[k]);
+            }
+        }
+    }
+}
+
+/**
+ * Uniform points on unit sphere
+ */
+__vmath_batch__ void random_fill_sphere(random_t* r, vec3_t* out, int count)
+{
+    random_fill3(r, out, count, RANDOM_SPHERE, vec3(0, 0, 1), 0.0f);
+}
+
+/**
+ * Uniform points in unit ball
+ */
+__vmath_batch__ void random_fill_ball(random_t* r, vec3_t* out, int count)
+{
+    random_fill3(r, out, count, RANDOM_BALL, vec3(0, 0, 1), 0.0f);
+}
+
+/**
+ * Uniform directions in a cone
+ */
+__vmath_batch__ void random_fill_cone(random_t* r, vec3_t* out, int count, vec3_arg_t axis, float angle)
+{
+    random_fill3(r, out, count, RANDOM_CONE, axis, angle);
+}
+
+/**
+ * Cosine weighted directions on hemisphere
+ */
+__vmath_batch__ void random_fill_hemisphere(random_t* r, vec3_t* out, int count, vec3_arg_t normal)
+{
+    random_fill3(r, out, count, RANDOM_HEMISPHERE, normal, 0.0f);
+}
+
+#if VMATH_BUILD_QUAT
+/**
+ * Uniform unit quaternions
+ */
+__vmath_batch__ void random_fill_quat(random_t* r, quat_t* out, int count)
+{
+    int i, g, k;
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = 0; g < 2; g++)
+        {
+            float x[4], y[4], z[4], w[4];
+            vfloat4_t vx, vy, vz, vw;
+            random_x4_quat(&r->lanes[g], &vx, &vy, &vz, &vw);
+            vfloat4_store(x, vx);
+            vfloat4_store(y, vy);
+            vfloat4_store(z, vz);
+            vfloat4_store(w, vw);
+            for (k = 0; k < 4 && i + 4 * g + k < count; k++)
+            {
+                out[i + 4 * g + k] = quat(x[k], y[k], z[k], w[k]);
+            }
+        }
+    }
+}
+#endif
+
+#endif /* __VMATH_RANDOM_H__ */
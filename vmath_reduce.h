@@ -0,0 +1,415 @@
+/******************************************************
+ * vmath_reduce - Single pass reductions of point arrays
+ *
+ * @author: MaiHD
+ * @license: NULL
+ * @copyright: MaiHD @ ${HOME}, 2017 - 2018
+ ******************************************************/
+
+#ifndef __VMATH_REDUCE_H__
+#define __VMATH_REDUCE_H__
+
+#include "vmath.h"
+
+/**
+ * vmath_reduce() read an array of points once and produce the bounds, the
+ * centroid, the covariance and the extreme points of a bounding sphere
+ * together. The sphere is Ritter's: the extreme points along x, y and z
+ * give a first sphere, which a second read grow to hold every point
+ * (5% to 20% bigger than the smallest sphere).
+ *
+ * The points are shifted by the first point before summing, and the sums
+ * of each block of VMATH_REDUCE_BLOCK points are added to Kahan compensated
+ * totals, so the covariance of data far from the origin keep its precision.
+ * Do not build with -ffast-math, which remove the compensation.
+ *
+ * For split and merge (see vmath_reduce_mt in vmath_jobs.h):
+ *     vmath_reduce_begin(&sums[i], points[0]);    same shift for every part
+ *     vmath_reduce_add(&sums[i], part_i, count_i, flags);
+ *     vmath_reduce_merge(&sums[0], &sums[i]);
+ *     vmath_reduce_end(&sums[0], flags, &result);
+ *     vmath_reduce_sphere(part_i, count_i, &center_i, &radius_i);  from result
+ *     vmath_reduce_mergesphere(&result.center, &result.radius, center_i, radius_i);
+ */
+
+#define VMATH_REDUCE_BOUNDS     0x1
+#define VMATH_REDUCE_CENTROID   0x2
+#define VMATH_REDUCE_COVARIANCE 0x4
+#define VMATH_REDUCE_SPHERE     0x8
+#define VMATH_REDUCE_ALL        0xF
+
+/**
+ * Points summed in float before they go to the compensated totals
+ */
+#ifndef VMATH_REDUCE_BLOCK
+#define VMATH_REDUCE_BLOCK 256
+#endif
+
+/**
+ * Partial sums of a part of the points
+ */
+typedef struct vmath_reduce_sums
+{
+    vec3_t ref;             /* Shift of every point                              */
+    vec3_t min, max;
+    vec3_t lo[3], hi[3];    /* Points with the smallest and largest x, y, z      */
+    vec3_t sum,  sum_c;     /* Sum of p - ref, and its Kahan compensation        */
+    vec3_t sq,   sq_c;      /* Sum of xx yy zz of p - ref                        */
+    vec3_t prod, prod_c;    /* Sum of xy yz zx of p - ref                        */
+    int    count;
+} vmath_reduce_sums_t;
+
+/**
+ * Reduction result, members not asked by the flags are not set
+ */
+typedef struct vmath_reduce
+{
+    vec3_t min, max;        /* VMATH_REDUCE_BOUNDS                               */
+    vec3_t centroid;        /* VMATH_REDUCE_CENTROID                             */
+    mat3_t covariance;      /* VMATH_REDUCE_COVARIANCE, divided by count         */
+    vec3_t center;          /* VMATH_REDUCE_SPHERE                               */
+    float  radius;
+} vmath_reduce_t;
+
+/**
+ * Start partial sums, every part of a reduction must use the same ref
+ */
+__vmath__ void vmath_reduce_begin(vmath_reduce_sums_t* sums, vec3_t ref)
+{
+    const vec3_t zero = vec3(0.0f, 0.0f, 0.0f);
+    int i;
+
+    sums->ref = ref;
+    sums->min = vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+    sums->max = vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (i = 0; i < 3; i++)
+    {
+        sums->lo[i] = ref;
+        sums->hi[i] = ref;
+    }
+    sums->sum    = zero;
+    sums->sum_c  = zero;
+    sums->sq     = zero;
+    sums->sq_c   = zero;
+    sums->prod   = zero;
+    sums->prod_c = zero;
+    sums->count  = 0;
+}
+
+/**
+ * Add v to a Kahan compensated sum, the value is sum - c
+ */
+__vmath__ void vmath_reduce_kahan(vec3_t* sum, vec3_t* c, vec3_t v)
+{
+    const vec3_t y = vec3_sub(v, *c);
+    const vec3_t t = vec3_add(*sum, y);
+    *c   = vec3_sub(vec3_sub(t, *sum), y);
+    *sum = t;
+}
+
+/**
+ * Add a block of at most VMATH_REDUCE_BLOCK points, VMATH_REDUCE_COVARIANCE
+ * is a constant at the call sites so the loop without it do not test it
+ */
+__vmath__ void vmath_reduce_block(vmath_reduce_sums_t* sums, const vec3_t* points, int count, int flags)
+{
+    const vec3_t min = sums->min;
+    const vec3_t max = sums->max;
+    vec3_t s, q, p;
+    int    i, k;
+
+#if VMATH_SSE_ENABLE
+    const __m128 ref = sums->ref.data;
+    __m128  mn = sums->min.data, mx = sums->max.data;
+    __m128  vs = _mm_setzero_ps(), vq = _mm_setzero_ps(), vp = _mm_setzero_ps();
+
+    /* 4 points per step, added as a tree so every sum has one dependency per step */
+    for (i = 0; i + 4 <= count; i += 4)
+    {
+        const __m128 a = points[i].data,     b = points[i + 1].data;
+        const __m128 c = points[i + 2].data, d = points[i + 3].data;
+        mn = _mm_min_ps(mn, _mm_min_ps(_mm_min_ps(a, b), _mm_min_ps(c, d)));
+        mx = _mm_max_ps(mx, _mm_max_ps(_mm_max_ps(a, b), _mm_max_ps(c, d)));
+
+        {
+            const __m128 da = _mm_sub_ps(a, ref), db = _mm_sub_ps(b, ref);
+            const __m128 dc = _mm_sub_ps(c, ref), dd = _mm_sub_ps(d, ref);
+            vs = _mm_add_ps(vs, _mm_add_ps(_mm_add_ps(da, db), _mm_add_ps(dc, dd)));
+
+            if (flags & VMATH_REDUCE_COVARIANCE)
+            {
+                const __m128 ya = _mm_shuffle_ps(da, da, _MM_SHUFFLE(3, 0, 2, 1));
+                const __m128 yb = _mm_shuffle_ps(db, db, _MM_SHUFFLE(3, 0, 2, 1));
+                const __m128 yc = _mm_shuffle_ps(dc, dc, _MM_SHUFFLE(3, 0, 2, 1));
+                const __m128 yd = _mm_shuffle_ps(dd, dd, _MM_SHUFFLE(3, 0, 2, 1));
+                vq = _mm_add_ps(vq, _mm_add_ps(_mm_add_ps(_mm_mul_ps(da, da), _mm_mul_ps(db, db)),
+                                               _mm_add_ps(_mm_mul_ps(dc, dc), _mm_mul_ps(dd, dd))));
+                vp = _mm_add_ps(vp, _mm_add_ps(_mm_add_ps(_mm_mul_ps(da, ya), _mm_mul_ps(db, yb)),
+                                               _mm_add_ps(_mm_mul_ps(dc, yc), _mm_mul_ps(dd, yd))));
+            }
+        }
+    }
+
+    sums->min.data = mn;
+    sums->max.data = mx;
+    s.data = vs;
+    q.data = vq;
+    p.data = vp;
+#else
+    s = vec3(0.0f, 0.0f, 0.0f);
+    q = s;
+    p = s;
+    i = 0;
+#endif
+
+    /* Tail, and every point without SSE */
+    for (; i < count; i++)
+    {
+        const vec3_t v = points[i];
+        const vec3_t d = vec3_sub(v, sums->ref);
+
+        sums->min = vec3_min(sums->min, v);
+        sums->max = vec3_max(sums->max, v);
+
+        s = vec3_add(s, d);
+        if (flags & VMATH_REDUCE_COVARIANCE)
+        {
+            q = vec3_add(q, vec3_mul(d, d));
+            p = vec3_add(p, vec3_mul(d, vec3(d.y, d.z, d.x)));
+        }
+    }
+
+    /* The extremes move in few blocks, find their points again there */
+    if (flags & VMATH_REDUCE_SPHERE)
+    {
+        for (k = 0; k < 3; k++)
+        {
+            for (i = 0; sums->min.m[k] < min.m[k] && i < count; i++)
+            {
+                if (points[i].m[k] == sums->min.m[k])
+                {
+                    sums->lo[k] = points[i];
+                    break;
+                }
+            }
+            for (i = 0; sums->max.m[k] > max.m[k] && i < count; i++)
+            {
+                if (points[i].m[k] == sums->max.m[k])
+                {
+                    sums->hi[k] = points[i];
+                    break;
+                }
+            }
+        }
+    }
+
+    vmath_reduce_kahan(&sums->sum, &sums->sum_c, s);
+    if (flags & VMATH_REDUCE_COVARIANCE)
+    {
+        vmath_reduce_kahan(&sums->sq, &sums->sq_c, q);
+        vmath_reduce_kahan(&sums->prod, &sums->prod_c, p);
+    }
+    sums->count += count;
+}
+
+/**
+ * Add points to partial sums
+ */
+__vmath_batch__ void vmath_reduce_add(vmath_reduce_sums_t* sums, const vec3_t* points, int count, int flags)
+{
+    int i;
+    for (i = 0; i < count; i += VMATH_REDUCE_BLOCK)
+    {
+        const vec3_t* block = points + i;
+        const int     n     = count - i < VMATH_REDUCE_BLOCK ? count - i : VMATH_REDUCE_BLOCK;
+
+        if (flags & VMATH_REDUCE_COVARIANCE)
+        {
+            vmath_reduce_block(sums, block, n, VMATH_REDUCE_COVARIANCE | (flags & VMATH_REDUCE_SPHERE));
+        }
+        else
+        {
+            vmath_reduce_block(sums, block, n, flags & VMATH_REDUCE_SPHERE);
+        }
+    }
+}
+
+/**
+ * Merge partial sums b into a, both started with the same ref
+ */
+__vmath__ void vmath_reduce_merge(vmath_reduce_sums_t* a, const vmath_reduce_sums_t* b)
+{
+    int i;
+    for (i = 0; i < 3; i++)
+    {
+        if (b->min.m[i] < a->min.m[i]) a->lo[i] = b->lo[i];
+        if (b->max.m[i] > a->max.m[i]) a->hi[i] = b->hi[i];
+    }
+    a->min = vec3_min(a->min, b->min);
+    a->max = vec3_max(a->max, b->max);
+
+    vmath_reduce_kahan(&a->sum, &a->sum_c, vec3_sub(b->sum, b->sum_c));
+    vmath_reduce_kahan(&a->sq, &a->sq_c, vec3_sub(b->sq, b->sq_c));
+    vmath_reduce_kahan(&a->prod, &a->prod_c, vec3_sub(b->prod, b->prod_c));
+    a->count += b->count;
+}
+
+/**
+ * Result of partial sums, the sphere is the first guess of Ritter's method:
+ * grow it with vmath_reduce_sphere() over the points
+ * @note: sums->count must be > 0
+ */
+__vmath__ void vmath_reduce_end(const vmath_reduce_sums_t* sums, int flags, vmath_reduce_t* out)
+{
+    const float  inv  = 1.0f / (float)sums->count;
+    const vec3_t mean = vec3_mulf(vec3_sub(sums->sum, sums->sum_c), inv);
+
+    out->min      = sums->min;
+    out->max      = sums->max;
+    out->centroid = vec3_add(sums->ref, mean);
+
+    if (flags & VMATH_REDUCE_COVARIANCE)
+    {
+        /* E[dd'] - E[d]E[d]', d = p - ref is small so the difference keep its precision */
+        const vec3_t sq   = vec3_mulf(vec3_sub(sums->sq, sums->sq_c), inv);
+        const vec3_t prod = vec3_mulf(vec3_sub(sums->prod, sums->prod_c), inv);
+
+        out->covariance.m00 = sq.x - mean.x * mean.x;
+        out->covariance.m11 = sq.y - mean.y * mean.y;
+        out->covariance.m22 = sq.z - mean.z * mean.z;
+        out->covariance.m01 = out->covariance.m10 = prod.x - mean.x * mean.y;
+        out->covariance.m12 = out->covariance.m21 = prod.y - mean.y * mean.z;
+        out->covariance.m02 = out->covariance.m20 = prod.z - mean.z * mean.x;
+    }
+
+    if (flags & VMATH_REDUCE_SPHERE)
+    {
+        /* Widest pair of extreme points along the axes */
+        int   axis = 0, i;
+        float best = -1.0f;
+        for (i = 0; i < 3; i++)
+        {
+            const float d2 = vec3_distancesquared(sums->lo[i], sums->hi[i]);
+            if (d2 > best)
+            {
+                best = d2;
+                axis = i;
+            }
+        }
+        out->center = vec3_mulf(vec3_add(sums->lo[axis], sums->hi[axis]), 0.5f);
+        out->radius = 0.5f * vmath_fsqrt(best);
+    }
+}
+
+/**
+ * radius padded by the rounding of the sphere computations: a few ulps of
+ * the largest of the center coordinates and the radius
+ */
+__vmath__ float vmath_reduce_pad(vec3_t center, float radius)
+{
+    const float x = fabsf(center.x) > fabsf(center.y) ? fabsf(center.x) : fabsf(center.y);
+    const float y = fabsf(center.z) > radius ? fabsf(center.z) : radius;
+    return radius + (x > y ? x : y) * (8.0f * FLT_EPSILON);
+}
+
+/**
+ * Grow a sphere to hold every point, the second pass of Ritter's method.
+ * The grows use sqrtf, not the approximation of VMATH_FAST_MATH, and are
+ * padded by vmath_reduce_pad, so every point is inside in exact arithmetic.
+ */
+__vmath_batch__ void vmath_reduce_sphere(const vec3_t* points, int count, vec3_t* center, float* radius)
+{
+    vec3_t c  = *center;
+    float  r  = *radius;
+    float  r2 = r * r;
+    int    i  = 0, j, end;
+
+    while (i < count)
+    {
+#if VMATH_SSE_ENABLE
+        /* Skip 4 points at once while they are inside, the sphere rarely grow */
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 a = _mm_sub_ps(points[i].data, c.data),     b = _mm_sub_ps(points[i + 1].data, c.data);
+            __m128 e = _mm_sub_ps(points[i + 2].data, c.data), f = _mm_sub_ps(points[i + 3].data, c.data);
+            a = _mm_mul_ps(a, a);
+            b = _mm_mul_ps(b, b);
+            e = _mm_mul_ps(e, e);
+            f = _mm_mul_ps(f, f);
+            _MM_TRANSPOSE4_PS(a, b, e, f);
+            if (_mm_movemask_ps(_mm_cmpgt_ps(_mm_add_ps(_mm_add_ps(a, b), e), _mm_set1_ps(r2))))
+            {
+                break;
+            }
+        }
+        end = i + 4 < count ? i + 4 : count;
+#else
+        end = count;
+#endif
+        for (j = i; j < end; j++)
+        {
+            const vec3_t d  = vec3_sub(points[j], c);
+            const float  d2 = vec3_dot(d, d);
+            if (d2 > r2)
+            {
+                /* New sphere touch the point and the opposite side of the old one */
+                const float dist = sqrtf(d2);
+                const float grow = 0.5f * (dist - r);
+                c   = vec3_add(c, vec3_mulf(d, grow / dist));
+                r   = vmath_reduce_pad(c, r + grow);
+                r2  = r * r;
+            }
+        }
+        i = end;
+    }
+    /* The points found inside by d2 <= r2 may be out by the rounding of d2 */
+    *center = c;
+    *radius = vmath_reduce_pad(c, r);
+}
+
+/**
+ * Grow sphere (center, radius) to hold sphere (c, r)
+ */
+__vmath__ void vmath_reduce_mergesphere(vec3_t* center, float* radius, vec3_t c, float r)
+{
+    const vec3_t d    = vec3_sub(c, *center);
+    const float  dist = sqrtf(vec3_dot(d, d));
+
+    /* Containment on the unpadded values, so equal and concentric spheres stop here and dist > 0 below */
+    if (dist + r <= *radius)
+    {
+        const float padded = vmath_reduce_pad(*center, dist + r);
+        *radius = padded > *radius ? padded : *radius;
+    }
+    else if (dist + *radius <= r)
+    {
+        const float padded = vmath_reduce_pad(c, dist + *radius);
+        *center = c;
+        *radius = padded > r ? padded : r;
+    }
+    else
+    {
+        const float merged = 0.5f * (dist + *radius + r);
+        *center = vec3_add(*center, vec3_mulf(d, (merged - *radius) / dist));
+        *radius = vmath_reduce_pad(*center, merged);
+    }
+}
+
+/**
+ * Reduce points in one read, two with VMATH_REDUCE_SPHERE
+ * @note: count must be > 0
+ */
+__vmath_batch__ void vmath_reduce(const vec3_t* points, int count, int flags, vmath_reduce_t* out)
+{
+    vmath_reduce_sums_t sums;
+
+    vmath_reduce_begin(&sums, points[0]);
+    vmath_reduce_add(&sums, points, count, flags);
+    vmath_reduce_end(&sums, flags, out);
+    if (flags & VMATH_REDUCE_SPHERE)
+    {
+        vmath_reduce_sphere(points, count, &out->center, &out->radius);
+    }
+}
+
+#endif /* __VMATH_REDUCE_H__ */
@@ -0,0 +1,648 @@
+/******************************************************
+ * vmath_rotation - Batched rotation conversions
+ *
+ * @author: MaiHD
+ * @license: NULL
+ * @copyright: MaiHD @ ${HOME}, 2017 - 2018
+ ******************************************************/
+
+#ifndef __VMATH_ROTATION_H__
+#define __VMATH_ROTATION_H__
+
+#include "vmath_soa.h"
+
+/**
+ * Conversions between quat_t, rotation mat3_t / mat4_t, axis-angle and
+ * Euler angles, branch free, one rotation per lane:
+ *
+ *  - Euler:       12 orders, sin and cos from one vfloat4_sincos
+ *  - matrix:      Shepperd's method, the largest of the 4 diagonal
+ *                 candidates is picked with selects, w is made positive
+ *  - axis-angle:  vec4_t with the axis in xyz and the angle in w, as
+ *                 quat_fromaxis / quat_toaxis
+ *
+ * Euler angles are stored in the order of the rotations: VMATH_EULER_ZYX
+ * rotate e.x around Z, then e.y around Y, then e.z around X, all around
+ * the fixed axes (so q = qx * qy * qz). The intrinsic convention of the
+ * same order is the reversed order.
+ */
+
+/**
+ * Euler order from 3 axes (0 = X, 1 = Y, 2 = Z)
+ */
+#define VMATH_EULER(a, b, c) ((a) | ((b) << 2) | ((c) << 4))
+
+#define VMATH_EULER_XYZ VMATH_EULER(0, 1, 2)
+#define VMATH_EULER_XZY VMATH_EULER(0, 2, 1)
+#define VMATH_EULER_YXZ VMATH_EULER(1, 0, 2)
+#define VMATH_EULER_YZX VMATH_EULER(1, 2, 0)
+#define VMATH_EULER_ZXY VMATH_EULER(2, 0, 1)
+#define VMATH_EULER_ZYX VMATH_EULER(2, 1, 0)
+#define VMATH_EULER_XYX VMATH_EULER(0, 1, 0)
+#define VMATH_EULER_XZX VMATH_EULER(0, 2, 0)
+#define VMATH_EULER_YXY VMATH_EULER(1, 0, 1)
+#define VMATH_EULER_YZY VMATH_EULER(1, 2, 1)
+#define VMATH_EULER_ZXZ VMATH_EULER(2, 0, 2)
+#define VMATH_EULER_ZYZ VMATH_EULER(2, 1, 2)
+
+/********************
+ * Lane kernels
+ ********************/
+
+/**
+ * Quaternions from Euler angles e = { e.x, e.y, e.z } of an order
+ */
+__vmath__ void quat_fromeuler_x4(int order, const vfloat4_t e[3], vfloat4_t q[4])
+{
+    const int i = order & 3;
+    const int j = (order >> 2) & 3;
+    const int k = 3 - i - j;
+    const int odd = j != (i + 1) % 3;
+    const vfloat4_t h = vfloat4_set1(odd ? -0.5f : 0.5f);
+    vfloat4_t s0, c0, s1, c1, s2, c2, x, y, z, w;
+
+    vfloat4_sincos(vfloat4_mul(e[0], h), &s0, &c0);
+    vfloat4_sincos(vfloat4_mul(e[1], h), &s1, &c1);
+    vfloat4_sincos(vfloat4_mul(e[2], h), &s2, &c2);
+
+    /* Product in the frame i j k, odd orders are mirrored: negated angles
+       in, negated vector out */
+    {
+        const vfloat4_t cc = vfloat4_mul(c0, c1), sc = vfloat4_mul(s0, c1);
+        const vfloat4_t cs = vfloat4_mul(c0, s1), ss = vfloat4_mul(s0, s1);
+        if (((order >> 4) & 3) == i)
+        {
+            x = vfloat4_madd(sc, c2, vfloat4_mul(cc, s2));
+            y = vfloat4_madd(cs, c2, vfloat4_mul(ss, s2));
+            z = vfloat4_nmadd(ss, c2, vfloat4_mul(cs, s2));
+            w = vfloat4_nmadd(sc, s2, vfloat4_mul(cc, c2));
+        }
+        else
+        {
+            x = vfloat4_nmadd(cs, s2, vfloat4_mul(sc, c2));
+            y = vfloat4_madd(cs, c2, vfloat4_mul(sc, s2));
+            z = vfloat4_nmadd(ss, c2, vfloat4_mul(cc, s2));
+            w = vfloat4_madd(ss, s2, vfloat4_mul(cc, c2));
+        }
+    }
+
+    q[i] = odd ? vfloat4_neg(x) : x;
+    q[j] = odd ? vfloat4_neg(y) : y;
+    q[k] = odd ? vfloat4_neg(z) : z;
+    q[3] = w;
+}
+
+/**
+ * Rotation matrices of unit quaternions, r[row][column]
+ */
+__vmath__ void quat_tomat3_x4(const vfloat4_t q[4], vfloat4_t r[3][3])
+{
+    const vfloat4_t two = vfloat4_set1(2.0f);
+    const vfloat4_t one = vfloat4_set1(1.0f);
+    const vfloat4_t xx = vfloat4_mul(q[0], q[0]), yy = vfloat4_mul(q[1], q[1]), zz = vfloat4_mul(q[2], q[2]);
+    const vfloat4_t xy = vfloat4_mul(q[0], q[1]), xz = vfloat4_mul(q[0], q[2]), yz = vfloat4_mul(q[1], q[2]);
+    const vfloat4_t wx = vfloat4_mul(q[3], q[0]), wy = vfloat4_mul(q[3], q[1]), wz = vfloat4_mul(q[3], q[2]);
+
+    r[0][0] = vfloat4_nmadd(two, vfloat4_add(yy, zz), one);
+    r[0][1] = vfloat4_mul(two, vfloat4_sub(xy, wz));
+    r[0][2] = vfloat4_mul(two, vfloat4_add(xz, wy));
+
+    r[1][0] = vfloat4_mul(two, vfloat4_add(xy, wz));
+    r[1][1] = vfloat4_nmadd(two, vfloat4_add(xx, zz), one);
+    r[1][2] = vfloat4_mul(two, vfloat4_sub(yz, wx));
+
+    r[2][0] = vfloat4_mul(two, vfloat4_sub(xz, wy));
+    r[2][1] = vfloat4_mul(two, vfloat4_add(yz, wx));
+    r[2][2] = vfloat4_nmadd(two, vfloat4_add(xx, yy), one);
+}
+
+/**
+ * Quaternions from rotation matrices r[row][column] (Shepperd)
+ */
+__vmath__ void quat_frommat3_x4(const vfloat4_t r[3][3], vfloat4_t q[4])
+{
+    const vfloat4_t one = vfloat4_set1(1.0f);
+
+    /* 4 q^2 of each component */
+    const vfloat4_t tw = vfloat4_add(one, vfloat4_add(r[0][0], vfloat4_add(r[1][1], r[2][2])));
+    const vfloat4_t tx = vfloat4_add(one, vfloat4_sub(r[0][0], vfloat4_add(r[1][1], r[2][2])));
+    const vfloat4_t ty = vfloat4_add(one, vfloat4_sub(r[1][1], vfloat4_add(r[0][0], r[2][2])));
+    const vfloat4_t tz = vfloat4_add(one, vfloat4_sub(r[2][2], vfloat4_add(r[0][0], r[1][1])));
+
+    /* 4 q_w q_i and 4 q_i q_j */
+    const vfloat4_t dx = vfloat4_sub(r[2][1], r[1][2]);
+    const vfloat4_t dy = vfloat4_sub(r[0][2], r[2][0]);
+    const vfloat4_t dz = vfloat4_sub(r[1][0], r[0][1]);
+    const vfloat4_t yz = vfloat4_add(r[1][2], r[2][1]);
+    const vfloat4_t xz = vfloat4_add(r[0][2], r[2][0]);
+    const vfloat4_t xy = vfloat4_add(r[0][1], r[1][0]);
+
+    /* Pick the largest, the candidates are { w, x } then { y, z } */
+    const vfloat4_t mwx = vfloat4_cmpgt(tx, tw);
+    const vfloat4_t myz = vfloat4_cmpgt(tz, ty);
+    const vfloat4_t twx = vfloat4_max(tw, tx);
+    const vfloat4_t tyz = vfloat4_max(ty, tz);
+    const vfloat4_t m   = vfloat4_cmpgt(tyz, twx);
+    const vfloat4_t t   = vfloat4_max(twx, tyz);
+    vfloat4_t f = vfloat4_div(vfloat4_set1(0.5f), vfloat4_sqrt(t));
+
+    q[0] = vfloat4_select(vfloat4_select(dx, tx, mwx), vfloat4_select(xy, xz, myz), m);
+    q[1] = vfloat4_select(vfloat4_select(dy, xy, mwx), vfloat4_select(ty, yz, myz), m);
+    q[2] = vfloat4_select(vfloat4_select(dz, xz, mwx), vfloat4_select(yz, tz, myz), m);
+    q[3] = vfloat4_select(vfloat4_select(tw, dx, mwx), vfloat4_select(dy, dz, myz), m);
+
+    f    = vfloat4_xor(f, vfloat4_and(q[3], vfloat4_set1(-0.0f)));
+    q[0] = vfloat4_mul(q[0], f);
+    q[1] = vfloat4_mul(q[1], f);
+    q[2] = vfloat4_mul(q[2], f);
+    q[3] = vfloat4_mul(q[3], f);
+}
+
+/**
+ * Euler angles of an order from unit quaternions, the last angle is 0 in
+ * gimbal lock
+ */
+__vmath__ void quat_toeuler_x4(int order, const vfloat4_t q[4], vfloat4_t e[3])
+{
+    const int       i   = order & 3;
+    const int       j   = (order >> 2) & 3;
+    const int       k   = 3 - i - j;
+    const vfloat4_t eps = vfloat4_set1(16.0f * FLT_EPSILON);
+    vfloat4_t       r[3][3], lock, c;
+
+    quat_tomat3_x4(q, r);
+    if (((order >> 4) & 3) == i)
+    {
+        /* Proper Euler angles, i j i */
+        c    = vfloat4_sqrt(vfloat4_madd(r[i][j], r[i][j], vfloat4_mul(r[i][k], r[i][k])));
+        lock = vfloat4_cmple(c, eps);
+        e[0] = vfloat4_select(vfloat4_atan2(r[i][j], r[i][k]), vfloat4_atan2(vfloat4_neg(r[j][k]), r[j][j]), lock);
+        e[1] = vfloat4_atan2(c, r[i][i]);
+    }
+    else
+    {
+        /* Tait-Bryan angles, i j k */
+        c    = vfloat4_sqrt(vfloat4_madd(r[i][i], r[i][i], vfloat4_mul(r[j][i], r[j][i])));
+        lock = vfloat4_cmple(c, eps);
+        e[0] = vfloat4_select(vfloat4_atan2(r[k][j], r[k][k]), vfloat4_atan2(vfloat4_neg(r[j][k]), r[j][j]), lock);
+        e[1] = vfloat4_atan2(vfloat4_neg(r[k][i]), c);
+    }
+
+    /* Last angle from the column j of r * rotate(i, -e0): its entries stay
+       large near the lock, where the direct formula lose all precision */
+    {
+        vfloat4_t s0, c0, nj[3];
+        vfloat4_sincos(e[0], &s0, &c0);
+        nj[i] = vfloat4_nmadd(s0, r[i][k], vfloat4_mul(c0, r[i][j]));
+        nj[j] = vfloat4_nmadd(s0, r[j][k], vfloat4_mul(c0, r[j][j]));
+        nj[k] = vfloat4_nmadd(s0, r[k][k], vfloat4_mul(c0, r[k][j]));
+        e[2]  = ((order >> 4) & 3) == i ? vfloat4_atan2(nj[k], nj[j]) : vfloat4_atan2(vfloat4_neg(nj[i]), nj[j]);
+    }
+
+    /* Odd permutations mirror the angles */
+    if (j != (i + 1) % 3)
+    {
+        e[0] = vfloat4_neg(e[0]);
+        e[1] = vfloat4_neg(e[1]);
+        e[2] = vfloat4_neg(e[2]);
+    }
+}
+
+/**
+ * Quaternions from axis-angle a = { x, y, z, angle }, a zero axis give the
+ * identity
+ */
+__vmath__ void quat_fromaxis_x4(const vfloat4_t a[4], vfloat4_t q[4])
+{
+    const vfloat4_t l = vfloat4_madd(a[0], a[0], vfloat4_madd(a[1], a[1], vfloat4_mul(a[2], a[2])));
+    const vfloat4_t z = vfloat4_cmple(l, vfloat4_zero());
+    vfloat4_t s, c, f;
+
+    vfloat4_sincos(vfloat4_mul(a[3], vfloat4_set1(0.5f)), &s, &c);
+    f = vfloat4_andnot(z, vfloat4_div(s, vfloat4_sqrt(vfloat4_max(l, vfloat4_set1(FLT_MIN)))));
+
+    q[0] = vfloat4_mul(a[0], f);
+    q[1] = vfloat4_mul(a[1], f);
+    q[2] = vfloat4_mul(a[2], f);
+    q[3] = vfloat4_select(c, vfloat4_set1(1.0f), z);
+}
+
+/**
+ * Axis-angle { x, y, z, angle } of unit quaternions, angle in [0, 2 pi],
+ * the axis is X for a null rotation
+ */
+__vmath__ void quat_toaxis_x4(const vfloat4_t q[4], vfloat4_t a[4])
+{
+    const vfloat4_t l = vfloat4_sqrt(vfloat4_madd(q[0], q[0], vfloat4_madd(q[1], q[1], vfloat4_mul(q[2], q[2]))));
+    const vfloat4_t z = vfloat4_cmple(l, vfloat4_set1(FLT_EPSILON));
+    const vfloat4_t f = vfloat4_div(vfloat4_set1(1.0f), vfloat4_max(l, vfloat4_set1(FLT_EPSILON)));
+
+    a[0] = vfloat4_select(vfloat4_mul(q[0], f), vfloat4_set1(1.0f), z);
+    a[1] = vfloat4_andnot(z, vfloat4_mul(q[1], f));
+    a[2] = vfloat4_andnot(z, vfloat4_mul(q[2], f));
+    a[3] = vfloat4_mul(vfloat4_set1(2.0f), vfloat4_atan2(l, q[3]));
+}
+
+/********************
+ * Loads and stores
+ ********************/
+
+/**
+ * Transpose up to 4 vec4_t / quat_t to lanes, missing lanes get fill
+ */
+__vmath__ void vmath_rotation_load4_x4(const float* v, int stride, int count, vfloat4_t fill, vfloat4_t r[4])
+{
+    int l;
+    for (l = 0; l < 4; l++)
+    {
+        r[l] = l < count ? vfloat4_load(v + l * stride) : fill;
+    }
+    vfloat4_transpose(&r[0], &r[1], &r[2], &r[3]);
+}
+
+/**
+ * Transpose lanes back to the first n vec4_t / quat_t
+ */
+__vmath__ void vmath_rotation_store4_x4(float* v, int stride, int count, const vfloat4_t r[4])
+{
+    vfloat4_t t[4];
+    int l;
+
+    t[0] = r[0]; t[1] = r[1]; t[2] = r[2]; t[3] = r[3];
+    vfloat4_transpose(&t[0], &t[1], &t[2], &t[3]);
+    for (l = 0; l < count; l++)
+    {
+        vfloat4_store(v + l * stride, t[l]);
+    }
+}
+
+/**
+ * Load up to 4 vec3_t to lanes, missing lanes get 0
+ */
+__vmath__ void vmath_rotation_load3_x4(const vec3_t* v, int count, vfloat4_t r[3])
+{
+    float lanes[3][4];
+    int   l;
+
+    for (l = 0; l < 4; l++)
+    {
+        lanes[0][l] = l < count ? v[l].x : 0.0f;
+        lanes[1][l] = l < count ? v[l].y : 0.0f;
+        lanes[2][l] = l < count ? v[l].z : 0.0f;
+    }
+    r[0] = vfloat4_load(lanes[0]);
+    r[1] = vfloat4_load(lanes[1]);
+    r[2] = vfloat4_load(lanes[2]);
+}
+
+/**
+ * Store the first n lanes to vec3_t
+ */
+__vmath__ void vmath_rotation_store3_x4(vec3_t* v, int count, const vfloat4_t r[3])
+{
+    float lanes[3][4];
+    int   l;
+
+    vfloat4_store(lanes[0], r[0]);
+    vfloat4_store(lanes[1], r[1]);
+    vfloat4_store(lanes[2], r[2]);
+    for (l = 0; l < count; l++)
+    {
+        v[l] = vec3(lanes[0][l], lanes[1][l], lanes[2][l]);
+    }
+}
+
+/**
+ * Load up to 4 mat3_t to lanes r[row][column], missing lanes get identity
+ */
+__vmath__ void vmath_rotation_loadmat3_x4(const mat3_t* m, int count, vfloat4_t r[3][3])
+{
+    float lanes[3][3][4];
+    int   i, j, l;
+
+    for (l = 0; l < 4; l++)
+    {
+        for (i = 0; i < 3; i++)
+        {
+            for (j = 0; j < 3; j++)
+            {
+                lanes[i][j][l] = l < count ? m[l].m[j][i] : (float)(i == j);
+            }
+        }
+    }
+
+    for (i = 0; i < 3; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            r[i][j] = vfloat4_load(lanes[i][j]);
+        }
+    }
+}
+
+/**
+ * Store the first n lanes r[row][column] to mat3_t
+ */
+__vmath__ void vmath_rotation_storemat3_x4(mat3_t* m, int count, const vfloat4_t r[3][3])
+{
+    float lanes[3][3][4];
+    int   i, j, l;
+
+    for (i = 0; i < 3; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            vfloat4_store(lanes[i][j], r[i][j]);
+        }
+    }
+
+    for (l = 0; l < count; l++)
+    {
+        for (i = 0; i < 3; i++)
+        {
+            for (j = 0; j < 3; j++)
+            {
+                m[l].m[j][i] = lanes[i][j][l];
+            }
+        }
+    }
+}
+
+/**
+ * Load the rotation of up to 4 mat4_t to lanes r[row][column], the scale
+ * of each axis is removed, missing lanes get identity
+ */
+__vmath__ void vmath_rotation_loadmat4_x4(const mat4_t* m, int count, vfloat4_t r[3][3])
+{
+    static const float identity[3][4] = { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 } };
+    int i, j;
+
+    for (j = 0; j < 3; j++)
+    {
+        vfloat4_t c[4], f;
+        for (i = 0; i < 4; i++)
+        {
+            c[i] = vfloat4_load(i < count ? m[i].m[j] : identity[j]);
+        }
+        vfloat4_transpose(&c[0], &c[1], &c[2], &c[3]);
+
+        f = vfloat4_madd(c[0], c[0], vfloat4_madd(c[1], c[1], vfloat4_mul(c[2], c[2])));
+        f = vfloat4_div(vfloat4_set1(1.0f), vfloat4_sqrt(vfloat4_max(f, vfloat4_set1(FLT_MIN))));
+        for (i = 0; i < 3; i++)
+        {
+            r[i][j] = vfloat4_mul(c[i], f);
+        }
+    }
+}
+
+/**
+ * Store the first n lanes r[row][column] to rotation mat4_t
+ */
+__vmath__ void vmath_rotation_storemat4_x4(mat4_t* m, int count, const vfloat4_t r[3][3])
+{
+    int i, j;
+    for (j = 0; j < 3; j++)
+    {
+        vfloat4_t c[4];
+        c[0] = r[0][j];
+        c[1] = r[1][j];
+        c[2] = r[2][j];
+        c[3] = vfloat4_zero();
+        vfloat4_transpose(&c[0], &c[1], &c[2], &c[3]);
+        for (i = 0; i < count; i++)
+        {
+            vfloat4_store(m[i].m[j], c[i]);
+        }
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        vfloat4_store(m[i].m[3], vfloat4_set(0.0f, 0.0f, 0.0f, 1.0f));
+    }
+}
+
+/********************
+ * Single rotation
+ ********************/
+
+/**
+ * Create a quaternion from Euler angles of an order
+ */
+__vmath__ quat_t quat_fromeuler(vec3_t e, int order)
+{
+    vfloat4_t v[3], q[4];
+    quat_t    r;
+
+    vmath_rotation_load3_x4(&e, 1, v);
+    quat_fromeuler_x4(order, v, q);
+    vmath_rotation_store4_x4(r.m, 4, 1, q);
+    return r;
+}
+
+/**
+ * Euler angles of an order from an unit quaternion
+ */
+__vmath__ vec3_t quat_toeulerorder(quat_t q, int order)
+{
+    vfloat4_t v[4], e[3];
+    vec3_t    r;
+
+    vmath_rotation_load4_x4(q.m, 4, 1, vfloat4_zero(), v);
+    quat_toeuler_x4(order, v, e);
+    vmath_rotation_store3_x4(&r, 1, e);
+    return r;
+}
+
+/**
+ * Create a quaternion from a rotation matrix
+ */
+__vmath__ quat_t quat_frommat3(mat3_t m)
+{
+    vfloat4_t r[3][3], q[4];
+    quat_t    res;
+
+    vmath_rotation_loadmat3_x4(&m, 1, r);
+    quat_frommat3_x4(r, q);
+    vmath_rotation_store4_x4(res.m, 4, 1, q);
+    return res;
+}
+
+/**
+ * Create a quaternion from the rotation of a transform, scale is removed
+ */
+__vmath__ quat_t quat_frommat4(mat4_t m)
+{
+    vfloat4_t r[3][3], q[4];
+    quat_t    res;
+
+    vmath_rotation_loadmat4_x4(&m, 1, r);
+    quat_frommat3_x4(r, q);
+    vmath_rotation_store4_x4(res.m, 4, 1, q);
+    return res;
+}
+
+/********************
+ * Batches
+ ********************/
+
+/**
+ * Quaternions from Euler angles of an order, 8 per loop
+ */
+__vmath_batch__ void quat_fromeuler_batch(const vec3_t* e, quat_t* q, int count, int order)
+{
+    int i, g;
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = i; g < i + 8 && g < count; g += 4)
+        {
+            const int n = count - g < 4 ? count - g : 4;
+            vfloat4_t v[3], r[4];
+
+            vmath_rotation_load3_x4(e + g, n, v);
+            quat_fromeuler_x4(order, v, r);
+            vmath_rotation_store4_x4(q[g].m, 4, n, r);
+        }
+    }
+}
+
+/**
+ * Euler angles of an order from unit quaternions, 8 per loop
+ */
+__vmath_batch__ void quat_toeuler_batch(const quat_t* q, vec3_t* e, int count, int order)
+{
+    int i, g;
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = i; g < i + 8 && g < count; g += 4)
+        {
+            const int n = count - g < 4 ? count - g : 4;
+            vfloat4_t v[4], r[3];
+
+            vmath_rotation_load4_x4(q[g].m, 4, n, vfloat4_set(0, 0, 0, 1), v);
+            quat_toeuler_x4(order, v, r);
+            vmath_rotation_store3_x4(e + g, n, r);
+        }
+    }
+}
+
+/**
+ * Quaternions from rotation matrices, 8 per loop
+ */
+__vmath_batch__ void quat_frommat3_batch(const mat3_t* m, quat_t* q, int count)
+{
+    int i, g;
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = i; g < i + 8 && g < count; g += 4)
+        {
+            const int n = count - g < 4 ? count - g : 4;
+            vfloat4_t r[3][3], v[4];
+
+            vmath_rotation_loadmat3_x4(m + g, n, r);
+            quat_frommat3_x4(r, v);
+            vmath_rotation_store4_x4(q[g].m, 4, n, v);
+        }
+    }
+}
+
+/**
+ * Rotation matrices of unit quaternions, 8 per loop
+ */
+__vmath_batch__ void quat_tomat3_batch(const quat_t* q, mat3_t* m, int count)
+{
+    int i, g;
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = i; g < i + 8 && g < count; g += 4)
+        {
+            const int n = count - g < 4 ? count - g : 4;
+            vfloat4_t v[4], r[3][3];
+
+            vmath_rotation_load4_x4(q[g].m, 4, n, vfloat4_set(0, 0, 0, 1), v);
+            quat_tomat3_x4(v, r);
+            vmath_rotation_storemat3_x4(m + g, n, r);
+        }
+    }
+}
+
+/**
+ * Quaternions from the rotation of transforms, scale is removed, 8 per loop
+ */
+__vmath_batch__ void quat_frommat4_batch(const mat4_t* m, quat_t* q, int count)
+{
+    int i, g;
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = i; g < i + 8 && g < count; g += 4)
+        {
+            const int n = count - g < 4 ? count - g : 4;
+            vfloat4_t r[3][3], v[4];
+
+            vmath_rotation_loadmat4_x4(m + g, n, r);
+            quat_frommat3_x4(r, v);
+            vmath_rotation_store4_x4(q[g].m, 4, n, v);
+        }
+    }
+}
+
+/**
+ * Rotation mat4_t of unit quaternions, 8 per loop
+ */
+__vmath_batch__ void quat_tomat4_batch(const quat_t* q, mat4_t* m, int count)
+{
+    int i, g;
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = i; g < i + 8 && g < count; g += 4)
+        {
+            const int n = count - g < 4 ? count - g : 4;
+            vfloat4_t v[4], r[3][3];
+
+            vmath_rotation_load4_x4(q[g].m, 4, n, vfloat4_set(0, 0, 0, 1), v);
+            quat_tomat3_x4(v, r);
+            vmath_rotation_storemat4_x4(m + g, n, r);
+        }
+    }
+}
+
+/**
+ * Quaternions from axis-angle { x, y, z, angle }, 8 per loop
+ */
+__vmath_batch__ void quat_fromaxis_batch(const vec4_t* a, quat_t* q, int count)
+{
+    int i, g;
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = i; g < i + 8 && g < count; g += 4)
+        {
+            const int n = count - g < 4 ? count - g : 4;
+            vfloat4_t v[4], r[4];
+
+            vmath_rotation_load4_x4(a[g].m, 4, n, vfloat4_zero(), v);
+            quat_fromaxis_x4(v, r);
+            vmath_rotation_store4_x4(q[g].m, 4, n, r);
+        }
+    }
+}
+
+/**
+ * Axis-angle { x, y, z, angle } of unit quaternions, 8 per loop
+ */
+__vmath_batch__ void quat_toaxis_batch(const quat_t* q, vec4_t* a, int count)
+{
+    int i, g;
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = i; g < i + 8 && g < count; g += 4)
+        {
+            const int n = count - g < 4 ? count - g : 4;
+            vfloat4_t v[4], r[4];
+
+            vmath_rotation_load4_x4(q[g].m, 4, n, vfloat4_set(0, 0, 0, 1), v);
+            quat_toaxis_x4(v, r);
+            vmath_rotation_store4_x4(a[g].m, 4, n, r);
+        }
+    }
+}
+
+#endif /* __VMATH_ROTATION_H__ */
@@ -0,0 +1,876 @@
+/******************************************************
+ * vmath_soa - 4-wide lanes for SoA batch kernels
+ *
+ * @author: MaiHD
+ * @license: NULL
+ * @copyright: MaiHD @ ${HOME}, 2017 - 2018
+ ******************************************************/
+
+#ifndef __VMATH_SOA_H__
+#define __VMATH_SOA_H__
+
+#include <string.h>
+
+#include "vmath.h"
+
+/**
+ * A lane type hold 4 independent values (one value per element of a batch),
+ * unlike vec4_t which hold 4 components of one value.
+ *
+ * @note: every operation is an exact IEEE operation (no estimate, no fused
+ *        multiply-add), so kernels built on it return the same bits with
+ *        SSE, NEON and scalar backends. Build the scalar backend with
+ *        -ffp-contract=off to keep the compiler from fusing a * b + c.
+ */
+#if VMATH_NEON_ENABLE
+typedef float32x4_t vfloat4_t;
+typedef int32x4_t   vint4_t;
+#elif VMATH_SSE_ENABLE
+# if defined(__SSE4_1__)
+#  include <smmintrin.h>
+# endif
+typedef __m128      vfloat4_t;
+typedef __m128i     vint4_t;
+#else
+typedef union vmath_vfloat4
+{
+    float        f[4];
+    unsigned int u[4];
+} vfloat4_t;
+
+typedef union vmath_vint4
+{
+    int          i[4];
+    unsigned int u[4];
+} vint4_t;
+#endif
+
+/**************************
+ * Float lanes
+ **************************/
+
+/**
+ * Set all lanes to a scalar
+ */
+__vmath__ vfloat4_t vfloat4_set1(float s)
+{
+#if VMATH_NEON_ENABLE
+    return vdupq_n_f32(s);
+#elif VMATH_SSE_ENABLE
+    return _mm_set1_ps(s);
+#else
+    vfloat4_t r;
+    r.f[0] = s; r.f[1] = s; r.f[2] = s; r.f[3] = s;
+    return r;
+#endif
+}
+
+/**
+ * Set lanes from 4 scalars, lane 0 first
+ */
+__vmath__ vfloat4_t vfloat4_set(float x, float y, float z, float w)
+{
+#if VMATH_NEON_ENABLE
+    const float f[4] = { x, y, z, w };
+    return vld1q_f32(f);
+#elif VMATH_SSE_ENABLE
+    return _mm_setr_ps(x, y, z, w);
+#else
+    vfloat4_t r;
+    r.f[0] = x; r.f[1] = y; r.f[2] = z; r.f[3] = w;
+    return r;
+#endif
+}
+
+__vmath__ vfloat4_t vfloat4_zero(void)
+{
+    return vfloat4_set1(0.0f);
+}
+
+/**
+ * Load 4 lanes from unaligned memory
+ */
+__vmath__ vfloat4_t vfloat4_load(const float* ptr)
+{
+#if VMATH_NEON_ENABLE
+    return vld1q_f32(ptr);
+#elif VMATH_SSE_ENABLE
+    return _mm_loadu_ps(ptr);
+#else
+    return vfloat4_set(ptr[0], ptr[1], ptr[2], ptr[3]);
+#endif
+}
+
+/**
+ * Store 4 lanes to unaligned memory
+ */
+__vmath__ void vfloat4_store(float* ptr, vfloat4_t v)
+{
+#if VMATH_NEON_ENABLE
+    vst1q_f32(ptr, v);
+#elif VMATH_SSE_ENABLE
+    _mm_storeu_ps(ptr, v);
+#else
+    ptr[0] = v.f[0]; ptr[1] = v.f[1]; ptr[2] = v.f[2]; ptr[3] = v.f[3];
+#endif
+}
+
+/**
+ * Load the first count (0..4) lanes, the others are zero
+ */
+__vmath__ vfloat4_t vfloat4_loadn(const float* ptr, int count)
+{
+    float tmp[4] = { 0, 0, 0, 0 };
+    int i;
+    for (i = 0; i < count; i++) tmp[i] = ptr[i];
+    return vfloat4_load(tmp);
+}
+
+/**
+ * Store the first count (0..4) lanes
+ */
+__vmath__ void vfloat4_storen(float* ptr, vfloat4_t v, int count)
+{
+    float tmp[4];
+    int i;
+    vfloat4_store(tmp, v);
+    for (i = 0; i < count; i++) ptr[i] = tmp[i];
+}
+
+/**
+ * Get value of a lane
+ */
+__vmath__ float vfloat4_get(vfloat4_t v, int lane)
+{
+    float tmp[4];
+    vfloat4_store(tmp, v);
+    return tmp[lane];
+}
+
+__vmath__ vfloat4_t vfloat4_add(vfloat4_t a, vfloat4_t b)
+{
+#if VMATH_NEON_ENABLE
+    return vaddq_f32(a, b);
+#elif VMATH_SSE_ENABLE
+    return _mm_add_ps(a, b);
+#else
+    vfloat4_t r;
+    r.f[0] = a.f[0] + b.f[0]; r.f[1] = a.f[1] + b.f[1];
+    r.f[2] = a.f[2] + b.f[2]; r.f[3] = a.f[3] + b.f[3];
+    return r;
+#endif
+}
+
+__vmath__ vfloat4_t vfloat4_sub(vfloat4_t a, vfloat4_t b)
+{
+#if VMATH_NEON_ENABLE
+    return vsubq_f32(a, b);
+#elif VMATH_SSE_ENABLE
+    return _mm_sub_ps(a, b);
+#else
+    vfloat4_t r;
+    r.f[0] = a.f[0] - b.f[0]; r.f[1] = a.f[1] - b.f[1];
+    r.f[2] = a.f[2] - b.f[2]; r.f[3] = a.f[3] - b.f[3];
+    return r;
+#endif
+}
+
+__vmath__ vfloat4_t vfloat4_mul(vfloat4_t a, vfloat4_t b)
+{
+#if VMATH_NEON_ENABLE
+    return vmulq_f32(a, b);
+#elif VMATH_SSE_ENABLE
+    return _mm_mul_ps(a, b);
+#else
+    vfloat4_t r;
+    r.f[0] = a.f[0] * b.f[0]; r.f[1] = a.f[1] * b.f[1];
+    r.f[2] = a.f[2] * b.f[2]; r.f[3] = a.f[3] * b.f[3];
+    return r;
+#endif
+}
+
+__vmath__ vfloat4_t vfloat4_div(vfloat4_t a, vfloat4_t b)
+{
+#if VMATH_NEON_ENABLE && defined(__aarch64__)
+    return vdivq_f32(a, b);
+#elif VMATH_SSE_ENABLE
+    return _mm_div_ps(a, b);
+#else
+    float fa[4], fb[4];
+    vfloat4_store(fa, a);
+    vfloat4_store(fb, b);
+    return vfloat4_set(fa[0] / fb[0], fa[1] / fb[1], fa[2] / fb[2], fa[3] / fb[3]);
+#endif
+}
+
+/**
+ * Multiply then add: a * b + c, rounded twice
+ */
+__vmath__ vfloat4_t vfloat4_madd(vfloat4_t a, vfloat4_t b, vfloat4_t c)
+{
+    return vfloat4_add(vfloat4_mul(a, b), c);
+}
+
+/**
+ * Multiply then subtract from: c - a * b, rounded twice
+ */
+__vmath__ vfloat4_t vfloat4_nmadd(vfloat4_t a, vfloat4_t b, vfloat4_t c)
+{
+    return vfloat4_sub(c, vfloat4_mul(a, b));
+}
+
+__vmath__ vfloat4_t vfloat4_min(vfloat4_t a, vfloat4_t b)
+{
+#if VMATH_NEON_ENABLE
+    return vminq_f32(a, b);
+#elif VMATH_SSE_ENABLE
+    return _mm_min_ps(a, b);
+#else
+    vfloat4_t r;
+    r.f[0] = a.f[0] < b.f[0] ? a.f[0] : b.f[0]; r.f[1] = a.f[1] < b.f[1] ? a.f[1] : b.f[1];
+    r.f[2] = a.f[2] < b.f[2] ? a.f[2] : b.f[2]; r.f[3] = a.f[3] < b.f[3] ? a.f[3] : b.f[3];
+    return r;
+#endif
+}
+
+__vmath__ vfloat4_t vfloat4_max(vfloat4_t a, vfloat4_t b)
+{
+#if VMATH_NEON_ENABLE
+    return vmaxq_f32(a, b);
+#elif VMATH_SSE_ENABLE
+    return _mm_max_ps(a, b);
+#else
+    vfloat4_t r;
+    r.f[0] = a.f[0] > b.f[0] ? a.f[0] : b.f[0]; r.f[1] = a.f[1] > b.f[1] ? a.f[1] : b.f[1];
+    r.f[2] = a.f[2] > b.f[2] ? a.f[2] : b.f[2]; r.f[3] = a.f[3] > b.f[3] ? a.f[3] : b.f[3];
+    return r;
+#endif
+}
+
+__vmath__ vfloat4_t vfloat4_clamp(vfloat4_t v, vfloat4_t min, vfloat4_t max)
+{
+    return vfloat4_min(vfloat4_max(v, min), max);
+}
+
+__vmath__ vfloat4_t vfloat4_sqrt(vfloat4_t v)
+{
+#if VMATH_NEON_ENABLE && defined(__aarch64__)
+    return vsqrtq_f32(v);
+#elif VMATH_SSE_ENABLE
+    return _mm_sqrt_ps(v);
+#else
+    float f[4];
+    vfloat4_store(f, v);
+    return vfloat4_set(sqrtf(f[0]), sqrtf(f[1]), sqrtf(f[2]), sqrtf(f[3]));
+#endif
+}
+
+/**************************
+ * Masks and bitwise
+ * A mask lane is all bits set (true) or all bits clear (false)
+ **************************/
+
+__vmath__ vfloat4_t vfloat4_and(vfloat4_t a, vfloat4_t b)
+{
+#if VMATH_NEON_ENABLE
+    return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+#elif VMATH_SSE_ENABLE
+    return _mm_and_ps(a, b);
+#else
+    vfloat4_t r;
+    r.u[0] = a.u[0] & b.u[0]; r.u[1] = a.u[1] & b.u[1];
+    r.u[2] = a.u[2] & b.u[2]; r.u[3] = a.u[3] & b.u[3];
+    return r;
+#endif
+}
+
+/**
+ * Bitwise and with complement of the first: ~a & b
+ */
+__vmath__ vfloat4_t vfloat4_andnot(vfloat4_t a, vfloat4_t b)
+{
+#if VMATH_NEON_ENABLE
+    return vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(b), vreinterpretq_u32_f32(a)));
+#elif VMATH_SSE_ENABLE
+    return _mm_andnot_ps(a, b);
+#else
+    vfloat4_t r;
+    r.u[0] = ~a.u[0] & b.u[0]; r.u[1] = ~a.u[1] & b.u[1];
+    r.u[2] = ~a.u[2] & b.u[2]; r.u[3] = ~a.u[3] & b.u[3];
+    return r;
+#endif
+}
+
+__vmath__ vfloat4_t vfloat4_or(vfloat4_t a, vfloat4_t b)
+{
+#if VMATH_NEON_ENABLE
+    return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+#elif VMATH_SSE_ENABLE
+    return _mm_or_ps(a, b);
+#else
+    vfloat4_t r;
+    r.u[0] = a.u[0] | b.u[0]; r.u[1] = a.u[1] | b.u[1];
+    r.u[2] = a.u[2] | b.u[2]; r.u[3] = a.u[3] | b.u[3];
+    return r;
+#endif
+}
+
+__vmath__ vfloat4_t vfloat4_xor(vfloat4_t a, vfloat4_t b)
+{
+#if VMATH_NEON_ENABLE
+    return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+#elif VMATH_SSE_ENABLE
+    return _mm_xor_ps(a, b);
+#else
+    vfloat4_t r;
+    r.u[0] = a.u[0] ^ b.u[0]; r.u[1] = a.u[1] ^ b.u[1];
+    r.u[2] = a.u[2] ^ b.u[2]; r.u[3] = a.u[3] ^ b.u[3];
+    return r;
+#endif
+}
+
+/**
+ * Select per lane: mask ? b : a
+ */
+__vmath__ vfloat4_t vfloat4_select(vfloat4_t a, vfloat4_t b, vfloat4_t mask)
+{
+#if VMATH_NEON_ENABLE
+    return vbslq_f32(vreinterpretq_u32_f32(mask), b, a);
+#else
+    return vfloat4_or(vfloat4_and(mask, b), vfloat4_andnot(mask, a));
+#endif
+}
+
+__vmath__ vfloat4_t vfloat4_cmplt(vfloat4_t a, vfloat4_t b)
+{
+#if VMATH_NEON_ENABLE
+    return vreinterpretq_f32_u32(vcltq_f32(a, b));
+#elif VMATH_SSE_ENABLE
+    return _mm_cmplt_ps(a, b);
+#else
+    vfloat4_t r;
+    r.u[0] = a.f[0] < b.f[0] ? ~0u : 0u; r.u[1] = a.f[1] < b.f[1] ? ~0u : 0u;
+    r.u[2] = a.f[2] < b.f[2] ? ~0u : 0u; r.u[3] = a.f[3] < b.f[3] ? ~0u : 0u;
+    return r;
+#endif
+}
+
+__vmath__ vfloat4_t vfloat4_cmple(vfloat4_t a, vfloat4_t b)
+{
+#if VMATH_NEON_ENABLE
+    return vreinterpretq_f32_u32(vcleq_f32(a, b));
+#elif VMATH_SSE_ENABLE
+    return _mm_cmple_ps(a, b);
+#else
+    vfloat4_t r;
+    r.u[0] = a.f[0] <= b.f[0] ? ~0u : 0u; r.u[1] = a.f[1] <= b.f[1] ? ~0u : 0u;
+    r.u[2] = a.f[2] <= b.f[2] ? ~0u : 0u; r.u[3] = a.f[3] <= b.f[3] ? ~0u : 0u;
+    return r;
+#endif
+}
+
+__vmath__ vfloat4_t vfloat4_cmpgt(vfloat4_t a, vfloat4_t b)
+{
+    return vfloat4_cmplt(b, a);
+}
+
+__vmath__ vfloat4_t vfloat4_cmpge(vfloat4_t a, vfloat4_t b)
+{
+    return vfloat4_cmple(b, a);
+}
+
+__vmath__ vfloat4_t vfloat4_cmpeq(vfloat4_t a, vfloat4_t b)
+{
+#if VMATH_NEON_ENABLE
+    return vreinterpretq_f32_u32(vceqq_f32(a, b));
+#elif VMATH_SSE_ENABLE
+    return _mm_cmpeq_ps(a, b);
+#else
+    vfloat4_t r;
+    r.u[0] = a.f[0] == b.f[0] ? ~0u : 0u; r.u[1] = a.f[1] == b.f[1] ? ~0u : 0u;
+    r.u[2] = a.f[2] == b.f[2] ? ~0u : 0u; r.u[3] = a.f[3] == b.f[3] ? ~0u : 0u;
+    return r;
+#endif
+}
+
+/**
+ * Get the sign bits of lanes, lane 0 at bit 0
+ */
+__vmath__ int vfloat4_movemask(vfloat4_t mask)
+{
+#if VMATH_SSE_ENABLE && !VMATH_NEON_ENABLE
+    return _mm_movemask_ps(mask);
+#else
+    float f[4];
+    unsigned int u[4];
+    int i, r = 0;
+    vfloat4_store(f, mask);
+    memcpy(u, f, sizeof(u));
+    for (i = 0; i < 4; i++) r |= (int)(u[i] >> 31) << i;
+    return r;
+#endif
+}
+
+__vmath__ vfloat4_t vfloat4_neg(vfloat4_t v)
+{
+    return vfloat4_xor(v, vfloat4_set1(-0.0f));
+}
+
+__vmath__ vfloat4_t vfloat4_abs(vfloat4_t v)
+{
+    return vfloat4_andnot(vfloat4_set1(-0.0f), v);
+}
+
+/**************************
+ * Integer lanes (32 bits, wrap around)
+ **************************/
+
+__vmath__ vint4_t vint4_set1(int s)
+{
+#if VMATH_NEON_ENABLE
+    return vdupq_n_s32(s);
+#elif VMATH_SSE_ENABLE
+    return _mm_set1_epi32(s);
+#else
+    vint4_t r;
+    r.i[0] = s; r.i[1] = s; r.i[2] = s; r.i[3] = s;
+    return r;
+#endif
+}
+
+__vmath__ vint4_t vint4_set(int x, int y, int z, int w)
+{
+#if VMATH_NEON_ENABLE
+    const int i[4] = { x, y, z, w };
+    return vld1q_s32(i);
+#elif VMATH_SSE_ENABLE
+    return _mm_setr_epi32(x, y, z, w);
+#else
+    vint4_t r;
+    r.i[0] = x; r.i[1] = y; r.i[2] = z; r.i[3] = w;
+    return r;
+#endif
+}
+
+__vmath__ vint4_t vint4_load(const int* ptr)
+{
+#if VMATH_NEON_ENABLE
+    return vld1q_s32(ptr);
+#elif VMATH_SSE_ENABLE
+    return _mm_loadu_si128((const __m128i*)ptr);
+#else
+    return vint4_set(ptr[0], ptr[1], ptr[2], ptr[3]);
+#endif
+}
+
+__vmath__ void vint4_store(int* ptr, vint4_t v)
+{
+#if VMATH_NEON_ENABLE
+    vst1q_s32(ptr, v);
+#elif VMATH_SSE_ENABLE
+    _mm_storeu_si128((__m128i*)ptr, v);
+#else
+    ptr[0] = v.i[0]; ptr[1] = v.i[1]; ptr[2] = v.i[2]; ptr[3] = v.i[3];
+#endif
+}
+
+/**
+ * Load 4 signed 16 bits integers, sign extended
+ */
+__vmath__ vint4_t vint4_loadi16(const short* ptr)
+{
+#if VMATH_NEON_ENABLE
+    return vmovl_s16(vld1_s16(ptr));
+#elif VMATH_SSE_ENABLE
+    const __m128i v = _mm_loadl_epi64((const __m128i*)ptr);
+    return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+#else
+    return vint4_set(ptr[0], ptr[1], ptr[2], ptr[3]);
+#endif
+}
+
+__vmath__ vint4_t vint4_add(vint4_t a, vint4_t b)
+{
+#if VMATH_NEON_ENABLE
+    return vaddq_s32(a, b);
+#elif VMATH_SSE_ENABLE
+    return _mm_add_epi32(a, b);
+#else
+    vint4_t r;
+    r.u[0] = a.u[0] + b.u[0]; r.u[1] = a.u[1] + b.u[1];
+    r.u[2] = a.u[2] + b.u[2]; r.u[3] = a.u[3] + b.u[3];
+    return r;
+#endif
+}
+
+__vmath__ vint4_t vint4_sub(vint4_t a, vint4_t b)
+{
+#if VMATH_NEON_ENABLE
+    return vsubq_s32(a, b);
+#elif VMATH_SSE_ENABLE
+    return _mm_sub_epi32(a, b);
+#else
+    vint4_t r;
+    r.u[0] = a.u[0] - b.u[0]; r.u[1] = a.u[1] - b.u[1];
+    r.u[2] = a.u[2] - b.u[2]; r.u[3] = a.u[3] - b.u[3];
+    return r;
+#endif
+}
+
+/**
+ * Multiplication, keep the low 32 bits
+ */
+__vmath__ vint4_t vint4_mul(vint4_t a, vint4_t b)
+{
+#if VMATH_NEON_ENABLE
+    return vmulq_s32(a, b);
+#elif VMATH_SSE_ENABLE && defined(__SSE4_1__)
+    return _mm_mullo_epi32(a, b);
+#elif VMATH_SSE_ENABLE
+    const __m128i even = _mm_mul_epu32(a, b);
+    const __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd,  _MM_SHUFFLE(0, 0, 2, 0)));
+#else
+    vint4_t r;
+    r.u[0] = a.u[0] * b.u[0]; r.u[1] = a.u[1] * b.u[1];
+    r.u[2] = a.u[2] * b.u[2]; r.u[3] = a.u[3] * b.u[3];
+    return r;
+#endif
+}
+
+__vmath__ vint4_t vint4_and(vint4_t a, vint4_t b)
+{
+#if VMATH_NEON_ENABLE
+    return vandq_s32(a, b);
+#elif VMATH_SSE_ENABLE
+    return _mm_and_si128(a, b);
+#else
+    vint4_t r;
+    r.u[0] = a.u[0] & b.u[0]; r.u[1] = a.u[1] & b.u[1];
+    r.u[2] = a.u[2] & b.u[2]; r.u[3] = a.u[3] & b.u[3];
+    return r;
+#endif
+}
+
+__vmath__ vint4_t vint4_or(vint4_t a, vint4_t b)
+{
+#if VMATH_NEON_ENABLE
+    return vorrq_s32(a, b);
+#elif VMATH_SSE_ENABLE
+    return _mm_or_si128(a, b);
+#else
+    vint4_t r;
+    r.u[0] = a.u[0] | b.u[0]; r.u[1] = a.u[1] | b.u[1];
+    r.u[2] = a.u[2] | b.u[2]; r.u[3] = a.u[3] | b.u[3];
+    return r;
+#endif
+}
+
+__vmath__ vint4_t vint4_xor(vint4_t a, vint4_t b)
+{
+#if VMATH_NEON_ENABLE
+    return veorq_s32(a, b);
+#elif VMATH_SSE_ENABLE
+    return _mm_xor_si128(a, b);
+#else
+    vint4_t r;
+    r.u[0] = a.u[0] ^ b.u[0]; r.u[1] = a.u[1] ^ b.u[1];
+    r.u[2] = a.u[2] ^ b.u[2]; r.u[3] = a.u[3] ^ b.u[3];
+    return r;
+#endif
+}
+
+/**
+ * Logical shift left
+ */
+__vmath__ vint4_t vint4_sll(vint4_t v, int n)
+{
+#if VMATH_NEON_ENABLE
+    return vshlq_s32(v, vdupq_n_s32(n));
+#elif VMATH_SSE_ENABLE
+    return _mm_slli_epi32(v, n);
+#else
+    vint4_t r;
+    r.u[0] = v.u[0] << n; r.u[1] = v.u[1] << n;
+    r.u[2] = v.u[2] << n; r.u[3] = v.u[3] << n;
+    return r;
+#endif
+}
+
+/**
+ * Logical shift right (fill with zero bits)
+ */
+__vmath__ vint4_t vint4_srl(vint4_t v, int n)
+{
+#if VMATH_NEON_ENABLE
+    return vreinterpretq_s32_u32(vshlq_u32(vreinterpretq_u32_s32(v), vdupq_n_s32(-n)));
+#elif VMATH_SSE_ENABLE
+    return _mm_srli_epi32(v, n);
+#else
+    vint4_t r;
+    r.u[0] = v.u[0] >> n; r.u[1] = v.u[1] >> n;
+    r.u[2] = v.u[2] >> n; r.u[3] = v.u[3] >> n;
+    return r;
+#endif
+}
+
+__vmath__ vint4_t vint4_cmpeq(vint4_t a, vint4_t b)
+{
+#if VMATH_NEON_ENABLE
+    return vreinterpretq_s32_u32(vceqq_s32(a, b));
+#elif VMATH_SSE_ENABLE
+    return _mm_cmpeq_epi32(a, b);
+#else
+    vint4_t r;
+    r.i[0] = -(a.i[0] == b.i[0]); r.i[1] = -(a.i[1] == b.i[1]);
+    r.i[2] = -(a.i[2] == b.i[2]); r.i[3] = -(a.i[3] == b.i[3]);
+    return r;
+#endif
+}
+
+/**
+ * Signed compare a < b
+ */
+__vmath__ vint4_t vint4_cmplt(vint4_t a, vint4_t b)
+{
+#if VMATH_NEON_ENABLE
+    return vreinterpretq_s32_u32(vcltq_s32(a, b));
+#elif VMATH_SSE_ENABLE
+    return _mm_cmplt_epi32(a, b);
+#else
+    vint4_t r;
+    r.i[0] = -(a.i[0] < b.i[0]); r.i[1] = -(a.i[1] < b.i[1]);
+    r.i[2] = -(a.i[2] < b.i[2]); r.i[3] = -(a.i[3] < b.i[3]);
+    return r;
+#endif
+}
+
+/**************************
+ * Conversions
+ **************************/
+
+/**
+ * Reinterpret bits of integer lanes as float lanes
+ */
+__vmath__ vfloat4_t vint4_asfloat(vint4_t v)
+{
+#if VMATH_NEON_ENABLE
+    return vreinterpretq_f32_s32(v);
+#elif VMATH_SSE_ENABLE
+    return _mm_castsi128_ps(v);
+#else
+    vfloat4_t r;
+    r.u[0] = v.u[0]; r.u[1] = v.u[1]; r.u[2] = v.u[2]; r.u[3] = v.u[3];
+    return r;
+#endif
+}
+
+/**
+ * Reinterpret bits of float lanes as integer lanes
+ */
+__vmath__ vint4_t vfloat4_asint(vfloat4_t v)
+{
+#if VMATH_NEON_ENABLE
+    return vreinterpretq_s32_f32(v);
+#elif VMATH_SSE_ENABLE
+    return _mm_castps_si128(v);
+#else
+    vint4_t r;
+    r.u[0] = v.u[0]; r.u[1] = v.u[1]; r.u[2] = v.u[2]; r.u[3] = v.u[3];
+    return r;
+#endif
+}
+
+/**
+ * Convert integer lanes to float lanes
+ */
+__vmath__ vfloat4_t vint4_tofloat(vint4_t v)
+{
+#if VMATH_NEON_ENABLE
+    return vcvtq_f32_s32(v);
+#elif VMATH_SSE_ENABLE
+    return _mm_cvtepi32_ps(v);
+#else
+    return vfloat4_set((float)v.i[0], (float)v.i[1], (float)v.i[2], (float)v.i[3]);
+#endif
+}
+
+/**
+ * Convert float lanes to integer lanes, round toward zero
+ * @note: lanes must be in range of int
+ */
+__vmath__ vint4_t vfloat4_toint(vfloat4_t v)
+{
+#if VMATH_NEON_ENABLE
+    return vcvtq_s32_f32(v);
+#elif VMATH_SSE_ENABLE
+    return _mm_cvttps_epi32(v);
+#else
+    return vint4_set((int)v.f[0], (int)v.f[1], (int)v.f[2], (int)v.f[3]);
+#endif
+}
+
+/**
+ * Round toward negative infinity
+ * @note: lanes must be in range of int
+ */
+__vmath__ vfloat4_t vfloat4_floor(vfloat4_t v)
+{
+    const vfloat4_t t = vint4_tofloat(vfloat4_toint(v));
+    return vfloat4_sub(t, vfloat4_and(vfloat4_cmpgt(t, v), vfloat4_set1(1.0f)));
+}
+
+/**
+ * Fractional part: v - floor(v)
+ */
+__vmath__ vfloat4_t vfloat4_frac(vfloat4_t v)
+{
+    return vfloat4_sub(v, vfloat4_floor(v));
+}
+
+/**
+ * Transpose 4 lanes of 4 rows, so rows become columns
+ */
+__vmath__ void vfloat4_transpose(vfloat4_t* r0, vfloat4_t* r1, vfloat4_t* r2, vfloat4_t* r3)
+{
+#if VMATH_SSE_ENABLE && !VMATH_NEON_ENABLE
+    _MM_TRANSPOSE4_PS(*r0, *r1, *r2, *r3);
+#else
+    float m[4][4];
+    vfloat4_store(m[0], *r0);
+    vfloat4_store(m[1], *r1);
+    vfloat4_store(m[2], *r2);
+    vfloat4_store(m[3], *r3);
+    *r0 = vfloat4_set(m[0][0], m[1][0], m[2][0], m[3][0]);
+    *r1 = vfloat4_set(m[0][1], m[1][1], m[2][1], m[3][1]);
+    *r2 = vfloat4_set(m[0][2], m[1][2], m[2][2], m[3][2]);
+    *r3 = vfloat4_set(m[0][3], m[1][3], m[2][3], m[3][3]);
+#endif
+}
+
+/**************************
+ * Elementary functions
+ **************************/
+
+/**
+ * Sine and cosine of lanes (Cephes polynomials, ~1 ulp on [-8192, 8192])
+ */
+__vmath__ void vfloat4_sincos(vfloat4_t v, vfloat4_t* s, vfloat4_t* c)
+{
+    const vfloat4_t sign = vfloat4_and(v, vfloat4_set1(-0.0f));
+    const vfloat4_t x    = vfloat4_abs(v);
+
+    /* Octant of x, round up to even */
+    vint4_t j = vfloat4_toint(vfloat4_mul(x, vfloat4_set1(1.27323954473516f)));
+    j = vint4_and(vint4_add(j, vint4_set1(1)), vint4_set1(~1));
+
+    const vfloat4_t y = vint4_tofloat(j);
+    vfloat4_t r = vfloat4_nmadd(y, vfloat4_set1(0.78515625f), x);
+    r = vfloat4_nmadd(y, vfloat4_set1(2.4187564849853515625e-4f), r);
+    r = vfloat4_nmadd(y, vfloat4_set1(3.77489497744594108e-8f), r);
+
+    const vfloat4_t z  = vfloat4_mul(r, r);
+    const vfloat4_t ps = vfloat4_madd(vfloat4_mul(vfloat4_madd(vfloat4_madd(z, vfloat4_set1(-1.9515295891e-4f), vfloat4_set1(8.3321608736e-3f)),
+                                                               z, vfloat4_set1(-1.6666654611e-1f)), z), r, r);
+    const vfloat4_t pc = vfloat4_add(vfloat4_nmadd(z, vfloat4_set1(0.5f),
+                                                   vfloat4_mul(vfloat4_mul(vfloat4_madd(vfloat4_madd(z, vfloat4_set1(2.443315711809948e-5f), vfloat4_set1(-1.388731625493765e-3f)),
+                                                                                        z, vfloat4_set1(4.166664568298827e-2f)), z), z)),
+                                     vfloat4_set1(1.0f));
+
+    /* Octants 1, 2, 5, 6 swap the polynomials */
+    const vfloat4_t swap = vint4_asfloat(vint4_cmpeq(vint4_and(j, vint4_set1(2)), vint4_set1(2)));
+    const vfloat4_t ssin = vfloat4_xor(sign, vint4_asfloat(vint4_sll(vint4_and(j, vint4_set1(4)), 29)));
+    const vfloat4_t scos = vint4_asfloat(vint4_sll(vint4_and(vint4_add(j, vint4_set1(2)), vint4_set1(4)), 29));
+
+    *s = vfloat4_xor(vfloat4_select(ps, pc, swap), ssin);
+    *c = vfloat4_xor(vfloat4_select(pc, ps, swap), scos);
+}
+
+/**
+ * Arc tangent of y / x in the quadrant of (x, y) (Cephes polynomial,
+ * ~2 ulp), atan2(0, 0) is 0
+ */
+__vmath__ vfloat4_t vfloat4_atan2(vfloat4_t y, vfloat4_t x)
+{
+    const vfloat4_t one = vfloat4_set1(1.0f);
+    const vfloat4_t ax  = vfloat4_abs(x);
+    const vfloat4_t ay  = vfloat4_abs(y);
+    vfloat4_t a = vfloat4_div(vfloat4_min(ax, ay), vfloat4_max(vfloat4_max(ax, ay), vfloat4_set1(FLT_MIN)));
+
+    /* Reduce [tan(pi / 8), 1] around pi / 4 */
+    const vfloat4_t big = vfloat4_cmpgt(a, vfloat4_set1(0.4142135624f));
+    a = vfloat4_select(a, vfloat4_div(vfloat4_sub(a, one), vfloat4_add(a, one)), big);
+
+    const vfloat4_t z = vfloat4_mul(a, a);
+    vfloat4_t p = vfloat4_madd(z, vfloat4_set1(8.05374449538e-2f), vfloat4_set1(-1.38776856032e-1f));
+    p = vfloat4_madd(p, z, vfloat4_set1(1.99777106478e-1f));
+    p = vfloat4_madd(p, z, vfloat4_set1(-3.33329491539e-1f));
+    p = vfloat4_madd(vfloat4_mul(p, z), a, a);
+    p = vfloat4_add(p, vfloat4_and(big, vfloat4_set1(0.7853981634f)));
+
+    /* Unfold the octant */
+    p = vfloat4_select(p, vfloat4_sub(vfloat4_set1(1.5707963268f), p), vfloat4_cmpgt(ay, ax));
+    p = vfloat4_select(p, vfloat4_sub(vfloat4_set1(3.1415926536f), p), vfloat4_cmplt(x, vfloat4_zero()));
+    return vfloat4_xor(p, vfloat4_and(y, vfloat4_set1(-0.0f)));
+}
+
+/**
+ * Base 2 exponent of lanes, ~1 ulp, input is clamped to [-126, 126]
+ */
+__vmath__ vfloat4_t vfloat4_exp2(vfloat4_t v)
+{
+    const vfloat4_t x = vfloat4_clamp(v, vfloat4_set1(-126.0f), vfloat4_set1(126.0f));
+    const vfloat4_t i = vfloat4_floor(vfloat4_add(x, vfloat4_set1(0.5f)));
+    const vfloat4_t f = vfloat4_sub(x, i);
+
+    /* Taylor series of 2^f on [-0.5, 0.5] */
+    vfloat4_t p = vfloat4_set1(1.5403530393381609954e-4f);
+    p = vfloat4_madd(p, f, vfloat4_set1(1.3333558146428443423e-3f));
+    p = vfloat4_madd(p, f, vfloat4_set1(9.6181291076284771620e-3f));
+    p = vfloat4_madd(p, f, vfloat4_set1(5.5504108664821579953e-2f));
+    p = vfloat4_madd(p, f, vfloat4_set1(2.4022650695910071233e-1f));
+    p = vfloat4_madd(p, f, vfloat4_set1(6.9314718055994530942e-1f));
+    p = vfloat4_madd(p, f, vfloat4_set1(1.0f));
+
+    /* Scale by 2^i, built from the exponent bits */
+    const vint4_t e = vint4_sll(vint4_add(vfloat4_toint(i), vint4_set1(127)), 23);
+    return vfloat4_mul(p, vint4_asfloat(e));
+}
+
+/**
+ * Base 2 logarithm of positive lanes, ~1 ulp
+ */
+__vmath__ vfloat4_t vfloat4_log2(vfloat4_t v)
+{
+    const vint4_t bits = vfloat4_asint(v);
+
+    /* v = m * 2^e, m in [sqrt(0.5), sqrt(2)) */
+    vint4_t   e = vint4_sub(vint4_and(vint4_srl(bits, 23), vint4_set1(0xff)), vint4_set1(127));
+    vfloat4_t m = vint4_asfloat(vint4_or(vint4_and(bits, vint4_set1(0x7fffff)), vint4_set1(0x3f800000)));
+
+    const vfloat4_t big = vfloat4_cmpgt(m, vfloat4_set1(1.41421356237f));
+    m = vfloat4_select(m, vfloat4_mul(m, vfloat4_set1(0.5f)), big);
+    e = vint4_sub(e, vfloat4_asint(big));
+
+    /* equation: ln(m) = 2 * atanh(s), s = (m - 1) / (m + 1) */
+    const vfloat4_t s  = vfloat4_div(vfloat4_sub(m, vfloat4_set1(1.0f)), vfloat4_add(m, vfloat4_set1(1.0f)));
+    const vfloat4_t s2 = vfloat4_mul(s, s);
+    vfloat4_t p = vfloat4_set1(2.0f / 9.0f);
+    p = vfloat4_madd(p, s2, vfloat4_set1(2.0f / 7.0f));
+    p = vfloat4_madd(p, s2, vfloat4_set1(2.0f / 5.0f));
+    p = vfloat4_madd(p, s2, vfloat4_set1(2.0f / 3.0f));
+    p = vfloat4_madd(p, s2, vfloat4_set1(2.0f));
+
+    return vfloat4_madd(vfloat4_mul(p, s), vfloat4_set1(1.44269504089f), vint4_tofloat(e));
+}
+
+/**
+ * Power of positive lanes: exp2(y * log2(x))
+ */
+__vmath__ vfloat4_t vfloat4_pow(vfloat4_t x, vfloat4_t y)
+{
+    return vfloat4_exp2(vfloat4_mul(y, vfloat4_log2(x)));
+}
+
+#endif /* __VMATH_SOA_H__ */
@@ -0,0 +1,730 @@
+/******************************************************
+ * vmath_solve - Small linear system solvers
+ *
+ * @author: MaiHD
+ * @license: NULL
+ * @copyright: MaiHD @ ${HOME}, 2017 - 2018
+ ******************************************************/
+
+#ifndef __VMATH_SOLVE_H__
+#define __VMATH_SOLVE_H__
+
+#include "vmath_soa.h"
+
+/**
+ * Solve x from mat3_mulv3(a, x) = b (or mat4_mulv4), the library multiply
+ * a row vector by the matrix, so the system is transpose(a) x = b.
+ *
+ *  - LU with partial pivoting: any square system
+ *  - Cholesky:                 symmetric positive definite, twice faster
+ *  - Householder QR with column pivoting: rank deficient and badly
+ *    conditioned systems, a least squares solution when rank deficient
+ *
+ * Every solver fill a vmath_solve_info_t:
+ *  - rank:  number of pivots greater than n * FLT_EPSILON * largest pivot
+ *  - rcond: smallest / largest pivot, a cheap estimate of 1 / condition,
+ *           0 for a singular system
+ * Unknowns of a zero pivot are set to 0, the solution stay finite.
+ *
+ * Raw factorizations work on n x n row-major float arrays (n <= 4) in the
+ * usual column vector form A x = b, and can be reused for many b.
+ */
+
+/**
+ * Diagnostics of a solve
+ */
+typedef struct vmath_solve_info
+{
+    int   rank;
+    float rcond;
+} vmath_solve_info_t;
+
+/**
+ * Rank and rcond from the pivots of a factorization, return the rank
+ */
+__vmath__ int vmath_solve_diagnose(const float* pivots, int n, vmath_solve_info_t* info)
+{
+    float lo = fabsf(pivots[0]), hi = lo, tol;
+    int   i, rank = 0;
+    for (i = 1; i < n; i++)
+    {
+        const float p = fabsf(pivots[i]);
+        lo = p < lo ? p : lo;
+        hi = p > hi ? p : hi;
+    }
+
+    tol = hi * (float)n * FLT_EPSILON;
+    for (i = 0; i < n; i++)
+    {
+        rank += fabsf(pivots[i]) > tol;
+    }
+
+    if (info)
+    {
+        info->rank  = rank;
+        info->rcond = hi > 0.0f && rank == n ? lo / hi : 0.0f;
+    }
+    return rank;
+}
+
+/********************
+ * LU
+ ********************/
+
+/**
+ * Factor a = P L U in place, L has a unit diagonal
+ * @param perm: row of a in each row of LU
+ * @return: 1 when a is full rank
+ */
+__vmath_batch__ int vmath_lu(float* a, int n, int* perm, vmath_solve_info_t* info)
+{
+    float pivots[4];
+    int   i, j, k;
+
+    for (i = 0; i < n; i++)
+    {
+        perm[i] = i;
+    }
+
+    for (k = 0; k < n; k++)
+    {
+        /* Partial pivoting: largest magnitude of the column */
+        int p = k;
+        for (i = k + 1; i < n; i++)
+        {
+            p = fabsf(a[i * n + k]) > fabsf(a[p * n + k]) ? i : p;
+        }
+        if (p != k)
+        {
+            int t = perm[k]; perm[k] = perm[p]; perm[p] = t;
+            for (j = 0; j < n; j++)
+            {
+                const float s = a[k * n + j];
+                a[k * n + j]  = a[p * n + j];
+                a[p * n + j]  = s;
+            }
+        }
+
+        pivots[k] = a[k * n + k];
+        if (pivots[k] != 0.0f)
+        {
+            const float inv = 1.0f / pivots[k];
+            for (i = k + 1; i < n; i++)
+            {
+                const float f = a[i * n + k] *= inv;
+                for (j = k + 1; j < n; j++)
+                {
+                    a[i * n + j] -= f * a[k * n + j];
+                }
+            }
+        }
+    }
+
+    return vmath_solve_diagnose(pivots, n, info) == n;
+}
+
+/**
+ * Solve with a factorization of vmath_lu
+ */
+__vmath_batch__ void vmath_lu_solve(const float* lu, int n, const int* perm, const float* b, float* x)
+{
+    float y[4], tol = 0.0f;
+    int   i, j;
+
+    for (i = 0; i < n; i++)
+    {
+        float s = b[perm[i]];
+        for (j = 0; j < i; j++)
+        {
+            s -= lu[i * n + j] * y[j];
+        }
+        y[i] = s;
+        tol  = fabsf(lu[i * n + i]) > tol ? fabsf(lu[i * n + i]) : tol;
+    }
+
+    tol *= (float)n * FLT_EPSILON;
+    for (i = n - 1; i >= 0; i--)
+    {
+        float s = y[i];
+        for (j = i + 1; j < n; j++)
+        {
+            s -= lu[i * n + j] * x[j];
+        }
+        x[i] = fabsf(lu[i * n + i]) > tol ? s / lu[i * n + i] : 0.0f;
+    }
+}
+
+/********************
+ * Cholesky
+ ********************/
+
+/**
+ * Factor a = L transpose(L) in place, only the lower triangle is used
+ * @return: 1 when a is positive definite
+ */
+__vmath_batch__ int vmath_cholesky(float* a, int n, vmath_solve_info_t* info)
+{
+    float pivots[4];
+    int   i, j, k, spd = 1;
+
+    for (j = 0; j < n; j++)
+    {
+        float d = a[j * n + j];
+        for (k = 0; k < j; k++)
+        {
+            d -= a[j * n + k] * a[j * n + k];
+        }
+
+        /* Not positive definite: stop the column here */
+        d = d > 0.0f ? sqrtf(d) : 0.0f;
+        spd &= d > 0.0f;
+        a[j * n + j] = d;
+        pivots[j]    = d * d;
+
+        for (i = j + 1; i < n; i++)
+        {
+            float s = a[i * n + j];
+            for (k = 0; k < j; k++)
+            {
+                s -= a[i * n + k] * a[j * n + k];
+            }
+            a[i * n + j] = d > 0.0f ? s / d : 0.0f;
+        }
+    }
+
+    if (vmath_solve_diagnose(pivots, n, info) < n || !spd)
+    {
+        if (info)
+        {
+            info->rcond = 0.0f;
+        }
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Solve with a factorization of vmath_cholesky
+ */
+__vmath_batch__ void vmath_cholesky_solve(const float* l, int n, const float* b, float* x)
+{
+    float y[4];
+    int   i, j;
+
+    for (i = 0; i < n; i++)
+    {
+        float s = b[i];
+        for (j = 0; j < i; j++)
+        {
+            s -= l[i * n + j] * y[j];
+        }
+        y[i] = l[i * n + i] > 0.0f ? s / l[i * n + i] : 0.0f;
+    }
+
+    for (i = n - 1; i >= 0; i--)
+    {
+        float s = y[i];
+        for (j = i + 1; j < n; j++)
+        {
+            s -= l[j * n + i] * x[j];
+        }
+        x[i] = l[i * n + i] > 0.0f ? s / l[i * n + i] : 0.0f;
+    }
+}
+
+/********************
+ * QR
+ ********************/
+
+/**
+ * Factor a P = Q R in place with Householder reflections and column
+ * pivoting: R in the upper triangle, its diagonal decreasing in magnitude,
+ * reflectors v (v[k] = 1 implied) below the diagonal
+ * @param beta: scale of each reflector, H = I - beta v transpose(v)
+ * @param perm: column of a in each column of R
+ * @return: 1 when a is full rank
+ */
+__vmath_batch__ int vmath_qr(float* a, int n, float* beta, int* perm, vmath_solve_info_t* info)
+{
+    float pivots[4];
+    int   i, j, k;
+
+    for (k = 0; k < n; k++)
+    {
+        perm[k] = k;
+    }
+
+    for (k = 0; k < n; k++)
+    {
+        float norm = 0.0f, alpha, v0;
+        int   p = k;
+
+        /* Largest remaining column first, recomputed: n is small and
+           downdated norms lose their accuracy when columns are dependent */
+        for (j = k; j < n; j++)
+        {
+            float s = 0.0f;
+            for (i = k; i < n; i++)
+            {
+                s += a[i * n + j] * a[i * n + j];
+            }
+            if (s > norm)
+            {
+                norm = s;
+                p    = j;
+            }
+        }
+        if (p != k)
+        {
+            for (i = 0; i < n; i++)
+            {
+                const float t = a[i * n + k];
+                a[i * n + k] = a[i * n + p];
+                a[i * n + p] = t;
+            }
+            i = perm[k]; perm[k] = perm[p]; perm[p] = i;
+        }
+        norm = sqrtf(norm);
+
+        /* Reflect to -sign(a_kk) |x| e_k, no cancellation in v0 */
+        alpha = a[k * n + k] > 0.0f ? -norm : norm;
+        v0    = a[k * n + k] - alpha;
+        if (norm == 0.0f || v0 == 0.0f)
+        {
+            beta[k]   = 0.0f;
+            pivots[k] = a[k * n + k];
+            continue;
+        }
+
+        for (i = k + 1; i < n; i++)
+        {
+            a[i * n + k] /= v0;
+        }
+        beta[k] = -v0 / alpha;
+
+        for (j = k + 1; j < n; j++)
+        {
+            float s = a[k * n + j];
+            for (i = k + 1; i < n; i++)
+            {
+                s += a[i * n + k] * a[i * n + j];
+            }
+            s *= beta[k];
+
+            a[k * n + j] -= s;
+            for (i = k + 1; i < n; i++)
+            {
+                a[i * n + j] -= s * a[i * n + k];
+            }
+        }
+
+        a[k * n + k] = alpha;
+        pivots[k]    = alpha;
+    }
+
+    return vmath_solve_diagnose(pivots, n, info) == n;
+}
+
+/**
+ * Solve with a factorization of vmath_qr. When rank deficient, the columns
+ * after the rank are dropped: a least squares solution, with the unknowns
+ * of the dropped columns set to 0 (not the minimum norm one).
+ */
+__vmath_batch__ void vmath_qr_solve(const float* qr, int n, const float* beta, const int* perm, const float* b, float* x)
+{
+    float y[4], z[4], tol = 0.0f;
+    int   i, j, k;
+
+    for (i = 0; i < n; i++)
+    {
+        y[i] = b[i];
+        tol  = fabsf(qr[i * n + i]) > tol ? fabsf(qr[i * n + i]) : tol;
+    }
+
+    /* y = transpose(Q) b */
+    for (k = 0; k < n; k++)
+    {
+        float s = y[k];
+        for (i = k + 1; i < n; i++)
+        {
+            s += qr[i * n + k] * y[i];
+        }
+        s *= beta[k];
+
+        y[k] -= s;
+        for (i = k + 1; i < n; i++)
+        {
+            y[i] -= s * qr[i * n + k];
+        }
+    }
+
+    /* The pivots decrease: the small ones are the trailing columns */
+    tol *= (float)n * FLT_EPSILON;
+    for (i = n - 1; i >= 0; i--)
+    {
+        float s = y[i];
+        for (j = i + 1; j < n; j++)
+        {
+            s -= qr[i * n + j] * z[j];
+        }
+        z[i] = fabsf(qr[i * n + i]) > tol ? s / qr[i * n + i] : 0.0f;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        x[perm[i]] = z[i];
+    }
+}
+
+/********************
+ * Matrix solvers
+ ********************/
+
+#define VMATH_SOLVE_LU          0
+#define VMATH_SOLVE_CHOLESKY    1
+#define VMATH_SOLVE_QR          2
+
+/**
+ * Solve an n x n system of transpose(m) x = b with a method
+ */
+__vmath_batch__ int vmath_solve(const float* m, int n, const float* b, float* x, int method, vmath_solve_info_t* info)
+{
+    float a[16], beta[4];
+    int   perm[4], i, j, ok;
+
+    for (i = 0; i < n; i++)
+    {
+        for (j = 0; j < n; j++)
+        {
+            a[i * n + j] = m[j * n + i];
+        }
+    }
+
+    switch (method)
+    {
+    case VMATH_SOLVE_CHOLESKY:
+        ok = vmath_cholesky(a, n, info);
+        vmath_cholesky_solve(a, n, b, x);
+        break;
+
+    case VMATH_SOLVE_QR:
+        ok = vmath_qr(a, n, beta, perm, info);
+        vmath_qr_solve(a, n, beta, perm, b, x);
+        break;
+
+    default:
+        ok = vmath_lu(a, n, perm, info);
+        vmath_lu_solve(a, n, perm, b, x);
+        break;
+    }
+    return ok;
+}
+
+/**
+ * Solve x from mat3_mulv3(m, x) = b
+ * @return: 1 when the system is full rank (positive definite for Cholesky)
+ */
+__vmath__ int mat3_solve(mat3_t m, vec3_t b, vec3_t* x, int method, vmath_solve_info_t* info)
+{
+    const float bv[3] = { b.x, b.y, b.z };
+    float       xv[3];
+    const int   ok = vmath_solve(m.data, 3, bv, xv, method, info);
+    *x = vec3(xv[0], xv[1], xv[2]);
+    return ok;
+}
+
+/**
+ * Solve x from mat4_mulv4(m, x) = b
+ * @return: 1 when the system is full rank (positive definite for Cholesky)
+ */
+__vmath__ int mat4_solve(mat4_t m, vec4_t b, vec4_t* x, int method, vmath_solve_info_t* info)
+{
+    return vmath_solve(m.data, 4, b.m, x->m, method, info);
+}
+
+/********************
+ * SoA solvers, one system per lane
+ ********************/
+
+/**
+ * LU with partial pivoting of n x n systems a x = b, rows are swapped per
+ * lane with selects
+ * @param rcond: smallest / largest pivot per lane, NULL to skip
+ */
+__vmath__ void vmath_lu_solve_x4(int n, vfloat4_t a[4][4], vfloat4_t b[4], vfloat4_t x[4], vfloat4_t* rcond)
+{
+    const vfloat4_t zero = vfloat4_zero();
+    vfloat4_t inv[4], lo, hi, tol;
+    int i, j, k;
+
+    for (k = 0; k < n; k++)
+    {
+        for (i = k + 1; i < n; i++)
+        {
+            const vfloat4_t swap = vfloat4_cmpgt(vfloat4_abs(a[i][k]), vfloat4_abs(a[k][k]));
+            const vfloat4_t t    = b[k];
+            b[k] = vfloat4_select(b[k], b[i], swap);
+            b[i] = vfloat4_select(b[i], t, swap);
+            for (j = k; j < n; j++)
+            {
+                const vfloat4_t s = a[k][j];
+                a[k][j] = vfloat4_select(a[k][j], a[i][j], swap);
+                a[i][j] = vfloat4_select(a[i][j], s, swap);
+            }
+        }
+
+        inv[k] = vfloat4_div(vfloat4_set1(1.0f), a[k][k]);
+        inv[k] = vfloat4_andnot(vfloat4_cmpeq(a[k][k], zero), inv[k]);
+        for (i = k + 1; i < n; i++)
+        {
+            const vfloat4_t f = vfloat4_mul(a[i][k], inv[k]);
+            for (j = k + 1; j < n; j++)
+            {
+                a[i][j] = vfloat4_nmadd(f, a[k][j], a[i][j]);
+            }
+            b[i] = vfloat4_nmadd(f, b[k], b[i]);
+        }
+    }
+
+    lo = hi = vfloat4_abs(a[0][0]);
+    for (k = 1; k < n; k++)
+    {
+        lo = vfloat4_min(lo, vfloat4_abs(a[k][k]));
+        hi = vfloat4_max(hi, vfloat4_abs(a[k][k]));
+    }
+    tol = vfloat4_mul(hi, vfloat4_set1((float)n * FLT_EPSILON));
+
+    for (i = n - 1; i >= 0; i--)
+    {
+        vfloat4_t s = b[i];
+        for (j = i + 1; j < n; j++)
+        {
+            s = vfloat4_nmadd(a[i][j], x[j], s);
+        }
+        x[i] = vfloat4_and(vfloat4_cmpgt(vfloat4_abs(a[i][i]), tol), vfloat4_mul(s, inv[i]));
+    }
+
+    if (rcond)
+    {
+        const vfloat4_t full = vfloat4_cmpgt(lo, tol);
+        *rcond = vfloat4_and(full, vfloat4_div(lo, vfloat4_max(hi, vfloat4_set1(FLT_MIN))));
+    }
+}
+
+/**
+ * Cholesky of n x n symmetric positive definite systems a x = b, only the
+ * lower triangle of a is used
+ * @param rcond: (smallest / largest diagonal of L)^2 per lane, 0 when not
+ *               positive definite, NULL to skip
+ */
+__vmath__ void vmath_cholesky_solve_x4(int n, vfloat4_t a[4][4], vfloat4_t b[4], vfloat4_t x[4], vfloat4_t* rcond)
+{
+    const vfloat4_t zero = vfloat4_zero();
+    vfloat4_t inv[4], y[4], lo, hi, spd;
+    int i, j, k;
+
+    spd = vfloat4_cmpeq(zero, zero);
+    for (j = 0; j < n; j++)
+    {
+        vfloat4_t d = a[j][j];
+        for (k = 0; k < j; k++)
+        {
+            d = vfloat4_nmadd(a[j][k], a[j][k], d);
+        }
+
+        {
+            const vfloat4_t positive = vfloat4_cmpgt(d, zero);
+            spd     = vfloat4_and(spd, positive);
+            d       = vfloat4_and(positive, vfloat4_sqrt(vfloat4_max(d, zero)));
+            a[j][j] = d;
+            inv[j]  = vfloat4_and(positive, vfloat4_div(vfloat4_set1(1.0f), vfloat4_select(vfloat4_set1(1.0f), d, positive)));
+        }
+
+        for (i = j + 1; i < n; i++)
+        {
+            vfloat4_t s = a[i][j];
+            for (k = 0; k < j; k++)
+            {
+                s = vfloat4_nmadd(a[i][k], a[j][k], s);
+            }
+            a[i][j] = vfloat4_mul(s, inv[j]);
+        }
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        vfloat4_t s = b[i];
+        for (j = 0; j < i; j++)
+        {
+            s = vfloat4_nmadd(a[i][j], y[j], s);
+        }
+        y[i] = vfloat4_mul(s, inv[i]);
+    }
+
+    for (i = n - 1; i >= 0; i--)
+    {
+        vfloat4_t s = y[i];
+        for (j = i + 1; j < n; j++)
+        {
+            s = vfloat4_nmadd(a[j][i], x[j], s);
+        }
+        x[i] = vfloat4_mul(s, inv[i]);
+    }
+
+    if (rcond)
+    {
+        lo = hi = a[0][0];
+        for (k = 1; k < n; k++)
+        {
+            lo = vfloat4_min(lo, a[k][k]);
+            hi = vfloat4_max(hi, a[k][k]);
+        }
+        lo     = vfloat4_div(lo, vfloat4_max(hi, vfloat4_set1(FLT_MIN)));
+        *rcond = vfloat4_and(spd, vfloat4_mul(lo, lo));
+    }
+}
+
+/**
+ * Load up to 4 systems of mat3_mulv3(m, x) = b to lanes, missing lanes
+ * get identity systems
+ */
+__vmath__ void vmath_solve_load3_x4(const mat3_t* m, const vec3_t* b, int count, vfloat4_t a[4][4], vfloat4_t v[4])
+{
+    float lanes[3][3][4], bl[3][4];
+    int   i, j, l;
+
+    for (l = 0; l < 4; l++)
+    {
+        for (i = 0; i < 3; i++)
+        {
+            for (j = 0; j < 3; j++)
+            {
+                lanes[i][j][l] = l < count ? m[l].m[j][i] : (float)(i == j);
+            }
+        }
+        bl[0][l] = l < count ? b[l].x : 0.0f;
+        bl[1][l] = l < count ? b[l].y : 0.0f;
+        bl[2][l] = l < count ? b[l].z : 0.0f;
+    }
+
+    for (i = 0; i < 3; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            a[i][j] = vfloat4_load(lanes[i][j]);
+        }
+        v[i] = vfloat4_load(bl[i]);
+    }
+}
+
+/**
+ * Load up to 4 systems of mat4_mulv4(m, x) = b to lanes, missing lanes
+ * get identity systems
+ */
+__vmath__ void vmath_solve_load4_x4(const mat4_t* m, const vec4_t* b, int count, vfloat4_t a[4][4], vfloat4_t v[4])
+{
+    static const float identity[4][4] = { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } };
+    int i, j;
+
+    /* Row i of the 4 matrices transposed is column i of a */
+    for (i = 0; i < 4; i++)
+    {
+        vfloat4_t r[4];
+        for (j = 0; j < 4; j++)
+        {
+            r[j] = vfloat4_load(j < count ? m[j].m[i] : identity[i]);
+        }
+        vfloat4_transpose(&r[0], &r[1], &r[2], &r[3]);
+        for (j = 0; j < 4; j++)
+        {
+            a[j][i] = r[j];
+        }
+    }
+
+    for (j = 0; j < 4; j++)
+    {
+        v[j] = j < count ? vfloat4_load(b[j].m) : vfloat4_zero();
+    }
+    vfloat4_transpose(&v[0], &v[1], &v[2], &v[3]);
+}
+
+/**
+ * Solve many systems of mat3_mulv3(m[i], x[i]) = b[i], 8 per loop
+ * @param method: VMATH_SOLVE_LU or VMATH_SOLVE_CHOLESKY
+ * @param rcond:  estimate of 1 / condition of each system, NULL to skip
+ */
+__vmath_batch__ void mat3_solve_batch(const mat3_t* m, const vec3_t* b, vec3_t* x, float* rcond, int count, int method)
+{
+    int i, g;
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = i; g < i + 8 && g < count; g += 4)
+        {
+            const int n = count - g < 4 ? count - g : 4;
+            vfloat4_t a[4][4], v[4], r[4], c;
+            int l;
+
+            vmath_solve_load3_x4(m + g, b + g, n, a, v);
+            if (method == VMATH_SOLVE_CHOLESKY)
+            {
+                vmath_cholesky_solve_x4(3, a, v, r, rcond ? &c : 0);
+            }
+            else
+            {
+                vmath_lu_solve_x4(3, a, v, r, rcond ? &c : 0);
+            }
+
+            r[3] = vfloat4_zero();
+            vfloat4_transpose(&r[0], &r[1], &r[2], &r[3]);
+            for (l = 0; l < n; l++)
+            {
+                x[g + l] = vec3(vfloat4_get(r[l], 0), vfloat4_get(r[l], 1), vfloat4_get(r[l], 2));
+            }
+            if (rcond)
+            {
+                vfloat4_storen(rcond + g, c, n);
+            }
+        }
+    }
+}
+
+/**
+ * Solve many systems of mat4_mulv4(m[i], x[i]) = b[i], 8 per loop
+ * @param method: VMATH_SOLVE_LU or VMATH_SOLVE_CHOLESKY
+ * @param rcond:  estimate of 1 / condition of each system, NULL to skip
+ */
+__vmath_batch__ void mat4_solve_batch(const mat4_t* m, const vec4_t* b, vec4_t* x, float* rcond, int count, int method)
+{
+    int i, g;
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = i; g < i + 8 && g < count; g += 4)
+        {
+            const int n = count - g < 4 ? count - g : 4;
+            vfloat4_t a[4][4], v[4], r[4], c;
+            int l;
+
+            vmath_solve_load4_x4(m + g, b + g, n, a, v);
+            if (method == VMATH_SOLVE_CHOLESKY)
+            {
+                vmath_cholesky_solve_x4(4, a, v, r, rcond ? &c : 0);
+            }
+            else
+            {
+                vmath_lu_solve_x4(4, a, v, r, rcond ? &c : 0);
+            }
+
+            vfloat4_transpose(&r[0], &r[1], &r[2], &r[3]);
+            for (l = 0; l < n; l++)
+            {
+                vfloat4_store(x[g + l].m, r[l]);
+            }
+            if (rcond)
+            {
+                vfloat4_storen(rcond + g, c, n);
+            }
+        }
+    }
+}
+
+#endif /* __VMATH_SOLVE_H__ */
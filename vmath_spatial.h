@@ -0,0 +1,749 @@
+/******************************************************
+ * vmath_spatial - Morton and Hilbert keys, radix sort by key
+ *
+ * @author: MaiHD
+ * @license: NULL
+ * @copyright: MaiHD @ ${HOME}, 2017 - 2018
+ ******************************************************/
+
+#ifndef __VMATH_SPATIAL_H__
+#define __VMATH_SPATIAL_H__
+
+#include <stdint.h>
+#include <string.h>
+
+#include "vmath.h"
+#include "vmath_soa.h"
+#include "vmath_jobs.h"
+#include "vmath_memory.h"
+
+/**
+ * Usage: define VMATH_IMPL before include this file in one source file.
+ *
+ * Sort items by the key of the grid cell of their position, so items close
+ * in space are close in memory and the neighbourhood, BVH... passes which
+ * follow read fewer cache lines:
+ *     grid = vmath_grid(min, max);
+ *     vmath_hilbert30_array(keys, positions, count, &grid);
+ *     vmath_radix_sort32(keys, order, count);
+ *     vmath_reorder(order, count, arrays, sizes, array_count);
+ *
+ * Morton keys interleave the bits of the cell, x in the lowest bit. Hilbert
+ * keys (Skilling's transpose) follow a curve without the jumps of Morton
+ * order: cells of consecutive keys are always face neighbours.
+ * 30 bits keys take 10 bits per axis, 63 bits keys 21 bits per axis.
+ *
+ * The array encoders quantize and run the Hilbert transform 4 points per
+ * step on vmath_soa.h lanes. 30 bits keys are interleaved in lanes too,
+ * 63 bits keys in scalar registers, with BMI2 pdep/pext when
+ * VMATH_SPATIAL_PDEP is set: by default when the build target has BMI2
+ * (-mbmi2, -march=haswell). Set it to 0 for AMD cores before Zen 3,
+ * where pdep is microcoded.
+ *
+ * The radix sort and vmath_reorder split their work with vmath_parallel_for:
+ * they are multi-threaded after vmath_jobs_init(), serial before.
+ */
+
+#ifndef VMATH_SPATIAL_PDEP
+#  if defined(__BMI2__)
+#    define VMATH_SPATIAL_PDEP 1
+#  else
+#    define VMATH_SPATIAL_PDEP 0
+#  endif
+#endif
+
+#if VMATH_SPATIAL_PDEP
+#include <immintrin.h>
+#endif
+
+/**
+ * Grid cell coordinates
+ */
+typedef union vmath_ivec3
+{
+    struct
+    {
+        int x, y, z;
+    };
+    int m[3];
+} ivec3_t;
+
+/**
+ * Map from the bounds of the points to the unit cube
+ */
+typedef struct vmath_grid
+{
+    vec3_t min;
+    vec3_t scale;           /* 1 / (max - min), 0 for a flat axis */
+} vmath_grid_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Sort keys, stable, order[i] receive the old index of the item i
+ * @return: 0 when out of memory, keys are not changed then
+ */
+int vmath_radix_sort32(uint32_t* keys, int* order, int count);
+
+/**
+ * Sort keys, stable, order[i] receive the old index of the item i
+ * @return: 0 when out of memory, keys are not changed then
+ */
+int vmath_radix_sort64(uint64_t* keys, int* order, int count);
+
+/**
+ * Reorder arrays in place: item i become the old item order[i]
+ * @param sizes: item size in bytes of each array
+ * @return: 0 when out of memory, arrays are not changed then
+ */
+int vmath_reorder(const int* order, int count, void* const* arrays, const int* sizes, int array_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+__vmath__ ivec3_t ivec3(int x, int y, int z)
+{
+    ivec3_t r;
+    r.x = x;
+    r.y = y;
+    r.z = z;
+    return r;
+}
+
+/**
+ * Grid over the bounds of the points
+ */
+__vmath__ vmath_grid_t vmath_grid(vec3_t min, vec3_t max)
+{
+    vmath_grid_t grid;
+    int i;
+    grid.min   = min;
+    grid.scale = vec3(0.0f, 0.0f, 0.0f);
+    for (i = 0; i < 3; i++)
+    {
+        grid.scale.m[i] = max.m[i] > min.m[i] ? 1.0f / (max.m[i] - min.m[i]) : 0.0f;
+    }
+    return grid;
+}
+
+/**
+ * Cell of a point on a grid of 2^bits cells per axis, clamped to the grid
+ */
+__vmath__ ivec3_t vmath_grid_cell(const vmath_grid_t* grid, vec3_t p, int bits)
+{
+    const float cells = (float)(1 << bits);
+    const float last  = cells - 1.0f;
+    ivec3_t r;
+    int i;
+    for (i = 0; i < 3; i++)
+    {
+        const float c = (p.m[i] - grid->min.m[i]) * (grid->scale.m[i] * cells);
+        r.m[i] = (int)(c < 0.0f ? 0.0f : (c > last ? last : c));
+    }
+    return r;
+}
+
+/**************************
+ * Bit interleaving
+ **************************/
+
+/**
+ * Spread the low 10 bits of v to every third bit
+ */
+__vmath__ uint32_t vmath_spread10(uint32_t v)
+{
+#if VMATH_SPATIAL_PDEP
+    return _pdep_u32(v, 0x09249249u);
+#else
+    v &= 0x3FFu;
+    v = (v | (v << 16)) & 0x030000FFu;
+    v = (v | (v << 8))  & 0x0300F00Fu;
+    v = (v | (v << 4))  & 0x030C30C3u;
+    v = (v | (v << 2))  & 0x09249249u;
+    return v;
+#endif
+}
+
+/**
+ * Gather every third bit of v, inverse of vmath_spread10
+ */
+__vmath__ uint32_t vmath_compact10(uint32_t v)
+{
+#if VMATH_SPATIAL_PDEP
+    return _pext_u32(v, 0x09249249u);
+#else
+    v &= 0x09249249u;
+    v = (v ^ (v >> 2))  & 0x030C30C3u;
+    v = (v ^ (v >> 4))  & 0x0300F00Fu;
+    v = (v ^ (v >> 8))  & 0x030000FFu;
+    v = (v ^ (v >> 16)) & 0x3FFu;
+    return v;
+#endif
+}
+
+/**
+ * Spread the low 21 bits of v to every third bit
+ */
+__vmath__ uint64_t vmath_spread21(uint64_t v)
+{
+#if VMATH_SPATIAL_PDEP && (defined(__x86_64__) || defined(_M_X64))
+    return _pdep_u64(v, 0x1249249249249249ull);
+#else
+    v &= 0x1FFFFFull;
+    v = (v | (v << 32)) & 0x001F00000000FFFFull;
+    v = (v | (v << 16)) & 0x001F0000FF0000FFull;
+    v = (v | (v << 8))  & 0x100F00F00F00F00Full;
+    v = (v | (v << 4))  & 0x10C30C30C30C30C3ull;
+    v = (v | (v << 2))  & 0x1249249249249249ull;
+    return v;
+#endif
+}
+
+/**
+ * Gather every third bit of v, inverse of vmath_spread21
+ */
+__vmath__ uint64_t vmath_compact21(uint64_t v)
+{
+#if VMATH_SPATIAL_PDEP && (defined(__x86_64__) || defined(_M_X64))
+    return _pext_u64(v, 0x1249249249249249ull);
+#else
+    v &= 0x1249249249249249ull;
+    v = (v ^ (v >> 2))  & 0x10C30C30C30C30C3ull;
+    v = (v ^ (v >> 4))  & 0x100F00F00F00F00Full;
+    v = (v ^ (v >> 8))  & 0x001F0000FF0000FFull;
+    v = (v ^ (v >> 16)) & 0x001F00000000FFFFull;
+    v = (v ^ (v >> 32)) & 0x1FFFFFull;
+    return v;
+#endif
+}
+
+/**
+ * Spread 4 lanes of 10 bits to every third bit
+ */
+__vmath__ vint4_t vint4_spread10(vint4_t v)
+{
+    v = vint4_and(v, vint4_set1(0x3FF));
+    v = vint4_and(vint4_or(v, vint4_sll(v, 16)), vint4_set1(0x030000FF));
+    v = vint4_and(vint4_or(v, vint4_sll(v, 8)),  vint4_set1(0x0300F00F));
+    v = vint4_and(vint4_or(v, vint4_sll(v, 4)),  vint4_set1(0x030C30C3));
+    v = vint4_and(vint4_or(v, vint4_sll(v, 2)),  vint4_set1(0x09249249));
+    return v;
+}
+
+/**************************
+ * Morton keys
+ **************************/
+
+/**
+ * 30 bits Morton key of a cell of 10 bits per axis
+ */
+__vmath__ uint32_t vmath_morton30(ivec3_t c)
+{
+    return vmath_spread10((uint32_t)c.x) | (vmath_spread10((uint32_t)c.y) << 1) | (vmath_spread10((uint32_t)c.z) << 2);
+}
+
+/**
+ * 63 bits Morton key of a cell of 21 bits per axis
+ */
+__vmath__ uint64_t vmath_morton63(ivec3_t c)
+{
+    return vmath_spread21((uint64_t)c.x) | (vmath_spread21((uint64_t)c.y) << 1) | (vmath_spread21((uint64_t)c.z) << 2);
+}
+
+__vmath__ ivec3_t vmath_morton30_decode(uint32_t key)
+{
+    return ivec3((int)vmath_compact10(key), (int)vmath_compact10(key >> 1), (int)vmath_compact10(key >> 2));
+}
+
+__vmath__ ivec3_t vmath_morton63_decode(uint64_t key)
+{
+    return ivec3((int)vmath_compact21(key), (int)vmath_compact21(key >> 1), (int)vmath_compact21(key >> 2));
+}
+
+/**************************
+ * Hilbert keys
+ **************************/
+
+/**
+ * Skilling's AxestoTranspose: cell to the transposed Hilbert index,
+ * whose bits interleaved (x[0] highest) are the key
+ */
+__vmath__ void vmath_hilbert_transpose(uint32_t x[3], int bits)
+{
+    /* Locals and masks: an array round trip through memory each step, and
+     * branches on the bits of random points, cost more than the work */
+    uint32_t x0 = x[0], x1 = x[1], x2 = x[2];
+    uint32_t q, p, t, set;
+
+    /* Inverse undo */
+    for (q = 1u << (bits - 1); q > 1; q >>= 1)
+    {
+        p   = q - 1;
+        x0 ^= p & (0u - ((x0 & q) != 0));
+
+        set = 0u - ((x1 & q) != 0);
+        t   = (x0 ^ x1) & p & ~set;
+        x0 ^= t ^ (p & set);
+        x1 ^= t;
+
+        set = 0u - ((x2 & q) != 0);
+        t   = (x0 ^ x2) & p & ~set;
+        x0 ^= t ^ (p & set);
+        x2 ^= t;
+    }
+
+    /* Gray encode, bit j of t is the parity of the bits of x2 above j */
+    x1 ^= x0;
+    x2 ^= x1;
+    t  = x2 >> 1;
+    t ^= t >> 1;
+    t ^= t >> 2;
+    t ^= t >> 4;
+    t ^= t >> 8;
+    t ^= t >> 16;
+    x[0] = x0 ^ t;
+    x[1] = x1 ^ t;
+    x[2] = x2 ^ t;
+}
+
+/**
+ * 30 bits Hilbert key of a cell of 10 bits per axis
+ */
+__vmath__ uint32_t vmath_hilbert30(ivec3_t c)
+{
+    uint32_t x[3];
+    x[0] = (uint32_t)c.x & 0x3FFu;
+    x[1] = (uint32_t)c.y & 0x3FFu;
+    x[2] = (uint32_t)c.z & 0x3FFu;
+    vmath_hilbert_transpose(x, 10);
+    return vmath_spread10(x[2]) | (vmath_spread10(x[1]) << 1) | (vmath_spread10(x[0]) << 2);
+}
+
+/**
+ * 63 bits Hilbert key of a cell of 21 bits per axis
+ */
+__vmath__ uint64_t vmath_hilbert63(ivec3_t c)
+{
+    uint32_t x[3];
+    x[0] = (uint32_t)c.x & 0x1FFFFFu;
+    x[1] = (uint32_t)c.y & 0x1FFFFFu;
+    x[2] = (uint32_t)c.z & 0x1FFFFFu;
+    vmath_hilbert_transpose(x, 21);
+    return vmath_spread21(x[2]) | (vmath_spread21(x[1]) << 1) | (vmath_spread21(x[0]) << 2);
+}
+
+/**
+ * vmath_hilbert_transpose of 4 cells, up to 21 bits per axis
+ */
+__vmath__ void vint4_hilbert_transpose(vint4_t* x0, vint4_t* x1, vint4_t* x2, int bits)
+{
+    const vint4_t zero = vint4_set1(0);
+    vint4_t a = *x0, b = *x1, c = *x2;
+    vint4_t p, clear, t;
+    int q;
+
+    for (q = 1 << (bits - 1); q > 1; q >>= 1)
+    {
+        const vint4_t vq = vint4_set1(q);
+        p = vint4_set1(q - 1);
+
+        /* Bit set: a ^= p, bit clear: swap the low bits of a and the axis */
+        a = vint4_xor(a, vint4_xor(p, vint4_and(p, vint4_cmpeq(vint4_and(a, vq), zero))));
+
+        clear = vint4_cmpeq(vint4_and(b, vq), zero);
+        t = vint4_and(vint4_and(vint4_xor(a, b), p), clear);
+        a = vint4_xor(a, vint4_xor(t, vint4_xor(p, vint4_and(p, clear))));
+        b = vint4_xor(b, t);
+
+        clear = vint4_cmpeq(vint4_and(c, vq), zero);
+        t = vint4_and(vint4_and(vint4_xor(a, c), p), clear);
+        a = vint4_xor(a, vint4_xor(t, vint4_xor(p, vint4_and(p, clear))));
+        c = vint4_xor(c, t);
+    }
+
+    b = vint4_xor(b, a);
+    c = vint4_xor(c, b);
+    t = vint4_srl(c, 1);
+    t = vint4_xor(t, vint4_srl(t, 1));
+    t = vint4_xor(t, vint4_srl(t, 2));
+    t = vint4_xor(t, vint4_srl(t, 4));
+    t = vint4_xor(t, vint4_srl(t, 8));
+    t = vint4_xor(t, vint4_srl(t, 16));
+    *x0 = vint4_xor(a, t);
+    *x1 = vint4_xor(b, t);
+    *x2 = vint4_xor(c, t);
+}
+
+/**************************
+ * Array encoders
+ **************************/
+
+/**
+ * vmath_grid_cell of 4 points, up to 21 bits per axis
+ */
+__vmath__ void vmath_grid_cellx4(const vmath_grid_t* grid, const vec3_t* points, int bits, vint4_t* x, vint4_t* y, vint4_t* z)
+{
+    const float cells = (float)(1 << bits);
+    const vfloat4_t last = vfloat4_set1(cells - 1.0f);
+    const vfloat4_t zero = vfloat4_zero();
+#if VMATH_SSE_ENABLE || VMATH_NEON_ENABLE
+    /* vec3_t is 16 bytes, load rows and transpose */
+    vfloat4_t px = vfloat4_load(points[0].m), py = vfloat4_load(points[1].m);
+    vfloat4_t pz = vfloat4_load(points[2].m), pw = vfloat4_load(points[3].m);
+    vfloat4_transpose(&px, &py, &pz, &pw);
+#else
+    const vfloat4_t px = vfloat4_set(points[0].x, points[1].x, points[2].x, points[3].x);
+    const vfloat4_t py = vfloat4_set(points[0].y, points[1].y, points[2].y, points[3].y);
+    const vfloat4_t pz = vfloat4_set(points[0].z, points[1].z, points[2].z, points[3].z);
+#endif
+    *x = vfloat4_toint(vfloat4_clamp(vfloat4_mul(vfloat4_sub(px, vfloat4_set1(grid->min.x)), vfloat4_set1(grid->scale.x * cells)), zero, last));
+    *y = vfloat4_toint(vfloat4_clamp(vfloat4_mul(vfloat4_sub(py, vfloat4_set1(grid->min.y)), vfloat4_set1(grid->scale.y * cells)), zero, last));
+    *z = vfloat4_toint(vfloat4_clamp(vfloat4_mul(vfloat4_sub(pz, vfloat4_set1(grid->min.z)), vfloat4_set1(grid->scale.z * cells)), zero, last));
+}
+
+/**
+ * 30 bits Morton keys of points
+ */
+__vmath_batch__ void vmath_morton30_array(uint32_t* keys, const vec3_t* points, int count, const vmath_grid_t* grid)
+{
+    int i;
+    for (i = 0; i + 4 <= count; i += 4)
+    {
+        vint4_t x, y, z;
+        vmath_grid_cellx4(grid, points + i, 10, &x, &y, &z);
+        vint4_store((int*)keys + i, vint4_or(vint4_spread10(x), vint4_or(vint4_sll(vint4_spread10(y), 1), vint4_sll(vint4_spread10(z), 2))));
+    }
+    for (; i < count; i++)
+    {
+        keys[i] = vmath_morton30(vmath_grid_cell(grid, points[i], 10));
+    }
+}
+
+/**
+ * 30 bits Hilbert keys of points
+ */
+__vmath_batch__ void vmath_hilbert30_array(uint32_t* keys, const vec3_t* points, int count, const vmath_grid_t* grid)
+{
+    int i;
+    for (i = 0; i + 4 <= count; i += 4)
+    {
+        vint4_t x, y, z;
+        vmath_grid_cellx4(grid, points + i, 10, &x, &y, &z);
+        vint4_hilbert_transpose(&x, &y, &z, 10);
+        vint4_store((int*)keys + i, vint4_or(vint4_spread10(z), vint4_or(vint4_sll(vint4_spread10(y), 1), vint4_sll(vint4_spread10(x), 2))));
+    }
+    for (; i < count; i++)
+    {
+        keys[i] = vmath_hilbert30(vmath_grid_cell(grid, points[i], 10));
+    }
+}
+
+/**
+ * 63 bits Morton keys of points
+ */
+__vmath_batch__ void vmath_morton63_array(uint64_t* keys, const vec3_t* points, int count, const vmath_grid_t* grid)
+{
+    int i, k;
+    for (i = 0; i + 4 <= count; i += 4)
+    {
+        /* Cells in lanes, 64 bits keys in scalar registers */
+        vint4_t x, y, z;
+        int     cx[4], cy[4], cz[4];
+        vmath_grid_cellx4(grid, points + i, 21, &x, &y, &z);
+        vint4_store(cx, x);
+        vint4_store(cy, y);
+        vint4_store(cz, z);
+        for (k = 0; k < 4; k++)
+        {
+            keys[i + k] = vmath_morton63(ivec3(cx[k], cy[k], cz[k]));
+        }
+    }
+    for (; i < count; i++)
+    {
+        keys[i] = vmath_morton63(vmath_grid_cell(grid, points[i], 21));
+    }
+}
+
+/**
+ * 63 bits Hilbert keys of points
+ */
+__vmath_batch__ void vmath_hilbert63_array(uint64_t* keys, const vec3_t* points, int count, const vmath_grid_t* grid)
+{
+    int i, k;
+    for (i = 0; i + 4 <= count; i += 4)
+    {
+        /* 21 bits fit the 32 bits lanes, only the interleave is scalar */
+        vint4_t x, y, z;
+        int     cx[4], cy[4], cz[4];
+        vmath_grid_cellx4(grid, points + i, 21, &x, &y, &z);
+        vint4_hilbert_transpose(&x, &y, &z, 21);
+        vint4_store(cx, x);
+        vint4_store(cy, y);
+        vint4_store(cz, z);
+        for (k = 0; k < 4; k++)
+        {
+            keys[i + k] = vmath_morton63(ivec3(cz[k], cy[k], cx[k]));
+        }
+    }
+    for (; i < count; i++)
+    {
+        keys[i] = vmath_hilbert63(vmath_grid_cell(grid, points[i], 21));
+    }
+}
+
+#endif /* __VMATH_SPATIAL_H__ */
+
+/********************
+ * Implementation
+ ********************/
+
+#if defined(VMATH_IMPL) && !defined(__VMATH_SPATIAL_IMPL__)
+#define __VMATH_SPATIAL_IMPL__
+
+#define VMATH_RADIX_BITS    8
+#define VMATH_RADIX_BUCKETS (1 << VMATH_RADIX_BITS)
+
+/* Items per chunk of the radix sort, under it the chunk histograms cost more than they save */
+#define VMATH_RADIX_MIN_GRAIN (16 * 1024)
+
+/**
+ * One pass of the radix sort. The items are split in contiguous chunks,
+ * each chunk count its digits then scatter its items from its own offsets,
+ * which keep the sort stable.
+ */
+typedef struct vmath_radix_args
+{
+    const void* keys_in;
+    void*       keys_out;
+    const int*  order_in;
+    int*        order_out;
+    int         count;
+    int         grain;
+    int         shift;
+    int*        counts;     /* VMATH_RADIX_BUCKETS per chunk: digit counts, then write offsets */
+} vmath_radix_args_t;
+
+#define VMATH_RADIX_JOBS(bits)                                                                  \
+static void vmath_radix_count##bits(void* user, int begin, int end)                             \
+{                                                                                               \
+    /* Locals: the stores to counts may alias the args fields */                                \
+    const vmath_radix_args_t* args  = (const vmath_radix_args_t*)user;                          \
+    const uint##bits##_t*     keys  = (const uint##bits##_t*)args->keys_in;                     \
+    const int                 shift = args->shift;                                              \
+    const int                 grain = args->grain;                                              \
+    const int                 count = args->count;                                              \
+    int c, i;                                                                                   \
+    for (c = begin; c < end; c++)                                                               \
+    {                                                                                           \
+        int*      counts = args->counts + c * VMATH_RADIX_BUCKETS;                              \
+        const int first  = c * grain;                                                           \
+        const int last   = count - first < grain ? count : first + grain;                       \
+        memset(counts, 0, VMATH_RADIX_BUCKETS * sizeof(int));                                   \
+        for (i = first; i < last; i++)                                                          \
+        {                                                                                       \
+            counts[(keys[i] >> shift) & (VMATH_RADIX_BUCKETS - 1)]++;                           \
+        }                                                                                       \
+    }                                                                                           \
+}                                                                                               \
+                                                                                                \
+static void vmath_radix_scatter##bits(void* user, int begin, int end)                           \
+{                                                                                               \
+    const vmath_radix_args_t* args      = (const vmath_radix_args_t*)user;                      \
+    const uint##bits##_t*     keys      = (const uint##bits##_t*)args->keys_in;                 \
+    uint##bits##_t*           out       = (uint##bits##_t*)args->keys_out;                      \
+    const int*                order_in  = args->order_in;                                       \
+    int*                      order_out = args->order_out;                                      \
+    const int                 shift     = args->shift;                                          \
+    const int                 grain     = args->grain;                                          \
+    const int                 count     = args->count;                                          \
+    int c, i;                                                                                   \
+    for (c = begin; c < end; c++)                                                               \
+    {                                                                                           \
+        int*      offsets = args->counts + c * VMATH_RADIX_BUCKETS;                             \
+        const int first   = c * grain;                                                          \
+        const int last    = count - first < grain ? count : first + grain;                      \
+        for (i = first; i < last; i++)                                                          \
+        {                                                                                       \
+            const uint##bits##_t key = keys[i];                                                 \
+            const int            to  = offsets[(key >> shift) & (VMATH_RADIX_BUCKETS - 1)]++;   \
+            out[to]       = key;                                                                \
+            order_out[to] = order_in[i];                                                        \
+        }                                                                                       \
+    }                                                                                           \
+}
+
+VMATH_RADIX_JOBS(32)
+VMATH_RADIX_JOBS(64)
+
+static int vmath_radix_sort(void* keys, int key_size, int* order, int count)
+{
+    const int  threads = vmath_jobs_threads();
+    char*      block;
+    void*      keys_tmp;
+    int*       order_tmp;
+    int        grain, chunks, shift, i;
+    vmath_radix_args_t args;
+
+    for (i = 0; i < count; i++)
+    {
+        order[i] = i;
+    }
+    if (count <= 1)
+    {
+        return 1;
+    }
+
+    /* Two chunks per thread, one chunk without the pool */
+    grain  = (count + 2 * threads - 1) / (2 * threads);
+    grain  = threads > 1 && grain < VMATH_RADIX_MIN_GRAIN ? VMATH_RADIX_MIN_GRAIN : grain;
+    chunks = (count + grain - 1) / grain;
+
+    block = (char*)vmath_aligned_alloc((size_t)count * (key_size + sizeof(int)) + (size_t)chunks * VMATH_RADIX_BUCKETS * sizeof(int), 64);
+    if (!block)
+    {
+        return 0;
+    }
+    keys_tmp  = block;
+    order_tmp = (int*)(block + (size_t)count * key_size);
+
+    args.keys_in   = keys;
+    args.keys_out  = keys_tmp;
+    args.order_in  = order;
+    args.order_out = order_tmp;
+    args.count     = count;
+    args.grain     = grain;
+    args.counts    = order_tmp + count;
+
+    for (shift = 0; shift < key_size * 8; shift += VMATH_RADIX_BITS)
+    {
+        int digit, c, offset = 0, skip = 0;
+
+        args.shift = shift;
+        vmath_parallel_for(chunks, 1, key_size == 4 ? vmath_radix_count32 : vmath_radix_count64, &args);
+
+        /* Offsets digit major then chunk, a pass where every key has the same digit is skipped */
+        for (digit = 0; digit < VMATH_RADIX_BUCKETS; digit++)
+        {
+            const int start = offset;
+            for (c = 0; c < chunks; c++)
+            {
+                const int n = args.counts[c * VMATH_RADIX_BUCKETS + digit];
+                args.counts[c * VMATH_RADIX_BUCKETS + digit] = offset;
+                offset += n;
+            }
+            skip = skip || offset - start == count;
+        }
+        if (skip)
+        {
+            continue;
+        }
+
+        vmath_parallel_for(chunks, 1, key_size == 4 ? vmath_radix_scatter32 : vmath_radix_scatter64, &args);
+
+        /* Swap buffers */
+        {
+            const void* keys_in  = args.keys_in;
+            const int*  order_in = args.order_in;
+            args.keys_in   = args.keys_out;
+            args.order_in  = args.order_out;
+            args.keys_out  = (void*)keys_in;
+            args.order_out = (int*)order_in;
+        }
+    }
+
+    if (args.keys_in != keys)
+    {
+        memcpy(keys, args.keys_in, (size_t)count * key_size);
+        memcpy(order, args.order_in, (size_t)count * sizeof(int));
+    }
+
+    vmath_aligned_free(block);
+    return 1;
+}
+
+int vmath_radix_sort32(uint32_t* keys, int* order, int count)
+{
+    return vmath_radix_sort(keys, sizeof(uint32_t), order, count);
+}
+
+int vmath_radix_sort64(uint64_t* keys, int* order, int count)
+{
+    return vmath_radix_sort(keys, sizeof(uint64_t), order, count);
+}
+
+typedef struct vmath_reorder_args
+{
+    const int*  order;
+    const char* src;
+    char*       dst;
+    int         size;
+} vmath_reorder_args_t;
+
+/**
+ * Gather items [begin, end), the common sizes get a fixed size copy
+ */
+static void vmath_reorder_gather(void* user, int begin, int end)
+{
+    const vmath_reorder_args_t* args = (const vmath_reorder_args_t*)user;
+    const int* order = args->order;
+    int i;
+
+    switch (args->size)
+    {
+    case 4:
+        for (i = begin; i < end; i++) memcpy(args->dst + 4 * (size_t)i, args->src + 4 * (size_t)order[i], 4);
+        break;
+
+    case 8:
+        for (i = begin; i < end; i++) memcpy(args->dst + 8 * (size_t)i, args->src + 8 * (size_t)order[i], 8);
+        break;
+
+    case 12:
+        for (i = begin; i < end; i++) memcpy(args->dst + 12 * (size_t)i, args->src + 12 * (size_t)order[i], 12);
+        break;
+
+    case 16:
+        for (i = begin; i < end; i++) memcpy(args->dst + 16 * (size_t)i, args->src + 16 * (size_t)order[i], 16);
+        break;
+
+    default:
+        for (i = begin; i < end; i++) memcpy(args->dst + (size_t)args->size * i, args->src + (size_t)args->size * order[i], args->size);
+        break;
+    }
+}
+
+int vmath_reorder(const int* order, int count, void* const* arrays, const int* sizes, int array_count)
+{
+    vmath_reorder_args_t args;
+    char* scratch;
+    int   size = 0, i;
+
+    for (i = 0; i < array_count; i++)
+    {
+        size = sizes[i] > size ? sizes[i] : size;
+    }
+    scratch = (char*)vmath_aligned_alloc((size_t)count * size, 64);
+    if (!scratch && count > 0 && size > 0)
+    {
+        return 0;
+    }
+
+    /* Gather to the scratch then copy back, the reads are random but the writes stream */
+    args.order = order;
+    args.dst   = scratch;
+    for (i = 0; i < array_count; i++)
+    {
+        args.src  = (const char*)arrays[i];
+        args.size = sizes[i];
+        vmath_parallel_for(count, vmath_jobs_grain(2 * sizes[i]), vmath_reorder_gather, &args);
+        memcpy(arrays[i], scratch, (size_t)count * sizes[i]);
+    }
+
+    vmath_aligned_free(scratch);
+    return 1;
+}
+
+#endif /* VMATH_IMPL */
@@ -0,0 +1,503 @@
+/******************************************************
+ * vmath_spline - Cubic splines: Bezier, Catmull-Rom, Hermite, B-spline
+ *
+ * @author: MaiHD
+ * @license: NULL
+ * @copyright: MaiHD @ ${HOME}, 2017 - 2018
+ ******************************************************/
+
+#ifndef __VMATH_SPLINE_H__
+#define __VMATH_SPLINE_H__
+
+#include "vmath_soa.h"
+
+/**
+ * Every spline is a cubic segment of 4 control points p(t) = sum(w_i(t) * p_i),
+ * with weights from the basis table below.
+ *
+ * A path is an array of control points, which segments overlap:
+ *   Bezier:      p0 c0 c1 p1 c2 c3 p2 ...  (stride 3)
+ *   Hermite:     p0 m0 p1 m1 p2 m2 ...     (stride 2, m is tangent)
+ *   Catmull-Rom: p0 p1 p2 p3 ...           (stride 1, pass p1..pn-2)
+ *   B-spline:    p0 p1 p2 p3 ...           (stride 1, approximate)
+ */
+#define SPLINE_BEZIER       0
+#define SPLINE_HERMITE      1
+#define SPLINE_CATMULLROM   2
+#define SPLINE_BSPLINE      3
+
+/**
+ * Polynomial coefficients of weights: w_i(t) = c0 + c1 t + c2 t^2 + c3 t^3
+ */
+static const float SPLINE_BASIS[4][4][4] = {
+    /* Bezier */
+    {
+        {  1.0f, -3.0f,  3.0f, -1.0f },
+        {  0.0f,  3.0f, -6.0f,  3.0f },
+        {  0.0f,  0.0f,  3.0f, -3.0f },
+        {  0.0f,  0.0f,  0.0f,  1.0f },
+    },
+
+    /* Hermite */
+    {
+        {  1.0f,  0.0f, -3.0f,  2.0f },
+        {  0.0f,  1.0f, -2.0f,  1.0f },
+        {  0.0f,  0.0f,  3.0f, -2.0f },
+        {  0.0f,  0.0f, -1.0f,  1.0f },
+    },
+
+    /* Catmull-Rom */
+    {
+        {  0.0f, -0.5f,  1.0f, -0.5f },
+        {  1.0f,  0.0f, -2.5f,  1.5f },
+        {  0.0f,  0.5f,  2.0f, -1.5f },
+        {  0.0f,  0.0f, -0.5f,  0.5f },
+    },
+
+    /* B-spline */
+    {
+        {  1.0f / 6.0f, -0.5f,  0.5f, -1.0f / 6.0f },
+        {  4.0f / 6.0f,  0.0f, -1.0f,  0.5f        },
+        {  1.0f / 6.0f,  0.5f,  0.5f, -0.5f        },
+        {  0.0f,         0.0f,  0.0f,  1.0f / 6.0f },
+    },
+};
+
+/**
+ * Distance between two segments in control points array
+ */
+__vmath__ int spline_stride(int type)
+{
+    return type == SPLINE_BEZIER ? 3 : (type == SPLINE_HERMITE ? 2 : 1);
+}
+
+/**
+ * Number of segments of a path
+ */
+__vmath__ int spline_segments(int type, int count)
+{
+    return count < 4 ? 0 : (count - 4) / spline_stride(type) + 1;
+}
+
+/**
+ * Weights of control points at t
+ * @param order: 0 for position, 1 for first derivative, 2 for second derivative
+ */
+__vmath__ vec4_t spline_weights(int type, float t, int order)
+{
+    const float (*c)[4] = SPLINE_BASIS[type];
+    float w[4];
+    int i;
+    for (i = 0; i < 4; i++)
+    {
+        switch (order)
+        {
+        case 0:  w[i] = c[i][0] + t * (c[i][1] + t * (c[i][2] + t * c[i][3])); break;
+        case 1:  w[i] = c[i][1] + t * (2.0f * c[i][2] + t * 3.0f * c[i][3]);  break;
+        default: w[i] = 2.0f * c[i][2] + t * 6.0f * c[i][3];                   break;
+        }
+    }
+    return vec4(w[0], w[1], w[2], w[3]);
+}
+
+/**
+ * Weighted sum of 4 control points
+ */
+__vmath__ vec4_t spline_combine(const vec4_t* p, vec4_arg_t w)
+{
+    return vec4_add(vec4_add(vec4_mulf(p[0], w.x), vec4_mulf(p[1], w.y)),
+                    vec4_add(vec4_mulf(p[2], w.z), vec4_mulf(p[3], w.w)));
+}
+
+/********************
+ * Segment evaluation
+ ********************/
+
+/**
+ * Evaluate a segment
+ * @param order: 0 for position, 1 for tangent, 2 for second derivative
+ */
+__vmath__ vec4_t spline_eval4(int type, const vec4_t* p, float t, int order)
+{
+    return spline_combine(p, spline_weights(type, t, order));
+}
+
+__vmath__ vec3_t spline_eval3(int type, const vec3_t* p, float t, int order)
+{
+    const vec4_t w = spline_weights(type, t, order);
+    return vec3_add(vec3_add(vec3_mulf(p[0], w.x), vec3_mulf(p[1], w.y)),
+                    vec3_add(vec3_mulf(p[2], w.z), vec3_mulf(p[3], w.w)));
+}
+
+__vmath__ vec2_t spline_eval2(int type, const vec2_t* p, float t, int order)
+{
+    const vec4_t w = spline_weights(type, t, order);
+    return vec2_add(vec2_add(vec2_mulf(p[0], w.x), vec2_mulf(p[1], w.y)),
+                    vec2_add(vec2_mulf(p[2], w.z), vec2_mulf(p[3], w.w)));
+}
+
+#if VMATH_BUILD_QUAT
+/**
+ * Evaluate a quaternion segment: control points are blended in 4D, each one
+ * flipped to the hemisphere of the previous one, then normalized
+ * @note: Hermite is not supported, tangents are not rotations
+ */
+__vmath__ quat_t spline_evalq(int type, const quat_t* q, float t)
+{
+    const vec4_t w = spline_weights(type, t, 0);
+    vec4_t p[4];
+    int i;
+
+    p[0] = vec4(q[0].x, q[0].y, q[0].z, q[0].w);
+    for (i = 1; i < 4; i++)
+    {
+        p[i] = vec4(q[i].x, q[i].y, q[i].z, q[i].w);
+        if (vec4_dot(p[i - 1], p[i]) < 0.0f)
+        {
+            p[i] = vec4_neg(p[i]);
+        }
+    }
+
+    {
+        const vec4_t r = spline_combine(p, w);
+        const float  s = 1.0f / sqrtf(vec4_dot(r, r));
+        return quat(r.x * s, r.y * s, r.z * s, r.w * s);
+    }
+}
+
+/**
+ * Derivative of quaternion segment with respect to t
+ */
+__vmath__ quat_t spline_derivq(int type, const quat_t* q, float t)
+{
+    vec4_t p[4];
+    int i;
+
+    p[0] = vec4(q[0].x, q[0].y, q[0].z, q[0].w);
+    for (i = 1; i < 4; i++)
+    {
+        p[i] = vec4(q[i].x, q[i].y, q[i].z, q[i].w);
+        if (vec4_dot(p[i - 1], p[i]) < 0.0f)
+        {
+            p[i] = vec4_neg(p[i]);
+        }
+    }
+
+    {
+        /* equation: d(r / |r|) = (dr - r * dot(r, dr) / |r|^2) / |r| */
+        const vec4_t r   = spline_combine(p, spline_weights(type, t, 0));
+        const vec4_t dr  = spline_combine(p, spline_weights(type, t, 1));
+        const float  rr  = vec4_dot(r, r);
+        const float  s   = 1.0f / sqrtf(rr);
+        const vec4_t d   = vec4_mulf(vec4_sub(dr, vec4_mulf(r, vec4_dot(r, dr) / rr)), s);
+        return quat(d.x, d.y, d.z, d.w);
+    }
+}
+#endif
+
+/********************
+ * Path evaluation
+ ********************/
+
+/**
+ * Segment of a path at parameter u in [0, segments], return local t
+ * @note: count must be >= 4, the control points of one segment,
+ *        a shorter path locate the first segment
+ */
+__vmath__ float spline_locate(int type, int count, float u, int* first)
+{
+    const int segments = spline_segments(type, count);
+    int       segment  = (int)floorf(u);
+
+    segment = segment >= segments ? segments - 1 : segment;
+    segment = segment < 0 ? 0 : segment;
+    *first  = segment * spline_stride(type);
+    return u - (float)segment;
+}
+
+/**
+ * Evaluate a path at parameter u in [0, segments]
+ * @note: count must be >= 4, the control points of one segment
+ */
+__vmath__ vec3_t spline_path3(int type, const vec3_t* p, int count, float u, int order)
+{
+    int first;
+    const float t = spline_locate(type, count, u, &first);
+    return spline_eval3(type, p + first, t, order);
+}
+
+__vmath__ vec2_t spline_path2(int type, const vec2_t* p, int count, float u, int order)
+{
+    int first;
+    const float t = spline_locate(type, count, u, &first);
+    return spline_eval2(type, p + first, t, order);
+}
+
+/********************
+ * Adaptive subdivision
+ ********************/
+
+/**
+ * Parameters of a polyline which stay within tolerance of the segment,
+ * first parameter is always 0 and last is 1
+ * @return: number of parameters written to out_t
+ */
+__vmath_batch__ int spline_subdivide3(int type, const vec3_t* p, float tolerance, float* out_t, int max_count)
+{
+    float stack[2 * 32];
+    int   depth[32];
+    int   top = 0, count = 0;
+
+    if (max_count < 2)
+    {
+        return 0;
+    }
+
+    out_t[count++] = 0.0f;
+    stack[0] = 0.0f; stack[1] = 1.0f; depth[0] = 0;
+    top = 1;
+    while (top > 0)
+    {
+        const float a = stack[2 * (top - 1) + 0];
+        const float b = stack[2 * (top - 1) + 1];
+        const int   d = depth[top - 1];
+        top--;
+
+        /* Deviation of the curve from the chord, at quarter points */
+        const vec3_t pa = spline_eval3(type, p, a, 0);
+        const vec3_t pb = spline_eval3(type, p, b, 0);
+        float error = 0.0f;
+        int k;
+        for (k = 1; k < 4; k++)
+        {
+            const float  s = (float)k * 0.25f;
+            const vec3_t q = spline_eval3(type, p, a + (b - a) * s, 0);
+            const float  e = vec3_distancesquared(q, vec3_add(pa, vec3_mulf(vec3_sub(pb, pa), s)));
+            error = e > error ? e : error;
+        }
+
+        /* Keep room for the right halves still on the stack */
+        if (error > tolerance * tolerance && d < 31 && count + top + 2 < max_count)
+        {
+            const float m = 0.5f * (a + b);
+            stack[2 * top + 0] = m; stack[2 * top + 1] = b; depth[top] = d + 1; top++;
+            stack[2 * top + 0] = a; stack[2 * top + 1] = m; depth[top] = d + 1; top++;
+        }
+        else
+        {
+            out_t[count++] = b;
+        }
+    }
+    return count;
+}
+
+/********************
+ * Arc length
+ ********************/
+
+/**
+ * Build arc-length table of a path: table[i] is the length from the start
+ * to parameter u = i * segments / (samples - 1)
+ * @return: total length
+ */
+__vmath_batch__ float spline_arclen3(int type, const vec3_t* p, int count, float* table, int samples)
+{
+    const int   segments = spline_segments(type, count);
+    const float du       = (float)segments / (float)(samples - 1);
+    const int   steps    = 8;
+
+    vec3_t prev = spline_path3(type, p, count, 0.0f, 0);
+    float  len  = 0.0f;
+    int    i, k;
+
+    table[0] = 0.0f;
+    for (i = 1; i < samples; i++)
+    {
+        /* Sub-steps per table entry, chords converge to the length */
+        for (k = 1; k <= steps; k++)
+        {
+            const float  u = ((float)(i - 1) + (float)k / (float)steps) * du;
+            const vec3_t q = spline_path3(type, p, count, u, 0);
+            len += sqrtf(vec3_distancesquared(prev, q));
+            prev = q;
+        }
+        table[i] = len;
+    }
+    return len;
+}
+
+/**
+ * Parameter u of a path at arc length s, for constant speed traversal
+ */
+__vmath__ float spline_arcparam(const float* table, int samples, int segments, float s)
+{
+    int lo = 0, hi = samples - 1;
+    if (s <= 0.0f)
+    {
+        return 0.0f;
+    }
+    if (s >= table[hi])
+    {
+        return (float)segments;
+    }
+
+    while (hi - lo > 1)
+    {
+        const int mid = (lo + hi) >> 1;
+        if (table[mid] <= s)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    {
+        const float span = table[hi] - table[lo];
+        const float f    = span > 0.0f ? (s - table[lo]) / span : 0.0f;
+        return ((float)lo + f) * (float)segments / (float)(samples - 1);
+    }
+}
+
+/********************
+ * Batch over SoA arrays
+ * Lane i evaluates curve i at t[i], 8 curves per iteration
+ ********************/
+
+/**
+ * Weights of control points for 4 lanes
+ */
+__vmath__ void spline_weights_x4(int type, vfloat4_t t, int order, vfloat4_t* w)
+{
+    const float (*c)[4] = SPLINE_BASIS[type];
+    int i;
+    for (i = 0; i < 4; i++)
+    {
+        switch (order)
+        {
+        case 0:
+            w[i] = vfloat4_madd(t, vfloat4_madd(t, vfloat4_madd(t, vfloat4_set1(c[i][3]), vfloat4_set1(c[i][2])),
+                                                vfloat4_set1(c[i][1])), vfloat4_set1(c[i][0]));
+            break;
+
+        case 1:
+            w[i] = vfloat4_madd(t, vfloat4_madd(t, vfloat4_set1(3.0f * c[i][3]), vfloat4_set1(2.0f * c[i][2])),
+                                vfloat4_set1(c[i][1]));
+            break;
+
+        default:
+            w[i] = vfloat4_madd(t, vfloat4_set1(6.0f * c[i][3]), vfloat4_set1(2.0f * c[i][2]));
+            break;
+        }
+    }
+}
+
+/**
+ * Load n (1..4) lanes, a direct load for a full group: n is a constant
+ * after inlining, so the full groups have no branch
+ */
+__vmath__ vfloat4_t spline_load_x4(const float* ptr, int n)
+{
+    return n == 4 ? vfloat4_load(ptr) : vfloat4_loadn(ptr, n);
+}
+
+__vmath__ void spline_store_x4(float* ptr, vfloat4_t v, int n)
+{
+    if (n == 4)
+    {
+        vfloat4_store(ptr, v);
+    }
+    else
+    {
+        vfloat4_storen(ptr, v, n);
+    }
+}
+
+/**
+ * Weighted sum of control point k of 4 curves
+ */
+__vmath__ vfloat4_t spline_combine_x4(const float* const* c, int index, int n, const vfloat4_t* w)
+{
+    vfloat4_t r = vfloat4_mul(w[0], spline_load_x4(c[0] + index, n));
+    r = vfloat4_madd(w[1], spline_load_x4(c[1] + index, n), r);
+    r = vfloat4_madd(w[2], spline_load_x4(c[2] + index, n), r);
+    r = vfloat4_madd(w[3], spline_load_x4(c[3] + index, n), r);
+    return r;
+}
+
+/**
+ * n (1..4) curves of spline_batch3 from index
+ */
+__vmath__ void spline_batch3_x4(int type, int order,
+                                const float* const cx[4], const float* const cy[4], const float* const cz[4],
+                                const float* t, float* ox, float* oy, float* oz, int index, int n)
+{
+    vfloat4_t w[4];
+    spline_weights_x4(type, spline_load_x4(t + index, n), order, w);
+    spline_store_x4(ox + index, spline_combine_x4(cx, index, n, w), n);
+    spline_store_x4(oy + index, spline_combine_x4(cy, index, n, w), n);
+    spline_store_x4(oz + index, spline_combine_x4(cz, index, n, w), n);
+}
+
+/**
+ * Evaluate count curves, each at its own parameter
+ * @param cx, cy, cz: control point k of curve i is (cx[k][i], cy[k][i], cz[k][i])
+ * @param order: 0 for position, 1 for tangent, 2 for second derivative
+ */
+__vmath_batch__ void spline_batch3(int type, int order,
+                                   const float* const cx[4], const float* const cy[4], const float* const cz[4],
+                                   const float* t, float* ox, float* oy, float* oz, int count)
+{
+    int i;
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        spline_batch3_x4(type, order, cx, cy, cz, t, ox, oy, oz, i,     4);
+        spline_batch3_x4(type, order, cx, cy, cz, t, ox, oy, oz, i + 4, 4);
+    }
+    if (i + 4 <= count)
+    {
+        spline_batch3_x4(type, order, cx, cy, cz, t, ox, oy, oz, i, 4);
+        i += 4;
+    }
+    if (i < count)
+    {
+        spline_batch3_x4(type, order, cx, cy, cz, t, ox, oy, oz, i, count - i);
+    }
+}
+
+/**
+ * Evaluate one curve at count parameters
+ */
+__vmath_batch__ void spline_sample3(int type, int order, const vec3_t* p, const float* t,
+                                    float* ox, float* oy, float* oz, int count)
+{
+    int i, g, k;
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = 0; g < 8 && i + g < count; g += 4)
+        {
+            const int index = i + g;
+            const int n     = count - index < 4 ? count - index : 4;
+
+            vfloat4_t w[4], x, y, z;
+            spline_weights_x4(type, vfloat4_loadn(t + index, n), order, w);
+
+            x = vfloat4_mul(w[0], vfloat4_set1(p[0].x));
+            y = vfloat4_mul(w[0], vfloat4_set1(p[0].y));
+            z = vfloat4_mul(w[0], vfloat4_set1(p[0].z));
+            for (k = 1; k < 4; k++)
+            {
+                x = vfloat4_madd(w[k], vfloat4_set1(p[k].x), x);
+                y = vfloat4_madd(w[k], vfloat4_set1(p[k].y), y);
+                z = vfloat4_madd(w[k], vfloat4_set1(p[k].z), z);
+            }
+            vfloat4_storen(ox + index, x, n);
+            vfloat4_storen(oy + index, y, n);
+            vfloat4_storen(oz + index, z, n);
+        }
+    }
+}
+
+#endif /* __VMATH_SPLINE_H__ */
@@ -0,0 +1,600 @@
+/******************************************************
+ * vmath_svd - 3x3 eigen and singular value decompositions
+ *
+ * @author: MaiHD
+ * @license: NULL
+ * @copyright: MaiHD @ ${HOME}, 2017 - 2018
+ ******************************************************/
+
+#ifndef __VMATH_SVD_H__
+#define __VMATH_SVD_H__
+
+#include "vmath_soa.h"
+
+/**
+ * Branch free 3x3 decompositions after McAdams et al. 2011, "Computing the
+ * Singular Value Decomposition of 3x3 matrices with minimal branching and
+ * elementary floating point operations":
+ *
+ *  - symmetric eigen: cyclic Jacobi with approximate Givens quaternions,
+ *                     a fixed VMATH_SVD_SWEEPS sweeps
+ *  - SVD:             eigen of transpose(a) a give V, columns of a V are
+ *                     sorted by norm, then a Givens QR give U and sigma
+ *
+ * Matrices follow mat3_mulv3: m = U * diag(s) * transpose(V) with mat3_mul,
+ * the rotations are returned as quaternions (the native form of the
+ * algorithm) or as mat3_t. U and V are always rotations, a reflection show
+ * as a negative last singular value. Values are sorted descending.
+ *
+ * Every function run the same SoA kernels, one matrix per lane, the single
+ * matrix versions broadcast their input to all lanes.
+ */
+
+/**
+ * Jacobi sweeps, 4 in the paper leave rare 1e-2 errors on random matrices,
+ * 5 reach float precision
+ */
+#ifndef VMATH_SVD_SWEEPS
+#define VMATH_SVD_SWEEPS 5
+#endif
+
+#ifndef VMATH_SVD_EPSILON
+#define VMATH_SVD_EPSILON 1e-6f
+#endif
+
+/********************
+ * Lane kernels
+ ********************/
+
+/**
+ * Approximate Givens quaternion (ch, sh) which diagonalize the 2x2 block
+ * [a11 a12; a12 a22], falls back to a pi / 4 rotation when the exact angle
+ * is too far from the approximation
+ */
+__vmath__ void vmath_svd_givens_x4(vfloat4_t a11, vfloat4_t a12, vfloat4_t a22, vfloat4_t* ch, vfloat4_t* sh)
+{
+    const vfloat4_t c = vfloat4_mul(vfloat4_set1(2.0f), vfloat4_sub(a11, a22));
+    const vfloat4_t s = a12;
+    const vfloat4_t c2 = vfloat4_mul(c, c);
+    const vfloat4_t s2 = vfloat4_mul(s, s);
+    const vfloat4_t b  = vfloat4_cmplt(vfloat4_mul(vfloat4_set1(5.828427124f), s2), c2); /* 3 + 2 sqrt(2) */
+    const vfloat4_t w  = vfloat4_div(vfloat4_set1(1.0f), vfloat4_sqrt(vfloat4_add(c2, s2)));
+
+    *ch = vfloat4_select(vfloat4_set1(0.9238795325f), vfloat4_mul(w, c), b); /* cos(pi / 8) */
+    *sh = vfloat4_select(vfloat4_set1(0.3826834324f), vfloat4_mul(w, s), b); /* sin(pi / 8) */
+}
+
+/**
+ * One Jacobi conjugation on the (x, y) plane of the symmetric matrix
+ * s = { s11, s21, s22, s31, s32, s33 }, accumulated to the quaternion
+ * q = { x, y, z, w }. The entries of s are cycled so the next call work on
+ * the next plane, three calls restore the order.
+ */
+__vmath__ void vmath_svd_conjugate_x4(int x, int y, int z, vfloat4_t s[6], vfloat4_t q[4])
+{
+    vfloat4_t ch, sh, a, b, t[3];
+    vfloat4_t s11, s21, s22, s31, s32, s33;
+
+    vmath_svd_givens_x4(s[0], s[1], s[2], &ch, &sh);
+    a = vfloat4_sub(vfloat4_mul(ch, ch), vfloat4_mul(sh, sh));
+    b = vfloat4_mul(vfloat4_set1(2.0f), vfloat4_mul(sh, ch));
+
+    /* s = transpose(Q) s Q on the (x, y) plane */
+    {
+        const vfloat4_t u0 = vfloat4_madd(a, s[0], vfloat4_mul(b, s[1]));
+        const vfloat4_t u1 = vfloat4_madd(a, s[1], vfloat4_mul(b, s[2]));
+        const vfloat4_t v0 = vfloat4_nmadd(b, s[0], vfloat4_mul(a, s[1]));
+        const vfloat4_t v1 = vfloat4_nmadd(b, s[1], vfloat4_mul(a, s[2]));
+
+        s11 = vfloat4_madd(a, u0, vfloat4_mul(b, u1));
+        s21 = vfloat4_madd(a, v0, vfloat4_mul(b, v1));
+        s22 = vfloat4_nmadd(b, v0, vfloat4_mul(a, v1));
+        s31 = vfloat4_madd(a, s[3], vfloat4_mul(b, s[4]));
+        s32 = vfloat4_nmadd(b, s[3], vfloat4_mul(a, s[4]));
+        s33 = s[5];
+    }
+
+    /* q = q * (ch, sh on axis z) */
+    t[0] = vfloat4_mul(q[0], sh);
+    t[1] = vfloat4_mul(q[1], sh);
+    t[2] = vfloat4_mul(q[2], sh);
+    sh   = vfloat4_mul(sh, q[3]);
+
+    q[0] = vfloat4_mul(q[0], ch);
+    q[1] = vfloat4_mul(q[1], ch);
+    q[2] = vfloat4_mul(q[2], ch);
+    q[3] = vfloat4_mul(q[3], ch);
+
+    q[z] = vfloat4_add(q[z], sh);
+    q[3] = vfloat4_sub(q[3], t[z]);
+    q[x] = vfloat4_add(q[x], t[y]);
+    q[y] = vfloat4_sub(q[y], t[x]);
+
+    /* Cycle to the next plane */
+    s[0] = s22;
+    s[1] = s32;
+    s[2] = s33;
+    s[3] = s21;
+    s[4] = s31;
+    s[5] = s11;
+}
+
+/**
+ * Normalize a lane quaternion
+ */
+__vmath__ void vmath_svd_normalizeq_x4(vfloat4_t q[4])
+{
+    const vfloat4_t l = vfloat4_madd(q[0], q[0], vfloat4_madd(q[1], q[1], vfloat4_madd(q[2], q[2], vfloat4_mul(q[3], q[3]))));
+    const vfloat4_t w = vfloat4_div(vfloat4_set1(1.0f), vfloat4_sqrt(l));
+    q[0] = vfloat4_mul(q[0], w);
+    q[1] = vfloat4_mul(q[1], w);
+    q[2] = vfloat4_mul(q[2], w);
+    q[3] = vfloat4_mul(q[3], w);
+}
+
+/**
+ * Rotation matrix of a lane quaternion, r[row][column]
+ */
+__vmath__ void vmath_svd_quatmat_x4(const vfloat4_t q[4], vfloat4_t r[3][3])
+{
+    const vfloat4_t two = vfloat4_set1(2.0f);
+    const vfloat4_t one = vfloat4_set1(1.0f);
+    const vfloat4_t xx = vfloat4_mul(q[0], q[0]), yy = vfloat4_mul(q[1], q[1]), zz = vfloat4_mul(q[2], q[2]);
+    const vfloat4_t xy = vfloat4_mul(q[0], q[1]), xz = vfloat4_mul(q[0], q[2]), yz = vfloat4_mul(q[1], q[2]);
+    const vfloat4_t wx = vfloat4_mul(q[3], q[0]), wy = vfloat4_mul(q[3], q[1]), wz = vfloat4_mul(q[3], q[2]);
+
+    r[0][0] = vfloat4_nmadd(two, vfloat4_add(yy, zz), one);
+    r[0][1] = vfloat4_mul(two, vfloat4_sub(xy, wz));
+    r[0][2] = vfloat4_mul(two, vfloat4_add(xz, wy));
+
+    r[1][0] = vfloat4_mul(two, vfloat4_add(xy, wz));
+    r[1][1] = vfloat4_nmadd(two, vfloat4_add(xx, zz), one);
+    r[1][2] = vfloat4_mul(two, vfloat4_sub(yz, wx));
+
+    r[2][0] = vfloat4_mul(two, vfloat4_sub(xz, wy));
+    r[2][1] = vfloat4_mul(two, vfloat4_add(yz, wx));
+    r[2][2] = vfloat4_nmadd(two, vfloat4_add(xx, yy), one);
+}
+
+/**
+ * Where mask is set: swap the columns i and j of b and negate the new
+ * column j, keeping the determinant, and rotate q the same way
+ * (quarter turn around the third axis)
+ */
+__vmath__ void vmath_svd_swap_x4(vfloat4_t mask, int i, int j, vfloat4_t b[3][3], vfloat4_t q[4])
+{
+    const vfloat4_t h = vfloat4_set1(0.7071067812f);
+    vfloat4_t p[4];
+    int r;
+
+    for (r = 0; r < 3; r++)
+    {
+        const vfloat4_t t = vfloat4_neg(b[r][i]);
+        b[r][i] = vfloat4_select(b[r][i], b[r][j], mask);
+        b[r][j] = vfloat4_select(b[r][j], t, mask);
+    }
+
+    /* p = q * axis, the axis is +z, -y or +x */
+    if (i == 0 && j == 1)
+    {
+        p[0] = q[1];
+        p[1] = vfloat4_neg(q[0]);
+        p[2] = q[3];
+        p[3] = vfloat4_neg(q[2]);
+    }
+    else if (i == 0)
+    {
+        p[0] = q[2];
+        p[1] = vfloat4_neg(q[3]);
+        p[2] = vfloat4_neg(q[0]);
+        p[3] = q[1];
+    }
+    else
+    {
+        p[0] = q[3];
+        p[1] = q[2];
+        p[2] = vfloat4_neg(q[1]);
+        p[3] = vfloat4_neg(q[0]);
+    }
+
+    for (r = 0; r < 4; r++)
+    {
+        q[r] = vfloat4_select(q[r], vfloat4_mul(h, vfloat4_add(q[r], p[r])), mask);
+    }
+}
+
+/**
+ * Eigen decomposition of symmetric matrices a[row][column] (lower
+ * triangle is read), values descending, q rotate the axes to the
+ * eigenvectors
+ */
+__vmath__ void vmath_eigensym_x4(vfloat4_t a[3][3], vfloat4_t values[3], vfloat4_t q[4])
+{
+    vfloat4_t s[6], mask, t;
+    int i;
+
+    s[0] = a[0][0];
+    s[1] = a[1][0];
+    s[2] = a[1][1];
+    s[3] = a[2][0];
+    s[4] = a[2][1];
+    s[5] = a[2][2];
+
+    q[0] = q[1] = q[2] = vfloat4_zero();
+    q[3] = vfloat4_set1(1.0f);
+    for (i = 0; i < VMATH_SVD_SWEEPS; i++)
+    {
+        vmath_svd_conjugate_x4(0, 1, 2, s, q);
+        vmath_svd_conjugate_x4(1, 2, 0, s, q);
+        vmath_svd_conjugate_x4(2, 0, 1, s, q);
+    }
+    vmath_svd_normalizeq_x4(q);
+
+    values[0] = s[0];
+    values[1] = s[2];
+    values[2] = s[5];
+
+    /* Sort network, the swaps only rotate q, a is not needed anymore */
+    mask = vfloat4_cmplt(values[0], values[1]);
+    vmath_svd_swap_x4(mask, 0, 1, a, q);
+    t = values[0];
+    values[0] = vfloat4_select(values[0], values[1], mask);
+    values[1] = vfloat4_select(values[1], t, mask);
+
+    mask = vfloat4_cmplt(values[0], values[2]);
+    vmath_svd_swap_x4(mask, 0, 2, a, q);
+    t = values[0];
+    values[0] = vfloat4_select(values[0], values[2], mask);
+    values[2] = vfloat4_select(values[2], t, mask);
+
+    mask = vfloat4_cmplt(values[1], values[2]);
+    vmath_svd_swap_x4(mask, 1, 2, a, q);
+    t = values[1];
+    values[1] = vfloat4_select(values[1], values[2], mask);
+    values[2] = vfloat4_select(values[2], t, mask);
+}
+
+/**
+ * Givens quaternion (ch, sh) which zero a2 in the column (a1, a2), exact
+ * rotation for the QR step
+ */
+__vmath__ void vmath_svd_qrgivens_x4(vfloat4_t a1, vfloat4_t a2, vfloat4_t* ch, vfloat4_t* sh)
+{
+    const vfloat4_t eps = vfloat4_set1(VMATH_SVD_EPSILON);
+    const vfloat4_t rho = vfloat4_sqrt(vfloat4_madd(a1, a1, vfloat4_mul(a2, a2)));
+    const vfloat4_t neg = vfloat4_cmplt(a1, vfloat4_zero());
+    const vfloat4_t s   = vfloat4_and(vfloat4_cmpgt(rho, eps), a2);
+    const vfloat4_t c   = vfloat4_add(vfloat4_abs(a1), vfloat4_max(rho, eps));
+    const vfloat4_t c1  = vfloat4_select(c, s, neg);
+    const vfloat4_t s1  = vfloat4_select(s, c, neg);
+    const vfloat4_t w   = vfloat4_div(vfloat4_set1(1.0f), vfloat4_sqrt(vfloat4_madd(c1, c1, vfloat4_mul(s1, s1))));
+
+    *ch = vfloat4_mul(c1, w);
+    *sh = vfloat4_mul(s1, w);
+}
+
+/**
+ * Apply a Givens rotation on the rows i and j of b
+ */
+__vmath__ void vmath_svd_rotate_x4(vfloat4_t ch, vfloat4_t sh, int i, int j, vfloat4_t b[3][3])
+{
+    const vfloat4_t a = vfloat4_nmadd(vfloat4_set1(2.0f), vfloat4_mul(sh, sh), vfloat4_set1(1.0f));
+    const vfloat4_t c = vfloat4_mul(vfloat4_set1(2.0f), vfloat4_mul(ch, sh));
+    int k;
+
+    for (k = 0; k < 3; k++)
+    {
+        const vfloat4_t bi = b[i][k];
+        b[i][k] = vfloat4_madd(a, bi, vfloat4_mul(c, b[j][k]));
+        b[j][k] = vfloat4_nmadd(c, bi, vfloat4_mul(a, b[j][k]));
+    }
+}
+
+/**
+ * Singular value decomposition of a[row][column] = U diag(s) transpose(V),
+ * U and V as lane quaternions { x, y, z, w }
+ */
+__vmath__ void vmath_svd_x4(vfloat4_t a[3][3], vfloat4_t u[4], vfloat4_t s[3], vfloat4_t v[4])
+{
+    vfloat4_t ata[3][3], m[3][3], b[3][3], n[3], mask, t;
+    vfloat4_t ch1, sh1, ch2, sh2, ch3, sh3;
+    int i, j, k;
+
+    /* V from the eigen decomposition of transpose(a) a, order is free */
+    for (i = 0; i < 3; i++)
+    {
+        for (j = 0; j <= i; j++)
+        {
+            ata[i][j] = vfloat4_mul(a[0][i], a[0][j]);
+            ata[i][j] = vfloat4_madd(a[1][i], a[1][j], ata[i][j]);
+            ata[i][j] = vfloat4_madd(a[2][i], a[2][j], ata[i][j]);
+        }
+    }
+
+    {
+        vfloat4_t e[6];
+        e[0] = ata[0][0];
+        e[1] = ata[1][0];
+        e[2] = ata[1][1];
+        e[3] = ata[2][0];
+        e[4] = ata[2][1];
+        e[5] = ata[2][2];
+
+        v[0] = v[1] = v[2] = vfloat4_zero();
+        v[3] = vfloat4_set1(1.0f);
+        for (i = 0; i < VMATH_SVD_SWEEPS; i++)
+        {
+            vmath_svd_conjugate_x4(0, 1, 2, e, v);
+            vmath_svd_conjugate_x4(1, 2, 0, e, v);
+            vmath_svd_conjugate_x4(2, 0, 1, e, v);
+        }
+        vmath_svd_normalizeq_x4(v);
+    }
+
+    /* b = a V */
+    vmath_svd_quatmat_x4(v, m);
+    for (i = 0; i < 3; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            b[i][j] = vfloat4_mul(a[i][0], m[0][j]);
+            for (k = 1; k < 3; k++)
+            {
+                b[i][j] = vfloat4_madd(a[i][k], m[k][j], b[i][j]);
+            }
+        }
+    }
+
+    /* Sort the columns of b by norm */
+    for (j = 0; j < 3; j++)
+    {
+        n[j] = vfloat4_madd(b[0][j], b[0][j], vfloat4_madd(b[1][j], b[1][j], vfloat4_mul(b[2][j], b[2][j])));
+    }
+
+    mask = vfloat4_cmplt(n[0], n[1]);
+    vmath_svd_swap_x4(mask, 0, 1, b, v);
+    t = n[0];
+    n[0] = vfloat4_select(n[0], n[1], mask);
+    n[1] = vfloat4_select(n[1], t, mask);
+
+    mask = vfloat4_cmplt(n[0], n[2]);
+    vmath_svd_swap_x4(mask, 0, 2, b, v);
+    n[2] = vfloat4_select(n[2], n[0], mask);
+
+    mask = vfloat4_cmplt(n[1], n[2]);
+    vmath_svd_swap_x4(mask, 1, 2, b, v);
+
+    /* QR of b, U = Q1 Q2 Q3 */
+    vmath_svd_qrgivens_x4(b[0][0], b[1][0], &ch1, &sh1);
+    vmath_svd_rotate_x4(ch1, sh1, 0, 1, b);
+
+    vmath_svd_qrgivens_x4(b[0][0], b[2][0], &ch2, &sh2);
+    vmath_svd_rotate_x4(ch2, sh2, 0, 2, b);
+
+    vmath_svd_qrgivens_x4(b[1][1], b[2][1], &ch3, &sh3);
+    vmath_svd_rotate_x4(ch3, sh3, 1, 2, b);
+
+    s[0] = b[0][0];
+    s[1] = b[1][1];
+    s[2] = b[2][2];
+
+    /* (ch1, 0, 0, sh1) * (ch2, 0, -sh2, 0) * (ch3, sh3, 0, 0) with (w, x, y, z) */
+    {
+        const vfloat4_t w12 = vfloat4_mul(ch1, ch2);
+        const vfloat4_t x12 = vfloat4_mul(sh1, sh2);
+        const vfloat4_t y12 = vfloat4_neg(vfloat4_mul(ch1, sh2));
+        const vfloat4_t z12 = vfloat4_mul(sh1, ch2);
+
+        u[0] = vfloat4_madd(x12, ch3, vfloat4_mul(w12, sh3));
+        u[1] = vfloat4_madd(y12, ch3, vfloat4_mul(z12, sh3));
+        u[2] = vfloat4_nmadd(y12, sh3, vfloat4_mul(z12, ch3));
+        u[3] = vfloat4_nmadd(x12, sh3, vfloat4_mul(w12, ch3));
+    }
+}
+
+/**
+ * Load up to 4 matrices to lanes a[row][column], missing lanes get
+ * identity matrices
+ */
+__vmath__ void vmath_svd_load_x4(const mat3_t* m, int count, vfloat4_t a[3][3])
+{
+    float lanes[3][3][4];
+    int   i, j, l;
+
+    for (l = 0; l < 4; l++)
+    {
+        for (i = 0; i < 3; i++)
+        {
+            for (j = 0; j < 3; j++)
+            {
+                lanes[i][j][l] = l < count ? m[l].m[j][i] : (float)(i == j);
+            }
+        }
+    }
+
+    for (i = 0; i < 3; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            a[i][j] = vfloat4_load(lanes[i][j]);
+        }
+    }
+}
+
+/**
+ * Broadcast one matrix to all lanes
+ */
+__vmath__ void vmath_svd_set1_x4(mat3_t m, vfloat4_t a[3][3])
+{
+    int i, j;
+    for (i = 0; i < 3; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            a[i][j] = vfloat4_set1(m.m[j][i]);
+        }
+    }
+}
+
+/**
+ * Store the first n lanes of values and quaternions
+ */
+__vmath__ void vmath_svd_store_x4(const vfloat4_t q[4], const vfloat4_t values[3], quat_t* rotations, vec3_t* out, int n)
+{
+    vfloat4_t r[4];
+    int l;
+
+    if (rotations)
+    {
+        r[0] = q[0];
+        r[1] = q[1];
+        r[2] = q[2];
+        r[3] = q[3];
+        vfloat4_transpose(&r[0], &r[1], &r[2], &r[3]);
+        for (l = 0; l < n; l++)
+        {
+            vfloat4_store(rotations[l].m, r[l]);
+        }
+    }
+
+    if (out)
+    {
+        r[0] = values[0];
+        r[1] = values[1];
+        r[2] = values[2];
+        r[3] = vfloat4_zero();
+        vfloat4_transpose(&r[0], &r[1], &r[2], &r[3]);
+        for (l = 0; l < n; l++)
+        {
+            out[l] = vec3(vfloat4_get(r[l], 0), vfloat4_get(r[l], 1), vfloat4_get(r[l], 2));
+        }
+    }
+}
+
+/********************
+ * Single matrix
+ ********************/
+
+/**
+ * Eigen decomposition of a symmetric matrix, values descending,
+ * quat_tomat3(rotation).m[i] is the eigenvector i
+ */
+__vmath__ void mat3_eigensymq(mat3_t m, vec3_t* values, quat_t* rotation)
+{
+    vfloat4_t a[3][3], v[3], q[4];
+    vmath_svd_set1_x4(m, a);
+    vmath_eigensym_x4(a, v, q);
+    vmath_svd_store_x4(q, v, rotation, values, 1);
+}
+
+/**
+ * Eigen decomposition of a symmetric matrix, values descending, the
+ * eigenvector i is vectors.m[i]
+ */
+__vmath__ void mat3_eigensym(mat3_t m, vec3_t* values, mat3_t* vectors)
+{
+    quat_t q;
+    mat3_eigensymq(m, values, &q);
+    if (vectors)
+    {
+        *vectors = quat_tomat3(q);
+    }
+}
+
+/**
+ * Singular value decomposition with rotations as quaternions,
+ * m = quat_tomat3(u) * diag(s) * transpose(quat_tomat3(v))
+ */
+__vmath__ void mat3_svdq(mat3_t m, quat_t* u, vec3_t* s, quat_t* v)
+{
+    vfloat4_t a[3][3], qu[4], sv[3], qv[4];
+    vmath_svd_set1_x4(m, a);
+    vmath_svd_x4(a, qu, sv, qv);
+    vmath_svd_store_x4(qu, sv, u, s, 1);
+    vmath_svd_store_x4(qv, sv, v, 0, 1);
+}
+
+/**
+ * Singular value decomposition, m = u * diag(s) * transpose(v)
+ */
+__vmath__ void mat3_svd(mat3_t m, mat3_t* u, vec3_t* s, mat3_t* v)
+{
+    quat_t qu, qv;
+    mat3_svdq(m, &qu, s, &qv);
+    if (u) *u = quat_tomat3(qu);
+    if (v) *v = quat_tomat3(qv);
+}
+
+/**
+ * Polar decomposition m = r * s, r is the closest rotation to m and s is
+ * symmetric (not positive when m is a reflection)
+ */
+__vmath__ void mat3_polar(mat3_t m, mat3_t* r, mat3_t* s)
+{
+    mat3_t u, v, vt;
+    vec3_t sv;
+    mat3_svd(m, &u, &sv, &v);
+
+    vt = mat3_transpose(v);
+    if (r)
+    {
+        *r = mat3_mul(u, vt);
+    }
+    if (s)
+    {
+        mat3_t d = v;
+        d.m[0][0] *= sv.x; d.m[0][1] *= sv.x; d.m[0][2] *= sv.x;
+        d.m[1][0] *= sv.y; d.m[1][1] *= sv.y; d.m[1][2] *= sv.y;
+        d.m[2][0] *= sv.z; d.m[2][1] *= sv.z; d.m[2][2] *= sv.z;
+        *s = mat3_mul(d, vt);
+    }
+}
+
+/********************
+ * Batches
+ ********************/
+
+/**
+ * Eigen decompositions of many symmetric matrices, 8 per loop
+ * @param rotations: may be NULL, quat_tomat3 give the eigenvectors
+ */
+__vmath_batch__ void mat3_eigensym_batch(const mat3_t* m, vec3_t* values, quat_t* rotations, int count)
+{
+    int i, g;
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = i; g < i + 8 && g < count; g += 4)
+        {
+            const int n = count - g < 4 ? count - g : 4;
+            vfloat4_t a[3][3], v[3], q[4];
+
+            vmath_svd_load_x4(m + g, n, a);
+            vmath_eigensym_x4(a, v, q);
+            vmath_svd_store_x4(q, v, rotations ? rotations + g : 0, values ? values + g : 0, n);
+        }
+    }
+}
+
+/**
+ * Singular value decompositions of many matrices, 8 per loop
+ * @param u, s, v: may be NULL
+ */
+__vmath_batch__ void mat3_svd_batch(const mat3_t* m, quat_t* u, vec3_t* s, quat_t* v, int count)
+{
+    int i, g;
+    for (i = 0; i < count; i += 8)
+    {
+        for (g = i; g < i + 8 && g < count; g += 4)
+        {
+            const int n = count - g < 4 ? count - g : 4;
+            vfloat4_t a[3][3], qu[4], sv[3], qv[4];
+
+            vmath_svd_load_x4(m + g, n, a);
+            vmath_svd_x4(a, qu, sv, qv);
+            vmath_svd_store_x4(qu, sv, u ? u + g : 0, s ? s + g : 0, n);
+            vmath_svd_store_x4(qv, sv, v ? v + g : 0, 0, n);
+        }
+    }
+}
+
+#endif /* __VMATH_SVD_H__ */
@@ -0,0 +1,457 @@
+/******************************************************
+ * vmath_text - Streaming text parser and formatter
+ *
+ * @author: MaiHD
+ * @license: NULL
+ * @copyright: MaiHD @ ${HOME}, 2017 - 2018
+ ******************************************************/
+
+#ifndef __VMATH_TEXT_H__
+#define __VMATH_TEXT_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vmath.h"
+
+/**
+ * The parser take text in chunks of any size and write one row per line,
+ * each number of the row go to a column: a float array with a stride, so
+ * rows are parsed straight to vec3_t/quat_t arrays (AoS) or to float
+ * arrays (SoA). Lines are found with a 16 bytes SIMD scan, a line split
+ * between two chunks is carried in a small buffer, nothing is allocated.
+ *
+ *   v 1.0 2.0 3.0          prefix "v",     3 columns
+ *   1.0,2.0,3.0,0,0,0,1    no prefix,      7 columns
+ *   vec3(1, 2, 3)          prefix "vec3(", 3 columns, see vmath_format_*
+ *
+ * Numbers are separated by spaces, tabs, ',', ';', '(' or ')'. Lines which
+ * do not match the prefix or do not have enough numbers are skipped.
+ */
+
+#ifndef VMATH_TEXT_COLUMNS
+#define VMATH_TEXT_COLUMNS  16
+#endif
+
+/**
+ * Longest line which can be split between two chunks
+ */
+#ifndef VMATH_TEXT_LINE_MAX
+#define VMATH_TEXT_LINE_MAX 1024
+#endif
+
+/**
+ * Streaming parser
+ */
+typedef struct vmath_text_parser
+{
+    const char* prefix;
+    int         prefix_length;
+    int         columns;
+    float*      out[VMATH_TEXT_COLUMNS];
+    int         stride[VMATH_TEXT_COLUMNS];     /* In floats */
+
+    int         rows;       /* Rows written since the last rewind */
+    int         capacity;   /* Rows the outputs can hold          */
+    int         skipped;    /* Lines which are not rows           */
+
+    int         carry;      /* Bytes of a line split between chunks */
+    char        line[VMATH_TEXT_LINE_MAX];
+} vmath_text_parser_t;
+
+/********************
+ * Numbers
+ ********************/
+
+/**
+ * Parse a float from [p, end)
+ * @return: end of the number, NULL when there is no number at p
+ */
+__vmath_batch__ const char* vmath_parse_float(const char* p, const char* end, float* out)
+{
+    static const double POW10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+
+    const char*        start    = p;
+    unsigned long long mantissa = 0;
+    int                exp10    = 0;
+    int                any      = 0;
+    int                negative = 0;
+    unsigned           digit;
+
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p++ == '-';
+    }
+
+    /* Integer part, digits past 18 only scale */
+    for (; p < end && (digit = (unsigned)(*p - '0')) < 10; p++, any = 1)
+    {
+        if (mantissa < 100000000000000000ull)
+        {
+            mantissa = mantissa * 10 + digit;
+        }
+        else
+        {
+            exp10++;
+        }
+    }
+
+    if (p < end && *p == '.')
+    {
+        for (p++; p < end && (digit = (unsigned)(*p - '0')) < 10; p++, any = 1)
+        {
+            if (mantissa < 100000000000000000ull)
+            {
+                mantissa = mantissa * 10 + digit;
+                exp10--;
+            }
+        }
+    }
+
+    if (any && p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char* q = p + 1;
+        int sign = 1, e = 0;
+        if (q < end && (*q == '-' || *q == '+'))
+        {
+            sign = *q++ == '-' ? -1 : 1;
+        }
+        if (q < end && (unsigned)(*q - '0') < 10)
+        {
+            for (; q < end && (unsigned)(*q - '0') < 10; q++)
+            {
+                e = e < 10000 ? e * 10 + (*q - '0') : e;
+            }
+            exp10 += sign * e;
+            p      = q;
+        }
+    }
+
+    /* Exact in double, then one rounding to float */
+    if (any && mantissa < (1ull << 53) && exp10 >= -22 && exp10 <= 22)
+    {
+        const double d = exp10 < 0 ? (double)mantissa / POW10[-exp10] : (double)mantissa * POW10[exp10];
+        *out = (float)(negative ? -d : d);
+        return p;
+    }
+
+    /* Slow path: long mantissa, large exponent, inf, nan */
+    {
+        char        buffer[64];
+        char*       stop;
+        size_t      length = (size_t)(end - start) < sizeof(buffer) - 1 ? (size_t)(end - start) : sizeof(buffer) - 1;
+        memcpy(buffer, start, length);
+        buffer[length] = 0;
+
+        *out = strtof(buffer, &stop);
+        return stop != buffer ? start + (stop - buffer) : 0;
+    }
+}
+
+/**
+ * Find the next '\n' in [p, end), end when there is none
+ */
+__vmath__ const char* vmath_text_findline(const char* p, const char* end)
+{
+#if VMATH_SSE_ENABLE
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; end - p >= 16; p += 16)
+    {
+        const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), newline));
+        if (mask)
+        {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, (unsigned long)mask);
+            return p + index;
+#else
+            return p + __builtin_ctz((unsigned)mask);
+#endif
+        }
+    }
+    for (; p < end && *p != '\n'; p++)
+    {
+    }
+    return p;
+#else
+    const char* found = (const char*)memchr(p, '\n', (size_t)(end - p));
+    return found ? found : end;
+#endif
+}
+
+/**
+ * Is c a separator of numbers
+ */
+__vmath__ int vmath_text_separator(char c)
+{
+    return c == ' ' || c == '\t' || c == ',' || c == ';' || c == '(' || c == ')' || c == '\r';
+}
+
+/********************
+ * Parser
+ ********************/
+
+/**
+ * Create a parser
+ * @param prefix:   first token of a row, NULL for none
+ * @param columns:  numbers per row
+ * @param capacity: rows the outputs can hold
+ */
+__vmath__ void vmath_text_init(vmath_text_parser_t* parser, const char* prefix, int columns, int capacity)
+{
+    memset(parser, 0, sizeof(*parser) - sizeof(parser->line));
+    parser->prefix        = prefix;
+    parser->prefix_length = prefix ? (int)strlen(prefix) : 0;
+    parser->columns       = columns < VMATH_TEXT_COLUMNS ? columns : VMATH_TEXT_COLUMNS;
+    parser->capacity      = capacity;
+}
+
+/**
+ * Output of a column: row i go to base[i * stride]
+ */
+__vmath__ void vmath_text_column(vmath_text_parser_t* parser, int column, float* base, int stride_bytes)
+{
+    parser->out[column]    = base;
+    parser->stride[column] = stride_bytes / (int)sizeof(float);
+}
+
+/**
+ * Columns [column, column + 3) to an array of vec3_t
+ */
+__vmath__ void vmath_text_vec3(vmath_text_parser_t* parser, int column, vec3_t* out)
+{
+    vmath_text_column(parser, column + 0, &out->x, sizeof(vec3_t));
+    vmath_text_column(parser, column + 1, &out->y, sizeof(vec3_t));
+    vmath_text_column(parser, column + 2, &out->z, sizeof(vec3_t));
+}
+
+/**
+ * Columns [column, column + 4) to an array of quat_t
+ */
+__vmath__ void vmath_text_quat(vmath_text_parser_t* parser, int column, quat_t* out)
+{
+    vmath_text_column(parser, column + 0, &out->x, sizeof(quat_t));
+    vmath_text_column(parser, column + 1, &out->y, sizeof(quat_t));
+    vmath_text_column(parser, column + 2, &out->z, sizeof(quat_t));
+    vmath_text_column(parser, column + 3, &out->w, sizeof(quat_t));
+}
+
+/**
+ * Column to a float array (SoA)
+ */
+__vmath__ void vmath_text_soa(vmath_text_parser_t* parser, int column, float* out)
+{
+    vmath_text_column(parser, column, out, sizeof(float));
+}
+
+/**
+ * Start writing rows from the beginning of the outputs again
+ */
+__vmath__ void vmath_text_rewind(vmath_text_parser_t* parser)
+{
+    parser->rows = 0;
+}
+
+/**
+ * Parse a line without '\n'
+ */
+__vmath_batch__ void vmath_text_parseline(vmath_text_parser_t* parser, const char* p, const char* end)
+{
+    const int row = parser->rows;
+    int c;
+
+    for (; p < end && (*p == ' ' || *p == '\t' || *p == '\r'); p++)
+    {
+    }
+    if (p == end || *p == '#')
+    {
+        return;
+    }
+
+    if (parser->prefix_length > 0)
+    {
+        if (end - p < parser->prefix_length || memcmp(p, parser->prefix, (size_t)parser->prefix_length) != 0)
+        {
+            parser->skipped++;
+            return;
+        }
+        p += parser->prefix_length;
+    }
+
+    for (c = 0; c < parser->columns; c++)
+    {
+        float value;
+        for (; p < end && vmath_text_separator(*p); p++)
+        {
+        }
+
+        p = p < end ? vmath_parse_float(p, end, &value) : 0;
+        if (!p)
+        {
+            parser->skipped++;
+            return;
+        }
+
+        if (parser->out[c])
+        {
+            parser->out[c][row * parser->stride[c]] = value;
+        }
+    }
+
+    parser->rows = row + 1;
+}
+
+/**
+ * Parse a chunk of text, lines may span chunks
+ * @return: bytes consumed, less than size when the outputs are full:
+ *          use the rows, rewind and feed the rest
+ */
+__vmath_batch__ size_t vmath_text_feed(vmath_text_parser_t* parser, const char* data, size_t size)
+{
+    const char* p   = data;
+    const char* end = data + size;
+
+    /* Finish the line carried from the last chunk */
+    if (parser->carry > 0 && p < end)
+    {
+        const char* eol    = vmath_text_findline(p, end);
+        const int   length = (int)(eol - p);
+        const int   room   = VMATH_TEXT_LINE_MAX - parser->carry;
+        if (eol == end)
+        {
+            memcpy(parser->line + parser->carry, p, (size_t)(length < room ? length : room));
+            parser->carry += length < room ? length : room;
+            return size;
+        }
+
+        if (parser->rows >= parser->capacity)
+        {
+            return 0;
+        }
+        memcpy(parser->line + parser->carry, p, (size_t)(length < room ? length : room));
+        vmath_text_parseline(parser, parser->line, parser->line + parser->carry + (length < room ? length : room));
+        parser->carry = 0;
+        p = eol + 1;
+    }
+
+    while (p < end)
+    {
+        const char* eol = vmath_text_findline(p, end);
+        if (eol == end)
+        {
+            /* Keep the partial line for the next chunk */
+            const int length = (int)(end - p) < VMATH_TEXT_LINE_MAX ? (int)(end - p) : VMATH_TEXT_LINE_MAX;
+            memcpy(parser->line, p, (size_t)length);
+            parser->carry = length;
+            return size;
+        }
+
+        if (parser->rows >= parser->capacity)
+        {
+            break;
+        }
+        vmath_text_parseline(parser, p, eol);
+        p = eol + 1;
+    }
+
+    return (size_t)(p - data);
+}
+
+/**
+ * Parse the last line when the text do not end with '\n'
+ * @return: 0 when the outputs are full, rewind and finish again
+ */
+__vmath__ int vmath_text_finish(vmath_text_parser_t* parser)
+{
+    if (parser->carry > 0)
+    {
+        if (parser->rows >= parser->capacity)
+        {
+            return 0;
+        }
+        vmath_text_parseline(parser, parser->line, parser->line + parser->carry);
+        parser->carry = 0;
+    }
+    return 1;
+}
+
+/********************
+ * Formatter
+ ********************/
+
+/**
+ * Shortest text which parse back to the same float
+ * @return: length of the text, as snprintf
+ */
+__vmath__ int vmath_format_float(char* buffer, int size, float value)
+{
+    char text[32];
+    int  precision;
+
+    for (precision = 6; precision <= 9; precision++)
+    {
+        snprintf(text, sizeof(text), "%.*g", precision, value);
+        if (strtof(text, 0) == value || value != value)
+        {
+            break;
+        }
+    }
+    return snprintf(buffer, (size_t)size, "%s", text);
+}
+
+/**
+ * Format name(v0, v1, ...)
+ */
+__vmath_batch__ int vmath_format_floats(char* buffer, int size, const char* name, const float* values, int count)
+{
+    int length = snprintf(buffer, (size_t)size, "%s(", name);
+    int i;
+    for (i = 0; i < count; i++)
+    {
+        char text[32];
+        vmath_format_float(text, sizeof(text), values[i]);
+        length += snprintf(buffer + (length < size ? length : size), (size_t)(length < size ? size - length : 0),
+                           i + 1 < count ? "%s, " : "%s)", text);
+    }
+    return length;
+}
+
+__vmath__ int vmath_format_vec2(char* buffer, int size, vec2_t v)
+{
+    const float values[] = { v.x, v.y };
+    return vmath_format_floats(buffer, size, "vec2", values, 2);
+}
+
+__vmath__ int vmath_format_vec3(char* buffer, int size, vec3_t v)
+{
+    const float values[] = { v.x, v.y, v.z };
+    return vmath_format_floats(buffer, size, "vec3", values, 3);
+}
+
+__vmath__ int vmath_format_vec4(char* buffer, int size, vec4_t v)
+{
+    const float values[] = { v.x, v.y, v.z, v.w };
+    return vmath_format_floats(buffer, size, "vec4", values, 4);
+}
+
+__vmath__ int vmath_format_quat(char* buffer, int size, quat_t q)
+{
+    const float values[] = { q.x, q.y, q.z, q.w };
+    return vmath_format_floats(buffer, size, "quat", values, 4);
+}
+
+__vmath__ int vmath_format_mat3(char* buffer, int size, mat3_t m)
+{
+    return vmath_format_floats(buffer, size, "mat3", m.data, 9);
+}
+
+__vmath__ int vmath_format_mat4(char* buffer, int size, mat4_t m)
+{
+    return vmath_format_floats(buffer, size, "mat4", m.data, 16);
+}
+
+#endif /* __VMATH_TEXT_H__ */
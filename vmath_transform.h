@@ -0,0 +1,609 @@
+/******************************************************
+ * vmath_transform - SoA transform hierarchy with dirty updates
+ *
+ * @author: MaiHD
+ * @license: NULL
+ * @copyright: MaiHD @ ${HOME}, 2017 - 2018
+ ******************************************************/
+
+#ifndef __VMATH_TRANSFORM_H__
+#define __VMATH_TRANSFORM_H__
+
+#include <string.h>
+
+#include "vmath.h"
+#include "vmath_memory.h"
+
+/**
+ * Usage: define VMATH_IMPL before include this file in one source file.
+ *
+ * A store of nodes with translation, rotation, scale in separate arrays,
+ * kept in topological order: the parent of a node is always before it.
+ * Nodes are referred by transform_id_t handles, an index in a slot table
+ * and a generation, so handles of destroyed nodes are rejected.
+ *
+ * Setters only mark the node dirty. transform_store_update recompose the
+ * local matrices of dirty nodes with mat4_composetrs over runs of
+ * neighbour nodes, then walk the nodes once, parents first, and multiply
+ * the world matrices of dirty nodes and their descendants. The dense
+ * indices of every node whose world changed are left in store->changed
+ * for culling, physics sync...
+ */
+
+/**
+ * Node flags
+ */
+#define TRANSFORM_LOCAL_DIRTY   1 /* Translation, rotation, scale or parent changed */
+#define TRANSFORM_WORLD_CHANGED 2 /* World matrix changed in the current update     */
+#define TRANSFORM_REMOVED       4 /* Destroyed, dropped by the next update          */
+
+/**
+ * Handle of a node, index is -1 for none
+ */
+typedef struct transform_id
+{
+    int index;          /* Slot of the node          */
+    int generation;     /* Generation of the slot    */
+} transform_id_t;
+
+/**
+ * Nodes in dense arrays, parent[i] < i
+ */
+typedef struct transform_store
+{
+    vec3_t*        position;
+    quat_t*        rotation;
+    vec3_t*        scale;
+    mat4_t*        local;
+    mat4_t*        world;
+    int*           parent;          /* Dense index of the parent, -1 for roots  */
+    int*           slot;            /* Slot of each node                        */
+    unsigned char* flags;           /* TRANSFORM_* flags of each node           */
+    int            count;
+    int            capacity;
+
+    int*           dense;           /* Dense index of each slot, -1 when free   */
+    int*           generation;      /* Generation of each slot                  */
+    int*           free_slots;      /* Stack of free slots                      */
+    int            free_count;
+    int            slot_count;
+    int            slot_capacity;
+
+    int*           changed;         /* Nodes whose world changed in the last update */
+    int            changed_count;
+
+    int            removed;         /* Nodes marked TRANSFORM_REMOVED           */
+    int            unsorted;        /* A reparenting broke the topological order */
+} transform_store_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Create an empty store, room for capacity nodes
+ * @return: 0 when out of memory
+ */
+int transform_store_init(transform_store_t* store, int capacity);
+
+/**
+ * Free every array of the store
+ */
+void transform_store_free(transform_store_t* store);
+
+/**
+ * Add a node at identity under parent (index -1 for a root)
+ * @return: handle of the node, index -1 when out of memory or parent is not valid
+ */
+transform_id_t transform_store_create(transform_store_t* store, transform_id_t parent);
+
+/**
+ * Destroy a node and all its descendants, their handles are not valid anymore
+ */
+void transform_store_destroy(transform_store_t* store, transform_id_t id);
+
+/**
+ * Move a node under another parent (index -1 for a root)
+ * @return: 0 when a handle is not valid or parent is in the subtree of the node
+ */
+int transform_store_setparent(transform_store_t* store, transform_id_t id, transform_id_t parent);
+
+/**
+ * Recompute the world matrices of dirty nodes and their descendants
+ * @return: 0 when out of memory, the store is left unchanged
+ */
+int transform_store_update(transform_store_t* store);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * Handle for no node
+ */
+__vmath__ transform_id_t transform_none(void)
+{
+    transform_id_t id = { -1, 0 };
+    return id;
+}
+
+/**
+ * Dense index of a node, -1 when the handle is not valid
+ * @note: dense indices change in transform_store_update
+ */
+__vmath__ int transform_store_index(const transform_store_t* store, transform_id_t id)
+{
+    if (id.index < 0 || id.index >= store->slot_count || store->generation[id.index] != id.generation)
+    {
+        return -1;
+    }
+    return store->dense[id.index];
+}
+
+__vmath__ bool transform_store_valid(const transform_store_t* store, transform_id_t id)
+{
+    return transform_store_index(store, id) >= 0;
+}
+
+/**
+ * Handle of the node at a dense index, such as store->changed[i]
+ */
+__vmath__ transform_id_t transform_store_id(const transform_store_t* store, int index)
+{
+    transform_id_t id;
+    id.index      = store->slot[index];
+    id.generation = store->generation[id.index];
+    return id;
+}
+
+__vmath__ void transform_store_setposition(transform_store_t* store, transform_id_t id, vec3_t position)
+{
+    const int i = transform_store_index(store, id);
+    if (i >= 0)
+    {
+        store->position[i] = position;
+        store->flags[i]   |= TRANSFORM_LOCAL_DIRTY;
+    }
+}
+
+__vmath__ void transform_store_setrotation(transform_store_t* store, transform_id_t id, quat_t rotation)
+{
+    const int i = transform_store_index(store, id);
+    if (i >= 0)
+    {
+        store->rotation[i] = rotation;
+        store->flags[i]   |= TRANSFORM_LOCAL_DIRTY;
+    }
+}
+
+__vmath__ void transform_store_setscale(transform_store_t* store, transform_id_t id, vec3_t scale)
+{
+    const int i = transform_store_index(store, id);
+    if (i >= 0)
+    {
+        store->scale[i]  = scale;
+        store->flags[i] |= TRANSFORM_LOCAL_DIRTY;
+    }
+}
+
+__vmath__ void transform_store_settrs(transform_store_t* store, transform_id_t id, vec3_t position, quat_t rotation, vec3_t scale)
+{
+    const int i = transform_store_index(store, id);
+    if (i >= 0)
+    {
+        store->position[i] = position;
+        store->rotation[i] = rotation;
+        store->scale[i]    = scale;
+        store->flags[i]   |= TRANSFORM_LOCAL_DIRTY;
+    }
+}
+
+/**
+ * World matrix of a node as of the last update, NULL when the handle is not valid
+ */
+__vmath__ const mat4_t* transform_store_world(const transform_store_t* store, transform_id_t id)
+{
+    const int i = transform_store_index(store, id);
+    return i >= 0 ? &store->world[i] : 0;
+}
+
+#endif /* __VMATH_TRANSFORM_H__ */
+
+/********************
+ * Implementation
+ ********************/
+
+#if defined(VMATH_IMPL) && !defined(__VMATH_TRANSFORM_IMPL__)
+#define __VMATH_TRANSFORM_IMPL__
+
+/**
+ * Move an array to a new buffer of capacity items
+ */
+static int transform_store_realloc(void** data, int count, int capacity, size_t item_size)
+{
+    void* data_new = vmath_aligned_alloc((size_t)capacity * item_size, VMATH_MEMORY_ALIGN);
+    if (!data_new)
+    {
+        return 0;
+    }
+    if (*data)
+    {
+        memcpy(data_new, *data, (size_t)count * item_size);
+        vmath_aligned_free(*data);
+    }
+    *data = data_new;
+    return 1;
+}
+
+/**
+ * Grow node arrays to hold count nodes at least
+ */
+static int transform_store_reserve(transform_store_t* store, int count)
+{
+    int capacity;
+    if (count <= store->capacity)
+    {
+        return 1;
+    }
+
+    capacity = store->capacity + store->capacity / 2;
+    capacity = capacity > count ? capacity : count;
+    capacity = capacity > 16 ? capacity : 16;
+    if (!transform_store_realloc((void**)&store->position, store->count, capacity, sizeof(vec3_t))
+        || !transform_store_realloc((void**)&store->rotation, store->count, capacity, sizeof(quat_t))
+        || !transform_store_realloc((void**)&store->scale, store->count, capacity, sizeof(vec3_t))
+        || !transform_store_realloc((void**)&store->local, store->count, capacity, sizeof(mat4_t))
+        || !transform_store_realloc((void**)&store->world, store->count, capacity, sizeof(mat4_t))
+        || !transform_store_realloc((void**)&store->parent, store->count, capacity, sizeof(int))
+        || !transform_store_realloc((void**)&store->slot, store->count, capacity, sizeof(int))
+        || !transform_store_realloc((void**)&store->flags, store->count, capacity, sizeof(unsigned char))
+        || !transform_store_realloc((void**)&store->changed, 0, capacity, sizeof(int)))
+    {
+        return 0; /* Arrays which grew are kept, capacity is the old one */
+    }
+    store->capacity = capacity;
+    return 1;
+}
+
+/**
+ * Grow slot arrays to hold count slots at least
+ */
+static int transform_store_reserveslots(transform_store_t* store, int count)
+{
+    int capacity;
+    if (count <= store->slot_capacity)
+    {
+        return 1;
+    }
+
+    capacity = store->slot_capacity + store->slot_capacity / 2;
+    capacity = capacity > count ? capacity : count;
+    capacity = capacity > 16 ? capacity : 16;
+    if (!transform_store_realloc((void**)&store->dense, store->slot_count, capacity, sizeof(int))
+        || !transform_store_realloc((void**)&store->generation, store->slot_count, capacity, sizeof(int))
+        || !transform_store_realloc((void**)&store->free_slots, store->free_count, capacity, sizeof(int)))
+    {
+        return 0;
+    }
+    store->slot_capacity = capacity;
+    return 1;
+}
+
+/**
+ * Reorder an array: data[i] = data[order[i]] for i < count
+ */
+static void transform_store_permute(void* data, void* temp, const int* order, int count, size_t item_size)
+{
+    int i;
+    for (i = 0; i < count; i++)
+    {
+        memcpy((char*)temp + (size_t)i * item_size, (const char*)data + (size_t)order[i] * item_size, item_size);
+    }
+    memcpy(data, temp, (size_t)count * item_size);
+}
+
+/**
+ * Drop removed nodes and restore the topological order, sorting nodes by depth
+ */
+static int transform_store_sort(transform_store_t* store)
+{
+    const int count = store->count;
+    int*  depth  = (int*)vmath_aligned_alloc((size_t)count * sizeof(int) * 3, VMATH_MEMORY_ALIGN);
+    void* temp   = vmath_aligned_alloc((size_t)count * sizeof(mat4_t), VMATH_MEMORY_ALIGN);
+    int*  order  = depth + count;
+    int*  remap  = depth + 2 * count;
+    int   i, max_depth = 0, kept = 0;
+
+    if (!depth || !temp)
+    {
+        vmath_aligned_free(depth);
+        vmath_aligned_free(temp);
+        return 0;
+    }
+
+    /* Depth of each node: walk up to a node of known depth, then fill the path */
+    for (i = 0; i < count; i++)
+    {
+        depth[i] = -1;
+    }
+    for (i = 0; i < count; i++)
+    {
+        int node = i, d = 0;
+        while (depth[node] < 0 && store->parent[node] >= 0)
+        {
+            node = store->parent[node];
+            d++;
+        }
+        d += depth[node] > 0 ? depth[node] : 0;
+
+        for (node = i; depth[node] < 0; node = store->parent[node])
+        {
+            depth[node] = d--;
+            if (store->parent[node] < 0)
+            {
+                break;
+            }
+        }
+        max_depth = depth[i] > max_depth ? depth[i] : max_depth;
+    }
+
+    /* Stable counting sort by depth, removed nodes are skipped */
+    for (i = 0; i <= max_depth; i++)
+    {
+        remap[i] = 0;
+    }
+    for (i = 0; i < count; i++)
+    {
+        if (!(store->flags[i] & TRANSFORM_REMOVED))
+        {
+            remap[depth[i]]++;
+            kept++;
+        }
+    }
+    {
+        int d, sum = 0;
+        for (d = 0; d <= max_depth; d++)
+        {
+            const int n = remap[d];
+            remap[d] = sum;
+            sum += n;
+        }
+    }
+    for (i = 0; i < count; i++)
+    {
+        if (!(store->flags[i] & TRANSFORM_REMOVED))
+        {
+            order[remap[depth[i]]++] = i;
+        }
+    }
+
+    /* Old to new dense index */
+    for (i = 0; i < count; i++)
+    {
+        remap[i] = -1;
+    }
+    for (i = 0; i < kept; i++)
+    {
+        remap[order[i]] = i;
+    }
+
+    transform_store_permute(store->position, temp, order, kept, sizeof(vec3_t));
+    transform_store_permute(store->rotation, temp, order, kept, sizeof(quat_t));
+    transform_store_permute(store->scale,    temp, order, kept, sizeof(vec3_t));
+    transform_store_permute(store->local,    temp, order, kept, sizeof(mat4_t));
+    transform_store_permute(store->world,    temp, order, kept, sizeof(mat4_t));
+    transform_store_permute(store->parent,   temp, order, kept, sizeof(int));
+    transform_store_permute(store->slot,     temp, order, kept, sizeof(int));
+    transform_store_permute(store->flags,    temp, order, kept, sizeof(unsigned char));
+
+    for (i = 0; i < kept; i++)
+    {
+        store->parent[i] = store->parent[i] >= 0 ? remap[store->parent[i]] : -1;
+        store->dense[store->slot[i]] = i;
+    }
+
+    store->count    = kept;
+    store->removed  = 0;
+    store->unsorted = 0;
+
+    vmath_aligned_free(depth);
+    vmath_aligned_free(temp);
+    return 1;
+}
+
+int transform_store_init(transform_store_t* store, int capacity)
+{
+    memset(store, 0, sizeof(*store));
+    if (!transform_store_reserve(store, capacity) || !transform_store_reserveslots(store, capacity))
+    {
+        transform_store_free(store);
+        return 0;
+    }
+    return 1;
+}
+
+void transform_store_free(transform_store_t* store)
+{
+    vmath_aligned_free(store->position);
+    vmath_aligned_free(store->rotation);
+    vmath_aligned_free(store->scale);
+    vmath_aligned_free(store->local);
+    vmath_aligned_free(store->world);
+    vmath_aligned_free(store->parent);
+    vmath_aligned_free(store->slot);
+    vmath_aligned_free(store->flags);
+    vmath_aligned_free(store->dense);
+    vmath_aligned_free(store->generation);
+    vmath_aligned_free(store->free_slots);
+    vmath_aligned_free(store->changed);
+    memset(store, 0, sizeof(*store));
+}
+
+transform_id_t transform_store_create(transform_store_t* store, transform_id_t parent)
+{
+    const int parent_index = parent.index < 0 ? -1 : transform_store_index(store, parent);
+    transform_id_t id;
+    int i;
+
+    if ((parent.index >= 0 && parent_index < 0)
+        || !transform_store_reserve(store, store->count + 1)
+        || !transform_store_reserveslots(store, store->slot_count + 1))
+    {
+        return transform_none();
+    }
+
+    if (store->free_count > 0)
+    {
+        id.index = store->free_slots[--store->free_count];
+    }
+    else
+    {
+        id.index = store->slot_count++;
+        store->generation[id.index] = 0;
+    }
+    id.generation = store->generation[id.index];
+
+    /* Appended after every node, so after its parent too */
+    i = store->count++;
+    store->dense[id.index] = i;
+    store->position[i]     = vec3(0.0f, 0.0f, 0.0f);
+    store->rotation[i]     = quat(0.0f, 0.0f, 0.0f, 1.0f);
+    store->scale[i]        = vec3(1.0f, 1.0f, 1.0f);
+    store->parent[i]       = parent_index;
+    store->slot[i]         = id.index;
+    store->flags[i]        = TRANSFORM_LOCAL_DIRTY;
+    return id;
+}
+
+void transform_store_destroy(transform_store_t* store, transform_id_t id)
+{
+    int first, i, marked;
+    if (transform_store_index(store, id) < 0)
+    {
+        return;
+    }
+
+    /* Sorted, descendants are after the node. Else scan all nodes until no more is marked */
+    if (store->unsorted)
+    {
+        transform_store_sort(store);
+    }
+    first = store->unsorted ? 0 : transform_store_index(store, id);
+
+    store->flags[transform_store_index(store, id)] |= TRANSFORM_REMOVED;
+    do
+    {
+        marked = 0;
+        for (i = first; i < store->count; i++)
+        {
+            const int p = store->parent[i];
+            if (!(store->flags[i] & TRANSFORM_REMOVED) && p >= 0 && (store->flags[p] & TRANSFORM_REMOVED))
+            {
+                store->flags[i] |= TRANSFORM_REMOVED;
+                marked = 1;
+            }
+        }
+    } while (store->unsorted && marked);
+
+    /* Release slots, nodes stay in the arrays until the next update */
+    for (i = first; i < store->count; i++)
+    {
+        const int slot = store->slot[i];
+        if ((store->flags[i] & TRANSFORM_REMOVED) && store->dense[slot] == i)
+        {
+            store->dense[slot] = -1;
+            store->generation[slot]++;
+            store->free_slots[store->free_count++] = slot;
+            store->removed++;
+        }
+    }
+}
+
+int transform_store_setparent(transform_store_t* store, transform_id_t id, transform_id_t parent)
+{
+    const int i = transform_store_index(store, id);
+    const int p = parent.index < 0 ? -1 : transform_store_index(store, parent);
+    int node;
+
+    if (i < 0 || (parent.index >= 0 && p < 0))
+    {
+        return 0;
+    }
+
+    /* Refuse cycles: the new parent must not be in the subtree of the node */
+    for (node = p; node >= 0; node = store->parent[node])
+    {
+        if (node == i)
+        {
+            return 0;
+        }
+    }
+
+    store->parent[i] = p;
+    store->flags[i] |= TRANSFORM_LOCAL_DIRTY;
+    store->unsorted |= p > i;
+    return 1;
+}
+
+int transform_store_update(transform_store_t* store)
+{
+    unsigned char* flags;
+    const int*     parent;
+    mat4_t*        local;
+    mat4_t*        world;
+    int*           changed;
+    int            count, changed_count = 0;
+    int            i;
+
+    if ((store->removed || store->unsorted) && !transform_store_sort(store))
+    {
+        return 0;
+    }
+
+    /* Locals: flags is a char pointer and may alias everything, keep the rest in registers */
+    flags   = store->flags;
+    parent  = store->parent;
+    local   = store->local;
+    world   = store->world;
+    changed = store->changed;
+    count   = store->count;
+
+    /* Local matrices, batched over runs of dirty nodes */
+    for (i = 0; i < count;)
+    {
+        int start;
+        if (!(flags[i] & TRANSFORM_LOCAL_DIRTY))
+        {
+            i++;
+            continue;
+        }
+
+        start = i;
+        while (i < count && (flags[i] & TRANSFORM_LOCAL_DIRTY))
+        {
+            i++;
+        }
+        mat4_composetrs(local + start, store->position + start, store->rotation + start, store->scale + start, i - start);
+    }
+
+    /* World matrices, parents first so a change flow to the descendants */
+    for (i = 0; i < count; i++)
+    {
+        const int p = parent[i];
+        if ((flags[i] & TRANSFORM_LOCAL_DIRTY) || (p >= 0 && (flags[p] & TRANSFORM_WORLD_CHANGED)))
+        {
+            world[i] = p >= 0 ? mat4_mul(world[p], local[i]) : local[i];
+            flags[i] = TRANSFORM_WORLD_CHANGED;
+            changed[changed_count++] = i;
+        }
+    }
+
+    for (i = 0; i < changed_count; i++)
+    {
+        flags[changed[i]] = 0;
+    }
+    store->changed_count = changed_count;
+    return 1;
+}
+
+#endif /* VMATH_IMPL */